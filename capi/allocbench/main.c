@@ -0,0 +1,355 @@
+/*
+  main.c
+
+  Page fault and TLB miss counts for the big buffers in ifsfract and
+  terrain, allocated each of the ways big_alloc.h offers.
+
+  The "ifs" workload writes a chaos game's points front to back and then
+  reads them all once, the way ifsfract builds its cloud and hands it to
+  RiPoints.  The "terrain" workload runs the diamond-square passes of
+  terrain's gen_terrain() over a point grid, whose early passes stride
+  whole rows apart and touch a new page on almost every access.
+
+  Counts come from perf_event_open() when the kernel allows it
+  (kernel.perf_event_paranoid <= 2); otherwise page faults come from
+  getrusage() and TLB misses are reported as n/a.  They cover only the
+  workload's loops, after the buffer has been allocated and prefaulted.
+  The allocation has a line of its own, "alloc", with its time and the
+  page faults getrusage() saw during it, which counts the ones the
+  prefault threads and madvise(MADV_POPULATE_WRITE) take in the kernel
+  (perf only sees faults from user space).
+*/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "big_alloc.h"
+#include "rng.h"
+
+typedef float point_t[3];
+
+enum counter_id { FAULTS, DTLB_LOAD_MISSES, DTLB_STORE_MISSES, NUM_COUNTERS };
+
+typedef struct counters_s {
+    int fd[NUM_COUNTERS];
+    long rusage_faults;
+    double start;
+} counters_t;
+
+typedef struct result_s {
+    double seconds;
+    long long count[NUM_COUNTERS];
+    /* Allocating and prefaulting the buffer, outside the counted loops */
+    double alloc_seconds;
+    long alloc_faults;
+} result_t;
+
+/* A mode is how the buffers get allocated: calloc() or big_alloc() with opts */
+typedef struct alloc_mode_s {
+    const char *name;
+    int use_malloc;
+    big_alloc_opts_t opts;
+} alloc_mode_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static long rusage_faults(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt + ru.ru_majflt;
+}
+
+static int open_counter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)type;
+    (void)config;
+    return -1;
+#endif
+}
+
+static void counters_start(counters_t *c) {
+    int i;
+#ifdef __linux__
+    c->fd[FAULTS] = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    c->fd[DTLB_LOAD_MISSES] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    c->fd[DTLB_STORE_MISSES] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                            (PERF_COUNT_HW_CACHE_OP_WRITE << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    for (i=0; i<NUM_COUNTERS; ++i) {
+        if (c->fd[i] >= 0) {
+            ioctl(c->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    for (i=0; i<NUM_COUNTERS; ++i) {
+        c->fd[i] = -1;
+    }
+#endif
+    c->rusage_faults = rusage_faults();
+    c->start = now();
+}
+
+/* Counters that couldn't be opened read as -1 */
+static void counters_stop(counters_t *c, result_t *res) {
+    int i;
+    res->seconds = now() - c->start;
+    for (i=0; i<NUM_COUNTERS; ++i) {
+        res->count[i] = -1;
+        if (c->fd[i] >= 0) {
+            long long value;
+            if (read(c->fd[i], &value, sizeof(value)) == sizeof(value)) {
+                res->count[i] = value;
+            }
+            close(c->fd[i]);
+        }
+    }
+    if (res->count[FAULTS] < 0) {
+        res->count[FAULTS] = rusage_faults() - c->rusage_faults;
+    }
+}
+
+static void *mode_alloc(const alloc_mode_t *mode, size_t bytes) {
+    if (mode->use_malloc) {
+        return calloc(1, bytes);
+    }
+    return big_alloc_opts(bytes, &mode->opts);
+}
+
+/* mode_alloc(), with its time and page faults (every thread's) into res */
+static void *timed_alloc(const alloc_mode_t *mode, size_t bytes, result_t *res) {
+    long faults = rusage_faults();
+    double start = now();
+    void *ptr = mode_alloc(mode, bytes);
+    res->alloc_seconds = now() - start;
+    res->alloc_faults = rusage_faults() - faults;
+    return ptr;
+}
+
+static void mode_free(const alloc_mode_t *mode, void *ptr) {
+    if (mode->use_malloc) {
+        free(ptr);
+    } else {
+        big_free(ptr);
+    }
+}
+
+/* ifsfract's Menger-like cloud: seven maps scaling by 0.34 toward an offset */
+static double run_ifs(const alloc_mode_t *mode, size_t num_points, result_t *res, big_pages_t *got) {
+    static const float offsets[7][3] = {{0,0,0.66f}, {0,0,-0.66f}, {0,0,0},
+                                        {0.66f,0,0}, {-0.66f,0,0}, {0,0.66f,0}, {0,-0.66f,0}};
+    uint32_t choice[256];
+    counters_t c;
+    point_t *pts;
+    double sum = 0.0;
+    size_t i, j;
+
+    pts = timed_alloc(mode, sizeof(point_t)*num_points, res);
+    if (pts == NULL) {
+        printf("Couldn't allocate %lu points!\n", (unsigned long)num_points);
+        exit(1);
+    }
+    *got = mode->use_malloc ? BIG_PAGES_SMALL : big_alloc_pages(pts);
+    counters_start(&c);
+    pts[0][0] = pts[0][1] = pts[0][2] = 0.5f;
+    for (i=1; i<num_points; i+=256) {
+        size_t count = (num_points-i < 256) ? num_points-i : 256;
+        rng_fill_u32(1, 0, i, choice, count);
+        for (j=0; j<count; ++j) {
+            const float *o = offsets[((uint64_t)choice[j]*7) >> 32];
+            pts[i+j][0] = 0.34f*pts[i+j-1][0] + o[0];
+            pts[i+j][1] = 0.34f*pts[i+j-1][1] + o[1];
+            pts[i+j][2] = 0.34f*pts[i+j-1][2] + o[2];
+        }
+    }
+    for (i=0; i<num_points; ++i) {
+        sum += pts[i][0] + pts[i][1] + pts[i][2];
+    }
+    counters_stop(&c, res);
+    mode_free(mode, pts);
+    return sum;
+}
+
+/* gen_terrain()'s diamond-square passes on an n x n grid */
+static double run_terrain(const alloc_mode_t *mode, size_t n, result_t *res, big_pages_t *got) {
+    counters_t c;
+    point_t *pts;
+    double sum = 0.0;
+    uint64_t pass = 0;
+    size_t step, hs, i, j;
+
+    pts = timed_alloc(mode, sizeof(point_t)*n*n, res);
+    if (pts == NULL) {
+        printf("Couldn't allocate a %lux%lu grid!\n", (unsigned long)n, (unsigned long)n);
+        exit(1);
+    }
+    *got = mode->use_malloc ? BIG_PAGES_SMALL : big_alloc_pages(pts);
+    counters_start(&c);
+    for (step = (n-1)/2; step > 0; step /= 2, pass += 2) {
+        for (i=step; i+step<n; i += 2*step) {
+            for (j=step; j+step<n; j += 2*step) {
+                rng_t rng;
+                float y = (pts[(i-step)*n + j-step][1] + pts[(i+step)*n + j-step][1] +
+                           pts[(i+step)*n + j+step][1] + pts[(i-step)*n + j+step][1])/4.0f;
+                rng_init(&rng, 1, 0, pass*n*n + i*n + j);
+                pts[i*n + j][0] = (float)i;
+                pts[i*n + j][1] = y + (float)rng_range(&rng, -2.0, 2.0);
+                pts[i*n + j][2] = (float)j;
+            }
+        }
+        hs = step/2;
+        for (i=hs; hs>0 && i+hs<n; i += step) {
+            for (j=hs; j+hs<n; j += step) {
+                rng_t rng;
+                float y = (pts[(i-hs)*n + j-hs][1] + pts[(i+hs)*n + j-hs][1] +
+                           pts[(i+hs)*n + j+hs][1] + pts[(i-hs)*n + j+hs][1])/4.0f;
+                rng_init(&rng, 1, 0, (pass+1)*n*n + i*n + j);
+                pts[i*n + j][1] = y + (float)rng_range(&rng, -2.0, 2.0);
+            }
+        }
+    }
+    for (i=0; i<n*n; ++i) {
+        sum += pts[i][1];
+    }
+    counters_stop(&c, res);
+    mode_free(mode, pts);
+    return sum;
+}
+
+static void print_count(long long value) {
+    if (value < 0) {
+        printf(" %14s", "n/a");
+    } else {
+        printf(" %14lld", value);
+    }
+}
+
+static void print_result(const char *workload, const alloc_mode_t *mode, big_pages_t got,
+                         const result_t *res) {
+    printf("%-8s %-18s %-6s %8.3f", workload, mode->name, big_pages_name(got), res->seconds);
+    print_count(res->count[FAULTS]);
+    print_count(res->count[DTLB_LOAD_MISSES]);
+    print_count(res->count[DTLB_STORE_MISSES]);
+    printf("\n");
+    printf("%-8s %-18s %-6s %8.3f", "", "alloc", "", res->alloc_seconds);
+    print_count(res->alloc_faults);
+    print_count(-1);
+    print_count(-1);
+    printf("\n");
+}
+
+static void usage(const char *prog) {
+    printf("Use:\n\t%s [-n ifs_points] [-g terrain_grid] [-t prefault_threads] [-w ifs|terrain]\n\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    size_t num_points = 50000000;
+    size_t grid = 4097;
+    int threads = 1;
+    const char *only = NULL;
+    alloc_mode_t modes[6];
+    size_t num_modes = 0;
+    size_t m;
+    int opt;
+    double check = 0.0;
+
+    while ((opt = getopt(argc, argv, "n:g:t:w:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_points = strtoul(optarg, NULL, 10);
+            break;
+        case 'g':
+            grid = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            threads = atoi(optarg);
+            break;
+        case 'w':
+            only = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_points < 2 || grid < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    modes[num_modes].name = "calloc";
+    modes[num_modes++].use_malloc = 1;
+    {
+        static const struct { const char *name; big_pages_t pages; big_numa_t numa; int prefault; } kinds[] = {
+            {"small,lazy", BIG_PAGES_SMALL, BIG_NUMA_FIRST_TOUCH, 0},
+            {"small,prefault", BIG_PAGES_SMALL, BIG_NUMA_FIRST_TOUCH, 1},
+            {"thp,prefault", BIG_PAGES_THP, BIG_NUMA_FIRST_TOUCH, 1},
+            {"2m,prefault", BIG_PAGES_2M, BIG_NUMA_FIRST_TOUCH, 1},
+            {"1g,interleave", BIG_PAGES_1G, BIG_NUMA_INTERLEAVE, 1},
+        };
+        size_t k;
+        for (k=0; k<sizeof(kinds)/sizeof(kinds[0]); ++k) {
+            modes[num_modes].name = kinds[k].name;
+            modes[num_modes].use_malloc = 0;
+            modes[num_modes].opts.pages = kinds[k].pages;
+            modes[num_modes].opts.numa = kinds[k].numa;
+            modes[num_modes].opts.prefault_threads = kinds[k].prefault ? threads : 0;
+            ++num_modes;
+        }
+    }
+
+    printf("ifs: %lu points (%lu MB), terrain: %lux%lu grid (%lu MB)\n",
+           (unsigned long)num_points, (unsigned long)(sizeof(point_t)*num_points >> 20),
+           (unsigned long)grid, (unsigned long)grid, (unsigned long)(sizeof(point_t)*grid*grid >> 20));
+    printf("Pages that couldn't be had fall back, so \"got\" is what each run really used.\n\n");
+    printf("%-8s %-18s %-6s %8s %14s %14s %14s\n",
+           "workload", "allocation", "got", "seconds", "page faults", "dTLB ld miss", "dTLB st miss");
+
+    for (m=0; m<num_modes; ++m) {
+        result_t res;
+        big_pages_t got;
+        if (only == NULL || strcmp(only, "ifs") == 0) {
+            check += run_ifs(&modes[m], num_points, &res, &got);
+            print_result("ifs", &modes[m], got, &res);
+        }
+        if (only == NULL || strcmp(only, "terrain") == 0) {
+            check += run_terrain(&modes[m], grid, &res, &got);
+            print_result("terrain", &modes[m], got, &res);
+        }
+    }
+    /* Keeps the workloads from being optimized away */
+    if (check == 12345.0) {
+        printf("\n");
+    }
+    return 0;
+}
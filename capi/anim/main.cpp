@@ -4,6 +4,15 @@
 #include <cstdlib>
 #include <iostream>
 
+// The shapes only turn with the world, so they're declared once as
+// retained objects and every frame instances them
+enum { SPHERE, CYLINDER, CONE, PARABOLOID, HYPERBOLOID, TORUS, NUM_SHAPES };
+
+static const RtFloat offsets[NUM_SHAPES][2] = { {-5.0,  2.5}, {0.0,  2.5}, {5.0,  2.5},
+                                                 {-5.0, -2.5}, {0.0, -2.5}, {5.0, -2.5} };
+static RtObjectHandle shapes[NUM_SHAPES];
+
+void declareShapes();
 void doFrame(int fNum, char *fName);
 
 int main(int argc, char *argv[])
@@ -15,6 +24,7 @@ int main(int argc, char *argv[])
     int i;
     RiBegin(RI_NULL);
 
+    declareShapes();
     for (i=1;i<=360; ++i) {
         doFrame(i, argv[1]);
     }
@@ -22,6 +32,34 @@ int main(int argc, char *argv[])
     RiEnd();
 }
 
+void declareShapes() {
+    shapes[SPHERE] = RiObjectBegin(); {
+        RiSphere(2.0,-2.0,2.0,360.0,RI_NULL);
+    } RiObjectEnd();
+
+    shapes[CYLINDER] = RiObjectBegin(); {
+        RiCylinder(2.0,-2.0,2.0,360.0,RI_NULL);
+    } RiObjectEnd();
+
+    shapes[CONE] = RiObjectBegin(); {
+        RiCone(4.0,2.0,360.0,RI_NULL);
+    } RiObjectEnd();
+
+    shapes[PARABOLOID] = RiObjectBegin(); {
+        RiParaboloid(4.0,0.0,4.0,360.0,RI_NULL);
+    } RiObjectEnd();
+
+    RtPoint p1 = {-1,-1,-4};
+    RtPoint p2 = {4,2,4};
+    shapes[HYPERBOLOID] = RiObjectBegin(); {
+        RiHyperboloid(p1, p2, 360.0,RI_NULL);
+    } RiObjectEnd();
+
+    shapes[TORUS] = RiObjectBegin(); {
+        RiTorus(2.0,0.5,0,360,360,RI_NULL);
+    } RiObjectEnd();
+}
+
 void doFrame(int fNum, char *fName) {
 
     RtPoint points[4] = {-0.5,0,-0.5,
@@ -71,37 +109,12 @@ void doFrame(int fNum, char *fName) {
             RiSurface((char*)"paintedplastic", (char*)"texturename", &texName, RI_NULL);
             RiRotate(fNum, 0,1,0);
 
-            RiAttributeBegin(); {
-                RiTranslate(-5.0,2.5,0.0);
-                RiSphere(2.0,-2.0,2.0,360.0,RI_NULL);
-            } RiAttributeEnd();
-
-            RiAttributeBegin(); {
-                RiTranslate(0.0,2.5,0.0);
-                RiCylinder(2.0,-2.0,2.0,360.0,RI_NULL);
-            }RiAttributeEnd();
-
-            RiAttributeBegin(); {
-                RiTranslate(5.0,2.5,0.0);
-                RiCone(4.0,2.0,360.0,RI_NULL);
-            } RiAttributeEnd();
-
-            RiAttributeBegin(); {
-                RiTranslate(-5.0,-2.5,0.0);
-                RiParaboloid(4.0,0.0,4.0,360.0,RI_NULL);
-            } RiAttributeEnd();
-
-            RtPoint p1 = {-1,-1,-4};
-            RtPoint p2 = {4,2,4};
-            RiAttributeBegin(); {
-                RiTranslate(0.0,-2.5,0.0);
-                RiHyperboloid(p1, p2, 360.0,RI_NULL);
-            } RiAttributeEnd();
-
-            RiAttributeBegin(); {
-                RiTranslate(5.0,-2.5,0.0);
-                RiTorus(2.0,0.5,0,360,360,RI_NULL);
-            } RiAttributeEnd();
+            for (int i=0; i<NUM_SHAPES; ++i) {
+                RiAttributeBegin(); {
+                    RiTranslate(offsets[i][0],offsets[i][1],0.0);
+                    RiObjectInstance(shapes[i]);
+                } RiAttributeEnd();
+            }
 
   
         } RiWorldEnd();
@@ -5,13 +5,9 @@
 #include <stdbool.h>
 
 #include <math.h>
-#include <time.h>
 
 #define PI (3.141592654)
 
-size_t randUInt(size_t min, size_t max) {
-    return ((rand()%(max-min)) + min);
-}
 
 typedef struct camera_s {
     RtPoint location;
@@ -91,7 +87,6 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     char *fprefix = argv[1];
-    srand(time(NULL));
     const size_t NUM_FRAMES = 1;
     RtInt md = 4;
     scene_info_t scene;
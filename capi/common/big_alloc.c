@@ -0,0 +1,381 @@
+/* MAP_ANONYMOUS, madvise() and syscall() are hidden by -std=c99 otherwise */
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+
+#include "big_alloc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define SIZE_2M ((size_t)2*1024*1024)
+#define SIZE_1G ((size_t)1024*1024*1024)
+
+/* Older headers know MAP_HUGETLB but not how to pick the page size */
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define MPOL_INTERLEAVE_MODE 3
+#define MAX_NUMA_NODES 1024
+#define MAX_PREFAULT_THREADS 64
+
+/* Live mappings, so big_free() can tell them from malloc()ed buffers */
+typedef struct big_block_s {
+    struct big_block_s *next;
+    void *ptr;
+    size_t size;
+    big_pages_t pages;
+} big_block_t;
+
+static big_block_t *blocks = NULL;
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t round_up(size_t n, size_t to) {
+    return (n + to - 1)/to*to;
+}
+
+const char *big_pages_name(big_pages_t pages) {
+    switch (pages) {
+    case BIG_PAGES_THP:
+        return "thp";
+    case BIG_PAGES_2M:
+        return "2m";
+    case BIG_PAGES_1G:
+        return "1g";
+    default:
+        return "small";
+    }
+}
+
+void big_alloc_default_opts(big_alloc_opts_t *opts) {
+    const char *pages = getenv("BIG_ALLOC_PAGES");
+    const char *numa = getenv("BIG_ALLOC_NUMA");
+    const char *prefault = getenv("BIG_ALLOC_PREFAULT");
+
+    opts->pages = BIG_PAGES_THP;
+    opts->numa = BIG_NUMA_FIRST_TOUCH;
+    opts->prefault_threads = 1;
+
+    if (pages != NULL) {
+        if (strcmp(pages, "small") == 0 || strcmp(pages, "4k") == 0) {
+            opts->pages = BIG_PAGES_SMALL;
+        } else if (strcmp(pages, "2m") == 0) {
+            opts->pages = BIG_PAGES_2M;
+        } else if (strcmp(pages, "1g") == 0) {
+            opts->pages = BIG_PAGES_1G;
+        }
+    }
+    if (numa != NULL && strcmp(numa, "interleave") == 0) {
+        opts->numa = BIG_NUMA_INTERLEAVE;
+    }
+    if (prefault != NULL) {
+        opts->prefault_threads = atoi(prefault);
+    }
+}
+
+#ifdef MAP_HUGETLB
+static void *map_hugetlb(size_t *size, size_t page, int flag) {
+    void *mem;
+    *size = round_up(*size, page);
+    mem = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flag, -1, 0);
+    return mem == MAP_FAILED ? NULL : mem;
+}
+#endif
+
+/* A 2 MB aligned mapping, so transparent huge pages can cover all of it */
+static void *map_aligned(size_t *size, size_t align) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t span, head;
+    char *mem;
+
+    *size = round_up(*size, page);
+    span = *size + align;
+    mem = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+    head = round_up((size_t)mem, align) - (size_t)mem;
+    if (head > 0) {
+        munmap(mem, head);
+    }
+    if (span - head > *size) {
+        munmap(mem + head + *size, span - head - *size);
+    }
+    return mem + head;
+}
+
+static void *map_pages(size_t *size, big_pages_t *pages) {
+    void *mem = NULL;
+    size_t want = *size;
+
+#ifdef MAP_HUGETLB
+    if (*pages == BIG_PAGES_1G) {
+        mem = map_hugetlb(size, SIZE_1G, MAP_HUGE_1GB);
+        if (mem == NULL) {
+            *size = want;
+            *pages = BIG_PAGES_2M;
+        }
+    }
+    if (mem == NULL && *pages == BIG_PAGES_2M) {
+        mem = map_hugetlb(size, SIZE_2M, MAP_HUGE_2MB);
+        if (mem == NULL) {
+            *size = want;
+            *pages = BIG_PAGES_THP;
+        }
+    }
+#else
+    if (*pages == BIG_PAGES_1G || *pages == BIG_PAGES_2M) {
+        *pages = BIG_PAGES_THP;
+    }
+#endif
+    if (mem == NULL && *pages == BIG_PAGES_THP) {
+#ifdef MADV_HUGEPAGE
+        mem = map_aligned(size, SIZE_2M);
+        if (mem != NULL) {
+            madvise(mem, *size, MADV_HUGEPAGE);
+        }
+#else
+        *pages = BIG_PAGES_SMALL;
+#endif
+    }
+    if (mem == NULL && *pages == BIG_PAGES_SMALL) {
+        mem = map_aligned(size, (size_t)sysconf(_SC_PAGESIZE));
+    }
+    return mem;
+}
+
+#ifdef __linux__
+/* Reads the online node list ("0-1,3") into a mask; returns the node count */
+static int online_nodes(unsigned long *mask, unsigned long *max_node) {
+    FILE *inf = fopen("/sys/devices/system/node/online", "r");
+    int count = 0;
+    int lo, hi;
+    char sep;
+
+    memset(mask, 0, MAX_NUMA_NODES/8);
+    *max_node = 0;
+    if (inf == NULL) {
+        return 0;
+    }
+    while (fscanf(inf, "%d", &lo) == 1) {
+        hi = lo;
+        sep = (char)fgetc(inf);
+        if (sep == '-') {
+            if (fscanf(inf, "%d", &hi) != 1) {
+                break;
+            }
+            sep = (char)fgetc(inf);
+        }
+        for (; lo <= hi && lo < MAX_NUMA_NODES; ++lo) {
+            mask[lo/(8*sizeof(unsigned long))] |= 1UL << (lo % (8*sizeof(unsigned long)));
+            *max_node = (unsigned long)lo + 1;
+            ++count;
+        }
+        if (sep != ',') {
+            break;
+        }
+    }
+    fclose(inf);
+    return count;
+}
+#endif
+
+/* Must happen before the pages are touched; a no-op on one node */
+static void interleave(void *mem, size_t size) {
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[MAX_NUMA_NODES/(8*sizeof(unsigned long))];
+    unsigned long max_node;
+
+    if (online_nodes(mask, &max_node) > 1) {
+        /* The kernel wants one more than the highest node */
+        syscall(SYS_mbind, mem, size, MPOL_INTERLEAVE_MODE, mask, max_node + 1, 0);
+    }
+#else
+    (void)mem;
+    (void)size;
+#endif
+}
+
+typedef struct prefault_job_s {
+    volatile char *start;
+    size_t size;
+    size_t stride;
+} prefault_job_t;
+
+static void *prefault_range(void *arg) {
+    prefault_job_t *job = arg;
+    size_t off;
+    /* Rewrite what's there, so this is safe on a buffer already in use */
+    for (off = 0; off < job->size; off += job->stride) {
+        job->start[off] = job->start[off];
+    }
+    return NULL;
+}
+
+/*
+ * The share'th of nshares even parts of [ptr, ptr+bytes) into job; returns
+ * 0 if that part is empty.  Shares end on huge page boundaries so no huge
+ * page is split between nodes.
+ */
+static int share_job(prefault_job_t *job, void *ptr, size_t bytes, int share, int nshares) {
+    size_t size = round_up((bytes + nshares - 1)/nshares, SIZE_2M);
+    size_t off = size*(size_t)share;
+
+    if (off >= bytes) {
+        return 0;
+    }
+    job->start = (char *)ptr + off;
+    job->size = (bytes - off < size) ? bytes - off : size;
+    job->stride = (size_t)sysconf(_SC_PAGESIZE);
+    return 1;
+}
+
+void big_prefault_share(void *ptr, size_t bytes, int share, int nshares) {
+    prefault_job_t job;
+
+    if (nshares <= 0 || share < 0 || share >= nshares) {
+        return;
+    }
+    if (share_job(&job, ptr, bytes, share, nshares)) {
+        prefault_range(&job);
+    }
+}
+
+void big_prefault(void *ptr, size_t bytes, int nthreads) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    prefault_job_t jobs[MAX_PREFAULT_THREADS];
+    pthread_t threads[MAX_PREFAULT_THREADS];
+    int i, started;
+
+    if (nthreads <= 0 || bytes == 0) {
+        return;
+    }
+    if (nthreads == 1) {
+#ifdef MADV_POPULATE_WRITE
+        /* Faults the whole range in with one call instead of a trap per page */
+        size_t head = (size_t)ptr % page;
+        if (madvise((char *)ptr - head, round_up(bytes + head, page), MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+        jobs[0].start = ptr;
+        jobs[0].size = bytes;
+        jobs[0].stride = page;
+        prefault_range(&jobs[0]);
+        return;
+    }
+    if (nthreads > MAX_PREFAULT_THREADS) {
+        nthreads = MAX_PREFAULT_THREADS;
+    }
+
+    started = 0;
+    while (started < nthreads && share_job(&jobs[started], ptr, bytes, started, nthreads)) {
+        ++started;
+    }
+    for (i = 1; i < started; ++i) {
+        if (pthread_create(&threads[i], NULL, prefault_range, &jobs[i]) != 0) {
+            prefault_range(&jobs[i]);
+            threads[i] = pthread_self();
+        }
+    }
+    prefault_range(&jobs[0]);
+    for (i = 1; i < started; ++i) {
+        if (!pthread_equal(threads[i], pthread_self())) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+void *big_alloc_opts(size_t bytes, const big_alloc_opts_t *opts) {
+    big_block_t *block;
+    big_pages_t pages = opts->pages;
+    size_t size = bytes > 0 ? bytes : 1;
+    void *mem;
+
+    if (bytes < BIG_ALLOC_MIN) {
+        return calloc(1, size);
+    }
+    block = malloc(sizeof(big_block_t));
+    if (block == NULL) {
+        return NULL;
+    }
+    mem = map_pages(&size, &pages);
+    if (mem == NULL) {
+        free(block);
+        return NULL;
+    }
+    if (opts->numa == BIG_NUMA_INTERLEAVE) {
+        interleave(mem, size);
+    }
+    big_prefault(mem, size, opts->prefault_threads);
+
+    block->ptr = mem;
+    block->size = size;
+    block->pages = pages;
+    pthread_mutex_lock(&blocks_lock);
+    block->next = blocks;
+    blocks = block;
+    pthread_mutex_unlock(&blocks_lock);
+    return mem;
+}
+
+void *big_alloc(size_t bytes) {
+    big_alloc_opts_t opts;
+    big_alloc_default_opts(&opts);
+    return big_alloc_opts(bytes, &opts);
+}
+
+void big_free(void *ptr) {
+    big_block_t **link;
+    big_block_t *block = NULL;
+
+    if (ptr == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&blocks_lock);
+    for (link = &blocks; *link != NULL; link = &(*link)->next) {
+        if ((*link)->ptr == ptr) {
+            block = *link;
+            *link = block->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&blocks_lock);
+
+    if (block == NULL) {
+        free(ptr);
+        return;
+    }
+    munmap(block->ptr, block->size);
+    free(block);
+}
+
+big_pages_t big_alloc_pages(const void *ptr) {
+    big_pages_t pages = BIG_PAGES_SMALL;
+    big_block_t *block;
+
+    pthread_mutex_lock(&blocks_lock);
+    for (block = blocks; block != NULL; block = block->next) {
+        if (block->ptr == ptr) {
+            pages = block->pages;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&blocks_lock);
+    return pages;
+}
@@ -0,0 +1,89 @@
+#ifndef BIG_ALLOC_H
+#define BIG_ALLOC_H
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Allocation for geometry buffers big enough that page faults and TLB
+ * misses show up in a profile: ifsfract's 100M points, the terrain grid
+ * and OBJ vertex arrays.  big_alloc() maps them directly, backs them with
+ * huge pages when it can, places them on NUMA nodes and faults every page
+ * in before returning, so the code filling a buffer doesn't trap once per
+ * 4k page and later walks over it need far fewer TLB entries.
+ *
+ * Pages:
+ *   BIG_PAGES_SMALL  ordinary pages
+ *   BIG_PAGES_THP    2 MB aligned and advised to use transparent huge pages
+ *   BIG_PAGES_2M     explicit 2 MB huge pages (vm.nr_hugepages)
+ *   BIG_PAGES_1G     explicit 1 GB huge pages (hugepagesz=1G at boot)
+ * An explicit size that isn't reserved falls back to the next one down, so
+ * asking for 1G on a machine without any still gets THP.
+ *
+ * NUMA:
+ *   BIG_NUMA_FIRST_TOUCH  each page lands on the node of the thread that
+ *                         first writes it
+ *   BIG_NUMA_INTERLEAVE   pages are spread round robin over all nodes, for
+ *                         buffers every thread reads, like a render's input
+ *
+ * big_alloc() takes its options from the environment:
+ *   BIG_ALLOC_PAGES=small|thp|2m|1g   (default thp)
+ *   BIG_ALLOC_NUMA=first-touch|interleave   (default first-touch)
+ *   BIG_ALLOC_PREFAULT=<threads>   (default 1, 0 leaves pages to fault in)
+ *
+ * big_alloc()'s prefault threads are its own, started and joined inside
+ * the call and pinned nowhere, so under first touch the pages land wherever
+ * the scheduler ran them, not near the threads that go on to fill the
+ * buffer.  That's fine for a buffer filled by one thread.  For one filled
+ * by several, call big_alloc_opts() with prefault_threads 0 and have each
+ * filling thread call big_prefault_share() for its part before it starts.
+ *
+ * Anything smaller than BIG_ALLOC_MIN just comes from malloc().  Either way
+ * the memory is zeroed and is released with big_free().
+ */
+typedef enum big_pages_e {
+    BIG_PAGES_SMALL,
+    BIG_PAGES_THP,
+    BIG_PAGES_2M,
+    BIG_PAGES_1G
+} big_pages_t;
+
+typedef enum big_numa_e {
+    BIG_NUMA_FIRST_TOUCH,
+    BIG_NUMA_INTERLEAVE
+} big_numa_t;
+
+typedef struct big_alloc_opts_s {
+    big_pages_t pages;
+    big_numa_t numa;
+    int prefault_threads;
+} big_alloc_opts_t;
+
+#define BIG_ALLOC_MIN (1024*1024)
+
+/* The options big_alloc() uses, from the environment */
+void big_alloc_default_opts(big_alloc_opts_t *opts);
+
+void *big_alloc(size_t bytes);
+void *big_alloc_opts(size_t bytes, const big_alloc_opts_t *opts);
+void big_free(void *ptr);
+
+/* What a buffer ended up with after any fallback; BIG_PAGES_SMALL for malloc()ed ones */
+big_pages_t big_alloc_pages(const void *ptr);
+
+/* Writes every page of [ptr, ptr+bytes) from nthreads threads, each taking an even share in order */
+void big_prefault(void *ptr, size_t bytes, int nthreads);
+
+/* The part of that split the share'th of nshares threads would take, written from the calling thread */
+void big_prefault_share(void *ptr, size_t bytes, int share, int nshares);
+
+const char *big_pages_name(big_pages_t pages);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <ri.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct camera_s {
+    RtPoint location;
+    RtPoint look_at;
+    double roll;
+} camera_t;
+
+/*
+ * AimZ(): rotate the world so the direction vector points in
+ *  positive z by rotating about the y axis, then x.
+ */
+void AimZ(RtPoint direction);
+
+/* The world to camera transform for cam; call it after RiProjection() */
+void PlaceCamera(camera_t *cam);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+/* MAP_ANONYMOUS and friends are hidden by -std=c99 otherwise */
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+
+#include "frame_arena.h"
+
+#include <string.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define ARENA_ALIGN 16
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
+static size_t round_up(size_t n, size_t to) {
+    return (n + to - 1)/to*to;
+}
+
+static int want_huge_pages(void) {
+    const char *env = getenv("FRAME_ARENA_HUGEPAGES");
+    return env != NULL && atoi(env) != 0;
+}
+
+/* Maps a block of at least *size bytes and faults its pages in */
+static char *map_block(size_t *size) {
+    int huge = want_huge_pages();
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void *mem = MAP_FAILED;
+
+    *size = round_up(*size, huge ? HUGE_PAGE_SIZE : page);
+#ifdef MAP_HUGETLB
+    if (huge) {
+        mem = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (mem == MAP_FAILED) {
+        mem = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge) {
+            madvise(mem, *size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    memset(mem, 0, *size);
+    return mem;
+}
+
+int frame_arena_init(frame_arena_t *arena, size_t size) {
+    arena->size = size > 0 ? size : 1;
+    arena->base = map_block(&arena->size);
+    arena->used = 0;
+    arena->frame_used = 0;
+    arena->overflow = NULL;
+    if (arena->base == NULL) {
+        arena->size = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static void free_overflow(frame_arena_t *arena) {
+    while (arena->overflow != NULL) {
+        frame_arena_block_t *next = arena->overflow->next;
+        free(arena->overflow);
+        arena->overflow = next;
+    }
+}
+
+void frame_arena_free(frame_arena_t *arena) {
+    free_overflow(arena);
+    if (arena->base != NULL) {
+        munmap(arena->base, arena->size);
+    }
+    arena->base = NULL;
+    arena->size = arena->used = arena->frame_used = 0;
+}
+
+void *frame_arena_alloc(frame_arena_t *arena, size_t bytes) {
+    frame_arena_block_t *block;
+    void *mem;
+
+    bytes = round_up(bytes > 0 ? bytes : 1, ARENA_ALIGN);
+    arena->frame_used += bytes;
+    if (arena->used + bytes <= arena->size) {
+        mem = arena->base + arena->used;
+        arena->used += bytes;
+        return mem;
+    }
+
+    /* Doesn't fit this frame; the next reset grows the main block */
+    block = malloc(round_up(sizeof(frame_arena_block_t), ARENA_ALIGN) + bytes);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = arena->overflow;
+    block->size = bytes;
+    arena->overflow = block;
+    return (char *)block + round_up(sizeof(frame_arena_block_t), ARENA_ALIGN);
+}
+
+void frame_arena_reset(frame_arena_t *arena) {
+    if (arena->overflow != NULL) {
+        size_t size = arena->frame_used + arena->frame_used/2;
+        char *base;
+
+        free_overflow(arena);
+        base = map_block(&size);
+        if (base != NULL) {
+            if (arena->base != NULL) {
+                munmap(arena->base, arena->size);
+            }
+            arena->base = base;
+            arena->size = size;
+        }
+    }
+    arena->used = 0;
+    arena->frame_used = 0;
+}
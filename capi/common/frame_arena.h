@@ -0,0 +1,53 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A bump allocator for the temporaries a frame builds for its Ri calls
+ * (point, color and index arrays, blobby ops and matrices).  Allocations
+ * last until frame_arena_reset(), which goes right after RiFrameEnd(),
+ * so there's nothing to free one by one and no malloc()/free() or fresh
+ * page faults in the frame loop once the arena has grown to fit a frame.
+ *
+ * The block is mapped up front and touched so its pages are resident.
+ * If a frame needs more, the extra comes from overflow blocks, and the
+ * next reset replaces everything with one block big enough for it.
+ *
+ * With FRAME_ARENA_HUGEPAGES=1 in the environment the block is mapped
+ * with huge pages when the system has them reserved, or advised to use
+ * transparent huge pages otherwise.
+ */
+typedef struct frame_arena_block_s {
+    struct frame_arena_block_s *next;
+    size_t size;
+} frame_arena_block_t;
+
+typedef struct frame_arena_s {
+    char *base;
+    size_t size;
+    size_t used;
+    /* Bytes used this frame, counting overflow blocks */
+    size_t frame_used;
+    frame_arena_block_t *overflow;
+} frame_arena_t;
+
+/* Returns 0 on success */
+int frame_arena_init(frame_arena_t *arena, size_t size);
+void frame_arena_free(frame_arena_t *arena);
+
+/* 16 byte aligned, never NULL unless the system is out of memory */
+void *frame_arena_alloc(frame_arena_t *arena, size_t bytes);
+
+/* Releases everything allocated since the last reset */
+void frame_arena_reset(frame_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,487 @@
+#include "hashlife.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NW 0
+#define NE 1
+#define SW 2
+#define SE 3
+
+/* Marks a free slot; real nodes are never this deep */
+#define FREE_LEVEL 0xFF
+
+static uint32_t hash4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint64_t h = a*0x9E3779B97F4A7C15ULL;
+    h = (h ^ b)*0xC2B2AE3D27D4EB4FULL;
+    h = (h ^ c)*0x165667B19E3779F9ULL;
+    h = (h ^ d)*0x27D4EB2F165667C5ULL;
+    return (uint32_t)(h ^ (h >> 29));
+}
+
+static void rehash(hashlife_t *hl, uint32_t num_buckets) {
+    uint32_t i;
+    uint32_t *buckets = malloc(sizeof(uint32_t)*num_buckets);
+
+    if (buckets == NULL) {
+        /* Keep the old table; chains just get longer */
+        return;
+    }
+    free(hl->buckets);
+    hl->buckets = buckets;
+    hl->num_buckets = num_buckets;
+    for (i=0; i<num_buckets; ++i) {
+        buckets[i] = HASHLIFE_NONE;
+    }
+    for (i=2; i<hl->num_nodes; ++i) {
+        hashlife_node_t *n = &hl->nodes[i];
+        if (n->level != FREE_LEVEL) {
+            uint32_t b = hash4(n->child[0], n->child[1], n->child[2], n->child[3]) & (num_buckets-1);
+            n->next = buckets[b];
+            buckets[b] = i;
+        }
+    }
+}
+
+/* HASHLIFE_NONE if there's no room for another */
+static uint32_t alloc_node(hashlife_t *hl) {
+    uint32_t i;
+    if (hl->free_list != HASHLIFE_NONE) {
+        i = hl->free_list;
+        hl->free_list = hl->nodes[i].next;
+        return i;
+    }
+    if (hl->num_nodes == hl->capacity) {
+        uint32_t capacity = hl->capacity*2;
+        hashlife_node_t *nodes;
+        if (capacity >= HASHLIFE_NONE/2) {
+            return HASHLIFE_NONE;
+        }
+        nodes = realloc(hl->nodes, sizeof(hashlife_node_t)*capacity);
+        if (nodes == NULL) {
+            return HASHLIFE_NONE;
+        }
+        hl->nodes = nodes;
+        hl->capacity = capacity;
+    }
+    return hl->num_nodes++;
+}
+
+static int out_of_memory(const hashlife_t *hl) {
+    printf("Hashlife ran out of memory at %lu nodes\n", (unsigned long)hl->live);
+    return 1;
+}
+
+/*
+ * The one node with these quadrants.  HASHLIFE_NONE if it had to be made
+ * and couldn't be, or if any quadrant is HASHLIFE_NONE, so a failure
+ * anywhere in building a node comes out at the top.
+ */
+static uint32_t find_node(hashlife_t *hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t h, i;
+    hashlife_node_t *n;
+
+    if (nw == HASHLIFE_NONE || ne == HASHLIFE_NONE || sw == HASHLIFE_NONE || se == HASHLIFE_NONE) {
+        return HASHLIFE_NONE;
+    }
+    h = hash4(nw, ne, sw, se);
+    i = hl->buckets[h & (hl->num_buckets-1)];
+    for (; i != HASHLIFE_NONE; i = hl->nodes[i].next) {
+        n = &hl->nodes[i];
+        if (n->child[NW] == nw && n->child[NE] == ne && n->child[SW] == sw && n->child[SE] == se) {
+            return i;
+        }
+    }
+
+    i = alloc_node(hl);
+    if (i == HASHLIFE_NONE) {
+        return HASHLIFE_NONE;
+    }
+    n = &hl->nodes[i];
+    n->child[NW] = nw;
+    n->child[NE] = ne;
+    n->child[SW] = sw;
+    n->child[SE] = se;
+    n->result = HASHLIFE_NONE;
+    n->level = hl->nodes[nw].level + 1;
+    n->mark = 0;
+    n->population = hl->nodes[nw].population + hl->nodes[ne].population +
+        hl->nodes[sw].population + hl->nodes[se].population;
+    n->next = hl->buckets[h & (hl->num_buckets-1)];
+    hl->buckets[h & (hl->num_buckets-1)] = i;
+    hl->live++;
+    if (hl->live > hl->num_buckets) {
+        rehash(hl, hl->num_buckets*2);
+    }
+    return i;
+}
+
+#define Q(i, q) (hl->nodes[i].child[q])
+
+static void init_step4x4(hashlife_t *hl) {
+    int bits, x, y;
+    /* Bit y*4+x of the index is cell (x, y) */
+    for (bits=0; bits<(1 << 16); ++bits) {
+        int out = 0;
+        for (y=1; y<3; ++y) {
+            for (x=1; x<3; ++x) {
+                int dx, dy, n = 0;
+                for (dy=-1; dy<=1; ++dy) {
+                    for (dx=-1; dx<=1; ++dx) {
+                        if (dx || dy) {
+                            n += (bits >> ((y+dy)*4 + x+dx)) & 1;
+                        }
+                    }
+                }
+                if (n == 3 || (n == 2 && ((bits >> (y*4 + x)) & 1))) {
+                    out |= 1 << ((y-1)*2 + (x-1));
+                }
+            }
+        }
+        hl->step4x4[bits] = (uint8_t)out;
+    }
+}
+
+int hashlife_init(hashlife_t *hl, size_t max_nodes) {
+    int level;
+
+    hl->capacity = 1 << 16;
+    hl->nodes = malloc(sizeof(hashlife_node_t)*hl->capacity);
+    hl->num_buckets = 1 << 16;
+    hl->buckets = malloc(sizeof(uint32_t)*hl->num_buckets);
+    if (hl->nodes == NULL || hl->buckets == NULL) {
+        free(hl->nodes);
+        free(hl->buckets);
+        return 1;
+    }
+    memset(hl->buckets, 0xFF, sizeof(uint32_t)*hl->num_buckets);
+    hl->max_nodes = max_nodes ? max_nodes : HASHLIFE_DEFAULT_NODES;
+    hl->free_list = HASHLIFE_NONE;
+    hl->live = 0;
+    hl->step_log = -1;
+    hl->generation = 0;
+
+    /* Nodes 0 and 1 are a dead and a live cell */
+    memset(hl->nodes, 0, sizeof(hashlife_node_t)*2);
+    hl->nodes[0].result = hl->nodes[1].result = HASHLIFE_NONE;
+    hl->nodes[1].population = 1;
+    hl->num_nodes = 2;
+
+    hl->empty[0] = 0;
+    for (level=1; level<=HASHLIFE_MAX_LEVEL; ++level) {
+        uint32_t e = hl->empty[level-1];
+        hl->empty[level] = find_node(hl, e, e, e, e);
+        if (hl->empty[level] == HASHLIFE_NONE) {
+            hashlife_free(hl);
+            return 1;
+        }
+    }
+    hl->root = hl->empty[3];
+    init_step4x4(hl);
+    return 0;
+}
+
+void hashlife_free(hashlife_t *hl) {
+    free(hl->nodes);
+    free(hl->buckets);
+    hl->nodes = NULL;
+    hl->buckets = NULL;
+    hl->num_nodes = hl->capacity = hl->live = 0;
+}
+
+/* The same pattern in a node twice the size, with empty space all round */
+static uint32_t expand(hashlife_t *hl, uint32_t n) {
+    uint32_t e = hl->empty[hl->nodes[n].level-1];
+    uint32_t nw = find_node(hl, e, e, e, Q(n, NW));
+    uint32_t ne = find_node(hl, e, e, Q(n, NE), e);
+    uint32_t sw = find_node(hl, e, Q(n, SW), e, e);
+    uint32_t se = find_node(hl, Q(n, SE), e, e, e);
+    return find_node(hl, nw, ne, sw, se);
+}
+
+static int64_t half_size(const hashlife_t *hl) {
+    return (int64_t)1 << (hl->nodes[hl->root].level - 1);
+}
+
+/* Whether everything alive is in the centre quarter of the root */
+static int padded(const hashlife_t *hl) {
+    uint32_t r = hl->root;
+    if (hl->nodes[r].level < 3) {
+        return hl->nodes[r].population == 0;
+    }
+    return hl->nodes[Q(r, NW)].population == hl->nodes[Q(Q(Q(r, NW), SE), SE)].population &&
+        hl->nodes[Q(r, NE)].population == hl->nodes[Q(Q(Q(r, NE), SW), SW)].population &&
+        hl->nodes[Q(r, SW)].population == hl->nodes[Q(Q(Q(r, SW), NE), NE)].population &&
+        hl->nodes[Q(r, SE)].population == hl->nodes[Q(Q(Q(r, SE), NW), NW)].population;
+}
+
+static uint32_t set_rec(hashlife_t *hl, uint32_t n, int level, uint64_t x, uint64_t y, int alive) {
+    uint64_t half;
+    int q;
+    uint32_t c[4];
+
+    if (level == 0) {
+        return alive ? 1 : 0;
+    }
+    half = (uint64_t)1 << (level-1);
+    q = (y >= half)*2 + (x >= half);
+    memcpy(c, hl->nodes[n].child, sizeof(c));
+    c[q] = set_rec(hl, c[q], level-1, x & (half-1), y & (half-1), alive);
+    return find_node(hl, c[NW], c[NE], c[SW], c[SE]);
+}
+
+int hashlife_set_cell(hashlife_t *hl, int64_t x, int64_t y, int alive) {
+    uint32_t root;
+    while (x < -half_size(hl) || x >= half_size(hl) || y < -half_size(hl) || y >= half_size(hl)) {
+        root = expand(hl, hl->root);
+        if (root == HASHLIFE_NONE) {
+            return out_of_memory(hl);
+        }
+        hl->root = root;
+    }
+    root = set_rec(hl, hl->root, hl->nodes[hl->root].level,
+                   (uint64_t)(x + half_size(hl)), (uint64_t)(y + half_size(hl)), alive);
+    if (root == HASHLIFE_NONE) {
+        return out_of_memory(hl);
+    }
+    hl->root = root;
+    return 0;
+}
+
+int hashlife_get_cell(const hashlife_t *hl, int64_t x, int64_t y) {
+    uint32_t n = hl->root;
+    int level = hl->nodes[n].level;
+    uint64_t ux, uy;
+
+    if (x < -half_size(hl) || x >= half_size(hl) || y < -half_size(hl) || y >= half_size(hl)) {
+        return 0;
+    }
+    ux = (uint64_t)(x + half_size(hl));
+    uy = (uint64_t)(y + half_size(hl));
+    while (level > 0 && hl->nodes[n].population > 0) {
+        uint64_t half = (uint64_t)1 << (level-1);
+        n = Q(n, (uy & half ? 2 : 0) + (ux & half ? 1 : 0));
+        --level;
+    }
+    return n == 1;
+}
+
+int hashlife_load(hashlife_t *hl, const life_board_t *board, int64_t x0, int64_t y0) {
+    size_t y, w;
+    if (hl->live > hl->max_nodes) {
+        hashlife_gc(hl);
+    }
+    for (y=0; y<board->height; ++y) {
+        const uint64_t *row = life_board_row(board, y);
+        for (w=0; w<board->words; ++w) {
+            uint64_t bits = row[w];
+            while (bits) {
+                int b = __builtin_ctzll(bits);
+                if (hashlife_set_cell(hl, x0 + (int64_t)(w*64 + b), y0 + (int64_t)y, 1)) {
+                    return 1;
+                }
+                bits &= bits - 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* The centre 2^(k-1) of a level k node, now */
+static uint32_t centre(hashlife_t *hl, uint32_t n) {
+    return find_node(hl, Q(Q(n, NW), SE), Q(Q(n, NE), SW), Q(Q(n, SW), NE), Q(Q(n, SE), NW));
+}
+
+/* The level k-1 square straddling two side by side, or stacked, level k-1 nodes */
+static uint32_t between_we(hashlife_t *hl, uint32_t w, uint32_t e) {
+    return find_node(hl, Q(w, NE), Q(e, NW), Q(w, SE), Q(e, SW));
+}
+
+static uint32_t between_ns(hashlife_t *hl, uint32_t n, uint32_t s) {
+    return find_node(hl, Q(n, SW), Q(n, SE), Q(s, NW), Q(s, NE));
+}
+
+static uint32_t result_4x4(hashlife_t *hl, uint32_t n) {
+    int bits = 0, q, c;
+    uint8_t out;
+    for (q=0; q<4; ++q) {
+        uint32_t quad = Q(n, q);
+        for (c=0; c<4; ++c) {
+            int x = (q & 1)*2 + (c & 1);
+            int y = (q >> 1)*2 + (c >> 1);
+            bits |= (int)Q(quad, c) << (y*4 + x);
+        }
+    }
+    out = hl->step4x4[bits];
+    return find_node(hl, out & 1, (out >> 1) & 1, (out >> 2) & 1, (out >> 3) & 1);
+}
+
+/*
+ * The centre half of n, 2^min(level-2, step_log) generations on.  The
+ * nine overlapping level-1 squares are either stepped (at full speed) or
+ * just cut down to their centres (once the step is shorter than this
+ * level could take), and the four squares made from those are stepped.
+ */
+static uint32_t result(hashlife_t *hl, uint32_t n) {
+    int level;
+    uint32_t sub[9], r[9];
+    uint32_t res;
+    int i;
+
+    if (n == HASHLIFE_NONE) {
+        return HASHLIFE_NONE;
+    }
+    level = hl->nodes[n].level;
+    if (hl->nodes[n].result != HASHLIFE_NONE) {
+        return hl->nodes[n].result;
+    }
+    if (hl->nodes[n].population == 0) {
+        res = hl->empty[level-1];
+    } else if (level == 2) {
+        res = result_4x4(hl, n);
+    } else {
+        sub[0] = Q(n, NW);
+        sub[1] = between_we(hl, Q(n, NW), Q(n, NE));
+        sub[2] = Q(n, NE);
+        sub[3] = between_ns(hl, Q(n, NW), Q(n, SW));
+        sub[4] = centre(hl, n);
+        sub[5] = between_ns(hl, Q(n, NE), Q(n, SE));
+        sub[6] = Q(n, SW);
+        sub[7] = between_we(hl, Q(n, SW), Q(n, SE));
+        sub[8] = Q(n, SE);
+        if (sub[1] == HASHLIFE_NONE || sub[3] == HASHLIFE_NONE || sub[4] == HASHLIFE_NONE ||
+            sub[5] == HASHLIFE_NONE || sub[7] == HASHLIFE_NONE) {
+            return HASHLIFE_NONE;
+        }
+        for (i=0; i<9; ++i) {
+            r[i] = (level-2 <= hl->step_log) ? result(hl, sub[i]) : centre(hl, sub[i]);
+        }
+        res = find_node(hl,
+                        result(hl, find_node(hl, r[0], r[1], r[3], r[4])),
+                        result(hl, find_node(hl, r[1], r[2], r[4], r[5])),
+                        result(hl, find_node(hl, r[3], r[4], r[6], r[7])),
+                        result(hl, find_node(hl, r[4], r[5], r[7], r[8])));
+        if (res == HASHLIFE_NONE) {
+            return HASHLIFE_NONE;
+        }
+    }
+    hl->nodes[n].result = res;
+    return res;
+}
+
+int hashlife_advance(hashlife_t *hl, int log2_gens) {
+    uint32_t i, root;
+
+    if (hl->live > hl->max_nodes) {
+        hashlife_gc(hl);
+    }
+    if (hl->step_log != log2_gens) {
+        for (i=0; i<hl->num_nodes; ++i) {
+            hl->nodes[i].result = HASHLIFE_NONE;
+        }
+        hl->step_log = log2_gens;
+    }
+    /* Room for the pattern to grow 2^log2_gens cells every way */
+    while (hl->nodes[hl->root].level < log2_gens + 3 || !padded(hl)) {
+        root = expand(hl, hl->root);
+        if (root == HASHLIFE_NONE) {
+            return out_of_memory(hl);
+        }
+        hl->root = root;
+    }
+    root = result(hl, hl->root);
+    if (root == HASHLIFE_NONE) {
+        return out_of_memory(hl);
+    }
+    hl->root = root;
+    hl->generation += (uint64_t)1 << log2_gens;
+    return 0;
+}
+
+int hashlife_advance_by(hashlife_t *hl, uint64_t gens) {
+    int k;
+    for (k=0; gens != 0; ++k, gens >>= 1) {
+        if ((gens & 1) && hashlife_advance(hl, k)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void extract_rec(const hashlife_t *hl, uint32_t n, int level, int64_t nx, int64_t ny,
+                        life_board_t *board, int64_t x0, int64_t y0) {
+    int64_t size = (int64_t)1 << level;
+    int64_t half = size/2;
+
+    if (hl->nodes[n].population == 0 ||
+        nx >= x0 + (int64_t)board->width || nx + size <= x0 ||
+        ny >= y0 + (int64_t)board->height || ny + size <= y0) {
+        return;
+    }
+    if (level == 0) {
+        life_board_set(board, (size_t)(nx - x0), (size_t)(ny - y0), 1);
+        return;
+    }
+    extract_rec(hl, Q(n, NW), level-1, nx, ny, board, x0, y0);
+    extract_rec(hl, Q(n, NE), level-1, nx + half, ny, board, x0, y0);
+    extract_rec(hl, Q(n, SW), level-1, nx, ny + half, board, x0, y0);
+    extract_rec(hl, Q(n, SE), level-1, nx + half, ny + half, board, x0, y0);
+}
+
+void hashlife_extract(const hashlife_t *hl, life_board_t *board, int64_t x0, int64_t y0) {
+    life_board_clear(board);
+    extract_rec(hl, hl->root, hl->nodes[hl->root].level, -half_size(hl), -half_size(hl),
+                board, x0, y0);
+}
+
+uint64_t hashlife_population(const hashlife_t *hl) {
+    return hl->nodes[hl->root].population;
+}
+
+static void mark(hashlife_t *hl, uint32_t n) {
+    int q;
+    if (n < 2 || hl->nodes[n].mark) {
+        return;
+    }
+    hl->nodes[n].mark = 1;
+    for (q=0; q<4; ++q) {
+        mark(hl, hl->nodes[n].child[q]);
+    }
+}
+
+void hashlife_gc(hashlife_t *hl) {
+    uint32_t i;
+    int level;
+
+    mark(hl, hl->root);
+    for (level=1; level<=HASHLIFE_MAX_LEVEL; ++level) {
+        mark(hl, hl->empty[level]);
+    }
+    for (i=2; i<hl->num_nodes; ++i) {
+        hashlife_node_t *n = &hl->nodes[i];
+        if (n->level == FREE_LEVEL) {
+            continue;
+        }
+        if (!n->mark) {
+            n->level = FREE_LEVEL;
+            n->next = hl->free_list;
+            hl->free_list = i;
+            hl->live--;
+        }
+    }
+    for (i=2; i<hl->num_nodes; ++i) {
+        hashlife_node_t *n = &hl->nodes[i];
+        if (n->level == FREE_LEVEL) {
+            continue;
+        }
+        /* A RESULT that was collected has to be worked out again */
+        if (n->result != HASHLIFE_NONE && n->result >= 2 && !hl->nodes[n->result].mark) {
+            n->result = HASHLIFE_NONE;
+        }
+    }
+    /* Only once every RESULT has been checked, or a live one looks collected */
+    for (i=2; i<hl->num_nodes; ++i) {
+        hl->nodes[i].mark = 0;
+    }
+    rehash(hl, hl->num_buckets);
+}
@@ -0,0 +1,107 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Gosper's Hashlife, for jumping a Life pattern thousands or millions of
+ * generations ahead.
+ *
+ * The universe is a quadtree.  A level k node is a 2^k square made of
+ * four level k-1 quadrants, and nodes are hash-consed: there is only one
+ * node for any given content, so the repeated blocks of a pattern (and
+ * all the empty space) cost one node each.  Each node also remembers its
+ * RESULT, its centre 2^(k-1) square some generations on.  A repeat of
+ * the same content anywhere, at any time, is then a lookup instead of a
+ * recomputation, and a step of 2^k generations costs about the same as
+ * a step of one.
+ *
+ * Unlike life_board_t this is the unbounded plane, not a torus.  What it
+ * gives for a window matches life_evolve() on a board only as long as the
+ * pattern hasn't reached the board's edges.  It only runs Conway's rule,
+ * whatever the board's (see life_rule.h).
+ *
+ * Nodes are garbage collected (mark and sweep from the root) whenever
+ * there are more than max_nodes of them at the start of a step, which
+ * also drops the RESULTs of everything that went.  A single big step can
+ * still go over the limit while it runs.  If memory runs out, the call
+ * that needed the nodes returns 1 and the universe is left as it was
+ * before that cell, or that step; hashlife_gc() may then make room.
+ */
+typedef struct hashlife_node_s {
+    /* nw, ne, sw, se; for level 1 these are cells, 0 or 1 */
+    uint32_t child[4];
+    /* HASHLIFE_NONE until worked out for the current step size */
+    uint32_t result;
+    /* Next node in the same hash bucket, or on the free list */
+    uint32_t next;
+    uint64_t population;
+    uint8_t level;
+    uint8_t mark;
+} hashlife_node_t;
+
+#define HASHLIFE_NONE 0xFFFFFFFFu
+#define HASHLIFE_MAX_LEVEL 62
+#define HASHLIFE_DEFAULT_NODES ((size_t)1 << 22)
+
+typedef struct hashlife_s {
+    hashlife_node_t *nodes;
+    uint32_t num_nodes;
+    uint32_t capacity;
+    uint32_t live;
+    uint32_t free_list;
+    uint32_t *buckets;
+    uint32_t num_buckets;
+    size_t max_nodes;
+    /* The all dead node of each level */
+    uint32_t empty[HASHLIFE_MAX_LEVEL+1];
+    /* Covers [-2^(level-1), 2^(level-1)) in x and y */
+    uint32_t root;
+    /* log2 of the step the stored RESULTs are for, -1 for none yet */
+    int step_log;
+    uint64_t generation;
+    /* A 4x4 block's (16 bits) centre 2x2 one generation on */
+    uint8_t step4x4[1 << 16];
+} hashlife_t;
+
+/* An empty universe at generation 0; max_nodes 0 means HASHLIFE_DEFAULT_NODES */
+int hashlife_init(hashlife_t *hl, size_t max_nodes);
+void hashlife_free(hashlife_t *hl);
+
+/*
+ * Turns on the universe's cells at (x0+x, y0+y) for the board's live (x, y).
+ * Returns 0 on success.
+ */
+int hashlife_load(hashlife_t *hl, const life_board_t *board, int64_t x0, int64_t y0);
+
+/* Returns 0 on success */
+int hashlife_set_cell(hashlife_t *hl, int64_t x, int64_t y, int alive);
+int hashlife_get_cell(const hashlife_t *hl, int64_t x, int64_t y);
+
+/* Steps 2^log2_gens generations at once; returns 0 on success */
+int hashlife_advance(hashlife_t *hl, int log2_gens);
+
+/*
+ * Steps gens generations, as the binary digits of gens worth of jumps.
+ * Returns 0 on success; on failure generation says how far it got.
+ */
+int hashlife_advance_by(hashlife_t *hl, uint64_t gens);
+
+/* The board's cell (x, y) becomes the universe's (x0+x, y0+y), for any board size */
+void hashlife_extract(const hashlife_t *hl, life_board_t *board, int64_t x0, int64_t y0);
+
+uint64_t hashlife_population(const hashlife_t *hl);
+void hashlife_gc(hashlife_t *hl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+#include "image_io.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+int image_alloc(image_t *img, size_t width, size_t height, size_t channels) {
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->pixels = NULL;
+    /* The sizes can come from a file, so the product mustn't wrap */
+    if (height != 0 && channels != 0 && width > SIZE_MAX/height/channels) {
+        return 1;
+    }
+    img->pixels = calloc(width*height*channels, 1);
+    return img->pixels == NULL;
+}
+
+void image_free(image_t *img) {
+    free(img->pixels);
+    img->pixels = NULL;
+    img->width = 0;
+    img->height = 0;
+    img->channels = 0;
+}
+
+/* TIFF tags we care about */
+enum {
+    TAG_WIDTH = 256,
+    TAG_HEIGHT = 257,
+    TAG_BITS = 258,
+    TAG_COMPRESSION = 259,
+    TAG_PHOTOMETRIC = 262,
+    TAG_STRIP_OFFSETS = 273,
+    TAG_SAMPLES = 277,
+    TAG_ROWS_PER_STRIP = 278,
+    TAG_STRIP_COUNTS = 279,
+    TAG_PLANAR = 284,
+    TAG_EXTRA_SAMPLES = 338
+};
+
+typedef struct tiff_reader_s {
+    uint8_t *data;
+    size_t size;
+    int big_endian;
+} tiff_reader_t;
+
+static uint32_t rd16(const tiff_reader_t *tr, size_t off) {
+    const uint8_t *p = tr->data + off;
+    if (off+2 > tr->size) return 0;
+    return tr->big_endian ? (uint32_t)(p[0]<<8 | p[1]) : (uint32_t)(p[1]<<8 | p[0]);
+}
+
+static uint32_t rd32(const tiff_reader_t *tr, size_t off) {
+    const uint8_t *p = tr->data + off;
+    if (off+4 > tr->size) return 0;
+    if (tr->big_endian) {
+        return (uint32_t)p[0]<<24 | (uint32_t)p[1]<<16 | (uint32_t)p[2]<<8 | p[3];
+    }
+    return (uint32_t)p[3]<<24 | (uint32_t)p[2]<<16 | (uint32_t)p[1]<<8 | p[0];
+}
+
+/* Value i of an IFD entry, SHORT or LONG, stored inline or at an offset */
+static uint32_t tag_value(const tiff_reader_t *tr, size_t entry, uint32_t i) {
+    uint32_t type = rd16(tr, entry+2);
+    uint32_t count = rd32(tr, entry+4);
+    size_t sz = (type == 3) ? 2 : 4;
+    size_t off = (count*sz <= 4) ? entry+8 : rd32(tr, entry+8);
+    return (type == 3) ? rd16(tr, off + i*sz) : rd32(tr, off + i*sz);
+}
+
+int image_read_tiff(const char *fname, image_t *img) {
+    tiff_reader_t tr;
+    FILE *inf = fopen(fname, "rb");
+    size_t ifd, num_entries, i;
+    uint32_t width = 0, height = 0, bits = 8, compression = 1, samples = 1;
+    uint32_t rows_per_strip = 0, planar = 1;
+    size_t offsets_entry = 0, nstrips = 0;
+    size_t row_bytes, row, strip;
+
+    if (inf == NULL) {
+        printf("Could not open \"%s\"\n", fname);
+        return 1;
+    }
+    fseek(inf, 0, SEEK_END);
+    if (ftell(inf) < 8) {
+        printf("\"%s\" is not a TIFF file\n", fname);
+        fclose(inf);
+        return 1;
+    }
+    tr.size = ftell(inf);
+    rewind(inf);
+    tr.data = malloc(tr.size);
+    if (tr.data == NULL) {
+        printf("Could not allocate %lu bytes to read \"%s\"\n", (unsigned long)tr.size, fname);
+        fclose(inf);
+        return 1;
+    }
+    if (fread(tr.data, 1, tr.size, inf) != tr.size) {
+        printf("Could not read \"%s\"\n", fname);
+        fclose(inf);
+        free(tr.data);
+        return 1;
+    }
+    fclose(inf);
+
+    if (!((tr.data[0] == 'I' && tr.data[1] == 'I') ||
+                         (tr.data[0] == 'M' && tr.data[1] == 'M'))) {
+        printf("\"%s\" is not a TIFF file\n", fname);
+        free(tr.data);
+        return 1;
+    }
+    tr.big_endian = (tr.data[0] == 'M');
+
+    ifd = rd32(&tr, 4);
+    num_entries = rd16(&tr, ifd);
+    for (i=0; i<num_entries; ++i) {
+        size_t entry = ifd + 2 + 12*i;
+        switch (rd16(&tr, entry)) {
+        case TAG_WIDTH: width = tag_value(&tr, entry, 0); break;
+        case TAG_HEIGHT: height = tag_value(&tr, entry, 0); break;
+        case TAG_BITS: bits = tag_value(&tr, entry, 0); break;
+        case TAG_COMPRESSION: compression = tag_value(&tr, entry, 0); break;
+        case TAG_SAMPLES: samples = tag_value(&tr, entry, 0); break;
+        case TAG_ROWS_PER_STRIP: rows_per_strip = tag_value(&tr, entry, 0); break;
+        case TAG_PLANAR: planar = tag_value(&tr, entry, 0); break;
+        case TAG_STRIP_OFFSETS:
+            offsets_entry = entry;
+            nstrips = rd32(&tr, entry+4);
+            break;
+        default:
+            break;
+        }
+    }
+    if (bits != 8 || compression != 1 || planar != 1 || offsets_entry == 0) {
+        printf("\"%s\" must be an uncompressed 8 bit chunky TIFF "
+               "(bits %u, compression %u, planar %u)\n", fname, bits, compression, planar);
+        free(tr.data);
+        return 1;
+    }
+    if (rows_per_strip == 0 || rows_per_strip > height) {
+        rows_per_strip = height;
+    }
+
+    if (width == 0 || height == 0 || samples == 0) {
+        printf("\"%s\" has no pixels (%ux%u, %u samples)\n", fname, width, height, samples);
+        free(tr.data);
+        return 1;
+    }
+    if (image_alloc(img, width, height, samples)) {
+        printf("Could not allocate a %ux%u image of %u samples for \"%s\"\n",
+               width, height, samples, fname);
+        free(tr.data);
+        return 1;
+    }
+    row_bytes = (size_t)width*samples;
+    for (row=0; row<height; ++row) {
+        size_t src;
+        strip = row/rows_per_strip;
+        if (strip >= nstrips) break;
+        src = tag_value(&tr, offsets_entry, strip) + (row%rows_per_strip)*row_bytes;
+        if (src + row_bytes > tr.size) {
+            printf("\"%s\" is truncated\n", fname);
+            image_free(img);
+            free(tr.data);
+            return 1;
+        }
+        memcpy(img->pixels + row*row_bytes, tr.data + src, row_bytes);
+    }
+    free(tr.data);
+    return 0;
+}
+
+static void wr16(FILE *outf, uint32_t v) {
+    fputc(v & 0xff, outf);
+    fputc((v>>8) & 0xff, outf);
+}
+
+static void wr32(FILE *outf, uint32_t v) {
+    wr16(outf, v & 0xffff);
+    wr16(outf, v >> 16);
+}
+
+static void wr_entry(FILE *outf, uint32_t tag, uint32_t type, uint32_t count, uint32_t value) {
+    wr16(outf, tag);
+    wr16(outf, type);
+    wr32(outf, count);
+    if (type == 3 && count == 1) {
+        wr16(outf, value);
+        wr16(outf, 0);
+    } else {
+        wr32(outf, value);
+    }
+}
+
+int image_write_tiff(const char *fname, const image_t *img) {
+    FILE *outf = fopen(fname, "wb");
+    const uint32_t num_entries = (img->channels == 4) ? 11 : 10;
+    const uint32_t ifd = 8;
+    const uint32_t bits_off = ifd + 2 + 12*num_entries + 4;
+    const uint32_t pix_off = bits_off + 2*(uint32_t)img->channels;
+    size_t i;
+
+    if (outf == NULL) {
+        printf("Could not open \"%s\" for writing\n", fname);
+        return 1;
+    }
+    fputs("II", outf);
+    wr16(outf, 42);
+    wr32(outf, ifd);
+
+    wr16(outf, num_entries);
+    wr_entry(outf, TAG_WIDTH, 4, 1, (uint32_t)img->width);
+    wr_entry(outf, TAG_HEIGHT, 4, 1, (uint32_t)img->height);
+    if (img->channels == 1) {
+        wr_entry(outf, TAG_BITS, 3, 1, 8);
+    } else {
+        wr_entry(outf, TAG_BITS, 3, (uint32_t)img->channels, bits_off);
+    }
+    wr_entry(outf, TAG_COMPRESSION, 3, 1, 1);
+    wr_entry(outf, TAG_PHOTOMETRIC, 3, 1, img->channels >= 3 ? 2 : 1);
+    wr_entry(outf, TAG_STRIP_OFFSETS, 4, 1, pix_off);
+    wr_entry(outf, TAG_SAMPLES, 3, 1, (uint32_t)img->channels);
+    wr_entry(outf, TAG_ROWS_PER_STRIP, 4, 1, (uint32_t)img->height);
+    wr_entry(outf, TAG_STRIP_COUNTS, 4, 1, (uint32_t)(img->width*img->height*img->channels));
+    wr_entry(outf, TAG_PLANAR, 3, 1, 1);
+    if (img->channels == 4) {
+        /* Associated (premultiplied) alpha */
+        wr_entry(outf, TAG_EXTRA_SAMPLES, 3, 1, 1);
+    }
+    wr32(outf, 0);
+
+    for (i=0; i<img->channels; ++i) {
+        wr16(outf, 8);
+    }
+    fwrite(img->pixels, 1, img->width*img->height*img->channels, outf);
+    fclose(outf);
+    return 0;
+}
+
+#ifdef HAVE_JPEG
+int image_write_jpeg(const char *fname, const image_t *img, int quality) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    FILE *outf = fopen(fname, "wb");
+    uint8_t *row;
+    size_t i, j, k;
+
+    if (outf == NULL) {
+        printf("Could not open \"%s\" for writing\n", fname);
+        return 1;
+    }
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, outf);
+    cinfo.image_width = img->width;
+    cinfo.image_height = img->height;
+    cinfo.input_components = img->channels >= 3 ? 3 : 1;
+    cinfo.in_color_space = img->channels >= 3 ? JCS_RGB : JCS_GRAYSCALE;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    row = malloc(img->width*cinfo.input_components);
+    for (j=0; j<img->height; ++j) {
+        const uint8_t *src = img->pixels + j*img->width*img->channels;
+        for (i=0; i<img->width; ++i) {
+            for (k=0; k<(size_t)cinfo.input_components; ++k) {
+                row[i*cinfo.input_components + k] = src[i*img->channels + k];
+            }
+        }
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    free(row);
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(outf);
+    return 0;
+}
+#else
+int image_write_jpeg(const char *fname, const image_t *img, int quality) {
+    printf("Can't write \"%s\", built without libjpeg\n", fname);
+    return 1;
+}
+#endif
+
+int image_write(const char *fname, const image_t *img) {
+    const char *ext = strrchr(fname, '.');
+    if (ext != NULL && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)) {
+        return image_write_jpeg(fname, img, 95);
+    }
+    return image_write_tiff(fname, img);
+}
@@ -0,0 +1,40 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An 8 bit per channel, chunky (RGBRGB... or RGBARGBA...) image. */
+typedef struct image_s {
+    size_t width;
+    size_t height;
+    size_t channels;
+    uint8_t *pixels;
+} image_t;
+
+int image_alloc(image_t *img, size_t width, size_t height, size_t channels);
+void image_free(image_t *img);
+
+/*
+ * Reads an uncompressed, 8 bit, chunky TIFF, which is what the renderer
+ * writes with "string compression" "none".  Returns 0 on success.
+ */
+int image_read_tiff(const char *fname, image_t *img);
+
+int image_write_tiff(const char *fname, const image_t *img);
+
+/* Only available when built with libjpeg (HAVE_JPEG).  Alpha is dropped. */
+int image_write_jpeg(const char *fname, const image_t *img, int quality);
+
+/* Picks the writer from the file extension: .jpg/.jpeg or TIFF otherwise. */
+int image_write(const char *fname, const image_t *img);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
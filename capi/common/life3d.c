@@ -0,0 +1,686 @@
+#include "life3d.h"
+#include "life_kernels.h"
+#include "rng.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LIFE3D_WORKERS 256
+/* Slabs per thread, so threads that finish early have some to steal */
+#define LIFE3D_SLABS_PER_THREAD 4
+
+void life3d_rule_init(life3d_rule_t *rule, uint32_t birth, uint32_t survive) {
+    int total;
+
+    rule->birth = birth & 0x7FFFFFF;
+    rule->survive = survive & 0x7FFFFFF;
+    rule->num_totals = 0;
+    for (total=0; total<28; ++total) {
+        /* A dead cell's total is its neighbours, a live one's one more */
+        int when = ((rule->birth >> total) & 1 ? LIFE3D_IF_DEAD : 0) |
+                   (total > 0 && (rule->survive >> (total - 1)) & 1 ? LIFE3D_IF_ALIVE : 0);
+        if (when != 0) {
+            rule->totals[rule->num_totals] = (uint8_t)total;
+            rule->when[rule->num_totals] = (uint8_t)when;
+            rule->num_totals++;
+        }
+    }
+}
+
+/* A count of 0 to 26; returns where it ends, or NULL if there isn't one */
+static const char *read_count(const char *p, int *n) {
+    if (!isdigit((unsigned char)*p)) {
+        return NULL;
+    }
+    *n = 0;
+    while (isdigit((unsigned char)*p) && *n <= 26) {
+        *n = 10*(*n) + (*p++ - '0');
+    }
+    return *n <= 26 ? p : NULL;
+}
+
+static uint32_t range_bits(int lo, int hi) {
+    uint32_t bits = 0;
+    for (; lo<=hi; ++lo) {
+        bits |= (uint32_t)1 << lo;
+    }
+    return bits;
+}
+
+/* Counts like "4,6-8" up to the next '/' or the end; returns where they end, or NULL */
+static const char *read_counts(const char *p, uint32_t *counts) {
+    *counts = 0;
+    while (*p != '\0' && *p != '/') {
+        int lo, hi;
+        p = read_count(p, &lo);
+        if (p == NULL) {
+            return NULL;
+        }
+        hi = lo;
+        if (*p == '-' && ((p = read_count(p+1, &hi)) == NULL || hi < lo)) {
+            return NULL;
+        }
+        *counts |= range_bits(lo, hi);
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    return p;
+}
+
+/* Bays' E_l E_u F_l F_u, a digit each or comma separated; returns 0 on success */
+static int read_bays(const char *p, uint32_t *birth, uint32_t *survive) {
+    int n[4], i;
+    size_t len = strlen(p);
+
+    for (i=0; i<4; ++i) {
+        if (len == 4) {
+            if (!isdigit((unsigned char)p[i])) {
+                return 1;
+            }
+            n[i] = p[i] - '0';
+        } else {
+            if ((p = read_count(p, &n[i])) == NULL || *p != (i < 3 ? ',' : '\0')) {
+                return 1;
+            }
+            ++p;
+        }
+    }
+    if (n[0] > n[1] || n[2] > n[3]) {
+        return 1;
+    }
+    *survive = range_bits(n[0], n[1]);
+    *birth = range_bits(n[2], n[3]);
+    return 0;
+}
+
+int life3d_rule_parse(life3d_rule_t *rule, const char *text) {
+    const char *p = text;
+    uint32_t birth = 0, survive = 0;
+    int seen = 0;
+
+    if (*p != 'B' && *p != 'b' && *p != 'S' && *p != 's') {
+        if (read_bays(p, &birth, &survive)) {
+            printf("Unreadable 3D rule %s, expected E_l E_u F_l F_u or B<counts>/S<counts>\n", text);
+            return 1;
+        }
+        life3d_rule_init(rule, birth, survive);
+        return 0;
+    }
+    /* B and S sections, in either order */
+    while (p != NULL && *p != '\0') {
+        int which = (*p == 'B' || *p == 'b') ? 1 : (*p == 'S' || *p == 's') ? 2 : 0;
+        if (which == 0 || (seen & which)) {
+            p = NULL;
+            break;
+        }
+        seen |= which;
+        p = read_counts(p+1, which == 1 ? &birth : &survive);
+        if (p != NULL && *p == '/') {
+            ++p;
+        }
+    }
+    if (p == NULL || seen != 3) {
+        printf("Unreadable 3D rule %s, expected E_l E_u F_l F_u or B<counts>/S<counts>\n", text);
+        return 1;
+    }
+    life3d_rule_init(rule, birth, survive);
+    return 0;
+}
+
+/* The counts in bits as "4,6-8"; returns the end of what's written */
+static char *write_counts(char *p, uint32_t bits) {
+    int n = 0;
+    const char *sep = "";
+    while (n < 27) {
+        int lo;
+        if (!((bits >> n) & 1)) {
+            ++n;
+            continue;
+        }
+        for (lo=n; n<27 && ((bits >> n) & 1); ++n) {
+        }
+        p += sprintf(p, n - 1 > lo ? "%s%d-%d" : "%s%d", sep, lo, n - 1);
+        sep = ",";
+    }
+    return p;
+}
+
+char *life3d_rule_format(const life3d_rule_t *rule, char *buf) {
+    char *p = buf;
+    *p++ = 'B';
+    p = write_counts(p, rule->birth);
+    *p++ = '/';
+    *p++ = 'S';
+    p = write_counts(p, rule->survive);
+    *p = '\0';
+    return buf;
+}
+
+int life3d_init(life3d_t *grid, size_t width, size_t height, size_t depth) {
+    size_t rows = height*depth;
+    grid->width = width;
+    grid->height = height;
+    grid->depth = depth;
+    grid->words = (width + 63)/64;
+    /* At least a word of padding, which evolve_layer() uses for the wrap around */
+    grid->stride = grid->words + 1;
+    grid->num_on = 0;
+    grid->cells = NULL;
+    if (width == 0 || rows == 0) {
+        return 1;
+    }
+    grid->cells = calloc(grid->stride*rows, sizeof(uint64_t));
+    if (grid->cells == NULL) {
+        return 1;
+    }
+    /* Survive with 4 or 5, born with 5 */
+    life3d_rule_init(&grid->rule, 0x20, 0x30);
+    return 0;
+}
+
+void life3d_free(life3d_t *grid) {
+    free(grid->cells);
+    grid->cells = NULL;
+    grid->num_on = 0;
+}
+
+void life3d_clear(life3d_t *grid) {
+    memset(grid->cells, 0, sizeof(uint64_t)*grid->stride*grid->height*grid->depth);
+    grid->num_on = 0;
+}
+
+void life3d_set(life3d_t *grid, size_t x, size_t y, size_t z, int alive) {
+    uint64_t *word = life3d_row(grid, y, z) + (x >> 6);
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if (((*word & bit) != 0) != (alive != 0)) {
+        *word ^= bit;
+        grid->num_on += alive ? 1 : (size_t)-1;
+    }
+}
+
+size_t life3d_count(life3d_t *grid) {
+    size_t rows = grid->height*grid->depth, r, w, n = 0;
+    for (r=0; r<rows; ++r) {
+        const uint64_t *row = grid->cells + r*grid->stride;
+        for (w=0; w<grid->words; ++w) {
+            n += life_popcount64(row[w]);
+        }
+    }
+    grid->num_on = n;
+    return n;
+}
+
+void life3d_random(life3d_t *grid, size_t size, double prob, uint64_t seed) {
+    size_t sx = size < grid->width ? size : grid->width;
+    size_t sy = size < grid->height ? size : grid->height;
+    size_t sz = size < grid->depth ? size : grid->depth;
+    size_t x0 = (grid->width - sx)/2, y0 = (grid->height - sy)/2, z0 = (grid->depth - sz)/2;
+    float r[256];
+    size_t x, y, z, i;
+
+    life3d_clear(grid);
+    for (z=0; z<sz; ++z) {
+        for (y=0; y<sy; ++y) {
+            uint64_t *row = life3d_row(grid, y0 + y, z0 + z);
+            for (x=0; x<sx; x+=256) {
+                size_t count = sx - x < 256 ? sx - x : 256;
+                /* One element per cell of the cube, so it doesn't depend on the grid */
+                rng_fill_float(seed, 0, (z*sy + y)*sx + x, r, count);
+                for (i=0; i<count; ++i) {
+                    size_t cx = x0 + x + i;
+                    row[cx >> 6] |= (uint64_t)(r[i] < prob) << (cx & 63);
+                }
+            }
+        }
+    }
+    life3d_count(grid);
+}
+
+/*
+ * The kernels work a run of words [first, end) of a layer.  The sum pass
+ * leaves, for each column x, how many of the nine rows around it have x
+ * alive, as 4 bit planes ps words apart; the next pass adds each plane
+ * word to itself shifted a cell either way, reading the words either side
+ * for the carries, matches the rule and keeps the bits in mask.
+ */
+
+/* The sum of the nine rows' words a[0..8], into v[0..3] (at most 9) */
+#define LIFE3D_SUM9(T, XOR, AND, XOR3, MAJ, a, v)                       \
+    {                                                                   \
+        T p0 = XOR3(a[0], a[1], a[2]), q0 = MAJ(a[0], a[1], a[2]);      \
+        T p1 = XOR3(a[3], a[4], a[5]), q1 = MAJ(a[3], a[4], a[5]);      \
+        T p2 = XOR3(a[6], a[7], a[8]), q2 = MAJ(a[6], a[7], a[8]);      \
+        T k1 = MAJ(p0, p1, p2), c1 = XOR3(q0, q1, q2), c2 = MAJ(q0, q1, q2); \
+        T k2 = AND(k1, c1);                                             \
+        v[0] = XOR3(p0, p1, p2);                                        \
+        v[1] = XOR(k1, c1);                                             \
+        v[2] = XOR(c2, k2);                                             \
+        v[3] = AND(c2, k2);                                             \
+    }
+
+/* The column sums west, centre and east added, into t[0..4] (at most 27) */
+#define LIFE3D_ADD3(T, XOR, AND, XOR3, MAJ, west, centre, east, t)      \
+    {                                                                   \
+        T s_[4], k_[4], c_;                                             \
+        int i_;                                                         \
+        for (i_=0; i_<4; ++i_) {                                        \
+            s_[i_] = XOR3(west[i_], centre[i_], east[i_]);              \
+            k_[i_] = MAJ(west[i_], centre[i_], east[i_]);               \
+        }                                                               \
+        t[0] = s_[0];                                                   \
+        t[1] = XOR(s_[1], k_[0]);                                       \
+        c_ = AND(s_[1], k_[0]);                                         \
+        t[2] = XOR3(s_[2], k_[1], c_);                                  \
+        c_ = MAJ(s_[2], k_[1], c_);                                     \
+        t[3] = XOR3(s_[3], k_[2], c_);                                  \
+        c_ = MAJ(s_[3], k_[2], c_);                                     \
+        t[4] = XOR(k_[3], c_);                                          \
+    }
+
+/*
+ * The next state of cells c, whose 3x3x3 totals are t[0..4], under rule:
+ * each total the rule lists is matched bit plane by bit plane, and ORed
+ * in for the cells (dead, alive or either) it keeps alive.
+ */
+#define LIFE3D_RULE(T, AND, OR, ANDN, ones, zero, rule, t, c, next)     \
+    {                                                                   \
+        T lit_[5][2], dead_ = ANDN(c, ones);                            \
+        int b_, i_;                                                     \
+        for (b_=0; b_<5; ++b_) {                                        \
+            lit_[b_][0] = ANDN(t[b_], ones);                            \
+            lit_[b_][1] = t[b_];                                        \
+        }                                                               \
+        next = zero;                                                    \
+        for (i_=0; i_<(rule).num_totals; ++i_) {                        \
+            int v_ = (rule).totals[i_];                                 \
+            T eq_ = AND(AND(AND(lit_[0][v_ & 1], lit_[1][(v_ >> 1) & 1]), \
+                            AND(lit_[2][(v_ >> 2) & 1], lit_[3][(v_ >> 3) & 1])), \
+                        lit_[4][v_ >> 4]);                              \
+            if ((rule).when[i_] == LIFE3D_IF_DEAD) {                    \
+                eq_ = AND(eq_, dead_);                                  \
+            } else if ((rule).when[i_] == LIFE3D_IF_ALIVE) {            \
+                eq_ = AND(eq_, c);                                      \
+            }                                                           \
+            next = OR(next, eq_);                                       \
+        }                                                               \
+    }
+
+typedef void (*sum_kernel_t)(const uint64_t *const *rows, uint64_t *planes, size_t ps,
+                             size_t first, size_t end);
+typedef size_t (*next_kernel_t)(const uint64_t *mid, const uint64_t *planes, size_t ps,
+                                const uint64_t *mask, uint64_t *out, size_t first, size_t end,
+                                const life3d_rule_t *rule);
+
+static void scalar_sum(const uint64_t *const *rows, uint64_t *planes, size_t ps,
+                       size_t first, size_t end) {
+    size_t w;
+    int k;
+    for (w=first; w<end; ++w) {
+        uint64_t a[9], v[4];
+        for (k=0; k<9; ++k) {
+            a[k] = rows[k][w];
+        }
+        LIFE3D_SUM9(uint64_t, LIFE_XOR, LIFE_AND, LIFE_XOR3, LIFE_MAJ, a, v);
+        for (k=0; k<4; ++k) {
+            planes[k*ps + w] = v[k];
+        }
+    }
+}
+
+static size_t scalar_next(const uint64_t *mid, const uint64_t *planes, size_t ps,
+                          const uint64_t *mask, uint64_t *out, size_t first, size_t end,
+                          const life3d_rule_t *rule) {
+    /* A copy, which the stores to out can't be writing over */
+    life3d_rule_t r = *rule;
+    size_t w, n = 0;
+    int k;
+    for (w=first; w<end; ++w) {
+        uint64_t west[4], centre[4], east[4], t[5], c = mid[w], next;
+        for (k=0; k<4; ++k) {
+            const uint64_t *p = planes + k*ps;
+            centre[k] = p[w];
+            west[k] = (p[w] << 1) | (p[w-1] >> 63);
+            east[k] = (p[w] >> 1) | (p[w+1] << 63);
+        }
+        LIFE3D_ADD3(uint64_t, LIFE_XOR, LIFE_AND, LIFE_XOR3, LIFE_MAJ, west, centre, east, t);
+        LIFE3D_RULE(uint64_t, LIFE_AND, LIFE_OR, LIFE_ANDN, ~(uint64_t)0, (uint64_t)0, r, t, c, next);
+        next &= mask[w];
+        out[w] = next;
+        n += life_popcount64(next);
+    }
+    return n;
+}
+
+#ifdef LIFE_X86_KERNELS
+
+__attribute__((target("sse2")))
+static void sse2_sum(const uint64_t *const *rows, uint64_t *planes, size_t ps,
+                     size_t first, size_t end) {
+    typedef __m128i T;
+    size_t w;
+    int k;
+    for (w=first; w+2<=end; w+=2) {
+        T a[9], v[4];
+        for (k=0; k<9; ++k) {
+            a[k] = SSE2_LOAD(rows[k] + w);
+        }
+        LIFE3D_SUM9(T, _mm_xor_si128, _mm_and_si128, SSE2_XOR3, SSE2_MAJ, a, v);
+        for (k=0; k<4; ++k) {
+            _mm_storeu_si128((__m128i *)(planes + k*ps + w), v[k]);
+        }
+    }
+    scalar_sum(rows, planes, ps, w, end);
+}
+
+__attribute__((target("sse2")))
+static size_t sse2_next(const uint64_t *mid, const uint64_t *planes, size_t ps,
+                        const uint64_t *mask, uint64_t *out, size_t first, size_t end,
+                        const life3d_rule_t *rule) {
+    typedef __m128i T;
+    life3d_rule_t r = *rule;
+    T acc = _mm_setzero_si128(), zero = _mm_setzero_si128(), ones = _mm_set1_epi64x(-1);
+    uint64_t lanes[2];
+    size_t w;
+    int k;
+    for (w=first; w+2<=end; w+=2) {
+        T west[4], centre[4], east[4], t[5], c = SSE2_LOAD(mid + w), next;
+        for (k=0; k<4; ++k) {
+            LIFE_LOAD_ROW(T, SSE2_LOAD, _mm_slli_epi64, _mm_srli_epi64, _mm_or_si128,
+                          planes + k*ps, w, west[k], centre[k], east[k]);
+        }
+        LIFE3D_ADD3(T, _mm_xor_si128, _mm_and_si128, SSE2_XOR3, SSE2_MAJ, west, centre, east, t);
+        LIFE3D_RULE(T, _mm_and_si128, _mm_or_si128, _mm_andnot_si128, ones, zero, r, t, c, next);
+        next = _mm_and_si128(next, SSE2_LOAD(mask + w));
+        _mm_storeu_si128((__m128i *)(out + w), next);
+        LIFE_POPCOUNT_VEC(acc, next, _mm_set1_epi64x, _mm_srli_epi64, _mm_and_si128,
+                          _mm_add_epi8, _mm_sub_epi8, _mm_sad_epu8, _mm_add_epi64, zero);
+    }
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + scalar_next(mid, planes, ps, mask, out, w, end, rule);
+}
+
+__attribute__((target("avx2")))
+static void avx2_sum(const uint64_t *const *rows, uint64_t *planes, size_t ps,
+                     size_t first, size_t end) {
+    typedef __m256i T;
+    size_t w;
+    int k;
+    for (w=first; w+4<=end; w+=4) {
+        T a[9], v[4];
+        for (k=0; k<9; ++k) {
+            a[k] = AVX2_LOAD(rows[k] + w);
+        }
+        LIFE3D_SUM9(T, _mm256_xor_si256, _mm256_and_si256, AVX2_XOR3, AVX2_MAJ, a, v);
+        for (k=0; k<4; ++k) {
+            _mm256_storeu_si256((__m256i *)(planes + k*ps + w), v[k]);
+        }
+    }
+    scalar_sum(rows, planes, ps, w, end);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_next(const uint64_t *mid, const uint64_t *planes, size_t ps,
+                        const uint64_t *mask, uint64_t *out, size_t first, size_t end,
+                        const life3d_rule_t *rule) {
+    typedef __m256i T;
+    life3d_rule_t r = *rule;
+    T acc = _mm256_setzero_si256(), zero = _mm256_setzero_si256(), ones = _mm256_set1_epi64x(-1);
+    uint64_t lanes[4];
+    size_t w;
+    int k;
+    for (w=first; w+4<=end; w+=4) {
+        T west[4], centre[4], east[4], t[5], c = AVX2_LOAD(mid + w), next;
+        for (k=0; k<4; ++k) {
+            LIFE_LOAD_ROW(T, AVX2_LOAD, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_or_si256,
+                          planes + k*ps, w, west[k], centre[k], east[k]);
+        }
+        LIFE3D_ADD3(T, _mm256_xor_si256, _mm256_and_si256, AVX2_XOR3, AVX2_MAJ,
+                    west, centre, east, t);
+        LIFE3D_RULE(T, _mm256_and_si256, _mm256_or_si256, _mm256_andnot_si256, ones, zero,
+                    r, t, c, next);
+        next = _mm256_and_si256(next, AVX2_LOAD(mask + w));
+        _mm256_storeu_si256((__m256i *)(out + w), next);
+        LIFE_POPCOUNT_VEC(acc, next, _mm256_set1_epi64x, _mm256_srli_epi64, _mm256_and_si256,
+                          _mm256_add_epi8, _mm256_sub_epi8, _mm256_sad_epu8, _mm256_add_epi64, zero);
+    }
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_next(mid, planes, ps, mask, out, w, end, rule);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_sum(const uint64_t *const *rows, uint64_t *planes, size_t ps,
+                       size_t first, size_t end) {
+    typedef __m512i T;
+    size_t w;
+    int k;
+    for (w=first; w+8<=end; w+=8) {
+        T a[9], v[4];
+        for (k=0; k<9; ++k) {
+            a[k] = AVX512_LOAD(rows[k] + w);
+        }
+        LIFE3D_SUM9(T, _mm512_xor_si512, _mm512_and_si512, AVX512_XOR3, AVX512_MAJ, a, v);
+        for (k=0; k<4; ++k) {
+            _mm512_storeu_si512((void *)(planes + k*ps + w), v[k]);
+        }
+    }
+    scalar_sum(rows, planes, ps, w, end);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t avx512_next(const uint64_t *mid, const uint64_t *planes, size_t ps,
+                          const uint64_t *mask, uint64_t *out, size_t first, size_t end,
+                          const life3d_rule_t *rule) {
+    typedef __m512i T;
+    life3d_rule_t r = *rule;
+    T acc = _mm512_setzero_si512(), zero = _mm512_setzero_si512(), ones = _mm512_set1_epi64(-1);
+    size_t w;
+    int k;
+    for (w=first; w+8<=end; w+=8) {
+        T west[4], centre[4], east[4], t[5], c = AVX512_LOAD(mid + w), next;
+        for (k=0; k<4; ++k) {
+            LIFE_LOAD_ROW(T, AVX512_LOAD, _mm512_slli_epi64, _mm512_srli_epi64, _mm512_or_si512,
+                          planes + k*ps, w, west[k], centre[k], east[k]);
+        }
+        LIFE3D_ADD3(T, _mm512_xor_si512, _mm512_and_si512, AVX512_XOR3, AVX512_MAJ,
+                    west, centre, east, t);
+        LIFE3D_RULE(T, _mm512_and_si512, _mm512_or_si512, _mm512_andnot_si512, ones, zero,
+                    r, t, c, next);
+        next = _mm512_and_si512(next, AVX512_LOAD(mask + w));
+        _mm512_storeu_si512((void *)(out + w), next);
+        LIFE_POPCOUNT_VEC(acc, next, _mm512_set1_epi64, _mm512_srli_epi64, _mm512_and_si512,
+                          _mm512_add_epi8, _mm512_sub_epi8, _mm512_sad_epu8, _mm512_add_epi64, zero);
+    }
+    return (size_t)_mm512_reduce_add_epi64(acc) + scalar_next(mid, planes, ps, mask, out, w, end, rule);
+}
+
+static const sum_kernel_t sum_kernels[LIFE_ISA_COUNT] = {
+    scalar_sum, sse2_sum, avx2_sum, avx512_sum
+};
+static const next_kernel_t next_kernels[LIFE_ISA_COUNT] = {
+    scalar_next, sse2_next, avx2_next, avx512_next
+};
+
+#else
+
+static const sum_kernel_t sum_kernels[LIFE_ISA_COUNT] = {scalar_sum, NULL, NULL, NULL};
+static const next_kernel_t next_kernels[LIFE_ISA_COUNT] = {scalar_next, NULL, NULL, NULL};
+
+#endif
+
+/* Words of the mask and of each of a layer's planes */
+static size_t layer_words(const life3d_t *grid) {
+    return grid->height*grid->stride;
+}
+
+/* Scratch for a layer: its four planes, each with a word either side */
+static size_t scratch_words(const life3d_t *grid) {
+    return 4*(layer_words(grid) + 2);
+}
+
+/* For a layer's words: the bits of each row in the grid, and none of the padding */
+static uint64_t *layer_mask(const life3d_t *grid) {
+    uint64_t tail = (grid->width & 63) ? ((uint64_t)1 << (grid->width & 63)) - 1 : ~(uint64_t)0;
+    uint64_t *mask = calloc(layer_words(grid), sizeof(uint64_t));
+    size_t y;
+    if (mask != NULL) {
+        for (y=0; y<grid->height; ++y) {
+            uint64_t *row = mask + y*grid->stride;
+            memset(row, 0xFF, sizeof(uint64_t)*(grid->words - 1));
+            row[grid->words - 1] = tail;
+        }
+    }
+    return mask;
+}
+
+/*
+ * Layer z of dst from src with isa's kernels; returns how many of its
+ * cells are alive.
+ *
+ * The layer's rows are worked as one run of words, padding and all, so
+ * the kernels get long runs even when rows are a few words.  Rows 1 to
+ * height-2 have their neighbours a stride either side, so they're summed
+ * in one go, and the two rows that wrap around in y on their own.  Then
+ * the wrap around in x: each row's last column sum goes in the top bit of
+ * the word before the row, and its first column's in the bit after its
+ * last, so every word takes its carries the same way.  That's the padding
+ * word at the end of the row before (init makes the stride more than the
+ * words), whose bottom bit can hold the other row's, or a guard word.
+ * The padding's results are masked off.
+ */
+static size_t evolve_layer(const life3d_t *src, life3d_t *dst, life_isa_t isa, size_t z,
+                           const uint64_t *mask, uint64_t *scratch) {
+    size_t h = src->height, d = src->depth, stride = src->stride, width = src->width;
+    size_t lw = layer_words(src), ps = lw + 2, y;
+    uint64_t *planes = scratch + 1;
+    const uint64_t *layers[3], *rows[9];
+    int dy, dz, k;
+
+    for (dz=-1; dz<=1; ++dz) {
+        layers[dz+1] = life3d_row(src, 0, (z + d + dz) % d);
+    }
+    if (h > 2) {
+        for (k=0, dz=0; dz<3; ++dz) {
+            for (dy=0; dy<3; ++dy) {
+                rows[k++] = layers[dz] + dy*stride;
+            }
+        }
+        sum_kernels[isa](rows, planes + stride, ps, 0, (h-2)*stride);
+    }
+    for (y=0; y<h; y += (h > 1 ? h-1 : 1)) {
+        for (k=0, dz=0; dz<3; ++dz) {
+            for (dy=-1; dy<=1; ++dy) {
+                rows[k++] = layers[dz] + ((y + h + dy) % h)*stride;
+            }
+        }
+        sum_kernels[isa](rows, planes + y*stride, ps, 0, stride);
+    }
+
+    for (k=0; k<4; ++k) {
+        uint64_t *p = planes + k*ps;
+        p[-1] = 0;
+        p[lw] = 0;
+        for (y=0; y<h; ++y) {
+            uint64_t *r = p + y*stride;
+            r[-1] |= ((r[(width-1) >> 6] >> ((width-1) & 63)) & 1) << 63;
+            r[width >> 6] |= (r[0] & 1) << (width & 63);
+        }
+    }
+    return next_kernels[isa](layers[1], planes, ps, mask, life3d_row(dst, 0, z), 0, lw,
+                             &src->rule);
+}
+
+typedef struct slab_job_s {
+    const life3d_t *src;
+    life3d_t *dst;
+    life_isa_t isa;
+    size_t layers;
+    const uint64_t *mask;
+    uint64_t *scratch;
+    /* Per worker populations, a cache line apart */
+    size_t counts[MAX_LIFE3D_WORKERS*8];
+} slab_job_t;
+
+static void evolve_slab_item(void *arg, size_t item, int worker) {
+    slab_job_t *job = arg;
+    size_t z0 = item*job->layers, z1 = z0 + job->layers, z, n = 0;
+    uint64_t *scratch = job->scratch + (size_t)worker*scratch_words(job->src);
+
+    if (z1 > job->src->depth) {
+        z1 = job->src->depth;
+    }
+    for (z=z0; z<z1; ++z) {
+        n += evolve_layer(job->src, job->dst, job->isa, z, job->mask, scratch);
+    }
+    job->counts[worker*8] += n;
+}
+
+int life3d_evolve_isa(const life3d_t *src, life3d_t *dst, life_isa_t isa) {
+    uint64_t *mask = layer_mask(src), *scratch = malloc(sizeof(uint64_t)*scratch_words(src));
+    size_t z, n = 0;
+
+    if (mask == NULL || scratch == NULL) {
+        free(mask);
+        free(scratch);
+        return 1;
+    }
+    for (z=0; z<src->depth; ++z) {
+        n += evolve_layer(src, dst, isa, z, mask, scratch);
+    }
+    free(mask);
+    free(scratch);
+    dst->num_on = n;
+    dst->rule = src->rule;
+    return 0;
+}
+
+int life3d_evolve_pool(const life3d_t *src, life3d_t *dst, work_pool_t *pool) {
+    slab_job_t *job;
+    uint64_t *mask;
+    size_t slabs;
+    int threads = pool != NULL ? work_pool_threads(pool) : 1, i;
+
+    if (threads == 1 || threads > MAX_LIFE3D_WORKERS) {
+        return life3d_evolve_isa(src, dst, life_isa());
+    }
+    /* Too big for the stack with all those counts */
+    job = malloc(sizeof(*job));
+    mask = layer_mask(src);
+    if (job == NULL || mask == NULL ||
+        (job->scratch = malloc(sizeof(uint64_t)*scratch_words(src)*threads)) == NULL) {
+        free(job);
+        free(mask);
+        return 1;
+    }
+    job->src = src;
+    job->dst = dst;
+    job->isa = life_isa();
+    job->mask = mask;
+    job->layers = src->depth/((size_t)threads*LIFE3D_SLABS_PER_THREAD);
+    if (job->layers == 0) {
+        job->layers = 1;
+    }
+    slabs = (src->depth + job->layers - 1)/job->layers;
+    memset(job->counts, 0, sizeof(job->counts));
+
+    work_pool_run(pool, slabs, evolve_slab_item, job);
+
+    dst->num_on = 0;
+    for (i=0; i<threads; ++i) {
+        dst->num_on += job->counts[i*8];
+    }
+    dst->rule = src->rule;
+    free(job->scratch);
+    free(job);
+    free(mask);
+    return 0;
+}
+
+int life3d_evolve(const life3d_t *src, life3d_t *dst) {
+    if (src->width*src->height*src->depth >= LIFE_PARALLEL_CELLS) {
+        return life3d_evolve_pool(src, dst, work_pool_shared());
+    }
+    return life3d_evolve_isa(src, dst, life_isa());
+}
@@ -0,0 +1,126 @@
+#ifndef LIFE3D_H
+#define LIFE3D_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_board.h"
+#include "work_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 3D Life-like rules over the 26 cells of a cell's 3x3x3 block.  Bit n of
+ * birth is set if a dead cell with n live neighbours comes alive, and bit
+ * n of survive if a live one stays alive; n goes up to 26.
+ *
+ * Rules are read in Bays' notation, "4555" being survival with 4 to 5
+ * neighbours and birth with 5 to 5 (E_l E_u F_l F_u, one digit each, or
+ * comma separated for bigger counts, "4,5,5,5"), or as "B5/S4-5", with
+ * counts comma separated and a-b for ranges.
+ *
+ * For the evolution, the totals (neighbours plus the cell itself, 0 to 27)
+ * that leave a cell alive are listed once, with whether they do it for
+ * dead cells, live ones or both, so the kernels only test those.
+ */
+#define LIFE3D_IF_DEAD 1
+#define LIFE3D_IF_ALIVE 2
+
+typedef struct life3d_rule_s {
+    uint32_t birth;
+    uint32_t survive;
+    int num_totals;
+    uint8_t totals[28];
+    /* LIFE3D_IF_DEAD and/or LIFE3D_IF_ALIVE */
+    uint8_t when[28];
+} life3d_rule_t;
+
+/* Big enough for life3d_rule_format() of any rule */
+#define LIFE3D_RULE_CHARS 96
+
+void life3d_rule_init(life3d_rule_t *rule, uint32_t birth, uint32_t survive);
+
+/* Returns 0 on success, leaving rule alone otherwise */
+int life3d_rule_parse(life3d_rule_t *rule, const char *text);
+
+/* As "B5/S4-5", into buf of at least LIFE3D_RULE_CHARS; returns buf */
+char *life3d_rule_format(const life3d_rule_t *rule, char *buf);
+
+/*
+ * A 3D cellular automaton on a 3-torus, packed 64 cells to a word as in
+ * life_board_t: cell (x, y, z) is bit x%64 of word x/64 of row (y, z), rows
+ * are stride words apart and layers height rows apart, and the bits past
+ * the width are always zero.  There is always at least a word of padding
+ * at the end of a row, which the evolution uses for the wrap around.
+ *
+ * Counting 26 neighbours a cell at a time would be 27 reads per cell.
+ * Instead life3d_evolve() works a word of 64 cells (or 128, 256 or 512
+ * with SSE2, AVX2 or AVX-512) at a time in two passes of bitwise adders:
+ * first the nine rows around its row, (y-1..y+1, z-1..z+1), are summed
+ * into 4 bit counts per column, then each column's count is added to the
+ * ones either side of it, shifted a cell, for the total over the 3x3x3
+ * block.  The rule is then matched against that total's five bit planes.
+ * A layer's rows are worked as one run of words, so short rows still
+ * fill the vectors.  The kernel is the widest life_isa() allows.
+ *
+ * Big grids are evolved in slabs of layers over a pool of threads; every
+ * slab reads the layers around it straight from the source, which nobody
+ * writes, so there is nothing to copy or lock.
+ */
+typedef struct life3d_s {
+    size_t width;
+    size_t height;
+    size_t depth;
+    size_t words;
+    size_t stride;
+    size_t num_on;
+    uint64_t *cells;
+    /* Evolved grids take their source's */
+    life3d_rule_t rule;
+} life3d_t;
+
+/* An empty grid under 4555; returns 0 on success */
+int life3d_init(life3d_t *grid, size_t width, size_t height, size_t depth);
+void life3d_free(life3d_t *grid);
+void life3d_clear(life3d_t *grid);
+
+static inline uint64_t *life3d_row(const life3d_t *grid, size_t y, size_t z) {
+    return grid->cells + (z*grid->height + y)*grid->stride;
+}
+
+static inline int life3d_get(const life3d_t *grid, size_t x, size_t y, size_t z) {
+    return (int)((life3d_row(grid, y, z)[x >> 6] >> (x & 63)) & 1);
+}
+
+/* Keeps num_on up to date */
+void life3d_set(life3d_t *grid, size_t x, size_t y, size_t z, int alive);
+
+/* Recounts num_on from the cells, for code that writes rows directly */
+size_t life3d_count(life3d_t *grid);
+
+/*
+ * Clears the grid and turns cells on with probability prob in the cube of
+ * side size (clipped to the grid) at its centre, for a soup to grow from.
+ */
+void life3d_random(life3d_t *grid, size_t size, double prob, uint64_t seed);
+
+/*
+ * dst becomes the generation after src; dst must be the same size.  Grids
+ * of LIFE_PARALLEL_CELLS or more use a pool shared by the whole program.
+ * Returns 0 on success.
+ */
+int life3d_evolve(const life3d_t *src, life3d_t *dst);
+
+/* In slabs over pool's threads, or on this one if pool is NULL */
+int life3d_evolve_pool(const life3d_t *src, life3d_t *dst, work_pool_t *pool);
+
+/* On this thread with a given kernel, which must be supported */
+int life3d_evolve_isa(const life3d_t *src, life3d_t *dst, life_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
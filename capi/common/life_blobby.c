@@ -0,0 +1,137 @@
+#include "life_blobby.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "life_kernels.h"
+
+#define BLOBBY_ELLIPSOID 1001
+#define BLOBBY_ADD 0
+
+int life_blobby_init(life_blobby_t *blobby, size_t width, size_t height) {
+    blobby->width = width;
+    blobby->height = height;
+    blobby->num_gens = 0;
+    blobby->num_leaves = 0;
+    blobby->max_leaves = 1024;
+    blobby->mats = malloc(sizeof(RtFloat)*16*blobby->max_leaves);
+    blobby->code_capacity = 3*blobby->max_leaves + 2;
+    blobby->code = malloc(sizeof(RtInt)*blobby->code_capacity);
+    if (blobby->mats == NULL || blobby->code == NULL) {
+        free(blobby->mats);
+        free(blobby->code);
+        return 1;
+    }
+    /* An add of nothing, for the first push to write over */
+    blobby->code[0] = BLOBBY_ADD;
+    blobby->code[1] = 0;
+    return 0;
+}
+
+void life_blobby_free(life_blobby_t *blobby) {
+    free(blobby->mats);
+    free(blobby->code);
+    blobby->mats = NULL;
+    blobby->code = NULL;
+    blobby->num_gens = blobby->num_leaves = blobby->max_leaves = blobby->code_capacity = 0;
+}
+
+static int reserve(life_blobby_t *blobby, size_t leaves) {
+    if (leaves > blobby->max_leaves) {
+        size_t max = blobby->max_leaves*2;
+        RtFloat *mats;
+        RtInt *code;
+        while (max < leaves) {
+            max *= 2;
+        }
+        mats = realloc(blobby->mats, sizeof(RtFloat)*16*max);
+        if (mats == NULL) {
+            return 1;
+        }
+        blobby->mats = mats;
+        code = realloc(blobby->code, sizeof(RtInt)*(3*max + 2));
+        if (code == NULL) {
+            return 1;
+        }
+        blobby->code = code;
+        blobby->max_leaves = max;
+        blobby->code_capacity = 3*max + 2;
+    }
+    return 0;
+}
+
+int life_blobby_push(life_blobby_t *blobby, const life_board_t *board) {
+    size_t n = blobby->num_leaves, k = 0, moved, kept, end, y, w, i;
+    RtInt *code;
+
+    if (board->width != blobby->width || board->height != blobby->height) {
+        return 1;
+    }
+    for (y=0; y<board->height; ++y) {
+        const uint64_t *row = life_board_row(board, y);
+        for (w=0; w<board->words; ++w) {
+            k += life_popcount64(row[w]);
+        }
+    }
+    if (reserve(blobby, n + k)) {
+        return 1;
+    }
+    code = blobby->code;
+
+    /*
+     * The add op and its operands are at [2n, 3n+2).  The new leaf ops and
+     * add op will cover [2n, 2n+2k+2), so the first min(2k, n) operands go
+     * after the ones that stay put, and the new leaves' indices after them.
+     */
+    moved = 2*k < n ? 2*k : n;
+    kept = n - moved;
+    end = 2*n + 2*k + 2 + kept;
+    memcpy(code + end, code + 2*n + 2, sizeof(RtInt)*moved);
+    for (i=0; i<k; ++i) {
+        code[end + moved + i] = (RtInt)(n + i);
+    }
+
+    for (y=0; y<board->height; ++y) {
+        const uint64_t *row = life_board_row(board, y);
+        for (w=0; w<board->words; ++w) {
+            uint64_t bits = row[w];
+            while (bits) {
+                RtFloat *m = blobby->mats + 16*n;
+                int b = __builtin_ctzll(bits);
+                memset(m, 0, sizeof(RtFloat)*16);
+                m[0] = m[5] = m[10] = 1.2f;
+                m[12] = (RtFloat)(w*64 + b);
+                m[13] = (RtFloat)blobby->num_gens;
+                m[14] = (RtFloat)y;
+                m[15] = 1.0f;
+                code[2*n] = BLOBBY_ELLIPSOID;
+                code[2*n+1] = (RtInt)(16*n);
+                ++n;
+                bits &= bits - 1;
+            }
+        }
+    }
+    code[2*n] = BLOBBY_ADD;
+    code[2*n+1] = (RtInt)n;
+
+    blobby->num_leaves = n;
+    blobby->num_gens++;
+    return 0;
+}
+
+void life_blobby_emit(const life_blobby_t *blobby) {
+    RtInt n = (RtInt)blobby->num_leaves;
+    if (n == 0) {
+        return;
+    }
+    RiTransformBegin();
+    RiTranslate(-(blobby->width/2.0), 0.0, -(blobby->height/2.0));
+    RiBlobby(n,
+             /* Ints */
+             3*n + 2, blobby->code,
+             /* Floats */
+             16*n, blobby->mats,
+             /* Strings */
+             0, (RtString*)RI_NULL, RI_NULL);
+    RiTransformEnd();
+}
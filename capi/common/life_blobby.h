@@ -0,0 +1,59 @@
+#ifndef LIFE_BLOBBY_H
+#define LIFE_BLOBBY_H
+
+#include <stdlib.h>
+
+#include "ri.h"
+
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A stack of Life generations as one RiBlobby, built up a generation at a
+ * time instead of all over again each frame.
+ *
+ * Generation g's live cells become ellipsoid leaves (scale 1.2) centred
+ * at (x, g, y); life_blobby_emit() shifts the lot by half the board so it
+ * sits where life_emit() would put it.  The code is every leaf's 1001 op,
+ * then one add op over all of them.  Only the leaves' matrices depend on
+ * the cells, and the add's operand list can be in any order, so a push
+ * writes the new matrices and leaf ops over the old add op, moves the
+ * handful of operands that were in the way to the end of the list and
+ * adds the new ones after them.  That's work in proportion to the new
+ * generation, and the arrays go to RiBlobby as they are.
+ *
+ * Both arrays grow by doubling and are never shrunk.
+ */
+typedef struct life_blobby_s {
+    size_t width;
+    size_t height;
+    size_t num_gens;
+    size_t num_leaves;
+
+    /* 16 a leaf */
+    RtFloat *mats;
+    size_t max_leaves;
+
+    /* 2 a leaf for the leaves, then 0, num_leaves and the add's operands */
+    RtInt *code;
+    size_t code_capacity;
+} life_blobby_t;
+
+/* Returns 0 on success */
+int life_blobby_init(life_blobby_t *blobby, size_t width, size_t height);
+void life_blobby_free(life_blobby_t *blobby);
+
+/* Appends generation num_gens, which must be the blobby's size; returns 0 on success */
+int life_blobby_push(life_blobby_t *blobby, const life_board_t *board);
+
+/* The RiBlobby, if there are any leaves */
+void life_blobby_emit(const life_blobby_t *blobby);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,564 @@
+#include "life_board.h"
+#include "life_kernels.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Tiles are about this many bytes of output, at most LIFE_TILE_WORDS wide */
+#define LIFE_TILE_BYTES (32*1024)
+#define LIFE_TILE_WORDS 64
+#define MAX_LIFE_WORKERS 256
+
+/* Unique to each state any board is ever in; 0 is nobody's */
+static uint64_t new_stamp(void) {
+    static uint64_t last = 0;
+    return __sync_add_and_fetch(&last, 1);
+}
+
+static size_t num_tiles(const life_board_t *board) {
+    return board->tiles_across*board->tiles_down;
+}
+
+int life_board_init(life_board_t *board, size_t width, size_t height) {
+    board->width = width;
+    board->height = height;
+    board->words = (width + 63)/64;
+    board->stride = (board->words + LIFE_ROW_ALIGN - 1)/LIFE_ROW_ALIGN*LIFE_ROW_ALIGN;
+    board->num_on = 0;
+    board->cells = NULL;
+    board->changed = NULL;
+    board->band_on = NULL;
+    /* Past SIZE_MAX-63 the word count wraps round to 0 */
+    if (width == 0 || width > SIZE_MAX - 63) {
+        return 1;
+    }
+    board->cells = calloc(board->stride*(height > 0 ? height : 1), sizeof(uint64_t));
+    board->tiles_across = board->words;
+    board->tiles_down = (height + LIFE_CHANGE_ROWS - 1)/LIFE_CHANGE_ROWS;
+    board->changed = malloc(num_tiles(board) > 0 ? num_tiles(board) : 1);
+    board->band_on = calloc(board->tiles_down > 0 ? board->tiles_down : 1, sizeof(size_t));
+    if (board->cells == NULL || board->changed == NULL || board->band_on == NULL) {
+        free(board->cells);
+        free(board->changed);
+        free(board->band_on);
+        board->cells = NULL;
+        board->changed = NULL;
+        board->band_on = NULL;
+        return 1;
+    }
+    life_rule_init(&board->rule, LIFE_CONWAY_BIRTH, LIFE_CONWAY_SURVIVE);
+    life_board_touch(board);
+    board->bands_counted = 1;
+    return 0;
+}
+
+void life_board_set_rule(life_board_t *board, const life_rule_t *rule) {
+    board->rule = *rule;
+    life_board_touch(board);
+}
+
+void life_board_free(life_board_t *board) {
+    free(board->cells);
+    free(board->changed);
+    free(board->band_on);
+    board->cells = NULL;
+    board->changed = NULL;
+    board->band_on = NULL;
+    board->width = board->height = 0;
+    board->words = board->stride = 0;
+    board->tiles_across = board->tiles_down = 0;
+    board->num_on = 0;
+}
+
+void life_board_touch(life_board_t *board) {
+    memset(board->changed, 1, num_tiles(board));
+    board->bands_counted = 0;
+    board->stamp = new_stamp();
+    board->parent = 0;
+}
+
+void life_board_settle(life_board_t *board) {
+    memset(board->changed, 0, num_tiles(board));
+    board->parent = board->stamp;
+    board->stamp = new_stamp();
+}
+
+size_t life_board_num_changed(const life_board_t *board) {
+    size_t i, n = 0;
+    for (i=0; i<num_tiles(board); ++i) {
+        n += board->changed[i];
+    }
+    return n;
+}
+
+int life_board_copy(life_board_t *dst, const life_board_t *src) {
+    if (dst->width != src->width || dst->height != src->height) {
+        life_board_free(dst);
+        if (life_board_init(dst, src->width, src->height)) {
+            return 1;
+        }
+    }
+    memcpy(dst->cells, src->cells, sizeof(uint64_t)*src->stride*src->height);
+    memcpy(dst->changed, src->changed, num_tiles(src));
+    memcpy(dst->band_on, src->band_on, sizeof(size_t)*src->tiles_down);
+    dst->bands_counted = src->bands_counted;
+    dst->num_on = src->num_on;
+    dst->rule = src->rule;
+    dst->stamp = new_stamp();
+    dst->parent = src->parent;
+    return 0;
+}
+
+void life_board_clear(life_board_t *board) {
+    memset(board->cells, 0, sizeof(uint64_t)*board->stride*board->height);
+    board->num_on = 0;
+    life_board_touch(board);
+    memset(board->band_on, 0, sizeof(size_t)*board->tiles_down);
+    board->bands_counted = 1;
+}
+
+void life_board_set(life_board_t *board, size_t x, size_t y, int alive) {
+    uint64_t *word = life_board_row(board, y) + (x >> 6);
+    uint64_t bit = (uint64_t)1 << (x & 63);
+
+    if (alive && !(*word & bit)) {
+        *word |= bit;
+        board->num_on++;
+        board->band_on[y/LIFE_CHANGE_ROWS]++;
+    } else if (!alive && (*word & bit)) {
+        *word &= ~bit;
+        board->num_on--;
+        board->band_on[y/LIFE_CHANGE_ROWS]--;
+    } else {
+        return;
+    }
+    board->changed[(y/LIFE_CHANGE_ROWS)*board->tiles_across + (x >> 6)] = 1;
+    board->stamp = new_stamp();
+}
+
+void life_board_xor(life_board_t *board, size_t y, size_t w, uint64_t bits) {
+    uint64_t *word = life_board_row(board, y) + w;
+    size_t before = life_popcount64(*word), after;
+
+    if (bits == 0) {
+        return;
+    }
+    *word ^= bits;
+    after = life_popcount64(*word);
+    board->num_on += after - before;
+    board->band_on[y/LIFE_CHANGE_ROWS] += after - before;
+    board->changed[(y/LIFE_CHANGE_ROWS)*board->tiles_across + w] = 1;
+    board->stamp = new_stamp();
+}
+
+/* Cells alive in words [w0, w1) of rows [y0, y1) */
+static size_t count_words(const life_board_t *board, size_t y0, size_t y1, size_t w0, size_t w1) {
+    size_t y, w, n = 0;
+    for (y=y0; y<y1; ++y) {
+        const uint64_t *row = life_board_row(board, y);
+        for (w=w0; w<w1; ++w) {
+            n += life_popcount64(row[w]);
+        }
+    }
+    return n;
+}
+
+static size_t band_end(const life_board_t *board, size_t ty) {
+    size_t y1 = (ty+1)*LIFE_CHANGE_ROWS;
+    return y1 < board->height ? y1 : board->height;
+}
+
+size_t life_board_count(life_board_t *board) {
+    size_t ty, n = 0;
+    for (ty=0; ty<board->tiles_down; ++ty) {
+        board->band_on[ty] = count_words(board, ty*LIFE_CHANGE_ROWS, band_end(board, ty),
+                                         0, board->words);
+        n += board->band_on[ty];
+    }
+    board->bands_counted = 1;
+    board->num_on = n;
+    return n;
+}
+
+/* Row r shifted so each cell's west (x-1) or east (x+1) neighbour is in its place */
+static inline uint64_t west_of(const life_board_t *b, const uint64_t *r, size_t w) {
+    uint64_t carry = (w > 0) ? r[w-1] >> 63 : (r[(b->width-1) >> 6] >> ((b->width-1) & 63)) & 1;
+    return (r[w] << 1) | carry;
+}
+
+static inline uint64_t east_of(const life_board_t *b, const uint64_t *r, size_t w) {
+    uint64_t e = r[w] >> 1;
+    if (w+1 < b->words) {
+        e |= r[w+1] << 63;
+    } else {
+        e |= (r[0] & 1) << ((b->width-1) & 63);
+    }
+    return e;
+}
+
+static const char *isa_names[LIFE_ISA_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+
+#ifdef LIFE_X86_KERNELS
+#define ROW_KERNELS(rule) \
+    {life_row_scalar_##rule, life_row_sse2_##rule, life_row_avx2_##rule, life_row_avx512_##rule}
+#else
+#define ROW_KERNELS(rule) {life_row_scalar_##rule, NULL, NULL, NULL}
+#endif
+
+static const life_row_kernel_t row_kernels[LIFE_RULE_KINDS][LIFE_ISA_COUNT] = {
+    ROW_KERNELS(conway),
+    ROW_KERNELS(highlife),
+    ROW_KERNELS(daynight),
+    ROW_KERNELS(seeds),
+    ROW_KERNELS(table)
+};
+
+const char *life_isa_name(life_isa_t isa) {
+    return isa < LIFE_ISA_COUNT ? isa_names[isa] : "unknown";
+}
+
+int life_isa_supported(life_isa_t isa) {
+    switch (isa) {
+    case LIFE_ISA_SCALAR:
+        return 1;
+#ifdef LIFE_X86_KERNELS
+    case LIFE_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case LIFE_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case LIFE_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+        return 0;
+    }
+}
+
+life_isa_t life_isa(void) {
+    /* Worked out once; racing threads all arrive at the same answer */
+    static int chosen = -1;
+    if (chosen < 0) {
+        const char *env = getenv("LIFE_ISA");
+        int isa, best = LIFE_ISA_SCALAR, cap = LIFE_ISA_COUNT-1;
+
+        if (env != NULL) {
+            for (isa=0; isa<LIFE_ISA_COUNT; ++isa) {
+                if (strcmp(env, isa_names[isa]) == 0) {
+                    cap = isa;
+                    break;
+                }
+            }
+            if (isa == LIFE_ISA_COUNT) {
+                printf("Unknown LIFE_ISA %s, using the best available\n", env);
+            }
+        }
+        for (isa=0; isa<=cap; ++isa) {
+            if (life_isa_supported((life_isa_t)isa)) {
+                best = isa;
+            }
+        }
+        chosen = best;
+    }
+    return (life_isa_t)chosen;
+}
+
+/*
+ * Words [w0, w1) of the row after mid, on a board b's width and under its
+ * rule; returns how many of them are alive.  diff is as for the row
+ * kernels, indexed by w - w0.
+ */
+static size_t evolve_words(const life_board_t *b, life_row_kernel_t kernel,
+                           const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                           uint64_t *out, size_t w0, size_t w1, uint64_t *diff) {
+    size_t last = b->words - 1;
+    /* The bits of the last word that are on the board */
+    uint64_t tail = (b->width & 63) ? ((uint64_t)1 << (b->width & 63)) - 1 : ~(uint64_t)0;
+    /* Interior words take their carries from the words either side */
+    size_t first = w0 > 1 ? w0 : 1;
+    size_t end = w1 < last ? w1 : last;
+    size_t w, n = 0;
+
+    if (end > first) {
+        n += kernel(up, mid, down, out, diff != NULL ? diff + (first - w0) : NULL, first, end,
+                    &b->rule);
+    }
+    /* The first and last wrap around the row */
+    for (w=0; w<=last; w += (last > 0 ? last : 1)) {
+        uint64_t next;
+        if (w < w0 || w >= w1) {
+            continue;
+        }
+        next = life_next(b->rule.kind, b->rule.table,
+                         west_of(b, up, w), up[w], east_of(b, up, w),
+                         west_of(b, mid, w), mid[w], east_of(b, mid, w),
+                         west_of(b, down, w), down[w], east_of(b, down, w));
+        if (w == last) {
+            next &= tail;
+        }
+        out[w] = next;
+        if (diff != NULL) {
+            diff[w - w0] |= next ^ mid[w];
+        }
+        n += life_popcount64(next);
+    }
+    return n;
+}
+
+/*
+ * Words [w0, w1) of rows [y0, y1) of dst; returns how many of them are
+ * alive.  diff, if not NULL, is as for the row kernels, indexed by w - w0.
+ */
+static size_t evolve_tile(const life_board_t *src, life_board_t *dst, life_row_kernel_t kernel,
+                          size_t y0, size_t y1, size_t w0, size_t w1, uint64_t *diff) {
+    size_t h = src->height;
+    size_t y, n = 0;
+
+    for (y=y0; y<y1; ++y) {
+        n += evolve_words(src, kernel, life_board_row(src, (y+h-1) % h), life_board_row(src, y),
+                          life_board_row(src, (y+1) % h), life_board_row(dst, y), w0, w1, diff);
+    }
+    return n;
+}
+
+size_t life_evolve_row(size_t width, const uint64_t *up, const uint64_t *mid,
+                       const uint64_t *down, uint64_t *out, const life_rule_t *rule) {
+    life_board_t shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.width = width;
+    shape.words = (width + 63)/64;
+    shape.rule = *rule;
+    if (shape.words == 0) {
+        return 0;
+    }
+    return evolve_words(&shape, row_kernels[rule->kind][life_isa()], up, mid, down, out,
+                        0, shape.words, NULL);
+}
+
+typedef struct tile_job_s {
+    const life_board_t *src;
+    life_board_t *dst;
+    life_row_kernel_t kernel;
+    size_t rows;
+    size_t cols;
+    size_t tiles_across;
+    /* Per worker populations, a cache line apart */
+    size_t counts[MAX_LIFE_WORKERS*8];
+} tile_job_t;
+
+static void evolve_tile_item(void *arg, size_t item, int worker) {
+    tile_job_t *job = arg;
+    size_t y0 = (item / job->tiles_across)*job->rows;
+    size_t w0 = (item % job->tiles_across)*job->cols;
+    size_t y1 = y0 + job->rows < job->src->height ? y0 + job->rows : job->src->height;
+    size_t w1 = w0 + job->cols < job->src->words ? w0 + job->cols : job->src->words;
+
+    job->counts[worker*8] += evolve_tile(job->src, job->dst, job->kernel, y0, y1, w0, w1, NULL);
+}
+
+void life_evolve_pool(const life_board_t *src, life_board_t *dst, work_pool_t *pool) {
+    tile_job_t job;
+    size_t tiles_down;
+    int i;
+
+    if (pool == NULL || work_pool_threads(pool) == 1 || work_pool_threads(pool) > MAX_LIFE_WORKERS) {
+        life_evolve_isa(src, dst, life_isa());
+        return;
+    }
+    job.src = src;
+    job.dst = dst;
+    job.kernel = row_kernels[src->rule.kind][life_isa()];
+    job.cols = src->words < LIFE_TILE_WORDS ? src->words : LIFE_TILE_WORDS;
+    job.rows = LIFE_TILE_BYTES/(job.cols*sizeof(uint64_t));
+    if (job.rows == 0) {
+        job.rows = 1;
+    }
+    job.tiles_across = (src->words + job.cols - 1)/job.cols;
+    tiles_down = (src->height + job.rows - 1)/job.rows;
+    memset(job.counts, 0, sizeof(job.counts));
+
+    work_pool_run(pool, job.tiles_across*tiles_down, evolve_tile_item, &job);
+
+    /* Whole numbers, so the total is the same however the tiles were shared out */
+    dst->num_on = 0;
+    for (i=0; i<work_pool_threads(pool); ++i) {
+        dst->num_on += job.counts[i*8];
+    }
+    /* The tiles don't line up with the bands, so those are counted later if needed */
+    dst->bands_counted = 0;
+    memset(dst->changed, 1, num_tiles(dst));
+    dst->rule = src->rule;
+    dst->stamp = new_stamp();
+    dst->parent = src->stamp;
+}
+
+void life_evolve_isa(const life_board_t *src, life_board_t *dst, life_isa_t isa) {
+    size_t ty;
+    dst->num_on = 0;
+    for (ty=0; ty<src->tiles_down; ++ty) {
+        dst->band_on[ty] = evolve_tile(src, dst, row_kernels[src->rule.kind][isa],
+                                       ty*LIFE_CHANGE_ROWS, band_end(src, ty), 0, src->words, NULL);
+        dst->num_on += dst->band_on[ty];
+    }
+    dst->bands_counted = 1;
+    memset(dst->changed, 1, num_tiles(dst));
+    dst->rule = src->rule;
+    dst->stamp = new_stamp();
+    dst->parent = src->stamp;
+}
+
+typedef struct band_job_s {
+    const life_board_t *src;
+    life_board_t *dst;
+    life_row_kernel_t kernel;
+    /* Whether dst's cells have to be brought up to src's in quiet tiles */
+    int copy;
+} band_job_t;
+
+/* Whether tile (tx, ty) or any of the eight round it changed */
+static int tile_active(const life_board_t *b, size_t tx, size_t ty) {
+    size_t ta = b->tiles_across, td = b->tiles_down;
+    size_t rows[3], cols[3];
+    int i, j;
+
+    rows[0] = (ty+td-1) % td;
+    rows[1] = ty;
+    rows[2] = (ty+1) % td;
+    cols[0] = (tx+ta-1) % ta;
+    cols[1] = tx;
+    cols[2] = (tx+1) % ta;
+    for (i=0; i<3; ++i) {
+        for (j=0; j<3; ++j) {
+            if (b->changed[rows[i]*ta + cols[j]]) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Whether nothing changed in tile row ty or either next to it */
+static int band_quiet(const life_board_t *b, size_t ty) {
+    size_t ta = b->tiles_across, td = b->tiles_down;
+    const uint8_t *rows[3];
+    uint8_t any = 0;
+    size_t i;
+
+    rows[0] = b->changed + ((ty+td-1) % td)*ta;
+    rows[1] = b->changed + ty*ta;
+    rows[2] = b->changed + ((ty+1) % td)*ta;
+    for (i=0; i<ta; ++i) {
+        any |= rows[0][i] | rows[1][i] | rows[2][i];
+    }
+    return !any;
+}
+
+/* Works out tiles [tx, end) of band ty, 64 at a time; returns how many cells live */
+static size_t evolve_run(band_job_t *job, size_t ty, size_t tx, size_t end) {
+    life_board_t *dst = job->dst;
+    uint64_t diff[64];
+    size_t c0, c1, w, n = 0;
+
+    for (c0=tx; c0<end; c0=c1) {
+        c1 = c0 + 64 < end ? c0 + 64 : end;
+        memset(diff, 0, sizeof(diff));
+        n += evolve_tile(job->src, dst, job->kernel, ty*LIFE_CHANGE_ROWS, band_end(dst, ty),
+                         c0, c1, diff);
+        for (w=c0; w<c1; ++w) {
+            dst->changed[ty*dst->tiles_across + w] = diff[w-c0] != 0;
+        }
+    }
+    return n;
+}
+
+static void copy_run(band_job_t *job, size_t ty, size_t tx, size_t end) {
+    size_t y;
+    if (job->copy) {
+        for (y=ty*LIFE_CHANGE_ROWS; y<band_end(job->src, ty); ++y) {
+            memcpy(life_board_row(job->dst, y) + tx, life_board_row(job->src, y) + tx,
+                   sizeof(uint64_t)*(end - tx));
+        }
+    }
+    memset(job->dst->changed + ty*job->dst->tiles_across + tx, 0, end - tx);
+}
+
+/*
+ * One row of change tiles, worked out or copied a run of like tiles at a
+ * time.  The band's population is src's with the worked out runs' old
+ * cells swapped for their new ones, so a quiet tile is never counted.
+ */
+static void evolve_band_item(void *arg, size_t ty, int worker) {
+    band_job_t *job = arg;
+    const life_board_t *src = job->src;
+    size_t y0 = ty*LIFE_CHANGE_ROWS, y1 = band_end(src, ty);
+    size_t tx = 0, end, quiet = 0, before = 0, after = 0;
+    int active, whole = 0;
+
+    (void)worker;
+    if (band_quiet(src, ty)) {
+        copy_run(job, ty, 0, src->tiles_across);
+        job->dst->band_on[ty] = src->bands_counted ? src->band_on[ty] :
+            count_words(src, y0, y1, 0, src->words);
+        return;
+    }
+    active = tile_active(src, 0, ty);
+    while (tx < src->tiles_across) {
+        int next = !active;
+        for (end=tx+1; end<src->tiles_across; ++end) {
+            next = tile_active(src, end, ty);
+            if (next != active) {
+                break;
+            }
+        }
+        if (!active) {
+            copy_run(job, ty, tx, end);
+            if (!src->bands_counted) {
+                quiet += count_words(src, y0, y1, tx, end);
+            }
+        } else {
+            after += evolve_run(job, ty, tx, end);
+            whole = (tx == 0 && end == src->tiles_across);
+            if (src->bands_counted && !whole) {
+                before += count_words(src, y0, y1, tx, end);
+            }
+        }
+        tx = end;
+        active = next;
+    }
+    if (whole) {
+        job->dst->band_on[ty] = after;
+    } else if (src->bands_counted) {
+        job->dst->band_on[ty] = src->band_on[ty] - before + after;
+    } else {
+        job->dst->band_on[ty] = quiet + after;
+    }
+}
+
+void life_evolve(const life_board_t *src, life_board_t *dst) {
+    band_job_t job;
+    work_pool_t *pool;
+    size_t ty;
+
+    job.src = src;
+    job.dst = dst;
+    job.kernel = row_kernels[src->rule.kind][life_isa()];
+    /* dst holding what src came from means quiet tiles already match */
+    job.copy = dst->stamp != src->parent;
+
+    pool = src->width*src->height >= LIFE_PARALLEL_CELLS ? work_pool_shared() : NULL;
+    if (pool != NULL) {
+        work_pool_run(pool, src->tiles_down, evolve_band_item, &job);
+    } else {
+        for (ty=0; ty<src->tiles_down; ++ty) {
+            evolve_band_item(&job, ty, 0);
+        }
+    }
+    /* Per band, so the total is the same however the bands were shared out */
+    dst->num_on = 0;
+    for (ty=0; ty<dst->tiles_down; ++ty) {
+        dst->num_on += dst->band_on[ty];
+    }
+    dst->bands_counted = 1;
+    dst->rule = src->rule;
+    dst->stamp = new_stamp();
+    dst->parent = src->stamp;
+}
@@ -0,0 +1,163 @@
+#ifndef LIFE_BOARD_H
+#define LIFE_BOARD_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_rule.h"
+#include "work_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A Game of Life board on a torus, packed 64 cells to a word.
+ *
+ * Cell (x, y) is bit x%64 of word x/64 of row y.  Each row is padded out
+ * to a whole number of cache lines (LIFE_ROW_ALIGN words), and the bits
+ * past the width are always zero, so rows can be worked on a word or a
+ * vector at a time without masking anything but the last word.
+ *
+ * life_evolve() adds up the eight neighbours of 64 cells at once with
+ * bitwise full adders (SWAR) instead of counting them cell by cell, and
+ * does 128, 256 or 512 cells at a time with SSE2, AVX2 or AVX-512 when
+ * the CPU has them (see life_kernels.h).  Boards run Conway's rule unless
+ * given another with life_board_set_rule() (see life_rule.h).
+ *
+ * The board also remembers which of its change tiles, 64 cells by
+ * LIFE_CHANGE_ROWS rows, differ from the board it was evolved from.  A
+ * tile whose neighbourhood didn't change can't change next generation
+ * either, so life_evolve() only works out the tiles in or next to one
+ * that did, and renderers can ask which tiles need redoing.
+ */
+#define LIFE_ROW_ALIGN 8
+#define LIFE_CHANGE_ROWS 16
+
+typedef struct life_board_s {
+    size_t width;
+    size_t height;
+    /* Words holding cells in each row, and words from one row to the next */
+    size_t words;
+    size_t stride;
+    size_t num_on;
+    uint64_t *cells;
+    /* Evolved boards take their source's */
+    life_rule_t rule;
+
+    /* One flag per change tile, row by row; see life_board_tile_changed() */
+    size_t tiles_across;
+    size_t tiles_down;
+    uint8_t *changed;
+    /* Cells alive in each row of tiles, if bands_counted */
+    size_t *band_on;
+    int bands_counted;
+    /* New with every write; parent is the stamp of the board evolved from */
+    uint64_t stamp;
+    uint64_t parent;
+} life_board_t;
+
+/* An empty board, at least a cell wide; returns 0 on success */
+int life_board_init(life_board_t *board, size_t width, size_t height);
+void life_board_free(life_board_t *board);
+
+/* Another board's size and cells, into an initialized board */
+int life_board_copy(life_board_t *dst, const life_board_t *src);
+void life_board_clear(life_board_t *board);
+
+static inline uint64_t *life_board_row(const life_board_t *board, size_t y) {
+    return board->cells + y*board->stride;
+}
+
+static inline int life_board_get(const life_board_t *board, size_t x, size_t y) {
+    return (int)((life_board_row(board, y)[x >> 6] >> (x & 63)) & 1);
+}
+
+/* Every tile counts as changed afterwards, as the next generation may differ anywhere */
+void life_board_set_rule(life_board_t *board, const life_rule_t *rule);
+
+/* Keeps num_on and the changed tiles up to date */
+void life_board_set(life_board_t *board, size_t x, size_t y, int alive);
+
+/* Recounts num_on from the cells, for code that writes rows directly */
+size_t life_board_count(life_board_t *board);
+
+/*
+ * Whether change tile (tx, ty), cells [64*tx, 64*tx+64) of rows
+ * [LIFE_CHANGE_ROWS*ty, LIFE_CHANGE_ROWS*ty+LIFE_CHANGE_ROWS), may differ
+ * from the generation before.  Every tile counts as changed on a new,
+ * cleared or directly written board.
+ */
+static inline int life_board_tile_changed(const life_board_t *board, size_t tx, size_t ty) {
+    return board->changed[ty*board->tiles_across + tx];
+}
+
+size_t life_board_num_changed(const life_board_t *board);
+
+/* Marks every tile changed, for code that writes rows directly */
+void life_board_touch(life_board_t *board);
+
+/*
+ * For building the next generation from its differences: life_board_settle()
+ * marks every tile unchanged, then life_board_xor() flips the given bits
+ * of word w of row y, marking its tile changed and keeping the counts.
+ */
+void life_board_settle(life_board_t *board);
+void life_board_xor(life_board_t *board, size_t y, size_t w, uint64_t bits);
+
+/*
+ * dst becomes the generation after src; dst must be the same size.  Only
+ * tiles next to one that changed are worked out, the rest are copied, and
+ * not even that when dst is the unchanged board src was evolved from, so
+ * swapping two boards costs in proportion to what's going on.  Boards of
+ * LIFE_PARALLEL_CELLS or more are done in bands of tiles on a pool shared
+ * by the whole program (see work_pool.h for sizing it).
+ */
+void life_evolve(const life_board_t *src, life_board_t *dst);
+
+#define LIFE_PARALLEL_CELLS ((size_t)1 << 20)
+
+/*
+ * Evolves the board in tiles of a few dozen rows by up to 4096 cells, about
+ * 32k of output each, spread over pool's threads.  Every tile reads the row
+ * above and below it straight from src, which nobody writes, so tiles need
+ * no copies of their halo rows and no locking.  num_on comes out the same
+ * as life_evolve_isa()'s whatever the thread count.  This and
+ * life_evolve_isa() work out every cell and mark every tile changed.
+ */
+void life_evolve_pool(const life_board_t *src, life_board_t *dst, work_pool_t *pool);
+
+/*
+ * One row of the generation after, for code that keeps its rows somewhere
+ * other than a life_board_t: out from the rows above, at and below it, each
+ * (width+63)/64 words laid out as a board row, under rule.  Returns how
+ * many are alive.
+ */
+size_t life_evolve_row(size_t width, const uint64_t *up, const uint64_t *mid,
+                       const uint64_t *down, uint64_t *out, const life_rule_t *rule);
+
+typedef enum life_isa_e {
+    LIFE_ISA_SCALAR,
+    LIFE_ISA_SSE2,
+    LIFE_ISA_AVX2,
+    LIFE_ISA_AVX512,
+    LIFE_ISA_COUNT
+} life_isa_t;
+
+/*
+ * The kernel life_evolve() uses: the widest this CPU supports, checked
+ * with cpuid on first use.  LIFE_ISA=scalar|sse2|avx2|avx512 in the
+ * environment caps it, for comparing them or working around a bad one.
+ */
+life_isa_t life_isa(void);
+int life_isa_supported(life_isa_t isa);
+const char *life_isa_name(life_isa_t isa);
+
+/* life_evolve() with a given kernel, which must be supported */
+void life_evolve_isa(const life_board_t *src, life_board_t *dst, life_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+#include "life_emit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+life_emit_mode_t life_emit_mode(void) {
+    const char *env = getenv("LIFE_EMIT");
+    if (env != NULL) {
+        if (strcmp(env, "spheres") == 0) {
+            return LIFE_EMIT_SPHERES;
+        }
+        if (strcmp(env, "cubes") == 0) {
+            return LIFE_EMIT_CUBES;
+        }
+    }
+    return LIFE_EMIT_POINTS;
+}
+
+static void emit_spheres(const life_board_t *board) {
+    size_t i, j;
+    RiTransformBegin();
+    RiTranslate(-(board->width/2.0), 0.0, -(board->height/2.0));
+    for (j=0; j<board->height; ++j) {
+        RiTransformBegin();
+        for (i=0; i<board->width; ++i) {
+            if (life_board_get(board, i, j)) {
+                RiSphere(0.5, -0.5,0.5, 360.0, RI_NULL);
+            }
+            RiTranslate(1.0, 0.0, 0.0);
+        }
+        RiTransformEnd();
+        RiTranslate(0.0, 0.0, 1.0);
+    }
+    RiTransformEnd();
+}
+
+/* The centres of the live cells into pts, up to max of them; returns how many */
+static size_t gather(const life_board_t *board, RtPoint *pts, size_t max) {
+    RtFloat x0 = (RtFloat)(-(board->width/2.0)), z0 = (RtFloat)(-(board->height/2.0));
+    size_t n = 0, y, w;
+    for (y=0; y<board->height; ++y) {
+        const uint64_t *row = life_board_row(board, y);
+        for (w=0; w<board->words; ++w) {
+            uint64_t bits = row[w];
+            while (bits && n < max) {
+                int b = __builtin_ctzll(bits);
+                pts[n][0] = x0 + (RtFloat)(w*64 + b);
+                pts[n][1] = 0.0f;
+                pts[n][2] = z0 + (RtFloat)y;
+                ++n;
+                bits &= bits - 1;
+            }
+        }
+    }
+    return n;
+}
+
+/* A unit cube's corners are bit 0 x, bit 1 y, bit 2 z; faces wound to face out */
+static const RtInt cube_faces[6][4] = {
+    {0, 4, 6, 2}, {1, 3, 7, 5},
+    {0, 1, 5, 4}, {2, 6, 7, 3},
+    {0, 2, 3, 1}, {4, 5, 7, 6}
+};
+
+static void emit_cubes(const RtPoint *centres, size_t n, frame_arena_t *arena) {
+    RtPoint *pts = frame_arena_alloc(arena, sizeof(RtPoint)*8*n);
+    RtInt *nverts = frame_arena_alloc(arena, sizeof(RtInt)*6*n);
+    RtInt *verts = frame_arena_alloc(arena, sizeof(RtInt)*24*n);
+    size_t c;
+    int k, f;
+
+    if (pts == NULL || nverts == NULL || verts == NULL) {
+        printf("Could not allocate %lu cubes, leaving them out\n", (unsigned long)n);
+        return;
+    }
+    for (c=0; c<n; ++c) {
+        for (k=0; k<8; ++k) {
+            pts[8*c+k][0] = centres[c][0] + ((k & 1) ? 0.5f : -0.5f);
+            pts[8*c+k][1] = centres[c][1] + ((k & 2) ? 0.5f : -0.5f);
+            pts[8*c+k][2] = centres[c][2] + ((k & 4) ? 0.5f : -0.5f);
+        }
+        for (f=0; f<6; ++f) {
+            nverts[6*c+f] = 4;
+            for (k=0; k<4; ++k) {
+                verts[24*c + 4*f + k] = (RtInt)(8*c) + cube_faces[f][k];
+            }
+        }
+    }
+    RiPointsPolygons((RtInt)(6*n), nverts, verts, RI_P, pts, RI_NULL);
+}
+
+void life_emit(const life_board_t *board, life_emit_mode_t mode, frame_arena_t *arena) {
+    RtFloat width = 1.0f;
+    RtPoint *centres;
+    size_t n;
+
+    if (mode == LIFE_EMIT_SPHERES) {
+        emit_spheres(board);
+        return;
+    }
+    if (board->num_on == 0) {
+        return;
+    }
+    centres = frame_arena_alloc(arena, sizeof(RtPoint)*board->num_on);
+    if (centres == NULL) {
+        printf("Could not allocate %lu cells, leaving them out\n", (unsigned long)board->num_on);
+        return;
+    }
+    n = gather(board, centres, board->num_on);
+    if (mode == LIFE_EMIT_CUBES) {
+        emit_cubes(centres, n, arena);
+    } else {
+        RiPoints((RtInt)n, "constantwidth", &width, RI_P, centres, RI_NULL);
+    }
+}
+
+/* The centres of the live cells of a 3D grid into pts, up to max of them; returns how many */
+static size_t gather_3d(const life3d_t *grid, RtPoint *pts, size_t max) {
+    RtFloat x0 = (RtFloat)(-(grid->width/2.0)), z0 = (RtFloat)(-(grid->height/2.0));
+    size_t n = 0, y, z, w;
+    for (z=0; z<grid->depth; ++z) {
+        for (y=0; y<grid->height; ++y) {
+            const uint64_t *row = life3d_row(grid, y, z);
+            for (w=0; w<grid->words; ++w) {
+                uint64_t bits = row[w];
+                while (bits && n < max) {
+                    int b = __builtin_ctzll(bits);
+                    pts[n][0] = x0 + (RtFloat)(w*64 + b);
+                    pts[n][1] = (RtFloat)z;
+                    pts[n][2] = z0 + (RtFloat)y;
+                    ++n;
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+void life_emit_3d(const life3d_t *grid, life_emit_mode_t mode, frame_arena_t *arena) {
+    RtFloat width = 1.0f;
+    RtPoint *centres;
+    size_t n;
+
+    if (grid->num_on == 0) {
+        return;
+    }
+    centres = frame_arena_alloc(arena, sizeof(RtPoint)*grid->num_on);
+    if (centres == NULL) {
+        printf("Could not allocate %lu cells, leaving them out\n", (unsigned long)grid->num_on);
+        return;
+    }
+    n = gather_3d(grid, centres, grid->num_on);
+    if (mode == LIFE_EMIT_CUBES) {
+        emit_cubes(centres, n, arena);
+    } else {
+        RiPoints((RtInt)n, "constantwidth", &width, RI_P, centres, RI_NULL);
+    }
+}
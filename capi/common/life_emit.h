@@ -0,0 +1,57 @@
+#ifndef LIFE_EMIT_H
+#define LIFE_EMIT_H
+
+#include "ri.h"
+
+#include "frame_arena.h"
+#include "life3d.h"
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Ri output for one Life generation: a unit cell at (x - width/2, 0,
+ * y - height/2) for every live (x, y) of the board.
+ *
+ * LIFE_EMIT_SPHERES is the old way, a RiSphere and a RiTranslate per cell
+ * (and a transform per row), tens of thousands of Ri calls for a busy
+ * board.  The other two gather the live cells' centres with one pass over
+ * the board's words and make a single primitive of them, which is a
+ * handful of Ri calls and gives the renderer one big thing to split:
+ *
+ *   LIFE_EMIT_POINTS  one RiPoints of width 1 particles, which the
+ *                     preview renderer draws as spheres
+ *   LIFE_EMIT_CUBES   one RiPointsPolygons of unit cubes, 8 vertices and
+ *                     6 quads a cell
+ *
+ * The arrays come from the arena and must live until the primitive has
+ * been handed over, which for a frame means until frame_arena_reset().
+ * If the arena can't grow the cells are left out of the frame, with a
+ * message, rather than the whole render failing.
+ */
+typedef enum life_emit_mode_e {
+    LIFE_EMIT_SPHERES,
+    LIFE_EMIT_POINTS,
+    LIFE_EMIT_CUBES
+} life_emit_mode_t;
+
+/* LIFE_EMIT=spheres|points|cubes from the environment, points by default */
+life_emit_mode_t life_emit_mode(void);
+
+void life_emit(const life_board_t *board, life_emit_mode_t mode, frame_arena_t *arena);
+
+/*
+ * The same for a 3D grid: a cell at (x - width/2, z, y - height/2) for
+ * every live (x, y, z), so its layers stack up like a board's generations
+ * (and like life_mesh_push_rows() puts them).  A sphere a cell would be
+ * millions of calls for a busy grid, so LIFE_EMIT_SPHERES gives points.
+ */
+void life_emit_3d(const life3d_t *grid, life_emit_mode_t mode, frame_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
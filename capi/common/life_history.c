@@ -0,0 +1,200 @@
+#include "life_history.h"
+
+#include <string.h>
+
+static int reserve(life_history_t *hist, size_t bytes) {
+    if (hist->used + bytes > hist->capacity) {
+        size_t capacity = hist->capacity*2;
+        uint8_t *data;
+        while (capacity < hist->used + bytes) {
+            capacity *= 2;
+        }
+        data = realloc(hist->data, capacity);
+        if (data == NULL) {
+            return 1;
+        }
+        hist->data = data;
+        hist->capacity = capacity;
+    }
+    return 0;
+}
+
+static void put_varint(life_history_t *hist, uint64_t v) {
+    while (v >= 0x80) {
+        hist->data[hist->used++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    hist->data[hist->used++] = (uint8_t)v;
+}
+
+static uint64_t get_varint(const uint8_t **p) {
+    uint64_t v = 0;
+    int shift = 0;
+    while (**p & 0x80) {
+        v |= (uint64_t)(*(*p)++ & 0x7F) << shift;
+        shift += 7;
+    }
+    return v | ((uint64_t)*(*p)++ << shift);
+}
+
+int life_history_init(life_history_t *hist, size_t width, size_t height, size_t keyframe_interval) {
+    hist->width = width;
+    hist->height = height;
+    hist->keyframe_interval = keyframe_interval ? keyframe_interval : LIFE_HISTORY_KEYFRAMES;
+    hist->used = 0;
+    hist->capacity = 4096;
+    hist->data = malloc(hist->capacity);
+    hist->num_gens = 0;
+    hist->max_gens = 64;
+    hist->offsets = malloc(sizeof(size_t)*(hist->max_gens+1));
+    if (hist->data == NULL || hist->offsets == NULL || life_board_init(&hist->last, width, height)) {
+        free(hist->data);
+        free(hist->offsets);
+        return 1;
+    }
+    hist->offsets[0] = 0;
+    return 0;
+}
+
+void life_history_free(life_history_t *hist) {
+    free(hist->data);
+    free(hist->offsets);
+    life_board_free(&hist->last);
+    hist->data = NULL;
+    hist->offsets = NULL;
+    hist->num_gens = hist->used = hist->capacity = 0;
+}
+
+/* Word i of the board in row order, XORed with the last generation unless this is a keyframe */
+static uint64_t word_at(const life_history_t *hist, const life_board_t *board, size_t i, int key) {
+    uint64_t v = life_board_row(board, i / board->words)[i % board->words];
+    return key ? v : v ^ life_board_row(&hist->last, i / board->words)[i % board->words];
+}
+
+int life_history_push(life_history_t *hist, const life_board_t *board) {
+    int key = hist->num_gens % hist->keyframe_interval == 0;
+    size_t total = board->words*board->height, i = 0;
+    /* Where the record starts, to drop what's been written if it fails */
+    size_t used = hist->used;
+
+    if (board->width != hist->width || board->height != hist->height) {
+        return 1;
+    }
+    if (hist->num_gens == hist->max_gens) {
+        size_t *offsets = realloc(hist->offsets, sizeof(size_t)*(hist->max_gens*2+1));
+        if (offsets == NULL) {
+            return 1;
+        }
+        hist->offsets = offsets;
+        hist->max_gens *= 2;
+    }
+
+    for (;;) {
+        size_t zeros = 0, start;
+        while (i < total && word_at(hist, board, i, key) == 0) {
+            ++zeros;
+            ++i;
+        }
+        /* A lone zero word stays in the literals; a new run costs more */
+        for (start=i; i<total; ++i) {
+            if (word_at(hist, board, i, key) == 0 &&
+                (i+1 == total || word_at(hist, board, i+1, key) == 0)) {
+                break;
+            }
+        }
+        if (reserve(hist, 20 + 8*(i - start))) {
+            hist->used = used;
+            return 1;
+        }
+        put_varint(hist, zeros);
+        /* No literals marks the end of the record */
+        put_varint(hist, i - start);
+        if (i == start) {
+            break;
+        }
+        for (; start<i; ++start) {
+            uint64_t lit = word_at(hist, board, start, key);
+            memcpy(hist->data + hist->used, &lit, sizeof(lit));
+            hist->used += sizeof(lit);
+        }
+    }
+
+    if (life_board_copy(&hist->last, board)) {
+        hist->used = used;
+        return 1;
+    }
+    hist->num_gens++;
+    hist->offsets[hist->num_gens] = hist->used;
+    return 0;
+}
+
+size_t life_history_bytes(const life_history_t *hist) {
+    return hist->used + sizeof(size_t)*(hist->num_gens+1);
+}
+
+/* Applies generation gen's record: a keyframe replaces the board, a delta XORs into it */
+static void decode(const life_history_t *hist, size_t gen, life_board_t *board) {
+    const uint8_t *p = hist->data + hist->offsets[gen];
+    size_t words = board->words, pos = 0;
+    int key = gen % hist->keyframe_interval == 0;
+
+    /* A keyframe may differ anywhere from whatever the board held */
+    if (key) {
+        life_board_clear(board);
+    } else {
+        life_board_settle(board);
+    }
+    for (;;) {
+        size_t lits;
+        pos += (size_t)get_varint(&p);
+        lits = (size_t)get_varint(&p);
+        if (lits == 0) {
+            break;
+        }
+        while (lits-- > 0) {
+            uint64_t lit;
+            memcpy(&lit, p, sizeof(lit));
+            p += sizeof(lit);
+            life_board_xor(board, pos / words, pos % words, lit);
+            ++pos;
+        }
+    }
+}
+
+int life_history_get(const life_history_t *hist, size_t gen, life_board_t *board) {
+    size_t g;
+    if (gen >= hist->num_gens || board->width != hist->width || board->height != hist->height) {
+        return 1;
+    }
+    for (g = gen - gen % hist->keyframe_interval; g <= gen; ++g) {
+        decode(hist, g, board);
+    }
+    return 0;
+}
+
+int life_history_iter_init(life_history_iter_t *it, const life_history_t *hist,
+                           size_t first, size_t end) {
+    it->hist = hist;
+    it->end = end < hist->num_gens ? end : hist->num_gens;
+    /* Catch up from the keyframe at or before first, so next() gives first */
+    it->gen = first - first % hist->keyframe_interval;
+    if (life_board_init(&it->board, hist->width, hist->height)) {
+        return 1;
+    }
+    while (it->gen < first && it->gen < it->end) {
+        decode(hist, it->gen++, &it->board);
+    }
+    return 0;
+}
+
+void life_history_iter_free(life_history_iter_t *it) {
+    life_board_free(&it->board);
+}
+
+const life_board_t *life_history_iter_next(life_history_iter_t *it) {
+    if (it->gen >= it->end) {
+        return NULL;
+    }
+    decode(it->hist, it->gen++, &it->board);
+    return &it->board;
+}
@@ -0,0 +1,84 @@
+#ifndef LIFE_HISTORY_H
+#define LIFE_HISTORY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every generation of a Life run, compressed, for renderers that draw the
+ * whole stack of them.
+ *
+ * Each generation is stored as its XOR with the one before, which for a
+ * settling pattern is almost all zero words, so it's run length coded:
+ * a varint count of zero words, a varint count of literal words, then the
+ * literals, until the board is covered.  Every keyframe_interval-th
+ * generation is coded the same way but whole, so getting at generation g
+ * means decoding at most keyframe_interval-1 deltas after a keyframe.
+ *
+ * A life_history_iter_t decodes generations in order into one board it
+ * owns, XORing each delta in place, so walking the stack costs one board
+ * of memory and time in proportion to what changed.  The board's changed
+ * tiles (see life_board.h) are the ones the delta touched.
+ */
+#define LIFE_HISTORY_KEYFRAMES 64
+
+typedef struct life_history_s {
+    size_t width;
+    size_t height;
+    size_t keyframe_interval;
+
+    /* Generation g's record is bytes [offsets[g], offsets[g+1]) of data */
+    uint8_t *data;
+    size_t used;
+    size_t capacity;
+    size_t *offsets;
+    size_t num_gens;
+    size_t max_gens;
+
+    /* The last generation pushed, to take the next one's XOR against */
+    life_board_t last;
+} life_history_t;
+
+/* keyframe_interval 0 means LIFE_HISTORY_KEYFRAMES; returns 0 on success */
+int life_history_init(life_history_t *hist, size_t width, size_t height, size_t keyframe_interval);
+void life_history_free(life_history_t *hist);
+
+/*
+ * Appends the next generation, which must be the history's size.  Returns 0
+ * on success, leaving the history as it was otherwise.
+ */
+int life_history_push(life_history_t *hist, const life_board_t *board);
+
+/* Compressed bytes, not counting the last board kept for the next delta */
+size_t life_history_bytes(const life_history_t *hist);
+
+/* Generation gen, into a board of the history's size; returns 0 on success */
+int life_history_get(const life_history_t *hist, size_t gen, life_board_t *board);
+
+typedef struct life_history_iter_s {
+    const life_history_t *hist;
+    /* The next generation to decode into board */
+    size_t gen;
+    size_t end;
+    life_board_t board;
+} life_history_iter_t;
+
+/* Generations [first, end), end clamped to what's stored; returns 0 on success */
+int life_history_iter_init(life_history_iter_t *it, const life_history_t *hist,
+                           size_t first, size_t end);
+void life_history_iter_free(life_history_iter_t *it);
+
+/* The next generation, or NULL after the last; valid until the next call */
+const life_board_t *life_history_iter_next(life_history_iter_t *it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+#include "life_kernels.h"
+
+#include <string.h>
+
+/* One kernel: the instruction set's loop with the kind of rule filled in */
+#define LIFE_ROW_KERNEL(isa, attr, name, kind)                          \
+    attr size_t life_row_##isa##_##name(const uint64_t *up, const uint64_t *mid, \
+                                        const uint64_t *down, uint64_t *out, uint64_t *diff, \
+                                        size_t first, size_t end, const life_rule_t *rule) { \
+        return isa##_row(up, mid, down, out, diff, first, end, rule, kind); \
+    }
+
+#define LIFE_ROW_KERNELS(isa, attr)                                     \
+    LIFE_ROW_KERNEL(isa, attr, conway, LIFE_RULE_CONWAY)                \
+    LIFE_ROW_KERNEL(isa, attr, highlife, LIFE_RULE_HIGHLIFE)            \
+    LIFE_ROW_KERNEL(isa, attr, daynight, LIFE_RULE_DAY_NIGHT)           \
+    LIFE_ROW_KERNEL(isa, attr, seeds, LIFE_RULE_SEEDS)                  \
+    LIFE_ROW_KERNEL(isa, attr, table, LIFE_RULE_TABLE)
+
+LIFE_INLINE size_t scalar_row(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                              uint64_t *out, uint64_t *diff, size_t first, size_t end,
+                              const life_rule_t *rule, life_rule_kind_t kind) {
+    /* A copy, which the stores to out can't be writing over */
+    uint64_t table[18];
+    size_t w, n = 0;
+
+    if (kind == LIFE_RULE_TABLE) {
+        memcpy(table, rule->table, sizeof(table));
+    }
+    for (w=first; w<end; ++w) {
+        uint64_t next = life_next(kind, table, (up[w] << 1) | (up[w-1] >> 63), up[w],
+                                  (up[w] >> 1) | (up[w+1] << 63),
+                                  (mid[w] << 1) | (mid[w-1] >> 63), mid[w],
+                                  (mid[w] >> 1) | (mid[w+1] << 63),
+                                  (down[w] << 1) | (down[w-1] >> 63), down[w],
+                                  (down[w] >> 1) | (down[w+1] << 63));
+        out[w] = next;
+        if (diff != NULL) {
+            diff[w-first] |= next ^ mid[w];
+        }
+        n += life_popcount64(next);
+    }
+    return n;
+}
+
+LIFE_ROW_KERNELS(scalar, )
+
+#ifdef LIFE_X86_KERNELS
+
+/* The rule's table, broadcast, for the LIFE_RULE_TABLE kernels */
+#define LIFE_LOAD_TABLE(table, SET1)                                    \
+    if (kind == LIFE_RULE_TABLE) {                                      \
+        int n_;                                                         \
+        for (n_=0; n_<18; ++n_) {                                       \
+            table[n_] = SET1((long long)rule->table[n_]);               \
+        }                                                               \
+    }
+
+LIFE_INLINE __attribute__((target("sse2")))
+size_t sse2_row(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                uint64_t *out, uint64_t *diff, size_t first, size_t end,
+                const life_rule_t *rule, life_rule_kind_t kind) {
+    typedef __m128i T;
+    T acc = _mm_setzero_si128(), zero = _mm_setzero_si128(), ones = _mm_set1_epi64x(-1);
+    T table[18];
+    uint64_t lanes[2];
+    size_t w;
+
+    LIFE_LOAD_TABLE(table, _mm_set1_epi64x);
+    for (w=first; w+2<=end; w+=2) {
+        T uw, uc, ue, mw, mc, me, dw, dc, de, next;
+        LIFE_LOAD_ROW(T, SSE2_LOAD, _mm_slli_epi64, _mm_srli_epi64, _mm_or_si128, up, w, uw, uc, ue);
+        LIFE_LOAD_ROW(T, SSE2_LOAD, _mm_slli_epi64, _mm_srli_epi64, _mm_or_si128, mid, w, mw, mc, me);
+        LIFE_LOAD_ROW(T, SSE2_LOAD, _mm_slli_epi64, _mm_srli_epi64, _mm_or_si128, down, w, dw, dc, de);
+        LIFE_NEXT(kind, table, T, _mm_xor_si128, _mm_and_si128, _mm_or_si128, _mm_andnot_si128,
+                  SSE2_XOR3, SSE2_MAJ, ones);
+        _mm_storeu_si128((__m128i *)(out + w), next);
+        if (diff != NULL) {
+            T d = _mm_or_si128(SSE2_LOAD(diff + w - first), _mm_xor_si128(next, mc));
+            _mm_storeu_si128((__m128i *)(diff + w - first), d);
+        }
+        LIFE_POPCOUNT_VEC(acc, next, _mm_set1_epi64x, _mm_srli_epi64, _mm_and_si128,
+                          _mm_add_epi8, _mm_sub_epi8, _mm_sad_epu8, _mm_add_epi64, zero);
+    }
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    if (diff != NULL) {
+        diff += w - first;
+    }
+    return lanes[0] + lanes[1] + scalar_row(up, mid, down, out, diff, w, end, rule, kind);
+}
+
+LIFE_ROW_KERNELS(sse2, __attribute__((target("sse2"))))
+
+LIFE_INLINE __attribute__((target("avx2")))
+size_t avx2_row(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                uint64_t *out, uint64_t *diff, size_t first, size_t end,
+                const life_rule_t *rule, life_rule_kind_t kind) {
+    typedef __m256i T;
+    T acc = _mm256_setzero_si256(), zero = _mm256_setzero_si256(), ones = _mm256_set1_epi64x(-1);
+    T table[18];
+    uint64_t lanes[4];
+    size_t w;
+
+    LIFE_LOAD_TABLE(table, _mm256_set1_epi64x);
+    for (w=first; w+4<=end; w+=4) {
+        T uw, uc, ue, mw, mc, me, dw, dc, de, next;
+        LIFE_LOAD_ROW(T, AVX2_LOAD, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_or_si256, up, w, uw, uc, ue);
+        LIFE_LOAD_ROW(T, AVX2_LOAD, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_or_si256, mid, w, mw, mc, me);
+        LIFE_LOAD_ROW(T, AVX2_LOAD, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_or_si256, down, w, dw, dc, de);
+        LIFE_NEXT(kind, table, T, _mm256_xor_si256, _mm256_and_si256, _mm256_or_si256,
+                  _mm256_andnot_si256, AVX2_XOR3, AVX2_MAJ, ones);
+        _mm256_storeu_si256((__m256i *)(out + w), next);
+        if (diff != NULL) {
+            T d = _mm256_or_si256(AVX2_LOAD(diff + w - first), _mm256_xor_si256(next, mc));
+            _mm256_storeu_si256((__m256i *)(diff + w - first), d);
+        }
+        LIFE_POPCOUNT_VEC(acc, next, _mm256_set1_epi64x, _mm256_srli_epi64, _mm256_and_si256,
+                          _mm256_add_epi8, _mm256_sub_epi8, _mm256_sad_epu8, _mm256_add_epi64, zero);
+    }
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    if (diff != NULL) {
+        diff += w - first;
+    }
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+        scalar_row(up, mid, down, out, diff, w, end, rule, kind);
+}
+
+LIFE_ROW_KERNELS(avx2, __attribute__((target("avx2"))))
+
+LIFE_INLINE __attribute__((target("avx512f,avx512bw")))
+size_t avx512_row(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                  uint64_t *out, uint64_t *diff, size_t first, size_t end,
+                  const life_rule_t *rule, life_rule_kind_t kind) {
+    typedef __m512i T;
+    T acc = _mm512_setzero_si512(), zero = _mm512_setzero_si512(), ones = _mm512_set1_epi64(-1);
+    T table[18];
+    size_t w;
+
+    LIFE_LOAD_TABLE(table, _mm512_set1_epi64);
+    for (w=first; w+8<=end; w+=8) {
+        T uw, uc, ue, mw, mc, me, dw, dc, de, next;
+        LIFE_LOAD_ROW(T, AVX512_LOAD, _mm512_slli_epi64, _mm512_srli_epi64, _mm512_or_si512, up, w, uw, uc, ue);
+        LIFE_LOAD_ROW(T, AVX512_LOAD, _mm512_slli_epi64, _mm512_srli_epi64, _mm512_or_si512, mid, w, mw, mc, me);
+        LIFE_LOAD_ROW(T, AVX512_LOAD, _mm512_slli_epi64, _mm512_srli_epi64, _mm512_or_si512, down, w, dw, dc, de);
+        LIFE_NEXT(kind, table, T, _mm512_xor_si512, _mm512_and_si512, _mm512_or_si512,
+                  _mm512_andnot_si512, AVX512_XOR3, AVX512_MAJ, ones);
+        _mm512_storeu_si512((void *)(out + w), next);
+        if (diff != NULL) {
+            T d = _mm512_or_si512(AVX512_LOAD(diff + w - first), _mm512_xor_si512(next, mc));
+            _mm512_storeu_si512((void *)(diff + w - first), d);
+        }
+        LIFE_POPCOUNT_VEC(acc, next, _mm512_set1_epi64, _mm512_srli_epi64, _mm512_and_si512,
+                          _mm512_add_epi8, _mm512_sub_epi8, _mm512_sad_epu8, _mm512_add_epi64, zero);
+    }
+    if (diff != NULL) {
+        diff += w - first;
+    }
+    return (size_t)_mm512_reduce_add_epi64(acc) +
+        scalar_row(up, mid, down, out, diff, w, end, rule, kind);
+}
+
+LIFE_ROW_KERNELS(avx512, __attribute__((target("avx512f,avx512bw"))))
+
+#endif
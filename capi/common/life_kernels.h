@@ -0,0 +1,205 @@
+#ifndef LIFE_KERNELS_H
+#define LIFE_KERNELS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_rule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The inner loops of life_evolve(), one per instruction set and kind of
+ * rule.  A row kernel computes words [first, end) of an output row from
+ * the rows above, at and below it, and returns how many of those cells
+ * are alive.  It reads the words either side of each one for the carries
+ * between words, so first must be at least 1 and end at most the row's
+ * word count less 1; life_board.c handles the two words that wrap around
+ * the torus.  Unless diff is NULL, each output word's XOR with the word it
+ * replaces (mid's) is ORed into diff[w - first], which is how
+ * life_evolve() finds the tiles that changed without reading the rows
+ * again.
+ *
+ * Every kernel is compiled into every x86 build (with per-function target
+ * attributes), and life_board.c picks the best one the CPU reports with
+ * cpuid, so one binary runs everywhere and uses AVX-512 where it exists.
+ *
+ * Each instruction set's loop is written once, as an always inlined
+ * function taking the rule's kind, and the kernels are that function with
+ * the kind filled in, so the switch on it folds away and each of the
+ * common rules costs no more than its few bitwise operations (as a C++
+ * template specialised on the rule would).  The LIFE_RULE_TABLE kernels
+ * take the rule's table from rule; the others ignore it.
+ */
+typedef size_t (*life_row_kernel_t)(const uint64_t *up, const uint64_t *mid,
+                                    const uint64_t *down, uint64_t *out, uint64_t *diff,
+                                    size_t first, size_t end, const life_rule_t *rule);
+
+/* life_row_<isa>_<rule> for each kind of rule */
+#define LIFE_ROW_KERNEL_DECLS(isa)                                      \
+    size_t life_row_##isa##_conway(const uint64_t *, const uint64_t *, const uint64_t *, \
+                                   uint64_t *, uint64_t *, size_t, size_t, const life_rule_t *); \
+    size_t life_row_##isa##_highlife(const uint64_t *, const uint64_t *, const uint64_t *, \
+                                     uint64_t *, uint64_t *, size_t, size_t, const life_rule_t *); \
+    size_t life_row_##isa##_daynight(const uint64_t *, const uint64_t *, const uint64_t *, \
+                                     uint64_t *, uint64_t *, size_t, size_t, const life_rule_t *); \
+    size_t life_row_##isa##_seeds(const uint64_t *, const uint64_t *, const uint64_t *, \
+                                  uint64_t *, uint64_t *, size_t, size_t, const life_rule_t *); \
+    size_t life_row_##isa##_table(const uint64_t *, const uint64_t *, const uint64_t *, \
+                                  uint64_t *, uint64_t *, size_t, size_t, const life_rule_t *);
+
+LIFE_ROW_KERNEL_DECLS(scalar)
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LIFE_X86_KERNELS 1
+/* 2, 4 and 8 words (128, 256 and 512 cells) per step */
+LIFE_ROW_KERNEL_DECLS(sse2)
+LIFE_ROW_KERNEL_DECLS(avx2)
+LIFE_ROW_KERNEL_DECLS(avx512)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define life_popcount64(x) ((size_t)__builtin_popcountll(x))
+#else
+static inline size_t life_popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (size_t)((x*0x0101010101010101ULL) >> 56);
+}
+#endif
+
+/*
+ * The next state of a word or vector of cells mc from the words holding
+ * their eight neighbours (uw, uc, ue above, mw and me either side, dw,
+ * dc, de below; w and e are a row shifted by one cell either way), left
+ * in next.  XOR3 and MAJ are the sum and carry of a full adder; ANDN(a, b)
+ * is ~a & b, as the instructions have it; ones is all ones.
+ *
+ * The three rows are summed as 2 bit counts with full adders, then added
+ * up to a 4 bit count s3..s0.  Its bit 3 is only set for a count of 8, and
+ * then the rest are clear, which the folded rules lean on.  The table rule
+ * matches the count against 0 to 8 and ORs together the matches table says
+ * are born (for dead cells) or survive (for live ones).
+ */
+#define LIFE_NEXT(kind, table, T, XOR, AND, OR, ANDN, XOR3, MAJ, ones)  \
+    {                                                                   \
+        T u0 = XOR3(uw, uc, ue), u1 = MAJ(uw, uc, ue);                  \
+        T d0 = XOR3(dw, dc, de), d1 = MAJ(dw, dc, de);                  \
+        T m0 = XOR(mw, me), m1 = AND(mw, me);                           \
+        T x0 = XOR(u0, d0), k0 = AND(u0, d0);                           \
+        T x1 = XOR3(u1, d1, k0), x2 = MAJ(u1, d1, k0);                  \
+        T s0 = XOR(x0, m0), k1 = AND(x0, m0);                           \
+        T s1 = XOR3(x1, m1, k1), k2 = MAJ(x1, m1, k1);                  \
+        T s2 = XOR(x2, k2), s3 = AND(x2, k2);                           \
+        switch (kind) {                                                 \
+        case LIFE_RULE_CONWAY:                                          \
+            /* 3, or 2 if alive */                                      \
+            next = ANDN(s2, AND(s1, OR(s0, mc)));                       \
+            break;                                                      \
+        case LIFE_RULE_HIGHLIFE:                                        \
+            /* Conway's, or 6 if dead */                                \
+            next = OR(ANDN(s2, AND(s1, OR(s0, mc))),                    \
+                      ANDN(OR(s0, mc), AND(s2, s1)));                   \
+            break;                                                      \
+        case LIFE_RULE_DAY_NIGHT:                                       \
+            /* 8, 6 or 7, 3, or 4 if alive */                           \
+            next = OR(OR(s3, AND(s2, s1)),                              \
+                      OR(ANDN(s2, AND(s1, s0)), AND(mc, ANDN(OR(s1, s0), s2)))); \
+            break;                                                      \
+        case LIFE_RULE_SEEDS:                                           \
+            /* 2 if dead */                                             \
+            next = ANDN(OR(OR(mc, s2), s0), s1);                        \
+            break;                                                      \
+        default: {                                                      \
+            T lo[4], h0 = ANDN(OR(s3, s2), ones), eq;                   \
+            T born = AND(s3, (table)[8]), live = AND(s3, (table)[17]);  \
+            int n_;                                                     \
+            lo[0] = ANDN(OR(s1, s0), ones);                             \
+            lo[1] = ANDN(s1, s0);                                       \
+            lo[2] = ANDN(s0, s1);                                       \
+            lo[3] = AND(s1, s0);                                        \
+            for (n_=0; n_<4; ++n_) {                                    \
+                eq = AND(h0, lo[n_]);                                   \
+                born = OR(born, AND(eq, (table)[n_]));                  \
+                live = OR(live, AND(eq, (table)[9+n_]));                \
+                eq = AND(s2, lo[n_]);                                   \
+                born = OR(born, AND(eq, (table)[4+n_]));                \
+                live = OR(live, AND(eq, (table)[13+n_]));               \
+            }                                                           \
+            next = OR(ANDN(mc, born), AND(mc, live));                   \
+            break;                                                      \
+        }                                                               \
+        }                                                               \
+    }
+
+#define LIFE_XOR(a, b) ((a) ^ (b))
+#define LIFE_AND(a, b) ((a) & (b))
+#define LIFE_OR(a, b) ((a) | (b))
+#define LIFE_ANDN(a, b) (~(a) & (b))
+#define LIFE_XOR3(a, b, c) ((a) ^ (b) ^ (c))
+#define LIFE_MAJ(a, b, c) (((a) & (b)) | ((c) & ((a) ^ (b))))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LIFE_INLINE static inline __attribute__((always_inline))
+#else
+#define LIFE_INLINE static inline
+#endif
+
+/* LIFE_NEXT() on 64 cells; table is the rule's, as in life_rule_t */
+LIFE_INLINE uint64_t life_next(life_rule_kind_t kind, const uint64_t *table,
+                               uint64_t uw, uint64_t uc, uint64_t ue,
+                               uint64_t mw, uint64_t mc, uint64_t me,
+                               uint64_t dw, uint64_t dc, uint64_t de) {
+    uint64_t next;
+    LIFE_NEXT(kind, table, uint64_t, LIFE_XOR, LIFE_AND, LIFE_OR, LIFE_ANDN,
+              LIFE_XOR3, LIFE_MAJ, ~(uint64_t)0);
+    return next;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef LIFE_X86_KERNELS
+/* Vector helpers the kernels share with life3d.c */
+#include <immintrin.h>
+
+/* Bytewise popcount, then summed into the 64 bit lanes of acc by SAD */
+#define LIFE_POPCOUNT_VEC(acc, v, SET1, SRLI, AND, ADD8, SUB8, SAD, ADD64, ZERO) \
+    {                                                                   \
+        T c = SUB8(v, AND(SRLI(v, 1), SET1(0x5555555555555555LL)));     \
+        c = ADD8(AND(c, SET1(0x3333333333333333LL)),                    \
+                 AND(SRLI(c, 2), SET1(0x3333333333333333LL)));          \
+        c = AND(ADD8(c, SRLI(c, 4)), SET1(0x0F0F0F0F0F0F0F0FLL));       \
+        acc = ADD64(acc, SAD(c, ZERO));                                 \
+    }
+
+/* Each cell's west and east neighbours, from loads one word either side */
+#define LIFE_LOAD_ROW(T, LOAD, SLLI, SRLI, OR, row, w, west, centre, east) \
+    {                                                                   \
+        T prev = LOAD((const void *)((row) + (w) - 1));                 \
+        T nxt = LOAD((const void *)((row) + (w) + 1));                  \
+        centre = LOAD((const void *)((row) + (w)));                     \
+        west = OR(SLLI(centre, 1), SRLI(prev, 63));                     \
+        east = OR(SRLI(centre, 1), SLLI(nxt, 63));                      \
+    }
+
+#define SSE2_XOR3(a, b, c) _mm_xor_si128(_mm_xor_si128(a, b), c)
+#define SSE2_MAJ(a, b, c) _mm_or_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_xor_si128(a, b)))
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+
+#define AVX2_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+#define AVX2_MAJ(a, b, c) _mm256_or_si256(_mm256_and_si256(a, b), \
+                                          _mm256_and_si256(c, _mm256_xor_si256(a, b)))
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+
+/* vpternlogq does a whole full adder half in one instruction */
+#define AVX512_XOR3(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0x96)
+#define AVX512_MAJ(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0xE8)
+#define AVX512_LOAD(p) _mm512_loadu_si512(p)
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#include "life_lut.h"
+
+#include <string.h>
+
+#define LOW7 0x7F7F7F7F7F7F7F7FULL
+#define HIGH 0x8080808080808080ULL
+
+int life_lut_init(life_lut_t *lut, const life_rule_t *rule, size_t width) {
+    int index;
+
+    for (index=0; index<512; ++index) {
+        int n = 0, bit;
+        for (bit=0; bit<9; ++bit) {
+            if (bit != 4) {
+                n += (index >> bit) & 1;
+            }
+        }
+        lut->next[index] = (((index >> 4) & 1 ? rule->survive : rule->birth) >> n) & 1;
+    }
+    lut->width = width;
+    lut->codes = malloc(width + 2);
+    if (lut->codes == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+void life_lut_free(life_lut_t *lut) {
+    free(lut->codes);
+    lut->codes = NULL;
+    lut->width = 0;
+}
+
+/* 1 in each byte of v that isn't 0, and 0 in the rest */
+static inline uint64_t nonzero_bytes(uint64_t v) {
+    return ((((v & LOW7) + LOW7) | v) & HIGH) >> 7;
+}
+
+/* The column codes of w cells, eight at a time as bytes of a word */
+static void column_codes(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                         uint8_t *codes, size_t w) {
+    size_t x;
+    for (x=0; x+8<=w; x+=8) {
+        uint64_t u, m, d, c;
+        memcpy(&u, up + x, 8);
+        memcpy(&m, mid + x, 8);
+        memcpy(&d, down + x, 8);
+        c = nonzero_bytes(u) | nonzero_bytes(m) << 1 | nonzero_bytes(d) << 2;
+        memcpy(codes + x, &c, 8);
+    }
+    for (; x<w; ++x) {
+        codes[x] = (uint8_t)((up[x] != 0) | (mid[x] != 0) << 1 | (down[x] != 0) << 2);
+    }
+}
+
+size_t life_lut_evolve_row(life_lut_t *lut, const uint8_t *up, const uint8_t *mid,
+                           const uint8_t *down, uint8_t *out) {
+    size_t w = lut->width, x, n = 0;
+    uint8_t *codes = lut->codes + 1;
+    unsigned index;
+
+    if (w == 0) {
+        return 0;
+    }
+    column_codes(up, mid, down, codes, w);
+    codes[-1] = codes[w-1];
+    codes[w] = codes[0];
+
+    /* Shifted down a column as the loop starts */
+    index = (unsigned)codes[-1] << 3 | (unsigned)codes[0] << 6;
+    for (x=0; x<w; ++x) {
+        unsigned alive;
+        index = (index >> 3) | (unsigned)codes[x+1] << 6;
+        alive = lut->next[index];
+        /* 0 if dying or staying dead, age+1 (but no more than 255) otherwise */
+        out[x] = (uint8_t)(-alive & (mid[x] + (mid[x] < 255)));
+        n += alive;
+    }
+    return n;
+}
+
+size_t life_lut_evolve(life_lut_t *lut, const uint8_t *cur, uint8_t *next, size_t height) {
+    size_t w = lut->width, y, n = 0;
+    for (y=0; y<height; ++y) {
+        n += life_lut_evolve_row(lut, cur + ((y+height-1) % height)*w, cur + y*w,
+                                 cur + ((y+1) % height)*w, next + y*w);
+    }
+    return n;
+}
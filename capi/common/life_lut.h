@@ -0,0 +1,53 @@
+#ifndef LIFE_LUT_H
+#define LIFE_LUT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_rule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Life on boards of a byte per cell, for callers that keep something per
+ * cell a packed life_board_t has no room for.  A cell's byte is its age:
+ * 0 if it's dead, otherwise how many generations it has been alive, up to
+ * 255, so a renderer can colour cells by how long they've lasted.
+ *
+ * Rather than counting eight neighbours and testing the rule, each row is
+ * turned into a 3 bit code per column (the cell above, at and below being
+ * alive), and each cell's 3x3 neighbourhood is then a 9 bit index rolled
+ * along the row, three bits in and three out per cell.  The next state is
+ * next[index], worked out from the rule once, and the age is updated in
+ * the same pass with arithmetic instead of tests, so there are no branches
+ * per cell.  The column codes are worked out eight cells at a time, as
+ * the bytes of a word.
+ *
+ * Index bits 0-2 are the column to the west (above, at, below), 3-5 the
+ * cell's own and 6-8 the column to the east, so the cell itself is bit 4.
+ */
+typedef struct life_lut_s {
+    uint8_t next[512];
+    size_t width;
+    /* Column codes of the row being worked out, with one either side for the wrap */
+    uint8_t *codes;
+} life_lut_t;
+
+/* For boards width cells wide under rule; returns 0 on success */
+int life_lut_init(life_lut_t *lut, const life_rule_t *rule, size_t width);
+void life_lut_free(life_lut_t *lut);
+
+/* One row of next from the rows above, at and below it; returns how many are alive */
+size_t life_lut_evolve_row(life_lut_t *lut, const uint8_t *up, const uint8_t *mid,
+                           const uint8_t *down, uint8_t *out);
+
+/* The generation after cur, a torus of height rows; returns how many are alive */
+size_t life_lut_evolve(life_lut_t *lut, const uint8_t *cur, uint8_t *next, size_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
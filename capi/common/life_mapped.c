@@ -0,0 +1,246 @@
+/* madvise() and ftruncate() are hidden by -std=c99 otherwise */
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+
+#include "life_mapped.h"
+#include "life_board.h"
+#include "life_kernels.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char magic[8] = {'L', 'I', 'F', 'E', 'M', 'A', 'P', '1'};
+
+/* The start of the file; the rest of LIFE_MAPPED_HEADER is zero */
+typedef struct header_s {
+    char magic[8];
+    uint64_t width;
+    uint64_t height;
+    uint64_t stride;
+    uint64_t num_on;
+    /* Both 0 in files from before there were other rules, which ran Conway's */
+    uint16_t birth;
+    uint16_t survive;
+} header_t;
+
+/* Closes fd if it fails */
+static int map_file(life_mapped_t *board, int fd, size_t bytes) {
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return 1;
+    }
+    board->fd = fd;
+    board->map = map;
+    board->map_bytes = bytes;
+    board->cells = (uint64_t*)(board->map + LIFE_MAPPED_HEADER);
+    return 0;
+}
+
+int life_mapped_create(life_mapped_t *board, const char *path, size_t width, size_t height) {
+    header_t header;
+    size_t bytes;
+    int fd;
+
+    board->width = width;
+    board->height = height;
+    board->words = (width + 63)/64;
+    board->stride = (board->words + LIFE_ROW_ALIGN - 1)/LIFE_ROW_ALIGN*LIFE_ROW_ALIGN;
+    board->num_on = 0;
+    life_rule_init(&board->rule, LIFE_CONWAY_BIRTH, LIFE_CONWAY_SURVIVE);
+    if (width == 0 || height == 0 || width > SIZE_MAX - 63) {
+        printf("Can't make a %lux%lu board\n", (unsigned long)width, (unsigned long)height);
+        return 1;
+    }
+    bytes = LIFE_MAPPED_HEADER + sizeof(uint64_t)*board->stride*height;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Could not create %s\n", path);
+        return 1;
+    }
+    /* A sparse file reads as zeros, so nothing is written for the dead cells */
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        printf("Could not make %s %lu bytes\n", path, (unsigned long)bytes);
+        close(fd);
+        return 1;
+    }
+    if (map_file(board, fd, bytes)) {
+        printf("Could not map %s\n", path);
+        return 1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.width = width;
+    header.height = height;
+    header.stride = board->stride;
+    header.birth = board->rule.birth;
+    header.survive = board->rule.survive;
+    memcpy(board->map, &header, sizeof(header));
+    return 0;
+}
+
+int life_mapped_open(life_mapped_t *board, const char *path) {
+    header_t header;
+    struct stat st;
+    int fd = open(path, O_RDWR);
+
+    if (fd < 0) {
+        printf("Could not open %s\n", path);
+        return 1;
+    }
+    if (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, magic, sizeof(magic)) != 0 || fstat(fd, &st) != 0) {
+        printf("%s isn't a Life board\n", path);
+        close(fd);
+        return 1;
+    }
+    if (header.width == 0 || header.height == 0 || header.width > SIZE_MAX - 63) {
+        printf("%s is damaged: a board can't be %lux%lu cells\n",
+               path, (unsigned long)header.width, (unsigned long)header.height);
+        close(fd);
+        return 1;
+    }
+    if (header.stride == 0 || header.stride < (header.width + 63)/64) {
+        printf("%s is damaged: rows of %lu cells can't be %lu words apart\n",
+               path, (unsigned long)header.width, (unsigned long)header.stride);
+        close(fd);
+        return 1;
+    }
+    /* Divided rather than multiplied out, so a bad header can't overflow its way past */
+    if ((uint64_t)st.st_size < LIFE_MAPPED_HEADER ||
+        ((uint64_t)st.st_size - LIFE_MAPPED_HEADER)/sizeof(uint64_t)/header.stride < header.height) {
+        printf("%s is damaged: %lu rows %lu words apart don't fit in %lu bytes\n",
+               path, (unsigned long)header.height, (unsigned long)header.stride,
+               (unsigned long)st.st_size);
+        close(fd);
+        return 1;
+    }
+    board->width = header.width;
+    board->height = header.height;
+    board->words = (board->width + 63)/64;
+    board->stride = header.stride;
+    board->num_on = header.num_on;
+    if (header.birth == 0 && header.survive == 0) {
+        header.birth = LIFE_CONWAY_BIRTH;
+        header.survive = LIFE_CONWAY_SURVIVE;
+    }
+    life_rule_init(&board->rule, header.birth, header.survive);
+    if (map_file(board, fd, (size_t)st.st_size)) {
+        printf("Could not map %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+void life_mapped_close(life_mapped_t *board) {
+    if (board->map != NULL) {
+        header_t *header = (header_t*)board->map;
+        header->num_on = board->num_on;
+        header->birth = board->rule.birth;
+        header->survive = board->rule.survive;
+        munmap(board->map, board->map_bytes);
+        close(board->fd);
+    }
+    board->map = NULL;
+    board->cells = NULL;
+    board->map_bytes = 0;
+}
+
+void life_mapped_set(life_mapped_t *board, size_t x, size_t y, int alive) {
+    uint64_t *word = &life_mapped_row(board, y)[x >> 6];
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if (alive && !(*word & bit)) {
+        *word |= bit;
+        board->num_on++;
+    } else if (!alive && (*word & bit)) {
+        *word &= ~bit;
+        board->num_on--;
+    }
+}
+
+size_t life_mapped_count(life_mapped_t *board) {
+    size_t n = 0, y, w;
+    for (y=0; y<board->height; ++y) {
+        const uint64_t *row = life_mapped_row(board, y);
+        for (w=0; w<board->words; ++w) {
+            n += life_popcount64(row[w]);
+        }
+    }
+    board->num_on = n;
+    return n;
+}
+
+/* Passes advice on for rows [y0, y1), widened to whole pages */
+static void advise(life_mapped_t *board, size_t y0, size_t y1, int advice) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = LIFE_MAPPED_HEADER + sizeof(uint64_t)*board->stride*y0;
+    size_t end = LIFE_MAPPED_HEADER + sizeof(uint64_t)*board->stride*y1;
+    start = start/page*page;
+    end = (end + page - 1)/page*page;
+    if (end > board->map_bytes) {
+        end = board->map_bytes;
+    }
+    if (end > start) {
+        madvise(board->map + start, end - start, advice);
+    }
+}
+
+int life_mapped_evolve(life_mapped_t *board) {
+    size_t h = board->height, stride = board->stride;
+    size_t rows = LIFE_MAPPED_BAND_BYTES/(sizeof(uint64_t)*stride);
+    size_t row_bytes = sizeof(uint64_t)*stride;
+    size_t y0, y, n = 0;
+    uint64_t *out, *above, *first;
+
+    if (h == 0) {
+        return 0;
+    }
+    if (rows == 0) {
+        rows = 1;
+    }
+    out = calloc(rows*stride, sizeof(uint64_t));
+    above = malloc(row_bytes);
+    first = malloc(row_bytes);
+    if (out == NULL || above == NULL || first == NULL) {
+        free(out);
+        free(above);
+        free(first);
+        return 1;
+    }
+
+    advise(board, 0, h, MADV_SEQUENTIAL);
+    /* The old rows the first and last bands need once they've been overwritten */
+    memcpy(above, life_mapped_row(board, h-1), row_bytes);
+    memcpy(first, life_mapped_row(board, 0), row_bytes);
+
+    for (y0=0; y0<h; y0+=rows) {
+        size_t y1 = y0 + rows < h ? y0 + rows : h;
+        advise(board, y1, y1 + rows < h ? y1 + rows : h, MADV_WILLNEED);
+
+        for (y=y0; y<y1; ++y) {
+            const uint64_t *up = (y == y0) ? above : life_mapped_row(board, y-1);
+            const uint64_t *down = (y+1 == h) ? first : life_mapped_row(board, y+1);
+            n += life_evolve_row(board->width, up, life_mapped_row(board, y), down,
+                                 out + (y-y0)*stride, &board->rule);
+        }
+        memcpy(above, life_mapped_row(board, y1-1), row_bytes);
+        memcpy(life_mapped_row(board, y0), out, row_bytes*(y1-y0));
+
+        /* Nothing reads the band before this one again */
+        if (y0 > 0) {
+            advise(board, y0 - rows, y0, MADV_DONTNEED);
+        }
+    }
+
+    board->num_on = n;
+    free(out);
+    free(above);
+    free(first);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#ifndef LIFE_MAPPED_H
+#define LIFE_MAPPED_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_rule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A Life board in a file, for boards of 64k x 64k cells and up that
+ * don't fit in memory, or only just do.
+ *
+ * The file is a LIFE_MAPPED_HEADER byte header, then the rows, laid out
+ * and padded exactly as a life_board_t's (so life_board.h's row functions
+ * and kernels work on them).  It's mapped shared, so the cells are read
+ * and written in place and the kernel pages them in and out as needed.
+ *
+ * life_mapped_evolve() steps the board one generation in place, a band of
+ * about LIFE_MAPPED_BAND_BYTES at a time.  Each band's next generation is
+ * worked out into a buffer and then copied over it, so all it needs to
+ * keep of the old generation is the last row of the band before and the
+ * first row of the board, for the wrap around.  The mapping is advised
+ * as sequential, the band after the one being worked on is prefetched,
+ * and the band before it is dropped from the mapping once it's been
+ * written, so only about three bands are resident at a time and a board
+ * bigger than memory evolves at about the speed of the disk.
+ */
+#define LIFE_MAPPED_HEADER 64
+#define LIFE_MAPPED_BAND_BYTES ((size_t)8*1024*1024)
+
+typedef struct life_mapped_s {
+    size_t width;
+    size_t height;
+    /* As for life_board_t */
+    size_t words;
+    size_t stride;
+    size_t num_on;
+    /* Conway's for a new file; kept in the header when closed */
+    life_rule_t rule;
+
+    int fd;
+    uint8_t *map;
+    size_t map_bytes;
+    uint64_t *cells;
+} life_mapped_t;
+
+/* A new file of all dead cells, replacing any that's there; returns 0 on success */
+int life_mapped_create(life_mapped_t *board, const char *path, size_t width, size_t height);
+
+/* An existing board file; returns 0 on success */
+int life_mapped_open(life_mapped_t *board, const char *path);
+
+/* Unmaps and closes; the cells are written back by the kernel */
+void life_mapped_close(life_mapped_t *board);
+
+static inline uint64_t *life_mapped_row(const life_mapped_t *board, size_t y) {
+    return board->cells + y*board->stride;
+}
+
+static inline int life_mapped_get(const life_mapped_t *board, size_t x, size_t y) {
+    return (int)((life_mapped_row(board, y)[x >> 6] >> (x & 63)) & 1);
+}
+
+/* Keeps num_on up to date */
+void life_mapped_set(life_mapped_t *board, size_t x, size_t y, int alive);
+
+/* Recounts num_on from the cells, for code that writes rows directly */
+size_t life_mapped_count(life_mapped_t *board);
+
+/* One generation, in place; returns 0 on success */
+int life_mapped_evolve(life_mapped_t *board);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
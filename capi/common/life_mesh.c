@@ -0,0 +1,312 @@
+#include "life_mesh.h"
+#include "life_kernels.h"
+
+#include <string.h>
+
+#define FREE_KEY (~(uint64_t)0)
+
+int life_mesh_init(life_mesh_t *mesh, size_t width, size_t height) {
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->width = width;
+    mesh->height = height;
+    mesh->words = (width + 63)/64;
+    return 0;
+}
+
+void life_mesh_free(life_mesh_t *mesh) {
+    free(mesh->cells);
+    free(mesh->nverts);
+    free(mesh->verts);
+    free(mesh->points);
+    free(mesh->keys);
+    free(mesh->slots);
+    free(mesh->mask);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+void life_mesh_reset(life_mesh_t *mesh) {
+    mesh->num_gens = 0;
+    mesh->num_cells = 0;
+}
+
+static uint64_t *gen_row(const life_mesh_t *mesh, size_t gen, size_t y) {
+    return mesh->cells + (gen*mesh->height + y)*mesh->words;
+}
+
+int life_mesh_push(life_mesh_t *mesh, const life_board_t *board) {
+    return life_mesh_push_rows(mesh, board->cells, board->stride);
+}
+
+int life_mesh_push_rows(life_mesh_t *mesh, const uint64_t *rows, size_t stride) {
+    size_t y, w;
+    if (mesh->num_gens == mesh->max_gens) {
+        size_t max = mesh->max_gens ? 2*mesh->max_gens : 16;
+        uint64_t *cells = realloc(mesh->cells, sizeof(uint64_t)*max*mesh->height*mesh->words);
+        if (cells == NULL) {
+            return 1;
+        }
+        mesh->cells = cells;
+        mesh->max_gens = max;
+    }
+    for (y=0; y<mesh->height; ++y) {
+        uint64_t *row = gen_row(mesh, mesh->num_gens, y);
+        memcpy(row, rows + y*stride, sizeof(uint64_t)*mesh->words);
+        for (w=0; w<mesh->words; ++w) {
+            mesh->num_cells += life_popcount64(row[w]);
+        }
+    }
+    mesh->num_gens++;
+    return 0;
+}
+
+static size_t slot_of(const life_mesh_t *mesh, uint64_t key) {
+    return (size_t)((key*0x9E3779B97F4A7C15ULL) >> 29) & (mesh->num_slots - 1);
+}
+
+/* Twice as many slots, with the points already in them put back */
+static int grow_slots(life_mesh_t *mesh) {
+    size_t old_slots = mesh->num_slots, i;
+    uint64_t *old_keys = mesh->keys;
+    RtInt *old_index = mesh->slots;
+
+    mesh->num_slots = old_slots ? 2*old_slots : 1024;
+    mesh->keys = malloc(sizeof(uint64_t)*mesh->num_slots);
+    mesh->slots = malloc(sizeof(RtInt)*mesh->num_slots);
+    if (mesh->keys == NULL || mesh->slots == NULL) {
+        free(mesh->keys);
+        free(mesh->slots);
+        mesh->keys = old_keys;
+        mesh->slots = old_index;
+        mesh->num_slots = old_slots;
+        return 1;
+    }
+    memset(mesh->keys, 0xFF, sizeof(uint64_t)*mesh->num_slots);
+    for (i=0; i<old_slots; ++i) {
+        if (old_keys[i] != FREE_KEY) {
+            size_t s = slot_of(mesh, old_keys[i]);
+            while (mesh->keys[s] != FREE_KEY) {
+                s = (s + 1) & (mesh->num_slots - 1);
+            }
+            mesh->keys[s] = old_keys[i];
+            mesh->slots[s] = old_index[i];
+        }
+    }
+    free(old_keys);
+    free(old_index);
+    return 0;
+}
+
+/* The index of lattice point (x, y, z), adding it if it's new; -1 if out of memory */
+static RtInt lattice_point(life_mesh_t *mesh, size_t x, size_t y, size_t z) {
+    uint64_t key = (uint64_t)x | (uint64_t)y << 21 | (uint64_t)z << 42;
+    size_t s;
+
+    if (2*(size_t)(mesh->num_points + 1) > mesh->num_slots && grow_slots(mesh)) {
+        return -1;
+    }
+    for (s=slot_of(mesh, key); mesh->keys[s] != FREE_KEY; s=(s + 1) & (mesh->num_slots - 1)) {
+        if (mesh->keys[s] == key) {
+            return mesh->slots[s];
+        }
+    }
+    if ((size_t)mesh->num_points == mesh->point_capacity) {
+        size_t cap = mesh->point_capacity ? 2*mesh->point_capacity : 1024;
+        RtPoint *points = realloc(mesh->points, sizeof(RtPoint)*cap);
+        if (points == NULL) {
+            return -1;
+        }
+        mesh->points = points;
+        mesh->point_capacity = cap;
+    }
+    /* Lattice points are cell corners, half a cell off the centres */
+    mesh->points[mesh->num_points][0] = (RtFloat)(x - mesh->width/2.0 - 0.5);
+    mesh->points[mesh->num_points][1] = (RtFloat)(y - 0.5);
+    mesh->points[mesh->num_points][2] = (RtFloat)(z - mesh->height/2.0 - 0.5);
+    mesh->keys[s] = key;
+    mesh->slots[s] = mesh->num_points;
+    return mesh->num_points++;
+}
+
+/*
+ * Each slice's mask is laid out (u, v): for faces across x it's (y, gen),
+ * and across the generations and y it's (x, y) and (x, gen).  Which way
+ * round a quad's corners go depends on that and the way it faces.
+ */
+enum { ACROSS_X, ACROSS_GEN, ACROSS_Y };
+
+/* Quad [u, u+du) x [v, v+dv) in slice s across axis, facing +axis if face is 1 */
+static int add_quad(life_mesh_t *mesh, int axis, size_t s, size_t u, size_t v,
+                    size_t du, size_t dv, int face) {
+    size_t us[4], vs[4];
+    RtInt corners[4];
+    int k;
+
+    if ((size_t)mesh->num_quads == mesh->quad_capacity) {
+        size_t cap = mesh->quad_capacity ? 2*mesh->quad_capacity : 1024;
+        RtInt *nverts = realloc(mesh->nverts, sizeof(RtInt)*cap);
+        RtInt *verts;
+        if (nverts == NULL) {
+            return 1;
+        }
+        mesh->nverts = nverts;
+        verts = realloc(mesh->verts, sizeof(RtInt)*4*cap);
+        if (verts == NULL) {
+            return 1;
+        }
+        mesh->verts = verts;
+        mesh->quad_capacity = cap;
+    }
+
+    us[0] = u;      vs[0] = v;
+    us[1] = u + du; vs[1] = v;
+    us[2] = u + du; vs[2] = v + dv;
+    us[3] = u;      vs[3] = v + dv;
+    for (k=0; k<4; ++k) {
+        switch (axis) {
+        case ACROSS_X:
+            corners[k] = lattice_point(mesh, s, vs[k], us[k]);
+            break;
+        case ACROSS_GEN:
+            corners[k] = lattice_point(mesh, us[k], s, vs[k]);
+            break;
+        default:
+            corners[k] = lattice_point(mesh, us[k], vs[k], s);
+            break;
+        }
+        if (corners[k] < 0) {
+            return 1;
+        }
+    }
+    /* In u, v order the corners wind about -x, -gen and +y; reversed to face the other way */
+    if ((axis == ACROSS_Y) != (face > 0)) {
+        RtInt t = corners[1];
+        corners[1] = corners[3];
+        corners[3] = t;
+    }
+    mesh->nverts[mesh->num_quads] = 4;
+    memcpy(mesh->verts + 4*mesh->num_quads, corners, sizeof(corners));
+    mesh->num_quads++;
+    return 0;
+}
+
+/* Covers the faces in mask, nu by nv, with as few quads as it greedily can */
+static int greedy(life_mesh_t *mesh, int axis, size_t s, int8_t *mask, size_t nu, size_t nv) {
+    size_t u, v, du, dv, k;
+
+    for (v=0; v<nv; ++v) {
+        int8_t *row = mask + v*nu;
+        for (u=0; u<nu; u+=du) {
+            int8_t face = row[u];
+            du = 1;
+            if (face == 0) {
+                continue;
+            }
+            while (u + du < nu && row[u + du] == face) {
+                ++du;
+            }
+            for (dv=1; v + dv < nv; ++dv) {
+                const int8_t *next = mask + (v + dv)*nu + u;
+                for (k=0; k<du && next[k] == face; ++k) {
+                }
+                if (k < du) {
+                    break;
+                }
+            }
+            for (k=0; k<dv; ++k) {
+                memset(mask + (v + k)*nu + u, 0, du);
+            }
+            if (add_quad(mesh, axis, s, u, v, du, dv, face)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* The faces between rows a and b (either may be NULL, for outside) into n cells of mask */
+static void row_faces(const uint64_t *a, const uint64_t *b, size_t words, size_t n, int8_t *mask) {
+    size_t w, bit;
+    for (w=0; w<words; ++w) {
+        uint64_t wa = a != NULL ? a[w] : 0, wb = b != NULL ? b[w] : 0;
+        /* Alive below and dead above faces up, and the other way down */
+        uint64_t up = wa & ~wb, down = wb & ~wa;
+        size_t end = (w+1)*64 < n ? 64 : n - w*64;
+        if ((up | down) == 0) {
+            memset(mask + w*64, 0, end);
+            continue;
+        }
+        for (bit=0; bit<end; ++bit) {
+            mask[w*64 + bit] = (int8_t)(((up >> bit) & 1) - ((down >> bit) & 1));
+        }
+    }
+}
+
+static int get(const life_mesh_t *mesh, size_t gen, size_t x, size_t y) {
+    return (int)((gen_row(mesh, gen, y)[x >> 6] >> (x & 63)) & 1);
+}
+
+int life_mesh_build(life_mesh_t *mesh) {
+    size_t w = mesh->width, h = mesh->height, gens = mesh->num_gens, s, v, u;
+    size_t area = w*h;
+
+    mesh->num_quads = 0;
+    mesh->num_points = 0;
+    if (mesh->num_slots > 0) {
+        memset(mesh->keys, 0xFF, sizeof(uint64_t)*mesh->num_slots);
+    }
+    if (w*gens > area) {
+        area = w*gens;
+    }
+    if (h*gens > area) {
+        area = h*gens;
+    }
+    if (area > mesh->mask_size) {
+        int8_t *mask = realloc(mesh->mask, area);
+        if (mask == NULL) {
+            return 1;
+        }
+        mesh->mask = mask;
+        mesh->mask_size = area;
+    }
+
+    /* Between generations s-1 and s, (x, y) */
+    for (s=0; s<=gens; ++s) {
+        for (v=0; v<h; ++v) {
+            row_faces(s > 0 ? gen_row(mesh, s-1, v) : NULL, s < gens ? gen_row(mesh, s, v) : NULL,
+                      mesh->words, w, mesh->mask + v*w);
+        }
+        if (greedy(mesh, ACROSS_GEN, s, mesh->mask, w, h)) {
+            return 1;
+        }
+    }
+    /* Between rows s-1 and s, (x, gen) */
+    for (s=0; s<=h; ++s) {
+        for (v=0; v<gens; ++v) {
+            row_faces(s > 0 ? gen_row(mesh, v, s-1) : NULL, s < h ? gen_row(mesh, v, s) : NULL,
+                      mesh->words, w, mesh->mask + v*w);
+        }
+        if (greedy(mesh, ACROSS_Y, s, mesh->mask, w, gens)) {
+            return 1;
+        }
+    }
+    /* Between columns s-1 and s, (y, gen) */
+    for (s=0; s<=w; ++s) {
+        for (v=0; v<gens; ++v) {
+            for (u=0; u<h; ++u) {
+                int a = s > 0 ? get(mesh, v, s-1, u) : 0;
+                int b = s < w ? get(mesh, v, s, u) : 0;
+                mesh->mask[v*h + u] = (int8_t)(a - b);
+            }
+        }
+        if (greedy(mesh, ACROSS_X, s, mesh->mask, h, gens)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void life_mesh_emit(const life_mesh_t *mesh) {
+    if (mesh->num_quads > 0) {
+        RiPointsPolygons(mesh->num_quads, mesh->nverts, mesh->verts, RI_P, mesh->points, RI_NULL);
+    }
+}
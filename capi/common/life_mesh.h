@@ -0,0 +1,89 @@
+#ifndef LIFE_MESH_H
+#define LIFE_MESH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ri.h"
+
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A stack of Life generations as one mesh: the live cells are unit voxels
+ * at (x - width/2, generation, y - height/2), as life_emit() places them
+ * with each generation a unit above the last, and only the faces between a
+ * live and a dead voxel are kept.  Those are merged greedily, slice by
+ * slice, into the biggest rectangles that cover them (Lysenko's greedy
+ * meshing), so a still life that lasts a hundred generations is a box of
+ * six quads instead of a hundred cubes, and the quads share their corners
+ * through a hash of the lattice points.  Faces are wound like life_emit()'s
+ * cubes.
+ *
+ * Generations are pushed oldest first; their cells are copied, packed,
+ * so the boards can be reused.  life_mesh_build() meshes everything pushed
+ * since the last life_mesh_reset(), and the arrays then stay put for
+ * life_mesh_emit() until the next build.  The mesh stops at the edges of
+ * the board; nothing is wrapped around.
+ */
+typedef struct life_mesh_s {
+    size_t width;
+    size_t height;
+    size_t words;
+
+    /* The pushed generations, words per row, height rows each */
+    uint64_t *cells;
+    size_t num_gens;
+    size_t max_gens;
+    size_t num_cells;
+
+    /* The mesh: num_quads quads of 4 corners each out of num_points points */
+    RtInt num_quads;
+    RtInt num_points;
+    RtInt *nverts;
+    RtInt *verts;
+    RtPoint *points;
+    size_t quad_capacity;
+    size_t point_capacity;
+
+    /* Lattice point to index in points; keys are ~0 when free */
+    uint64_t *keys;
+    RtInt *slots;
+    size_t num_slots;
+
+    /* One slice's faces, +1 or -1 for the way they face */
+    int8_t *mask;
+    size_t mask_size;
+} life_mesh_t;
+
+/* For boards width x height; returns 0 on success */
+int life_mesh_init(life_mesh_t *mesh, size_t width, size_t height);
+void life_mesh_free(life_mesh_t *mesh);
+
+/* Forgets the pushed generations */
+void life_mesh_reset(life_mesh_t *mesh);
+
+/* Another generation, on top of the last; returns 0 on success */
+int life_mesh_push(life_mesh_t *mesh, const life_board_t *board);
+
+/*
+ * The same from rows laid out as a board's, stride words apart, such as
+ * a layer of a life3d_t; a 3D grid pushed layer by layer comes out with
+ * layer z at height z.
+ */
+int life_mesh_push_rows(life_mesh_t *mesh, const uint64_t *rows, size_t stride);
+
+/* Returns 0 on success */
+int life_mesh_build(life_mesh_t *mesh);
+
+/* One RiPointsPolygons of the last build, if it has any faces */
+void life_mesh_emit(const life_mesh_t *mesh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
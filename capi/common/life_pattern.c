@@ -0,0 +1,280 @@
+#include "life_pattern.h"
+#include "rng.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Bits of prob life_pattern_random() keeps */
+#define RANDOM_BITS 8
+
+/* Turns on n cells of row y from x, wrapping around the board */
+static void set_run(life_board_t *board, size_t x, size_t y, size_t n) {
+    uint64_t *row = life_board_row(board, y % board->height);
+    x %= board->width;
+    while (n > 0) {
+        size_t len = n < board->width - x ? n : board->width - x;
+        size_t end = x + len;
+        while (x < end) {
+            size_t bit = x & 63;
+            size_t take = end - x < 64 - bit ? end - x : 64 - bit;
+            uint64_t mask = (take == 64) ? ~(uint64_t)0 : (((uint64_t)1 << take) - 1) << bit;
+            row[x >> 6] |= mask;
+            x += take;
+        }
+        n -= len;
+        x = 0;
+    }
+}
+
+/* After writing rows directly */
+static void finish(life_board_t *board) {
+    life_board_touch(board);
+    life_board_count(board);
+}
+
+static void clear_info(life_pattern_t *info) {
+    info->width = info->height = 0;
+    info->rule[0] = '\0';
+}
+
+static const char *next_line(const char *p) {
+    while (*p != '\0' && *p != '\n') {
+        ++p;
+    }
+    return *p == '\n' ? p+1 : p;
+}
+
+/* Copies the rule out of an RLE header line, "x = 3, y = 3, rule = B3/S23" */
+static void header_rule(const char *line, life_pattern_t *info) {
+    const char *r = strstr(line, "rule");
+    size_t n = 0;
+    if (r == NULL || r > next_line(line)) {
+        return;
+    }
+    r += 4;
+    while (*r == ' ' || *r == '\t' || *r == '=') {
+        ++r;
+    }
+    while (n+1 < sizeof(info->rule) && r[n] != '\0' && !isspace((unsigned char)r[n]) && r[n] != ',') {
+        info->rule[n] = r[n];
+        ++n;
+    }
+    info->rule[n] = '\0';
+}
+
+int life_pattern_read_rle(const char *text, life_board_t *board, size_t x0, size_t y0,
+                          life_pattern_t *info) {
+    life_pattern_t own;
+    const char *p = text;
+    size_t x = 0, y = 0, count = 0;
+    unsigned long w, h;
+
+    if (info == NULL) {
+        info = &own;
+    }
+    clear_info(info);
+    while (*p == '#' || *p == '\n' || *p == '\r') {
+        p = next_line(p);
+    }
+    if (sscanf(p, " x = %lu , y = %lu", &w, &h) != 2) {
+        printf("Missing the RLE header line\n");
+        return 1;
+    }
+    info->width = w;
+    info->height = h;
+    header_rule(p, info);
+    p = next_line(p);
+    if (board == NULL) {
+        return 0;
+    }
+
+    for (; *p != '\0' && *p != '!'; ++p) {
+        size_t n;
+        if (isdigit((unsigned char)*p)) {
+            count = count*10 + (size_t)(*p - '0');
+            continue;
+        }
+        if (isspace((unsigned char)*p)) {
+            continue;
+        }
+        n = count ? count : 1;
+        count = 0;
+        if (*p == 'b' || *p == '.') {
+            x += n;
+        } else if (*p == '$') {
+            y += n;
+            x = 0;
+        } else if (isalpha((unsigned char)*p)) {
+            /* o, or any state of a multi-state pattern, is alive */
+            set_run(board, x0 + x, y0 + y, n);
+            x += n;
+        } else {
+            printf("Unexpected '%c' in an RLE pattern\n", *p);
+            finish(board);
+            return 1;
+        }
+    }
+    finish(board);
+    return 0;
+}
+
+int life_pattern_read_cells(const char *text, life_board_t *board, size_t x0, size_t y0,
+                            life_pattern_t *info) {
+    life_pattern_t own;
+    const char *p = text;
+    size_t y = 0;
+
+    if (info == NULL) {
+        info = &own;
+    }
+    clear_info(info);
+    while (*p == '!') {
+        p = next_line(p);
+    }
+    for (; *p != '\0'; p = next_line(p), ++y) {
+        size_t x = 0;
+        while (p[x] != '\0' && p[x] != '\n' && p[x] != '\r') {
+            if (board != NULL && p[x] != '.' && !isspace((unsigned char)p[x])) {
+                size_t run = x;
+                while (p[run] == p[x]) {
+                    ++run;
+                }
+                set_run(board, x0 + x, y0 + y, run - x);
+                x = run;
+            } else {
+                ++x;
+            }
+        }
+        if (x > info->width) {
+            info->width = x;
+        }
+    }
+    info->height = y;
+    if (board != NULL) {
+        finish(board);
+    }
+    return 0;
+}
+
+/* The whole file, NUL terminated; NULL if it can't be read */
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *text = NULL;
+    long size;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        text = malloc((size_t)size + 1);
+        if (text != NULL) {
+            if (fread(text, 1, (size_t)size, f) != (size_t)size) {
+                free(text);
+                text = NULL;
+            } else {
+                text[size] = '\0';
+            }
+        }
+    }
+    fclose(f);
+    return text;
+}
+
+int life_pattern_load(const char *path, life_board_t *board, life_pattern_t *info) {
+    typedef int (*reader_t)(const char *, life_board_t *, size_t, size_t, life_pattern_t *);
+    life_pattern_t own;
+    char *text = read_file(path);
+    const char *p = text;
+    reader_t reader;
+    size_t x0, y0;
+    int failed;
+
+    if (text == NULL) {
+        printf("Could not read %s\n", path);
+        return 1;
+    }
+    if (info == NULL) {
+        info = &own;
+    }
+    /* Only RLE has a header line, and its comments start with # */
+    while (*p == '#' || *p == '!') {
+        p = next_line(p);
+    }
+    while (*p == ' ' || *p == '\t') {
+        ++p;
+    }
+    reader = (*p == 'x') ? life_pattern_read_rle : life_pattern_read_cells;
+
+    failed = reader(text, NULL, 0, 0, info);
+    if (!failed) {
+        x0 = info->width < board->width ? (board->width - info->width)/2 : 0;
+        y0 = info->height < board->height ? (board->height - info->height)/2 : 0;
+        failed = reader(text, board, x0, y0, info);
+    }
+    free(text);
+    return failed;
+}
+
+int life_pattern_random(life_board_t *board, double prob, uint64_t seed) {
+    size_t total = board->words*board->height;
+    uint64_t tail = (board->width & 63) ? ((uint64_t)1 << (board->width & 63)) - 1 : ~(uint64_t)0;
+    uint64_t *r;
+    /* prob as q/2^bits, made odd below so that every bit counts */
+    uint32_t q = (prob <= 0) ? 0 : (prob >= 1) ? (1u << RANDOM_BITS) :
+                 (uint32_t)(prob*(1u << RANDOM_BITS) + 0.5);
+    int bits = RANDOM_BITS, b;
+    size_t y, w;
+
+    if (q == 0 || q == (1u << RANDOM_BITS)) {
+        for (y=0; y<board->height; ++y) {
+            uint64_t *row = life_board_row(board, y);
+            for (w=0; w<board->words; ++w) {
+                row[w] = q ? ~(uint64_t)0 : 0;
+            }
+            if (board->words > 0) {
+                row[board->words-1] &= tail;
+            }
+        }
+        finish(board);
+        return 0;
+    }
+    r = malloc(sizeof(uint64_t)*(board->words > 0 ? board->words : 1));
+    if (r == NULL) {
+        return 1;
+    }
+    while ((q & 1) == 0) {
+        q >>= 1;
+        --bits;
+    }
+
+    /*
+     * From the lowest bit up, ORing in a random word takes the chance of a
+     * cell being alive from p to (1+p)/2 and ANDing takes it to p/2, so
+     * after all the bits it's q/2^bits.  The lowest is 1, so it starts as
+     * just a random word.  Bit b's words are elements b*total + the word's
+     * index on the board.
+     */
+    for (y=0; y<board->height; ++y) {
+        uint64_t *row = life_board_row(board, y);
+        rng_fill_u64(seed, 0, y*board->words, row, board->words);
+        for (b=1; b<bits; ++b) {
+            rng_fill_u64(seed, 0, (uint64_t)b*total + y*board->words, r, board->words);
+            if ((q >> b) & 1) {
+                for (w=0; w<board->words; ++w) {
+                    row[w] |= r[w];
+                }
+            } else {
+                for (w=0; w<board->words; ++w) {
+                    row[w] &= r[w];
+                }
+            }
+        }
+        if (board->words > 0) {
+            row[board->words-1] &= tail;
+        }
+    }
+    free(r);
+    finish(board);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef LIFE_PATTERN_H
+#define LIFE_PATTERN_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "life_board.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Starting boards: the standard Life pattern files, and random soup.
+ *
+ * The readers take the text of a pattern in either of the formats the
+ * pattern collections use and OR its live cells into a board with its
+ * top left corner at (x0, y0), wrapping around the torus.  Runs of live
+ * cells are written a word at a time, not cell by cell.  With a NULL
+ * board they only fill in the pattern's size, so it can be centred.
+ *
+ *   RLE    #-comment lines, then "x = 3, y = 3, rule = B3/S23", then runs:
+ *          an optional count and b (dead), o (alive), $ (end of row) or
+ *          ! (end of pattern)
+ *   .cells !-comment lines, then a row per line of . (dead) and O (alive)
+ *
+ * life_pattern_random() makes every cell alive with probability prob,
+ * independently, a word of 64 cells at a time: prob is rounded to 8 bits,
+ * and each bit down to the lowest set one takes a random word ANDed or
+ * ORed into the result, so 0.25 costs two words from rng_fill_u64() per
+ * 64 cells and the worst case eight.
+ * The board depends only on the seed.
+ */
+typedef struct life_pattern_s {
+    size_t width;
+    size_t height;
+    /* The RLE header's rule, or "" */
+    char rule[32];
+} life_pattern_t;
+
+/* Returns 0 on success; info may be NULL */
+int life_pattern_read_rle(const char *text, life_board_t *board, size_t x0, size_t y0,
+                          life_pattern_t *info);
+int life_pattern_read_cells(const char *text, life_board_t *board, size_t x0, size_t y0,
+                            life_pattern_t *info);
+
+/* Either format, told apart by their contents, centred on the board; returns 0 on success */
+int life_pattern_load(const char *path, life_board_t *board, life_pattern_t *info);
+
+/* Replaces the board's cells with random ones; returns 0 on success */
+int life_pattern_random(life_board_t *board, double prob, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#include "life_rule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+
+typedef struct known_rule_s {
+    uint16_t birth;
+    uint16_t survive;
+    life_rule_kind_t kind;
+    const char *name;
+} known_rule_t;
+
+static const known_rule_t known_rules[] = {
+    {LIFE_CONWAY_BIRTH, LIFE_CONWAY_SURVIVE, LIFE_RULE_CONWAY, "conway"},
+    {0x048, 0x00C, LIFE_RULE_HIGHLIFE, "highlife"},
+    {0x1C8, 0x1D8, LIFE_RULE_DAY_NIGHT, "daynight"},
+    {0x004, 0x000, LIFE_RULE_SEEDS, "seeds"}
+};
+
+#define NUM_KNOWN (sizeof(known_rules)/sizeof(known_rules[0]))
+
+void life_rule_init(life_rule_t *rule, uint16_t birth, uint16_t survive) {
+    size_t i;
+    int n;
+
+    rule->birth = birth & 0x1FF;
+    rule->survive = survive & 0x1FF;
+    rule->kind = LIFE_RULE_TABLE;
+    for (i=0; i<NUM_KNOWN; ++i) {
+        if (known_rules[i].birth == rule->birth && known_rules[i].survive == rule->survive) {
+            rule->kind = known_rules[i].kind;
+        }
+    }
+    for (n=0; n<9; ++n) {
+        rule->table[n] = ((rule->birth >> n) & 1) ? ~(uint64_t)0 : 0;
+        rule->table[9+n] = ((rule->survive >> n) & 1) ? ~(uint64_t)0 : 0;
+    }
+}
+
+/* The counts 0 to 8 from a run of digits; returns where they end */
+static const char *read_counts(const char *p, uint16_t *counts) {
+    *counts = 0;
+    while (*p >= '0' && *p <= '8') {
+        *counts |= (uint16_t)(1 << (*p - '0'));
+        ++p;
+    }
+    return p;
+}
+
+int life_rule_parse(life_rule_t *rule, const char *text) {
+    const char *p = text;
+    uint16_t birth, survive;
+    size_t i;
+
+    for (i=0; i<NUM_KNOWN; ++i) {
+        const char *a = text, *b = known_rules[i].name;
+        while (*b != '\0' && tolower((unsigned char)*a) == *b) {
+            ++a;
+            ++b;
+        }
+        if (*a == '\0' && *b == '\0') {
+            life_rule_init(rule, known_rules[i].birth, known_rules[i].survive);
+            return 0;
+        }
+    }
+
+    if (*p == 'B' || *p == 'b') {
+        p = read_counts(p+1, &birth);
+        if (*p++ != '/' || (*p != 'S' && *p != 's')) {
+            printf("Unreadable rule %s, expected B<counts>/S<counts>\n", text);
+            return 1;
+        }
+        p = read_counts(p+1, &survive);
+    } else {
+        /* survive/birth */
+        p = read_counts(p, &survive);
+        if (*p++ != '/') {
+            printf("Unreadable rule %s, expected B<counts>/S<counts>\n", text);
+            return 1;
+        }
+        p = read_counts(p, &birth);
+    }
+    if (*p != '\0') {
+        printf("Unreadable rule %s, expected B<counts>/S<counts>\n", text);
+        return 1;
+    }
+    life_rule_init(rule, birth, survive);
+    return 0;
+}
+
+char *life_rule_format(const life_rule_t *rule, char *buf) {
+    char *p = buf;
+    int n;
+
+    *p++ = 'B';
+    for (n=0; n<9; ++n) {
+        if ((rule->birth >> n) & 1) {
+            *p++ = (char)('0' + n);
+        }
+    }
+    *p++ = '/';
+    *p++ = 'S';
+    for (n=0; n<9; ++n) {
+        if ((rule->survive >> n) & 1) {
+            *p++ = (char)('0' + n);
+        }
+    }
+    *p = '\0';
+    return buf;
+}
+
+const char *life_rule_kind_name(life_rule_kind_t kind) {
+    size_t i;
+    for (i=0; i<NUM_KNOWN; ++i) {
+        if (known_rules[i].kind == kind) {
+            return known_rules[i].name;
+        }
+    }
+    return kind == LIFE_RULE_TABLE ? "table" : "unknown";
+}
@@ -0,0 +1,56 @@
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Life-like rules, written as rulestrings: "B3/S23" is Conway's Life, a
+ * dead cell being born with 3 live neighbours and a live one surviving
+ * with 2 or 3.  Bit n of birth and survive is set for each n listed.  The
+ * older "23/3" form, survival first, is read too.
+ *
+ * The rules people mostly run have row kernels of their own with the rule
+ * folded into a handful of bitwise operations on the neighbour count (see
+ * life_kernels.h); kind says which, or LIFE_RULE_TABLE for any other rule,
+ * whose kernel looks each cell's next state up in table.
+ */
+typedef enum life_rule_kind_e {
+    LIFE_RULE_CONWAY,
+    LIFE_RULE_HIGHLIFE,
+    LIFE_RULE_DAY_NIGHT,
+    LIFE_RULE_SEEDS,
+    LIFE_RULE_TABLE,
+    LIFE_RULE_KINDS
+} life_rule_kind_t;
+
+#define LIFE_CONWAY_BIRTH 0x008
+#define LIFE_CONWAY_SURVIVE 0x00C
+
+typedef struct life_rule_s {
+    uint16_t birth;
+    uint16_t survive;
+    life_rule_kind_t kind;
+    /* All ones if a dead cell with n neighbours is born, at n, or a live one survives, at 9+n */
+    uint64_t table[18];
+} life_rule_t;
+
+void life_rule_init(life_rule_t *rule, uint16_t birth, uint16_t survive);
+
+/* Returns 0 on success, leaving rule alone otherwise */
+int life_rule_parse(life_rule_t *rule, const char *text);
+
+/* As "B3/S23", into buf of at least 24 chars; returns buf */
+char *life_rule_format(const life_rule_t *rule, char *buf);
+
+const char *life_rule_kind_name(life_rule_kind_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
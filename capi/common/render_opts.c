@@ -0,0 +1,164 @@
+#include "render_opts.h"
+
+#include <ri.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+void render_opts_usage(const char *prog) {
+    printf("Use:\n\t%s [-f first:last] [-s seed] [-p fraction] "
+           "[-c xmin,xmax,ymin,ymax [-t tag]] output_prefix\n\n", prog);
+}
+
+static int parse_range(const char *txt, size_t *first, size_t *last) {
+    char *end = NULL;
+    *first = strtoul(txt, &end, 10);
+    if (end == txt) {
+        return 0;
+    }
+    if (*end == '\0') {
+        *last = *first;
+        return 1;
+    }
+    if (*end != ':' && *end != '-') {
+        return 0;
+    }
+    txt = end+1;
+    if (*txt == '\0') {
+        *last = RENDER_OPTS_ALL_FRAMES;
+        return 1;
+    }
+    *last = strtoul(txt, &end, 10);
+    return (*end == '\0') && (*last >= *first);
+}
+
+static int parse_crop(const char *txt, float crop[4]) {
+    int i;
+    char *end = NULL;
+    for (i=0; i<4; ++i) {
+        crop[i] = (float)strtod(txt, &end);
+        if (end == txt || (i<3 && *end != ',')) {
+            return 0;
+        }
+        txt = end+1;
+    }
+    return (*end == '\0') && crop[0] < crop[1] && crop[2] < crop[3];
+}
+
+int render_opts_parse(render_opts_t *opts, int argc, char *argv[]) {
+    int i;
+
+    opts->fprefix = NULL;
+    opts->first_frame = 0;
+    opts->last_frame = RENDER_OPTS_ALL_FRAMES;
+    opts->seed = 0;
+    opts->have_seed = 0;
+    opts->have_crop = 0;
+    opts->tile_tag = "crop";
+    opts->preview = 0.0f;
+
+    for (i=1; i<argc; ++i) {
+        if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            if (!parse_range(argv[++i], &opts->first_frame, &opts->last_frame)) {
+                printf("Bad frame range \"%s\"\n", argv[i]);
+                render_opts_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            opts->seed = strtoul(argv[++i], NULL, 10);
+            opts->have_seed = 1;
+        } else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+            if (!parse_crop(argv[++i], opts->crop)) {
+                printf("Bad crop window \"%s\"\n", argv[i]);
+                render_opts_usage(argv[0]);
+                return 1;
+            }
+            opts->have_crop = 1;
+        } else if (strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            opts->preview = (float)strtod(argv[++i], NULL);
+            if (opts->preview <= 0.0f || opts->preview > 1.0f) {
+                printf("Preview fraction must be in (0,1], got \"%s\"\n", argv[i]);
+                render_opts_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            opts->tile_tag = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            printf("Unknown option \"%s\"\n", argv[i]);
+            render_opts_usage(argv[0]);
+            return 1;
+        } else if (opts->fprefix == NULL) {
+            opts->fprefix = argv[i];
+        } else {
+            printf("Too many arguments given!\n");
+            render_opts_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts->fprefix == NULL) {
+        printf("No output file name prefix given.\n");
+        render_opts_usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+int render_opts_want_frame(const render_opts_t *opts, size_t fnum) {
+    return fnum >= opts->first_frame && fnum <= opts->last_frame;
+}
+
+void render_opts_display(const render_opts_t *opts, const char *fname,
+                         const char *type, const char *mode) {
+    char name[512];
+    char buffer[600];
+    RtString compression = "none";
+
+    if (opts->preview > 0.0f) {
+        const char *base = strrchr(fname, '/');
+        base = (base == NULL) ? fname : base+1;
+        snprintf(name, sizeof(name), "%.*spreview_%s", (int)(base-fname), fname, base);
+        fname = name;
+    }
+    if (!opts->have_crop) {
+        RiDisplay((char*)fname, (char*)type, (char*)mode, RI_NULL);
+        return;
+    }
+    snprintf(buffer, sizeof(buffer), "%s.%s.tif", fname, opts->tile_tag);
+    RiDisplay(buffer, (char*)"tiff", (char*)mode,
+              "string compression", (RtPointer)&compression,
+              RI_NULL);
+    RiCropWindow(opts->crop[0], opts->crop[1], opts->crop[2], opts->crop[3]);
+}
+
+void render_opts_format(const render_opts_t *opts, int xres, int yres, float aspect) {
+    if (opts->preview <= 0.0f) {
+        RiFormat(xres, yres, aspect);
+        return;
+    }
+    xres = (int)(xres*opts->preview + 0.5f);
+    yres = (int)(yres*opts->preview + 0.5f);
+    RiFormat(xres > 0 ? xres : 1, yres > 0 ? yres : 1, aspect);
+    RiPixelSamples(1, 1);
+    RiShadingRate(4.0);
+}
+
+int render_opts_maxdepth(const render_opts_t *opts, int max_depth) {
+    return (opts->preview > 0.0f) ? 1 : max_depth;
+}
+
+void render_opts_shadows(const render_opts_t *opts, int samples) {
+    RtString shadows = (opts->preview > 0.0f) ? "off" : "on";
+    RtInt nsamples = samples;
+    RiAttribute((RtToken)"light", (RtToken)"shadows", (RtPointer)&shadows,
+                (RtToken)"samples", (RtPointer)&nsamples, RI_NULL);
+    RiAttribute((RtToken)"light", "string shadow", (RtPointer)&shadows, RI_NULL);
+}
+
+unsigned long render_opts_seed(render_opts_t *opts) {
+    if (!opts->have_seed) {
+        opts->seed = (unsigned long)time(NULL);
+        opts->have_seed = 1;
+    }
+    return opts->seed;
+}
@@ -0,0 +1,75 @@
+#ifndef RENDER_OPTS_H
+#define RENDER_OPTS_H
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Command line options shared by the capi programs.
+ *
+ *   prog [-f first:last] [-s seed] [-p fraction]
+ *        [-c xmin,xmax,ymin,ymax [-t tag]] output_prefix
+ *
+ * -f restricts which frames are emitted so a frame list can be split
+ * across several renderer processes (see renderq in the top level
+ * directory).  Frames outside the range are still simulated, just not
+ * rendered.  -s fixes the random seed so that every process builds the
+ * same scene.
+ *
+ * -c renders only a crop window of each frame, to an uncompressed TIFF
+ * named "<image name>.<tag>.tif" that capi/stitch can put back together.
+ *
+ * -p renders a quick preview: the resolution scaled by fraction, one pixel
+ * sample, a coarse shading rate, no ray depth and no shadows, written to
+ * "preview_<image name>" next to the final image so the two never clash.
+ */
+typedef struct render_opts_s {
+    char *fprefix;
+    size_t first_frame;
+    size_t last_frame;
+    unsigned long seed;
+    int have_seed;
+    int have_crop;
+    float crop[4];
+    const char *tile_tag;
+    float preview;
+} render_opts_t;
+
+#define RENDER_OPTS_ALL_FRAMES ((size_t)-1)
+
+void render_opts_usage(const char *prog);
+
+/* Returns 0 on success, non-zero (after printing usage) on bad arguments. */
+int render_opts_parse(render_opts_t *opts, int argc, char *argv[]);
+
+int render_opts_want_frame(const render_opts_t *opts, size_t fnum);
+
+/*
+ * Calls RiDisplay() (and RiCropWindow() when cropping) for a frame.  Must
+ * be called before RiWorldBegin().
+ */
+void render_opts_display(const render_opts_t *opts, const char *fname,
+                         const char *type, const char *mode);
+
+/*
+ * RiFormat() scaled down for previews, plus the cheaper sampling settings.
+ */
+void render_opts_format(const render_opts_t *opts, int xres, int yres, float aspect);
+
+/* Ray depth for RiOption("trace", "maxdepth"): max_depth, or 1 for previews. */
+int render_opts_maxdepth(const render_opts_t *opts, int max_depth);
+
+/* The light shadow attributes, turned off for previews. */
+void render_opts_shadows(const render_opts_t *opts, int samples);
+
+/* The seed to hand to srand() or the RNG: -s if given, otherwise the time. */
+unsigned long render_opts_seed(render_opts_t *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,229 @@
+#include "rng.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define RNG_AVX2 1
+#include <immintrin.h>
+#endif
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+/* Elements done per pass of the batch loop */
+#define RNG_BATCH 8
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    int r;
+
+    for (r=0; r<PHILOX_ROUNDS; ++r) {
+        uint64_t p0 = (uint64_t)PHILOX_M0*c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1*c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void rng_init(rng_t *rng, uint64_t seed, uint32_t frame, uint64_t element) {
+    rng->key[0] = (uint32_t)seed;
+    rng->key[1] = (uint32_t)(seed >> 32);
+    rng->ctr[0] = 0;
+    rng->ctr[1] = (uint32_t)element;
+    rng->ctr[2] = (uint32_t)(element >> 32);
+    rng->ctr[3] = frame;
+    rng->used = 4;
+}
+
+uint32_t rng_u32(rng_t *rng) {
+    if (rng->used == 4) {
+        philox4x32(rng->ctr, rng->key, rng->out);
+        rng->ctr[0]++;
+        rng->used = 0;
+    }
+    return rng->out[rng->used++];
+}
+
+double rng_double(rng_t *rng) {
+    uint32_t a = rng_u32(rng) >> 5, b = rng_u32(rng) >> 6;
+    return (a*67108864.0 + b)*(1.0/9007199254740992.0);
+}
+
+float rng_float(rng_t *rng) {
+    return (rng_u32(rng) >> 8)*(1.0f/16777216.0f);
+}
+
+double rng_range(rng_t *rng, double min, double max) {
+    return min + (max-min)*rng_double(rng);
+}
+
+/* Lemire's multiply and reject */
+uint32_t rng_below(rng_t *rng, uint32_t n) {
+    uint64_t m = (uint64_t)rng_u32(rng)*n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+        uint32_t threshold = (uint32_t)(-n) % n;
+        while (low < threshold) {
+            m = (uint64_t)rng_u32(rng)*n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#ifdef RNG_AVX2
+/* Counters per call, in enough registers that the multiplies' latency is hidden */
+#define RNG_AVX2_VECS 4
+#define RNG_AVX2_BATCH (8*RNG_AVX2_VECS)
+
+/*
+ * Philox across RNG_AVX2_BATCH counters in the 32 bit lanes of AVX2
+ * registers, for compilers that won't vectorize the 32x32->64 bit
+ * multiplies themselves.  vpmuludq multiplies the even lanes, so the odd
+ * ones are shifted down for a second multiply and the halves blended back
+ * into place.  out0 and out1 get each counter's c0 and c1.
+ */
+__attribute__((target("avx2")))
+static void philox_avx2(uint64_t seed, uint32_t frame, uint64_t first, uint32_t *out0, uint32_t *out1) {
+    const __m256i m0 = _mm256_set1_epi64x(PHILOX_M0), m1 = _mm256_set1_epi64x(PHILOX_M1);
+    const __m256i w0 = _mm256_set1_epi32((int)PHILOX_W0), w1 = _mm256_set1_epi32((int)PHILOX_W1);
+    __m256i k0 = _mm256_set1_epi32((int)(uint32_t)seed);
+    __m256i k1 = _mm256_set1_epi32((int)(uint32_t)(seed >> 32));
+    __m256i c0[RNG_AVX2_VECS], c1[RNG_AVX2_VECS], c2[RNG_AVX2_VECS], c3[RNG_AVX2_VECS];
+    uint32_t lo[RNG_AVX2_BATCH], hi[RNG_AVX2_BATCH];
+    int r, v, l;
+
+    for (l=0; l<RNG_AVX2_BATCH; ++l) {
+        lo[l] = (uint32_t)(first + l);
+        hi[l] = (uint32_t)((first + l) >> 32);
+    }
+    for (v=0; v<RNG_AVX2_VECS; ++v) {
+        c0[v] = _mm256_setzero_si256();
+        c1[v] = _mm256_loadu_si256((const __m256i *)(lo + 8*v));
+        c2[v] = _mm256_loadu_si256((const __m256i *)(hi + 8*v));
+        c3[v] = _mm256_set1_epi32((int)frame);
+    }
+    for (r=0; r<PHILOX_ROUNDS; ++r) {
+        for (v=0; v<RNG_AVX2_VECS; ++v) {
+            __m256i p0e = _mm256_mul_epu32(c0[v], m0);
+            __m256i p0o = _mm256_mul_epu32(_mm256_srli_epi64(c0[v], 32), m0);
+            __m256i p1e = _mm256_mul_epu32(c2[v], m1);
+            __m256i p1o = _mm256_mul_epu32(_mm256_srli_epi64(c2[v], 32), m1);
+            c0[v] = _mm256_xor_si256(_mm256_xor_si256(
+                        _mm256_blend_epi32(_mm256_srli_epi64(p1e, 32), p1o, 0xAA), c1[v]), k0);
+            c2[v] = _mm256_xor_si256(_mm256_xor_si256(
+                        _mm256_blend_epi32(_mm256_srli_epi64(p0e, 32), p0o, 0xAA), c3[v]), k1);
+            c1[v] = _mm256_blend_epi32(p1e, _mm256_slli_epi64(p1o, 32), 0xAA);
+            c3[v] = _mm256_blend_epi32(p0e, _mm256_slli_epi64(p0o, 32), 0xAA);
+        }
+        k0 = _mm256_add_epi32(k0, w0);
+        k1 = _mm256_add_epi32(k1, w1);
+    }
+    for (v=0; v<RNG_AVX2_VECS; ++v) {
+        _mm256_storeu_si256((__m256i *)(out0 + 8*v), c0[v]);
+        _mm256_storeu_si256((__m256i *)(out1 + 8*v), c1[v]);
+    }
+}
+#endif
+
+/* rng_fill_u32() into out32, or rng_fill_u64() into out64 */
+static void fill(uint64_t seed, uint32_t frame, uint64_t first, uint32_t *out32, uint64_t *out64,
+                 size_t n) {
+    const uint32_t key0 = (uint32_t)seed, key1 = (uint32_t)(seed >> 32);
+    size_t i = 0;
+
+#ifdef RNG_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        for (; i + RNG_AVX2_BATCH <= n; i += RNG_AVX2_BATCH) {
+            uint32_t c0[RNG_AVX2_BATCH], c1[RNG_AVX2_BATCH];
+            int l;
+            philox_avx2(seed, frame, first + i, c0, c1);
+            if (out64 != NULL) {
+                for (l=0; l<RNG_AVX2_BATCH; ++l) {
+                    out64[i+l] = c0[l] | ((uint64_t)c1[l] << 32);
+                }
+            } else {
+                for (l=0; l<RNG_AVX2_BATCH; ++l) {
+                    out32[i+l] = c0[l];
+                }
+            }
+        }
+    }
+#endif
+    /* The same rounds as philox4x32() across RNG_BATCH counters at once */
+    for (; i + RNG_BATCH <= n; i += RNG_BATCH) {
+        uint32_t c0[RNG_BATCH], c1[RNG_BATCH], c2[RNG_BATCH], c3[RNG_BATCH];
+        uint32_t k0 = key0, k1 = key1;
+        int r, l;
+
+        for (l=0; l<RNG_BATCH; ++l) {
+            uint64_t e = first + i + l;
+            c0[l] = 0;
+            c1[l] = (uint32_t)e;
+            c2[l] = (uint32_t)(e >> 32);
+            c3[l] = frame;
+        }
+        for (r=0; r<PHILOX_ROUNDS; ++r) {
+            for (l=0; l<RNG_BATCH; ++l) {
+                uint64_t p0 = (uint64_t)PHILOX_M0*c0[l];
+                uint64_t p1 = (uint64_t)PHILOX_M1*c2[l];
+                c0[l] = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+                c2[l] = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+                c1[l] = (uint32_t)p1;
+                c3[l] = (uint32_t)p0;
+            }
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        if (out64 != NULL) {
+            for (l=0; l<RNG_BATCH; ++l) {
+                out64[i+l] = c0[l] | ((uint64_t)c1[l] << 32);
+            }
+        } else {
+            for (l=0; l<RNG_BATCH; ++l) {
+                out32[i+l] = c0[l];
+            }
+        }
+    }
+    for (; i < n; ++i) {
+        rng_t rng;
+        rng_init(&rng, seed, frame, first + i);
+        if (out64 != NULL) {
+            uint32_t lo = rng_u32(&rng);
+            out64[i] = lo | ((uint64_t)rng_u32(&rng) << 32);
+        } else {
+            out32[i] = rng_u32(&rng);
+        }
+    }
+}
+
+void rng_fill_u32(uint64_t seed, uint32_t frame, uint64_t first, uint32_t *out, size_t n) {
+    fill(seed, frame, first, out, NULL, n);
+}
+
+void rng_fill_u64(uint64_t seed, uint32_t frame, uint64_t first, uint64_t *out, size_t n) {
+    fill(seed, frame, first, NULL, out, n);
+}
+
+void rng_fill_float(uint64_t seed, uint32_t frame, uint64_t first, float *out, size_t n) {
+    uint32_t bits[256];
+    size_t i, j;
+
+    for (i=0; i<n; i+=256) {
+        size_t count = (n-i < 256) ? n-i : 256;
+        rng_fill_u32(seed, frame, first + i, bits, count);
+        for (j=0; j<count; ++j) {
+            out[i+j] = (bits[j] >> 8)*(1.0f/16777216.0f);
+        }
+    }
+}
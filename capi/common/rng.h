@@ -0,0 +1,62 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Counter based random numbers (Philox4x32-10, Salmon et al., "Parallel
+ * Random Numbers: As Easy as 1, 2, 3").  A number is a pure function of
+ * the seed, a frame number, an element index (a cell, a sphere, a grid
+ * point) and how many numbers that element has drawn, so there is no
+ * shared state: any thread can generate any element's numbers and a
+ * scene comes out the same whatever order or thread count builds it.
+ *
+ * Use one rng_t per element, or a single one over element 0 for
+ * inherently serial things like the chaos game.  rng_fill_*() give the
+ * first number of a run of elements at once, a batch at a time.
+ */
+typedef struct rng_s {
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t out[4];
+    unsigned used;
+} rng_t;
+
+/* The stream for element of frame under seed */
+void rng_init(rng_t *rng, uint64_t seed, uint32_t frame, uint64_t element);
+
+uint32_t rng_u32(rng_t *rng);
+
+/* Uniform in [0,1), with 53 and 24 bits of precision */
+double rng_double(rng_t *rng);
+float rng_float(rng_t *rng);
+
+/* Uniform in [min,max) */
+double rng_range(rng_t *rng, double min, double max);
+
+/* Uniform in [0,n), without modulo bias; n > 0 */
+uint32_t rng_below(rng_t *rng, uint32_t n);
+
+/*
+ * out[i] = the first rng_u32()/rng_float() of element first+i, i.e. what
+ * rng_init(&r, seed, frame, first+i) would start with; for rng_fill_u64()
+ * it's the first two rng_u32()s, the first in the low half.  The loop
+ * works on several elements at once so the compiler can vectorize it.
+ */
+void rng_fill_u32(uint64_t seed, uint32_t frame, uint64_t first, uint32_t *out, size_t n);
+void rng_fill_float(uint64_t seed, uint32_t frame, uint64_t first, float *out, size_t n);
+void rng_fill_u64(uint64_t seed, uint32_t frame, uint64_t first, uint64_t *out, size_t n);
+
+/* The raw block function: 4 words from a counter and key */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
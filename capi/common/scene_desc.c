@@ -0,0 +1,400 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "scene_desc.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void scene_desc_init(scene_desc_t *desc) {
+    memset(desc, 0, sizeof(*desc));
+    memcpy(desc->magic, SCENE_DESC_MAGIC, sizeof(SCENE_DESC_MAGIC));
+    desc->version = SCENE_DESC_VERSION;
+    desc->size = sizeof(scene_desc_t);
+
+    desc->num_frames = 1;
+    desc->xres = 800;
+    desc->yres = 600;
+    desc->pixel_aspect = 1.0f;
+    desc->xsamples = 2.0f;
+    desc->ysamples = 2.0f;
+    desc->fov = 90.0f;
+    desc->maxdepth = 4;
+    desc->sides = 2;
+    desc->shadows = 1;
+    desc->shadow_samples = 2;
+    strcpy(desc->display, "images/{prefix}{frame}.tif");
+    strcpy(desc->display_type, "file");
+    strcpy(desc->display_mode, "rgba");
+    desc->cam_location[0] = 20;
+    desc->cam_location[1] = 20;
+    desc->cam_location[2] = 20;
+    strcpy(desc->surface, "matte");
+    desc->color[0] = desc->color[1] = desc->color[2] = 1.0f;
+}
+
+/* Copies a word into a fixed size field, failing if it doesn't fit */
+static int copy_word(char *dst, size_t size, const char *src) {
+    if (src == NULL || strlen(src) >= size) {
+        return 0;
+    }
+    strcpy(dst, src);
+    return 1;
+}
+
+static int read_floats(char **words, int nwords, float *out, int count) {
+    int i;
+    char *end;
+    if (nwords < count) {
+        return 0;
+    }
+    for (i=0; i<count; ++i) {
+        out[i] = (float)strtod(words[i], &end);
+        if (*end != '\0') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Handles one split line; returns 0 if it isn't a valid setting */
+static int parse_setting(scene_desc_t *desc, char **w, int n) {
+    const char *key = w[0];
+    ++w;
+    --n;
+    if (strcmp(key, "frames") == 0 && n == 1) {
+        desc->num_frames = (uint32_t)strtoul(w[0], NULL, 10);
+        return desc->num_frames > 0;
+    } else if (strcmp(key, "format") == 0 && n == 3) {
+        desc->xres = (uint32_t)strtoul(w[0], NULL, 10);
+        desc->yres = (uint32_t)strtoul(w[1], NULL, 10);
+        return read_floats(w+2, 1, &desc->pixel_aspect, 1) && desc->xres > 0 && desc->yres > 0;
+    } else if (strcmp(key, "samples") == 0 && n == 2) {
+        return read_floats(w, n, &desc->xsamples, 1) && read_floats(w+1, 1, &desc->ysamples, 1);
+    } else if (strcmp(key, "fov") == 0 && n == 1) {
+        return read_floats(w, n, &desc->fov, 1);
+    } else if (strcmp(key, "maxdepth") == 0 && n == 1) {
+        desc->maxdepth = (int32_t)strtol(w[0], NULL, 10);
+        return 1;
+    } else if (strcmp(key, "sides") == 0 && n == 1) {
+        desc->sides = (int32_t)strtol(w[0], NULL, 10);
+        return desc->sides == 1 || desc->sides == 2;
+    } else if (strcmp(key, "shadows") == 0 && (n == 1 || n == 2)) {
+        desc->shadows = strcmp(w[0], "on") == 0;
+        if (n == 2) {
+            desc->shadow_samples = (int32_t)strtol(w[1], NULL, 10);
+        }
+        return desc->shadows || strcmp(w[0], "off") == 0;
+    } else if (strcmp(key, "background") == 0 && n == 3) {
+        desc->have_background = 1;
+        return read_floats(w, n, desc->background, 3);
+    } else if (strcmp(key, "display") == 0 && n == 3) {
+        return copy_word(desc->display, sizeof(desc->display), w[0]) &&
+            copy_word(desc->display_type, sizeof(desc->display_type), w[1]) &&
+            copy_word(desc->display_mode, sizeof(desc->display_mode), w[2]);
+    } else if (strcmp(key, "camera") == 0 && (n == 6 || n == 7)) {
+        desc->cam_roll = 0.0f;
+        return read_floats(w, 3, desc->cam_location, 3) &&
+            read_floats(w+3, 3, desc->cam_look_at, 3) &&
+            (n == 6 || read_floats(w+6, 1, &desc->cam_roll, 1));
+    } else if (strcmp(key, "orbit") == 0 && n == 1) {
+        return read_floats(w, n, &desc->orbit_turns, 1);
+    } else if (strcmp(key, "light") == 0 && (n == 4 || n == 5)) {
+        scene_light_t *light = &desc->lights[desc->num_lights];
+        if (desc->num_lights == SCENE_MAX_LIGHTS) {
+            return 0;
+        }
+        if (strcmp(w[0], "ambient") == 0) {
+            light->type = SCENE_LIGHT_AMBIENT;
+        } else if (strcmp(w[0], "distant") == 0) {
+            light->type = SCENE_LIGHT_DISTANT;
+        } else if (strcmp(w[0], "point") == 0) {
+            light->type = SCENE_LIGHT_POINT;
+        } else {
+            return 0;
+        }
+        light->intensity = 1.0f;
+        if (!read_floats(w+1, 3, light->from, 3) ||
+            (n == 5 && !read_floats(w+4, 1, &light->intensity, 1))) {
+            return 0;
+        }
+        desc->num_lights++;
+        return 1;
+    } else if (strcmp(key, "surface") == 0 && n == 1) {
+        return copy_word(desc->surface, sizeof(desc->surface), w[0]);
+    } else if (strcmp(key, "color") == 0 && n == 3) {
+        return read_floats(w, n, desc->color, 3);
+    } else if (strcmp(key, "generator") == 0 && n == 1) {
+        return copy_word(desc->generator, sizeof(desc->generator), w[0]);
+    } else if (strcmp(key, "param") == 0 && n == 2) {
+        scene_param_t *param = &desc->params[desc->num_params];
+        if (desc->num_params == SCENE_MAX_PARAMS) {
+            return 0;
+        }
+        if (!copy_word(param->key, sizeof(param->key), w[0]) ||
+            !copy_word(param->value, sizeof(param->value), w[1])) {
+            return 0;
+        }
+        desc->num_params++;
+        return 1;
+    }
+    return 0;
+}
+
+int scene_desc_parse(const char *fname, scene_desc_t *desc) {
+    FILE *inf = fopen(fname, "r");
+    char line[512];
+    size_t line_num = 0;
+
+    if (inf == NULL) {
+        printf("Could not open \"%s\"\n", fname);
+        return 1;
+    }
+    scene_desc_init(desc);
+    while (fgets(line, sizeof(line), inf) != NULL) {
+        char *words[16];
+        int n = 0;
+        char *p = line;
+
+        ++line_num;
+        if (strchr(line, '#') != NULL) {
+            *strchr(line, '#') = '\0';
+        }
+        while (*p != '\0' && n < 16) {
+            while (isspace((unsigned char)*p)) ++p;
+            if (*p == '\0') break;
+            words[n++] = p;
+            while (*p != '\0' && !isspace((unsigned char)*p)) ++p;
+            if (*p != '\0') *p++ = '\0';
+        }
+        if (n == 0) {
+            continue;
+        }
+        if (!parse_setting(desc, words, n)) {
+            printf("%s:%lu: bad setting \"%s\"\n", fname, (unsigned long)line_num, words[0]);
+            fclose(inf);
+            return 1;
+        }
+    }
+    fclose(inf);
+    return 0;
+}
+
+int scene_desc_write_binary(const char *fname, const scene_desc_t *desc) {
+    FILE *outf = fopen(fname, "wb");
+    if (outf == NULL) {
+        printf("Could not open \"%s\" for writing\n", fname);
+        return 1;
+    }
+    if (fwrite(desc, sizeof(*desc), 1, outf) != 1) {
+        printf("Could not write \"%s\"\n", fname);
+        fclose(outf);
+        return 1;
+    }
+    fclose(outf);
+    return 0;
+}
+
+int scene_desc_write_text(const char *fname, const scene_desc_t *desc) {
+    static const char *light_types[] = {"ambient", "distant", "point"};
+    FILE *outf = fopen(fname, "w");
+    uint32_t i;
+
+    if (outf == NULL) {
+        printf("Could not open \"%s\" for writing\n", fname);
+        return 1;
+    }
+    fprintf(outf, "frames %u\n", desc->num_frames);
+    fprintf(outf, "format %u %u %g\n", desc->xres, desc->yres, desc->pixel_aspect);
+    fprintf(outf, "samples %g %g\n", desc->xsamples, desc->ysamples);
+    fprintf(outf, "fov %g\n", desc->fov);
+    fprintf(outf, "maxdepth %d\n", desc->maxdepth);
+    fprintf(outf, "sides %d\n", desc->sides);
+    fprintf(outf, "shadows %s %d\n", desc->shadows ? "on" : "off", desc->shadow_samples);
+    if (desc->have_background) {
+        fprintf(outf, "background %g %g %g\n",
+                desc->background[0], desc->background[1], desc->background[2]);
+    }
+    fprintf(outf, "display %s %s %s\n", desc->display, desc->display_type, desc->display_mode);
+    fprintf(outf, "camera %g %g %g  %g %g %g  %g\n",
+            desc->cam_location[0], desc->cam_location[1], desc->cam_location[2],
+            desc->cam_look_at[0], desc->cam_look_at[1], desc->cam_look_at[2], desc->cam_roll);
+    fprintf(outf, "orbit %g\n", desc->orbit_turns);
+    for (i=0; i<desc->num_lights; ++i) {
+        const scene_light_t *light = &desc->lights[i];
+        fprintf(outf, "light %s %g %g %g %g\n", light_types[light->type],
+                light->from[0], light->from[1], light->from[2], light->intensity);
+    }
+    fprintf(outf, "surface %s\n", desc->surface);
+    fprintf(outf, "color %g %g %g\n", desc->color[0], desc->color[1], desc->color[2]);
+    if (desc->generator[0] != '\0') {
+        fprintf(outf, "generator %s\n", desc->generator);
+    }
+    for (i=0; i<desc->num_params; ++i) {
+        fprintf(outf, "param %s %s\n", desc->params[i].key, desc->params[i].value);
+    }
+    fclose(outf);
+    return 0;
+}
+
+/* Whether a fixed size field holds a string, NUL and all */
+static int terminated(const char *field, size_t size) {
+    return memchr(field, '\0', size) != NULL;
+}
+
+/*
+ * A mapped description is used as it is, so it has to pass what
+ * parse_setting() would have checked.  Returns the first bad setting, or
+ * NULL if there isn't one.
+ */
+static const char *check_desc(const scene_desc_t *desc) {
+    uint32_t i;
+    if (desc->num_frames == 0) {
+        return "frames";
+    }
+    if (desc->xres == 0 || desc->yres == 0) {
+        return "format";
+    }
+    if (desc->sides != 1 && desc->sides != 2) {
+        return "sides";
+    }
+    if (!terminated(desc->display, sizeof(desc->display)) ||
+        !terminated(desc->display_type, sizeof(desc->display_type)) ||
+        !terminated(desc->display_mode, sizeof(desc->display_mode))) {
+        return "display";
+    }
+    if (desc->num_lights > SCENE_MAX_LIGHTS) {
+        return "light";
+    }
+    for (i=0; i<desc->num_lights; ++i) {
+        if (desc->lights[i].type > SCENE_LIGHT_POINT) {
+            return "light";
+        }
+    }
+    if (!terminated(desc->surface, sizeof(desc->surface))) {
+        return "surface";
+    }
+    if (!terminated(desc->generator, sizeof(desc->generator))) {
+        return "generator";
+    }
+    if (desc->num_params > SCENE_MAX_PARAMS) {
+        return "param";
+    }
+    for (i=0; i<desc->num_params; ++i) {
+        if (!terminated(desc->params[i].key, sizeof(desc->params[i].key)) ||
+            !terminated(desc->params[i].value, sizeof(desc->params[i].value))) {
+            return "param";
+        }
+    }
+    return NULL;
+}
+
+int scene_file_open(const char *fname, scene_file_t *file) {
+    struct stat st;
+    int fd = open(fname, O_RDONLY);
+    scene_desc_t *parsed;
+
+    file->desc = NULL;
+    file->mapping = NULL;
+    file->mapped_size = 0;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Could not open \"%s\"\n", fname);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    if ((size_t)st.st_size >= sizeof(scene_desc_t)) {
+        void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem != MAP_FAILED) {
+            const scene_desc_t *desc = (const scene_desc_t *)mem;
+            if (memcmp(desc->magic, SCENE_DESC_MAGIC, sizeof(SCENE_DESC_MAGIC)) == 0) {
+                close(fd);
+                if (desc->version != SCENE_DESC_VERSION || desc->size != sizeof(scene_desc_t)) {
+                    printf("\"%s\" is a version %u scene, expected version %u; "
+                           "recompile it with scenec\n", fname, desc->version, SCENE_DESC_VERSION);
+                    munmap(mem, st.st_size);
+                    return 1;
+                }
+                if (check_desc(desc) != NULL) {
+                    printf("\"%s\" is damaged: bad %s setting\n", fname, check_desc(desc));
+                    munmap(mem, st.st_size);
+                    return 1;
+                }
+                file->desc = desc;
+                file->mapping = mem;
+                file->mapped_size = st.st_size;
+                return 0;
+            }
+            munmap(mem, st.st_size);
+        }
+    }
+    close(fd);
+
+    /* Not a binary scene, so it must be text */
+    parsed = malloc(sizeof(scene_desc_t));
+    if (parsed == NULL) {
+        printf("Could not allocate the scene for \"%s\"\n", fname);
+        return 1;
+    }
+    if (scene_desc_parse(fname, parsed) != 0) {
+        free(parsed);
+        return 1;
+    }
+    file->desc = parsed;
+    return 0;
+}
+
+void scene_file_close(scene_file_t *file) {
+    if (file->mapping != NULL) {
+        munmap(file->mapping, file->mapped_size);
+    } else {
+        free((void *)file->desc);
+    }
+    file->desc = NULL;
+    file->mapping = NULL;
+    file->mapped_size = 0;
+}
+
+const char *scene_param(const scene_desc_t *desc, const char *key, const char *def) {
+    uint32_t i;
+    for (i=0; i<desc->num_params && i<SCENE_MAX_PARAMS; ++i) {
+        if (strncmp(desc->params[i].key, key, sizeof(desc->params[i].key)) == 0) {
+            return desc->params[i].value;
+        }
+    }
+    return def;
+}
+
+double scene_param_double(const scene_desc_t *desc, const char *key, double def) {
+    const char *value = scene_param(desc, key, NULL);
+    return value ? strtod(value, NULL) : def;
+}
+
+long scene_param_long(const scene_desc_t *desc, const char *key, long def) {
+    const char *value = scene_param(desc, key, NULL);
+    return value ? strtol(value, NULL, 10) : def;
+}
+
+void scene_display_name(const scene_desc_t *desc, const char *prefix, size_t fnum,
+                        char *buffer, size_t size) {
+    const char *src = desc->display;
+    size_t len = 0;
+
+    while (*src != '\0' && len+1 < size) {
+        if (strncmp(src, "{prefix}", 8) == 0) {
+            len += snprintf(buffer+len, size-len, "%s", prefix);
+            src += 8;
+        } else if (strncmp(src, "{frame}", 7) == 0) {
+            len += snprintf(buffer+len, size-len, "%05lu", (unsigned long)fnum);
+            src += 7;
+        } else {
+            buffer[len++] = *src++;
+        }
+    }
+    buffer[len < size ? len : size-1] = '\0';
+}
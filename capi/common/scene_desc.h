@@ -0,0 +1,133 @@
+#ifndef SCENE_DESC_H
+#define SCENE_DESC_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Everything a capi program used to hardcode about its scene: resolution,
+ * display name, camera path, lights, frame count, and which generator
+ * makes the geometry along with its parameters.
+ *
+ * The text form is one setting per line, '#' starts a comment:
+ *
+ *   frames 120
+ *   format 1280 720 1.0
+ *   samples 2 2
+ *   fov 45
+ *   maxdepth 4
+ *   sides 2
+ *   shadows on 2
+ *   background 0 0 0
+ *   display images/{prefix}{frame}.jpg jpeg rgb
+ *   camera 55 55 55  0 0 0  0        # location, look at, roll
+ *   orbit 1                          # turns about the look at point's y axis
+ *   light distant 80 80 80 1.0       # type, from, intensity
+ *   surface plastic
+ *   color 0 1 0
+ *   generator life
+ *   param width 80                   # generator parameters
+ *
+ * {prefix} is the output prefix given on the command line and {frame} the
+ * five digit frame number.
+ *
+ * The binary form is a scene_desc_t written as is, so loading it is a
+ * single mmap().  It is only portable between machines with the same
+ * endianness; scenec converts one form to the other.
+ */
+
+#define SCENE_DESC_MAGIC "RISCENE"
+#define SCENE_DESC_VERSION 1
+#define SCENE_MAX_LIGHTS 8
+#define SCENE_MAX_PARAMS 32
+
+enum scene_light_type { SCENE_LIGHT_AMBIENT, SCENE_LIGHT_DISTANT, SCENE_LIGHT_POINT };
+
+typedef struct scene_light_s {
+    uint32_t type;
+    float from[3];
+    float intensity;
+} scene_light_t;
+
+typedef struct scene_param_s {
+    char key[32];
+    char value[96];
+} scene_param_t;
+
+typedef struct scene_desc_s {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+
+    uint32_t num_frames;
+    uint32_t xres;
+    uint32_t yres;
+    float pixel_aspect;
+    float xsamples;
+    float ysamples;
+    float fov;
+    int32_t maxdepth;
+    int32_t sides;
+    int32_t shadows;
+    int32_t shadow_samples;
+    int32_t have_background;
+    float background[3];
+
+    char display[128];
+    char display_type[16];
+    char display_mode[8];
+
+    float cam_location[3];
+    float cam_look_at[3];
+    float cam_roll;
+    float orbit_turns;
+
+    uint32_t num_lights;
+    scene_light_t lights[SCENE_MAX_LIGHTS];
+
+    char surface[32];
+    float color[3];
+
+    char generator[32];
+    uint32_t num_params;
+    scene_param_t params[SCENE_MAX_PARAMS];
+} scene_desc_t;
+
+/* A loaded description, either mapped from a binary file or parsed text */
+typedef struct scene_file_s {
+    const scene_desc_t *desc;
+    void *mapping;
+    size_t mapped_size;
+} scene_file_t;
+
+/* The defaults a description starts from before any settings are read */
+void scene_desc_init(scene_desc_t *desc);
+
+/* Parses the text form.  Returns 0 on success, prints the bad line otherwise. */
+int scene_desc_parse(const char *fname, scene_desc_t *desc);
+
+int scene_desc_write_binary(const char *fname, const scene_desc_t *desc);
+int scene_desc_write_text(const char *fname, const scene_desc_t *desc);
+
+/* Maps a binary description, or parses a text one.  Returns 0 on success. */
+int scene_file_open(const char *fname, scene_file_t *file);
+void scene_file_close(scene_file_t *file);
+
+/* Generator parameters, with a default when the key isn't set */
+const char *scene_param(const scene_desc_t *desc, const char *key, const char *def);
+double scene_param_double(const scene_desc_t *desc, const char *key, double def);
+long scene_param_long(const scene_desc_t *desc, const char *key, long def);
+
+/* The display name for a frame, with {prefix} and {frame} filled in */
+void scene_display_name(const scene_desc_t *desc, const char *prefix, size_t fnum,
+                        char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
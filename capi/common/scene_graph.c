@@ -0,0 +1,174 @@
+#include "scene_graph.h"
+
+#include <string.h>
+
+static sg_node_t *sg_node(enum sg_node_type type) {
+    sg_node_t *node = calloc(1, sizeof(sg_node_t));
+    node->type = type;
+    node->dirty = 1;
+    return node;
+}
+
+sg_node_t *sg_group(void) {
+    return sg_node(SG_GROUP);
+}
+
+sg_node_t *sg_transform(void) {
+    sg_node_t *node = sg_node(SG_TRANSFORM);
+    sg_identity(node);
+    return node;
+}
+
+sg_node_t *sg_attributes(const char *surface, const RtColor color) {
+    sg_node_t *node = sg_node(SG_ATTRIBUTES);
+    if (surface != NULL) {
+        sg_set_surface(node, surface);
+    }
+    if (color != NULL) {
+        sg_set_color(node, color);
+    }
+    return node;
+}
+
+sg_node_t *sg_geometry(sg_emit_t emit, void *data) {
+    sg_node_t *node = sg_node(SG_GEOMETRY);
+    node->emit = emit;
+    node->data = data;
+    return node;
+}
+
+void sg_free(sg_node_t *node) {
+    size_t i;
+    if (node == NULL) {
+        return;
+    }
+    for (i=0; i<node->num_children; ++i) {
+        sg_free(node->children[i]);
+    }
+    free(node->children);
+    free(node);
+}
+
+sg_node_t *sg_add(sg_node_t *parent, sg_node_t *child) {
+    if (parent->num_children == parent->max_children) {
+        parent->max_children = parent->max_children ? 2*parent->max_children : 4;
+        parent->children = realloc(parent->children,
+                                   sizeof(sg_node_t*)*parent->max_children);
+    }
+    parent->children[parent->num_children++] = child;
+    child->parent = parent;
+    sg_touch(parent);
+    return child;
+}
+
+void sg_touch(sg_node_t *node) {
+    for (; node != NULL; node = node->parent) {
+        node->dirty = 1;
+        node->have_cache = 0;
+    }
+}
+
+void sg_identity(sg_node_t *node) {
+    int i, j;
+    for (i=0; i<4; ++i) {
+        for (j=0; j<4; ++j) {
+            node->xform[i][j] = (i == j) ? 1.0f : 0.0f;
+        }
+    }
+    sg_touch(node);
+}
+
+/* Ri matrices take row vectors, so RiTranslate() is xform = T*xform */
+void sg_translate(sg_node_t *node, RtFloat dx, RtFloat dy, RtFloat dz) {
+    int j;
+    for (j=0; j<4; ++j) {
+        node->xform[3][j] += dx*node->xform[0][j] + dy*node->xform[1][j] + dz*node->xform[2][j];
+    }
+    sg_touch(node);
+}
+
+void sg_scale(sg_node_t *node, RtFloat sx, RtFloat sy, RtFloat sz) {
+    int j;
+    for (j=0; j<4; ++j) {
+        node->xform[0][j] *= sx;
+        node->xform[1][j] *= sy;
+        node->xform[2][j] *= sz;
+    }
+    sg_touch(node);
+}
+
+void sg_set_surface(sg_node_t *node, const char *surface) {
+    strncpy(node->surface, surface, sizeof(node->surface)-1);
+    node->surface[sizeof(node->surface)-1] = '\0';
+    sg_touch(node);
+}
+
+void sg_set_color(sg_node_t *node, const RtColor color) {
+    node->color[0] = color[0];
+    node->color[1] = color[1];
+    node->color[2] = color[2];
+    node->have_color = 1;
+    sg_touch(node);
+}
+
+/* Emits node and its children, instancing cached subtrees if use_cache */
+static void sg_emit(sg_node_t *node, int use_cache) {
+    size_t i;
+
+    if (use_cache && node->have_cache) {
+        RiObjectInstance(node->cache);
+        return;
+    }
+    switch (node->type) {
+    case SG_TRANSFORM:
+        RiTransformBegin();
+        RiConcatTransform(node->xform);
+        break;
+    case SG_ATTRIBUTES:
+        RiAttributeBegin();
+        if (node->surface[0] != '\0') {
+            RiSurface(node->surface, RI_NULL);
+        }
+        if (node->have_color) {
+            RiColor(node->color);
+        }
+        break;
+    case SG_GEOMETRY:
+        node->emit(node->data);
+        break;
+    default:
+        break;
+    }
+    for (i=0; i<node->num_children; ++i) {
+        sg_emit(node->children[i], use_cache);
+    }
+    if (node->type == SG_TRANSFORM) {
+        RiTransformEnd();
+    } else if (node->type == SG_ATTRIBUTES) {
+        RiAttributeEnd();
+    }
+    node->dirty = 0;
+}
+
+void sg_prepare(sg_node_t *root) {
+    size_t i;
+    if (root->have_cache) {
+        return;
+    }
+    if (!root->dirty) {
+        /* Unchanged since the last frame, so worth keeping.  Objects can't
+           instance other objects, so the subtree is emitted in full. */
+        root->cache = RiObjectBegin();
+        sg_emit(root, 0);
+        RiObjectEnd();
+        root->have_cache = 1;
+        return;
+    }
+    for (i=0; i<root->num_children; ++i) {
+        sg_prepare(root->children[i]);
+    }
+}
+
+void sg_render(sg_node_t *root) {
+    sg_emit(root, 1);
+}
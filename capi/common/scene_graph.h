@@ -0,0 +1,102 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <stdlib.h>
+
+#include <ri.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A small retained scene graph for what goes between RiWorldBegin() and
+ * RiWorldEnd().  Every node remembers whether it (or anything under it)
+ * changed since the last frame.  A subtree that stayed the same for a
+ * frame is recorded once as an Ri retained object and from then on each
+ * frame just instances it, so when only the camera moves a frame costs
+ * the camera plus one RiObjectInstance().  Anything changed is emitted
+ * directly again.
+ *
+ * Per frame:
+ *
+ *   sg_prepare(root);       outside any frame block, after RiBegin()
+ *   RiFrameBegin(fnum);
+ *   ... display, camera, lights ...
+ *   RiWorldBegin();
+ *   sg_render(root);
+ *   RiWorldEnd();
+ *   RiFrameEnd();
+ *
+ * Ri has no way to delete a retained object, so an object replaced after
+ * a change stays in the renderer until RiEnd().  A node that changes every
+ * frame is never cached, so it doesn't pile them up.
+ */
+
+enum sg_node_type { SG_GROUP, SG_TRANSFORM, SG_ATTRIBUTES, SG_GEOMETRY };
+
+/* Emits a geometry node's primitives */
+typedef void (*sg_emit_t)(void *data);
+
+typedef struct sg_node_s {
+    enum sg_node_type type;
+    struct sg_node_s *parent;
+    struct sg_node_s **children;
+    size_t num_children;
+    size_t max_children;
+
+    /* SG_TRANSFORM */
+    RtMatrix xform;
+
+    /* SG_ATTRIBUTES; an empty surface or have_color == 0 inherits */
+    char surface[32];
+    RtColor color;
+    int have_color;
+
+    /* SG_GEOMETRY */
+    sg_emit_t emit;
+    void *data;
+
+    /* Set when this node or a descendant changed since it was last rendered */
+    int dirty;
+    int have_cache;
+    RtObjectHandle cache;
+} sg_node_t;
+
+sg_node_t *sg_group(void);
+sg_node_t *sg_transform(void);
+sg_node_t *sg_attributes(const char *surface, const RtColor color);
+sg_node_t *sg_geometry(sg_emit_t emit, void *data);
+
+/* Frees node and everything under it */
+void sg_free(sg_node_t *node);
+
+/* Adds child as the last child of parent, returns child */
+sg_node_t *sg_add(sg_node_t *parent, sg_node_t *child);
+
+/* Transform node edits, composed the same way as the Ri calls */
+void sg_identity(sg_node_t *node);
+void sg_translate(sg_node_t *node, RtFloat dx, RtFloat dy, RtFloat dz);
+void sg_scale(sg_node_t *node, RtFloat sx, RtFloat sy, RtFloat sz);
+
+/* Attribute node edits */
+void sg_set_surface(sg_node_t *node, const char *surface);
+void sg_set_color(sg_node_t *node, const RtColor color);
+
+/*
+ * Marks node as changed, e.g. after the data a geometry node emits was
+ * modified.  The sg_ edit functions do this themselves.
+ */
+void sg_touch(sg_node_t *node);
+
+/* Records retained objects for unchanged subtrees; outside frame blocks */
+void sg_prepare(sg_node_t *root);
+
+/* Emits the graph; inside the world block */
+void sg_render(sg_node_t *root);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+/* sysconf(_SC_NPROCESSORS_ONLN) is hidden by -std=c99 otherwise */
+#define _DEFAULT_SOURCE
+
+#include "work_pool.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_WORKERS 256
+
+/* The items [head, tail) a worker has left */
+typedef struct work_queue_s {
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+} work_queue_t;
+
+struct work_pool_s {
+    int nthreads;
+    pthread_t *threads;
+    work_queue_t *queues;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    /* Bumped for each run so sleeping workers know there's a new one */
+    unsigned long generation;
+    int busy;
+    int quit;
+
+    work_fn_t fn;
+    void *arg;
+};
+
+typedef struct worker_s {
+    work_pool_t *pool;
+    int id;
+} worker_t;
+
+static int take(work_queue_t *queue, size_t *item) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->head < queue->tail) {
+        *item = queue->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/* Moves the back half of some other worker's items to id's queue */
+static int steal(work_pool_t *pool, int id) {
+    int i;
+    for (i=1; i<pool->nthreads; ++i) {
+        work_queue_t *victim = &pool->queues[(id + i) % pool->nthreads];
+        size_t lo = 0, hi = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail) {
+            size_t half = (victim->tail - victim->head + 1)/2;
+            hi = victim->tail;
+            lo = hi - half;
+            victim->tail = lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (hi > lo) {
+            pthread_mutex_lock(&pool->queues[id].lock);
+            pool->queues[id].head = lo;
+            pool->queues[id].tail = hi;
+            pthread_mutex_unlock(&pool->queues[id].lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void work(work_pool_t *pool, int id) {
+    size_t item;
+    do {
+        while (take(&pool->queues[id], &item)) {
+            pool->fn(pool->arg, item, id);
+        }
+    } while (steal(pool, id));
+}
+
+static void *worker_main(void *arg) {
+    worker_t *self = arg;
+    work_pool_t *pool = self->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool, self->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    free(self);
+    return NULL;
+}
+
+static int default_threads(void) {
+    const char *env = getenv("WORK_POOL_THREADS");
+    long n = (env != NULL) ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+work_pool_t *work_pool_create(int nthreads) {
+    work_pool_t *pool = calloc(1, sizeof(work_pool_t));
+    int i;
+
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (nthreads <= 0) {
+        nthreads = default_threads();
+    }
+    if (nthreads > MAX_WORKERS) {
+        nthreads = MAX_WORKERS;
+    }
+    pool->threads = calloc(nthreads, sizeof(pthread_t));
+    pool->queues = calloc(nthreads, sizeof(work_queue_t));
+    if (pool->threads == NULL || pool->queues == NULL) {
+        free(pool->threads);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i=0; i<nthreads; ++i) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    /* Worker 0 is whoever calls work_pool_run() */
+    pool->nthreads = 1;
+    for (i=1; i<nthreads; ++i) {
+        worker_t *w = malloc(sizeof(worker_t));
+        if (w == NULL) {
+            break;
+        }
+        w->pool = pool;
+        w->id = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, w) != 0) {
+            free(w);
+            break;
+        }
+        pool->nthreads++;
+    }
+    return pool;
+}
+
+void work_pool_destroy(work_pool_t *pool) {
+    int i;
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (i=1; i<pool->nthreads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (i=0; i<pool->nthreads; ++i) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->queues);
+    free(pool);
+}
+
+int work_pool_threads(const work_pool_t *pool) {
+    return pool->nthreads;
+}
+
+void work_pool_run(work_pool_t *pool, size_t num_items, work_fn_t fn, void *arg) {
+    size_t n = (size_t)pool->nthreads;
+    size_t i;
+
+    if (num_items == 0) {
+        return;
+    }
+    if (pool->nthreads == 1 || num_items == 1) {
+        for (i=0; i<num_items; ++i) {
+            fn(arg, i, 0);
+        }
+        return;
+    }
+
+    /* Nobody else is running, so the queues can be set without their locks */
+    for (i=0; i<n; ++i) {
+        pool->queues[i].head = i*num_items/n;
+        pool->queues[i].tail = (i+1)*num_items/n;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->busy = pool->nthreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static work_pool_t *shared_pool = NULL;
+static pthread_once_t shared_pool_once = PTHREAD_ONCE_INIT;
+
+static void create_shared_pool(void) {
+    shared_pool = work_pool_create(0);
+}
+
+work_pool_t *work_pool_shared(void) {
+    pthread_once(&shared_pool_once, create_shared_pool);
+    return shared_pool;
+}
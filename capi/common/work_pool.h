@@ -0,0 +1,49 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A fixed set of worker threads that run fn(arg, item, worker) for every
+ * item in 0..num_items-1.
+ *
+ * Each worker starts with an even, contiguous share of the items, so
+ * neighbouring items (tiles of the same rows, say) stay on one thread.
+ * A worker that finishes its share steals the back half of another's
+ * remaining items.  Uneven items, like the busy and empty parts of a
+ * Life board, then even out without a shared queue everyone fights over.
+ *
+ * The calling thread works as worker 0, so a pool of 1 thread runs
+ * everything inline.  fn must only touch per-item or per-worker state.
+ */
+typedef void (*work_fn_t)(void *arg, size_t item, int worker);
+
+typedef struct work_pool_s work_pool_t;
+
+/* nthreads <= 0 means WORK_POOL_THREADS from the environment, or one per CPU */
+work_pool_t *work_pool_create(int nthreads);
+void work_pool_destroy(work_pool_t *pool);
+
+int work_pool_threads(const work_pool_t *pool);
+
+/* Returns when every item is done; not reentrant */
+void work_pool_run(work_pool_t *pool, size_t num_items, work_fn_t fn, void *arg);
+
+/*
+ * The one pool for the whole program, made with work_pool_create(0) the
+ * first time it's asked for and never destroyed.  Everything that wants
+ * threads without being handed a pool (life_evolve(), life3d_evolve())
+ * shares it, so there's never more than a thread per CPU.  NULL if it
+ * couldn't be made.
+ */
+work_pool_t *work_pool_shared(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
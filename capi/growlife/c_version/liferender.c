@@ -1,5 +1,12 @@
 #include "ri.h"
 
+#include "frame_arena.h"
+#include "life_blobby.h"
+#include "life_board.h"
+#include "life_emit.h"
+#include "life_pattern.h"
+#include "render_opts.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -9,212 +16,100 @@
 
 #define PI (3.141592654)
 
-size_t randUInt(size_t min, size_t max) {
-    return ((rand()%(max-min)) + min);
-}
-
+/* Cells live in a packed life_board_t; see life_board.h */
 typedef struct game_of_life_s {
     size_t width;
     size_t height;
     size_t num_on;
-    bool **board;
+    life_board_t cells;
 } game_of_life_t;
 
+/* Into caller provided storage; returns 0 on success */
+int gol_init_board(game_of_life_t *board, size_t w, size_t h) {
+    board->width = w;
+    board->height = h;
+    board->num_on = 0;
+    return life_board_init(&board->cells, w, h);
+}
+
+void gol_free_board(game_of_life_t *board) {
+    life_board_free(&board->cells);
+}
+
 game_of_life_t *gol_create_board(size_t w, size_t h) {
     game_of_life_t *rval = malloc(sizeof(game_of_life_t));
-    rval->width = w;
-    rval->height = h;
-    rval->num_on = 0;
-    rval->board = malloc(sizeof(bool*)*rval->width);
-
-    for (size_t i=0; i<rval->width; ++i) {
-        rval->board[i] = malloc(sizeof(bool)*rval->height);
-        for (size_t j=0; j<rval->height; ++j) {
-            rval->board[i][j] = false;
-        }
+    if (rval == NULL || gol_init_board(rval, w, h)) {
+        free(rval);
+        return NULL;
     }
     return rval;
 }
 
 void gol_destroy_board(game_of_life_t **board) {
-    for (size_t i=0; i<(*board)->width; ++i) {
-        free((*board)->board[i]);
-    }
-    free((*board)->board);
+    gol_free_board(*board);
     free(*board);
     *board = 0;
 }
 
+bool gol_get(game_of_life_t *board, size_t i, size_t j) {
+    return life_board_get(&board->cells, i, j);
+}
+
 void gol_debug_show_life(game_of_life_t *board) {
     for (size_t j=0; j<board->height; ++j) {
         for (size_t i=0; i<board->width; ++i) {
-            printf(board->board[i][j]?"X":" ");
+            printf(gol_get(board, i, j)?"X":" ");
         }
         printf("\n");
     }
 }
 
-void gol_random_init(game_of_life_t *board, double prob) {
-    size_t numFilled = prob*(board->width*board->height);
-    for (int i=0;i<numFilled; ++i) {
-        size_t ri = randUInt(0, board->height);
-        size_t rj = randUInt(0, board->width);
-        if (! board->board[ri][rj]) {
-            board->board[ri][rj] = true;
-            board->num_on += 1;
-        }
+/* Each cell alive with probability prob; the board depends only on seed */
+int gol_random_init(game_of_life_t *board, double prob, unsigned long seed) {
+    if (life_pattern_random(&board->cells, prob, seed)) {
+        return 1;
     }
+    board->num_on = board->cells.num_on;
+    return 0;
 }
 
-size_t gol_count_neighbors(game_of_life_t *board, int i, int j) {
-    int w = board->width;
-    int h = board->height;
-
-    int num = 0;
-    int up = i-1>0 ? i-1 : h-1;
-    int down = i+1 <h-1 ? i+1 : 0;
-    int left = j-1>0 ? j-1 : w-1;
-    int right = j+1 < w-1 ? j+1 : 0;
-    
-    num += board->board[up][j];
-    num += board->board[down][j];
-    num += board->board[i][left];
-    num += board->board[i][right];
-    num += board->board[up][left];
-    num += board->board[up][right];
-    num += board->board[down][left];
-    num += board->board[down][right];
-
-    return num;
+/* goes_to must be initialized to the same size; nothing is allocated */
+void gol_evolve_into(const game_of_life_t *board, game_of_life_t *goes_to) {
+    life_evolve(&board->cells, &goes_to->cells);
+    goes_to->num_on = goes_to->cells.num_on;
 }
 
-game_of_life_t *gol_evolve(game_of_life_t *board) {
-    int w = board->width;
-    int h = board->height;
-
-    game_of_life_t *goes_to = malloc(sizeof(game_of_life_t));
-    goes_to->width = w;
-    goes_to->height = h;
-    goes_to->num_on = 0;
-    goes_to->board = malloc(sizeof(bool*)*goes_to->width);
-
-    for (size_t i=0; i<goes_to->width; ++i) {
-        goes_to->board[i] = malloc(sizeof(bool)*goes_to->height);
-        for (size_t j=0; j<goes_to->height; ++j) {
-            int num = gol_count_neighbors(board, i,j);
-
-            if (board->board[i][j]) {
-                if ((num < 2) || (num > 3)) {
-                    goes_to->board[i][j] = false;
-                } else {
-                    goes_to->board[i][j] = true;
-                    goes_to->num_on += 1;
-                }
-            } else {
-                if (num == 3) {
-                    goes_to->board[i][j] = true;
-                    goes_to->num_on += 1;
-                } else {
-                    goes_to->board[i][j] = false;
-                }
-            }
-        }
-    }
-    return goes_to;
+/* The point or polygon arrays come from arena and live until its reset */
+void gol_show_renderman(frame_arena_t *arena, game_of_life_t *board) {
+    life_emit(&board->cells, life_emit_mode(), arena);
 }
 
-void gol_show_renderman(game_of_life_t *board) {
-    RiTransformBegin();
-    RiTranslate(-(board->width/2.0), 0.0, -(board->height/2.0));
-    for (size_t j=0; j<board->height; ++j) {
-        RiTransformBegin();
-        for (size_t i=0; i<board->width; ++i) {
-            if (board->board[i][j]) {
-                RiSphere(0.5, -0.5,0.5, 360.0, RI_NULL);
-            }
-            RiTranslate(1.0, 0.0, 0.0);
-        }
-        RiTransformEnd();
-        RiTranslate(0.0, 0.0, 1.0);
-    }
-    RiTransformEnd();
-}
-
-void gol_show_renderman_blobby(game_of_life_t *boards[], size_t num) {
-    size_t totalOn = 0;
-    for (size_t i=0; i<num; ++i) {
-        totalOn += boards[i]->num_on;
-    }
-    RtFloat *mats = malloc(sizeof(RtFloat)*16*totalOn);
-    RtInt *ops = malloc(sizeof(RtInt)*(2*totalOn + 1*totalOn + 2));
-    size_t curOff = 0;
-    RiTransformBegin();
-    RiTranslate(-(boards[0]->width/2.0), 0.0, -(boards[0]->height/2.0));
-    for (size_t k=0; k<num; ++k) {
-        game_of_life_t *board = boards[k];
-        for (size_t j=0; j<board->height; ++j) {
-            for (size_t i=0; i<board->width; ++i) {
-                if (board->board[i][j]) {
-                    mats[curOff+0] =1.2;
-                    mats[curOff+1] =0.0;
-                    mats[curOff+2] =0.0;
-                    mats[curOff+3] =0.0;
-                    mats[curOff+4] =0.0;
-                    mats[curOff+5] =1.2;
-                    mats[curOff+6] =0.0;
-                    mats[curOff+7] =0.0;
-                    mats[curOff+8] =0.0;
-                    mats[curOff+9] =0.0;
-                    mats[curOff+10] =1.2;
-                    mats[curOff+11] =0.0;
-                    mats[curOff+12] =(RtFloat)i;
-                    mats[curOff+13] =(RtFloat)k;
-                    mats[curOff+14] =(RtFloat)j;
-                    mats[curOff+15] =1.0;
-                    curOff += 16;
-                }
-            }
-        }
-    }
-    curOff = 0;
-    for (size_t i=0;i<totalOn; ++i) {
-        ops[curOff] = 1001;
-        ops[curOff+1] = i*16;
-        curOff+=2;
-    }
-    ops[curOff] = 0;
-    curOff += 1;
-    ops[curOff] = totalOn;
-    curOff += 1;
-    for (size_t i=0;i<totalOn; ++i) {
-        ops[curOff] = i;
-        curOff += 1;
-    }
-    RiBlobby(totalOn,
-             /* Ints */
-             totalOn*3 + 2, ops,
-             /* Floats */
-             totalOn * 16, mats,
-             /* Strings */
-             0, (RtString*)RI_NULL, RI_NULL);
-    RiTransformEnd();
+/* Draws the generations pushed into blobby so far */
+void gol_show_renderman_blobby(life_blobby_t *blobby) {
+    life_blobby_emit(blobby);
 }
 
 /* #define DEBUG_LIFE 1 */
 
 #ifdef DEBUG_LIFE
 int main(int argc, char *argv[]) {
-    game_of_life_t *cur= gol_create_board(50,50);
+    game_of_life_t a, b;
+    game_of_life_t *cur = &a, *next = &b;
+    if (gol_init_board(&a, 50, 50) || gol_init_board(&b, 50, 50)) {
+        return 1;
+    }
 
-    gol_random_init(cur, 0.025);
+    gol_random_init(cur, 0.025, time(NULL));
     
+    /* Only the latest generation is shown, so two boards take turns */
     for (int i=0;i<50; ++i) {
-        
+        game_of_life_t *tmp;
         gol_debug_show_life(cur);
-        game_of_life_t *next = gol_evolve(cur);
-        gol_destroy_board(&cur);
-        cur = next;
+        gol_evolve_into(cur, next);
+        tmp = cur; cur = next; next = tmp;
     }
+    gol_free_board(&a);
+    gol_free_board(&b);
 }
 #else
 typedef struct camera_s {
@@ -286,18 +181,17 @@ void PlaceCamera(camera_t *cam)
     RiTranslate(-cam->location[0], -cam->location[1], -cam->location[2]);
 }
 
+/* Takes render_opts.h's options, like the C++ version; -s makes runs repeatable */
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Not enough arguments given!\n");
-        return 1;
-    } else if (argc > 2) {
-        printf("Too many arguments given!\n");
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         return 1;
     }
-    char *fprefix = argv[1];
-    srand(time(NULL));
+    char *fprefix = opts.fprefix;
+    unsigned long seed = render_opts_seed(&opts);
+    printf("Using seed %lu\n", seed);
     const size_t NUM_FRAMES = 100;
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     scene_info_t scene;
     double rad = 80.0;
     double t = 0.0;
@@ -319,22 +213,60 @@ int main(int argc, char *argv[]) {
 
     scene.fprefix = fprefix;
 
-    game_of_life_t *boards[NUM_FRAMES+1];
-    size_t curBoard = 0;
-    boards[curBoard] = gol_create_board(80,80);
-    gol_random_init(boards[curBoard], 0.125);
+    frame_arena_t arena;
+    if (frame_arena_init(&arena, 16*1024*1024)) {
+        printf("Could not allocate the frame arena\n");
+        return 1;
+    }
+
+    life_blobby_t blobby;
+    if (life_blobby_init(&blobby, 80, 80)) {
+        printf("Could not allocate the blobby\n");
+        return 1;
+    }
+
+    /*
+     * The stack of generations lives in the blobby, which takes each one as
+     * it's made, so two boards take turns as the current one and the next.
+     */
+    game_of_life_t a, b;
+    game_of_life_t *cur = &a, *next = &b;
+    if (gol_init_board(&a, 80, 80) || gol_init_board(&b, 80, 80)) {
+        printf("Could not allocate the boards\n");
+        return 1;
+    }
+    if (gol_random_init(cur, 0.125, seed)) {
+        printf("Could not allocate the boards\n");
+        return 1;
+    }
+    /* GROWLIFE_RULE runs another Life-like rule, "B36/S23" say (see life_rule.h) */
+    if (getenv("GROWLIFE_RULE") != NULL) {
+        life_rule_t rule;
+        if (life_rule_parse(&rule, getenv("GROWLIFE_RULE"))) {
+            return 1;
+        }
+        life_board_set_rule(&cur->cells, &rule);
+    }
     
-    for (fnum = 0; fnum < NUM_FRAMES; ++fnum) {
+    for (fnum = 0; fnum < NUM_FRAMES && fnum <= opts.last_frame; ++fnum) {
         scene.cam.location[0] = rad*sin(t);
         scene.cam.location[1] = (double)fnum+(NUM_FRAMES/4.0);
         scene.cam.location[2] = rad*cos(t);
         /* scene.cam.look_at[1] = rad; */
         t += dt;
+        game_of_life_t *tmp;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            if (life_blobby_push(&blobby, &cur->cells)) {
+                printf("Could not allocate the blobby\n");
+                return 1;
+            }
+            gol_evolve_into(cur, next);
+            tmp = cur; cur = next; next = tmp;
+            continue;
+        }
         printf("Rendering frame %lu\n", fnum);
         RtInt on = 1;
         char buffer[256];
-        RtString on_string = "on";
-        RtInt samples = 2;
         RtPoint light1Pos = {80,80,80};
         RtPoint light2Pos = {0,120,0};
         RtPoint light3Pos = {0,40,0};
@@ -342,9 +274,9 @@ RiImager("background", RI_NULL);
         RiFrameBegin(fnum);
 
         sprintf(buffer, "images/%s%05zd.jpg", scene.fprefix, fnum);
-        RiDisplay(buffer,(char*)"jpeg",(char*)"rgb",RI_NULL);
+        render_opts_display(&opts, buffer, "jpeg", "rgb");
   
-        RiFormat(1200,1200,1.0);
+        render_opts_format(&opts, 1200, 1200, 1.0);
 
         RiProjection((char*)"perspective",RI_NULL);
 
@@ -358,9 +290,7 @@ RiImager("background", RI_NULL);
                      "int specular", (RtPointer)&on,
                      "int photon", (RtPointer)&on,
                      RI_NULL );
-        RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL );
-
-        RiAttribute((RtToken)"light", "string shadow", (RtPointer)&on_string, RI_NULL);
+        render_opts_shadows(&opts, 2);
         RiLightSource("distantlight", "point from", (RtPointer)light1Pos, RI_NULL);
         RiLightSource("distantlight", "point from", (RtPointer)light2Pos, RI_NULL);
         RiLightSource("pointlight", "point from", (RtPointer)light3Pos, RI_NULL);
@@ -377,25 +307,32 @@ RiImager("background", RI_NULL);
 
         RiTransformBegin();
         /* for (size_t i=0;i<(curBoard+1); ++i) { */
-        /*     gol_show_renderman(boards[i]); */
+        /*     gol_show_renderman(&arena, boards[i]); */
         /*     RiTranslate(0,1.0,0); */
         /* } */
-        gol_show_renderman_blobby(boards, curBoard);
+        gol_show_renderman_blobby(&blobby);
         RiTransformEnd();
         RiAttributeEnd();
 
-        boards[curBoard+1] = gol_evolve(boards[curBoard]);
-        curBoard+=1;
+        /* Frame fnum shows generations [0, fnum); this one is on the next */
+        if (life_blobby_push(&blobby, &cur->cells)) {
+            printf("Could not allocate the blobby\n");
+            return 1;
+        }
+        gol_evolve_into(cur, next);
+        tmp = cur; cur = next; next = tmp;
         
         RiWorldEnd();
         RiFrameEnd();
+        frame_arena_reset(&arena);
 
     }
     RiEnd();
+    frame_arena_free(&arena);
+    life_blobby_free(&blobby);
 
-    for (size_t i=0; i<curBoard; ++i) {
-        gol_destroy_board(&boards[i]);
-    }
+    gol_free_board(&a);
+    gol_free_board(&b);
 
     return 0;
 }
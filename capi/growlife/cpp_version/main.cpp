@@ -1,36 +1,64 @@
 #include "ri.h"
 
-#include <vector>
+#include "frame_arena.h"
+#include "hashlife.h"
+#include "life3d.h"
+#include "life_emit.h"
+#include "life_board.h"
+#include "life_history.h"
+#include "life_mesh.h"
+#include "life_pattern.h"
+#include "life_rule.h"
+#include "render_opts.h"
+
 #include <iostream>
+#include <new>
 #include <cmath>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #define PI (3.141592654)
 
-size_t randUInt(std:: size_t min, size_t max) {
-    return ((std::rand()%(max-min)) + min);
-}
-
-
 class GameOfLife;
 
+// Cells live in a packed life_board_t; see life_board.h
 class GameOfLife {
 public:
-    GameOfLife(size_t w, size_t h) : _width(w), _height(h), _num_on(0) {
-
-        std::vector<bool> tmp;
-        tmp.reserve(_height);
-        tmp.insert(tmp.begin(), _height, false);
-        _board.reserve(_width);
-        _board.insert(_board.begin(), _width, tmp);
+    GameOfLife(size_t w, size_t h) : _width(w), _height(h) {
+        if (life_board_init(&_board, w, h)) {
+            throw std::bad_alloc();
+        }
     }
     GameOfLife(GameOfLife &original) : _width(original._width),
-                                       _height(original._height),
-                                       _num_on(original._num_on),
-                                       _board(original._board)
+                                       _height(original._height)
     {
-        
-        
+        if (life_board_init(&_board, _width, _height) ||
+            life_board_copy(&_board, &original._board)) {
+            throw std::bad_alloc();
+        }
+    }
+    // Takes the cells over; original is left empty
+    GameOfLife(GameOfLife &&original) : _width(original._width),
+                                        _height(original._height),
+                                        _board(original._board)
+    {
+        original._board.cells = NULL;
+        original._board.changed = NULL;
+        original._board.band_on = NULL;
+        original._width = original._height = 0;
+    }
+    GameOfLife &operator=(GameOfLife &&other) {
+        std::swap(_width, other._width);
+        std::swap(_height, other._height);
+        std::swap(_board, other._board);
+        return *this;
+    }
+    ~GameOfLife() {
+        life_board_free(&_board);
     }
     size_t GetWidth() const {
         return _width;
@@ -39,162 +67,204 @@ public:
         return _height;
     }
     size_t GetNumOn() const {
-        return _num_on;
+        return _board.num_on;
+    }
+    bool Get(size_t i, size_t j) const {
+        return life_board_get(&_board, i, j) != 0;
     }
     void DebugPrint() const {
         for (size_t j=0; j<_height; ++j) {
             for (size_t i=0; i<_width; ++i) {
-                std::cout << (_board[i][j]?"X":" ");
+                std::cout << (Get(i,j)?"X":" ");
             }
             std::cout << "\n";
         }
     }
-    void Randomize(double prob) {
-        
-        int numFilled = prob*_width*_height;
-        for (int i=0;i<numFilled; ++i) {
-            size_t ri = randUInt(0, _height);
-            size_t rj = randUInt(0, _width);
-            if (! _board[ri][rj]) {
-                _board[ri][rj] = true;
-                _num_on += 1;
-            }
+    // Each cell alive with probability prob; the board depends only on seed
+    void Randomize(double prob, unsigned long seed) {
+        if (life_pattern_random(&_board, prob, seed)) {
+            throw std::bad_alloc();
         }
-
     }
-
-    size_t CountNeighbors(int i, int j) {
-        int w = _width;
-        int h = _height;
-
-        int num = 0;
-        int up = i-1>0 ? i-1 : h-1;
-        int down = i+1 <h-1 ? i+1 : 0;
-        int left = j-1>0 ? j-1 : w-1;
-        int right = j+1 < w-1 ? j+1 : 0;
-    
-        num += _board[up][j];
-        num += _board[down][j];
-        num += _board[i][left];
-        num += _board[i][right];
-        num += _board[up][left];
-        num += _board[up][right];
-        num += _board[down][left];
-        num += _board[down][right];
-
-        return num;
+    // An RLE or .cells pattern file, centred, and the rule an RLE file
+    // names; returns false if it can't be read
+    bool LoadPattern(const char *path) {
+        life_pattern_t info;
+        life_rule_t rule;
+        life_board_clear(&_board);
+        if (life_pattern_load(path, &_board, &info)) {
+            return false;
+        }
+        if (info.rule[0] != '\0' && life_rule_parse(&rule, info.rule) == 0) {
+            SetRule(rule);
+        }
+        return true;
+    }
+    // Generations evolved from this one follow rule too
+    void SetRule(const life_rule_t &rule) {
+        life_board_set_rule(&_board, &rule);
     }
-    GameOfLife *Evolve() {
-        GameOfLife *goes_to = new GameOfLife(*this);
 
-        
-        goes_to->_num_on = 0;
-        for (size_t i=0; i<goes_to->_width; ++i) {
-            for (size_t j=0; j<goes_to->_height; ++j) {
-                int num = CountNeighbors(i,j);
-
-                if (goes_to->_board[i][j]) {
-                    if ((num < 2) || (num > 3)) {
-                        goes_to->_board[i][j] = false;
-                    } else {
-                        goes_to->_board[i][j] = true;
-                        goes_to->_num_on += 1;
-                    }
-                } else {
-                    if (num == 3) {
-                        goes_to->_board[i][j] = true;
-                        goes_to->_num_on += 1;
-                    } else {
-                        goes_to->_board[i][j] = false;
-                    }
-                }
-            }
-        }
-        return goes_to;
+    // next must be the same size; nothing is allocated
+    void EvolveInto(GameOfLife &next) const {
+        life_evolve(&_board, &next._board);
     }
-    void ShowRenderman() {
-        RiTransformBegin();
-        RiTranslate(-(_width/2.0), 0.0, -(_height/2.0));
-        for (size_t j=0; j<_height; ++j) {
-            RiTransformBegin();
-            for (size_t i=0; i<_width; ++i) {
-                if (_board[i][j]) {
-                    RiSphere(0.5, -0.5,0.5, 360.0, RI_NULL);
-                }
-                RiTranslate(1.0, 0.0, 0.0);
+    // Moves on a generation, using scratch as the other buffer
+    void Step(GameOfLife &scratch) {
+        EvolveInto(scratch);
+        std::swap(_board, scratch._board);
+    }
+    // Hashlife on the open plane, so this matches Evolve() gens times over
+    // only while nothing has wrapped around the board's edges.  Hashlife
+    // only knows Conway's rule, so other rules are evolved the long way,
+    // as is whatever Hashlife runs out of memory before getting to.
+    void JumpAhead(uint64_t gens) {
+        uint64_t done = 0;
+        if (_board.rule.kind == LIFE_RULE_CONWAY) {
+            done = HashlifeJump(gens);
+        }
+        if (done < gens) {
+            GameOfLife scratch(_width, _height);
+            for (uint64_t g=done; g<gens; ++g) {
+                Step(scratch);
             }
-            RiTransformEnd();
-            RiTranslate(0.0, 0.0, 1.0);
         }
-        RiTransformEnd();
     }
-    static void ShowRendermanBlobby(GameOfLife *boards[], size_t num) {
-        size_t totalOn = 0;
-        for (size_t i=0; i<num; ++i) {
-            totalOn += boards[i]->_num_on;
+    const life_board_t *Board() const {
+        return &_board;
+    }
+    void ShowRenderman(frame_arena_t *arena) const {
+        ShowRenderman(&_board, arena);
+    }
+    // For boards that aren't a GameOfLife, like those out of a life_history_t
+    static void ShowRenderman(const life_board_t *board, frame_arena_t *arena) {
+        life_emit(board, life_emit_mode(), arena);
+    }
+    // Generations [first, end) of history as one greedy mesh, with first
+    // at y = 0; with compare, prints what it saves over a primitive per cell
+    static int ShowRendermanMesh(life_mesh_t *mesh, const life_history_t *history,
+                                 size_t first, size_t end, bool compare) {
+        life_history_iter_t gens;
+        if (life_history_iter_init(&gens, history, first, end)) {
+            return 1;
         }
-        RtFloat *mats = new RtFloat[16*totalOn];
-        RtInt *ops = new RtInt[2*totalOn + 1*totalOn + 2];
-        size_t curOff = 0;
-        RiTransformBegin();
-        RiTranslate(-(boards[0]->_width/2.0), 0.0, -(boards[0]->_height/2.0));
-        for (size_t k=0; k<num; ++k) {
-            GameOfLife *board = boards[k];
-            for (size_t j=0; j<board->_height; ++j) {
-                for (size_t i=0; i<board->_width; ++i) {
-                    if (board->_board[i][j]) {
-                        mats[curOff+0] =1.2;
-                        mats[curOff+1] =0.0;
-                        mats[curOff+2] =0.0;
-                        mats[curOff+3] =0.0;
-                        mats[curOff+4] =0.0;
-                        mats[curOff+5] =1.2;
-                        mats[curOff+6] =0.0;
-                        mats[curOff+7] =0.0;
-                        mats[curOff+8] =0.0;
-                        mats[curOff+9] =0.0;
-                        mats[curOff+10] =1.2;
-                        mats[curOff+11] =0.0;
-                        mats[curOff+12] =(RtFloat)i;
-                        mats[curOff+13] =(RtFloat)k;
-                        mats[curOff+14] =(RtFloat)j;
-                        mats[curOff+15] =1.0;
-                        curOff += 16;
-                    }
-                }
+        life_mesh_reset(mesh);
+        while (const life_board_t *board = life_history_iter_next(&gens)) {
+            if (life_mesh_push(mesh, board)) {
+                life_history_iter_free(&gens);
+                return 1;
             }
         }
-        curOff = 0;
-        for (size_t i=0;i<totalOn; ++i) {
-            ops[curOff] = 1001;
-            ops[curOff+1] = i*16;
-            curOff+=2;
+        life_history_iter_free(&gens);
+        if (life_mesh_build(mesh)) {
+            return 1;
         }
-        ops[curOff] = 0;
-        curOff += 1;
-        ops[curOff] = totalOn;
-        curOff += 1;
-        for (size_t i=0;i<totalOn; ++i) {
-            ops[curOff] = i;
-            curOff += 1;
+        if (compare) {
+            std::cout << (end - first) << " generations, " << mesh->num_cells << " cells: "
+                      << mesh->num_cells << " spheres, or cubes of "
+                      << 6*mesh->num_cells << " quads and " << 8*mesh->num_cells
+                      << " points; meshed " << mesh->num_quads << " quads and "
+                      << mesh->num_points << " points\n";
         }
-        RiBlobby(totalOn,
-                 /* Ints */
-                 totalOn*3 + 2, ops,
-                 /* Floats */
-                 totalOn * 16, mats,
-                 /* Strings */
-                 0, (RtString*)RI_NULL, RI_NULL);
-        RiTransformEnd();
-        delete [] mats;
-        delete [] ops;
+        life_mesh_emit(mesh);
+        return 0;
     }
 
 private:
+    GameOfLife &operator=(const GameOfLife &) = delete;
+
+    // Up to gens generations on with Hashlife; returns how many it managed
+    uint64_t HashlifeJump(uint64_t gens) {
+        hashlife_t *hl = static_cast<hashlife_t*>(malloc(sizeof(hashlife_t)));
+        if (hl == NULL || hashlife_init(hl, 0)) {
+            free(hl);
+            throw std::bad_alloc();
+        }
+        int64_t x0 = -(int64_t)(_width/2), y0 = -(int64_t)(_height/2);
+        uint64_t done = 0;
+        if (hashlife_load(hl, &_board, x0, y0) == 0) {
+            hashlife_advance_by(hl, gens);
+            done = hl->generation;
+            hashlife_extract(hl, &_board, x0, y0);
+        }
+        hashlife_free(hl);
+        free(hl);
+        return done;
+    }
+
     size_t _width;
     size_t _height;
-    size_t _num_on;
-    std::vector<std::vector<bool> > _board;
+    life_board_t _board;
+};
+
+// A 26 neighbour automaton in a packed cube of life3d_t cells; see life3d.h
+class Life3D {
+public:
+    Life3D(size_t size) {
+        if (life3d_init(&_grid, size, size, size)) {
+            throw std::bad_alloc();
+        }
+        if (life3d_init(&_scratch, size, size, size)) {
+            life3d_free(&_grid);
+            throw std::bad_alloc();
+        }
+    }
+    ~Life3D() {
+        life3d_free(&_grid);
+        life3d_free(&_scratch);
+    }
+    size_t GetSize() const {
+        return _grid.width;
+    }
+    size_t GetNumOn() const {
+        return _grid.num_on;
+    }
+    // "4555" or "B5/S4-5", say; returns false if it can't be read
+    bool SetRule(const char *text) {
+        return life3d_rule_parse(&_grid.rule, text) == 0;
+    }
+    // A soup of cells alive with probability prob in a cube of side size
+    // at the centre; the cube depends only on seed
+    void Randomize(size_t size, double prob, unsigned long seed) {
+        life3d_random(&_grid, size, prob, seed);
+    }
+    void Step() {
+        if (life3d_evolve(&_grid, &_scratch)) {
+            throw std::bad_alloc();
+        }
+        std::swap(_grid, _scratch);
+    }
+    void ShowRenderman(frame_arena_t *arena) const {
+        life_emit_3d(&_grid, life_emit_mode(), arena);
+    }
+    // The live cells as one greedy mesh of their voxels; with compare,
+    // prints what it saves over a primitive per cell
+    int ShowRendermanMesh(life_mesh_t *mesh, bool compare) const {
+        life_mesh_reset(mesh);
+        for (size_t z=0; z<_grid.depth; ++z) {
+            if (life_mesh_push_rows(mesh, life3d_row(&_grid, 0, z), _grid.stride)) {
+                return 1;
+            }
+        }
+        if (life_mesh_build(mesh)) {
+            return 1;
+        }
+        if (compare) {
+            std::cout << mesh->num_cells << " cells: " << mesh->num_cells
+                      << " points, or cubes of " << 6*mesh->num_cells << " quads and "
+                      << 8*mesh->num_cells << " points; meshed " << mesh->num_quads
+                      << " quads and " << mesh->num_points << " points\n";
+        }
+        life_mesh_emit(mesh);
+        return 0;
+    }
+
+private:
+    Life3D(const Life3D &) = delete;
+    Life3D &operator=(const Life3D &) = delete;
+
+    life3d_t _grid;
+    life3d_t _scratch;
 };
 
 typedef struct camera_s {
@@ -267,23 +337,29 @@ void PlaceCamera(camera_t *cam)
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        std::cout << "Not enough arguments given!\n";
-        return 1;
-    } else if (argc > 2) {
-        std::cout << "Too many arguments given!\n";
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         return 1;
     }
-    char *fprefix = argv[1];
-    srand(time(NULL));
+    char *fprefix = opts.fprefix;
+    unsigned long seed = render_opts_seed(&opts);
+    std::cout << "Using seed " << seed << "\n";
     const size_t NUM_FRAMES = 100;
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     scene_info_t scene;
     double rad = 80.0;
     double t = 0.0;
     double dt = 2.0*PI/(NUM_FRAMES-1);
     size_t fnum;
 
+    // The C structs are freed by these guards on every way out of main()
+    frame_arena_t arena;
+    if (frame_arena_init(&arena, 16*1024*1024)) {
+        std::cout << "Could not allocate the frame arena\n";
+        return 1;
+    }
+    std::unique_ptr<frame_arena_t, void (*)(frame_arena_t *)> arenaGuard(&arena, frame_arena_free);
+
     RiBegin(RI_NULL);
     RiOption("trace", "maxdepth", &md, RI_NULL);
     RiSides(1);
@@ -299,22 +375,121 @@ int main(int argc, char *argv[]) {
 
     scene.fprefix = fprefix;
 
-    GameOfLife *boards[NUM_FRAMES+1];
+    // Two boards take turns being the latest generation, and the stack
+    // comes out of a compressed history of them; GROWLIFE_STACK_DEPTH
+    // limits it to that many of the latest (default all of them)
+    size_t depth = NUM_FRAMES+1;
+    if (getenv("GROWLIFE_STACK_DEPTH") != NULL && atol(getenv("GROWLIFE_STACK_DEPTH")) > 0) {
+        depth = std::min<size_t>(atol(getenv("GROWLIFE_STACK_DEPTH")), NUM_FRAMES+1);
+    }
+    GameOfLife life(80, 80), scratch(80, 80);
+    life_history_t history;
+    if (life_history_init(&history, 80, 80, 0)) {
+        std::cout << "Could not allocate the generation history\n";
+        return 1;
+    }
+    std::unique_ptr<life_history_t, void (*)(life_history_t *)> historyGuard(&history, life_history_free);
     size_t curBoard = 0;
-    boards[curBoard] = new GameOfLife(80,80);
-    boards[curBoard]->Randomize(0.25);
+    // GROWLIFE_PATTERN names a pattern file to start from instead of a soup
+    if (getenv("GROWLIFE_PATTERN") != NULL) {
+        if (!life.LoadPattern(getenv("GROWLIFE_PATTERN"))) {
+            return 1;
+        }
+    } else {
+        life.Randomize(0.25, seed);
+    }
+    // GROWLIFE_RULE runs another Life-like rule, "B36/S23" say (see life_rule.h)
+    if (getenv("GROWLIFE_RULE") != NULL) {
+        life_rule_t rule;
+        if (life_rule_parse(&rule, getenv("GROWLIFE_RULE"))) {
+            return 1;
+        }
+        life.SetRule(rule);
+    }
+    // Start the stack this many generations in
+    if (getenv("GROWLIFE_START_GEN") != NULL) {
+        uint64_t startGen = strtoull(getenv("GROWLIFE_START_GEN"), NULL, 10);
+        std::cout << "Starting at generation " << startGen << "\n";
+        life.JumpAhead(startGen);
+    }
+    if (life_history_push(&history, life.Board())) {
+        std::cout << "Could not allocate the generation history\n";
+        return 1;
+    }
+    // Generation g's retained geometry, once it's been shown
+    std::vector<RtObjectHandle> genObjects;
+    // GROWLIFE_MESH=1 draws the stack as one greedy mesh of its voxels,
+    // rebuilt every frame, instead; GROWLIFE_MESH=compare also prints how
+    // big it is against a primitive per cell
+    const char *meshEnv = getenv("GROWLIFE_MESH");
+    bool meshStack = meshEnv != NULL && strcmp(meshEnv, "0") != 0;
+    bool meshCompare = meshStack && strcmp(meshEnv, "compare") == 0;
+    // GROWLIFE_3D=<rule> grows a 3D automaton instead, "4555" say (see
+    // life3d.h), in a cube GROWLIFE_3D_SIZE cells on a side (default 64)
+    // from a soup in the middle eighth of it, drawn as points or cubes
+    // (LIFE_EMIT) or, with GROWLIFE_MESH, meshed voxels
+    std::unique_ptr<Life3D> life3d;
+    if (getenv("GROWLIFE_3D") != NULL) {
+        size_t size = 64;
+        if (getenv("GROWLIFE_3D_SIZE") != NULL && atol(getenv("GROWLIFE_3D_SIZE")) > 0) {
+            size = atol(getenv("GROWLIFE_3D_SIZE"));
+        }
+        life3d.reset(new Life3D(size));
+        if (!life3d->SetRule(getenv("GROWLIFE_3D"))) {
+            return 1;
+        }
+        life3d->Randomize(size/2, 0.3, seed);
+    }
+    life_mesh_t mesh;
+    if (life_mesh_init(&mesh, life3d != NULL ? life3d->GetSize() : 80,
+                       life3d != NULL ? life3d->GetSize() : 80)) {
+        std::cout << "Could not allocate the mesh\n";
+        return 1;
+    }
+    std::unique_ptr<life_mesh_t, void (*)(life_mesh_t *)> meshGuard(&mesh, life_mesh_free);
     
-    for (fnum = 0; fnum < NUM_FRAMES; ++fnum) {
+    for (fnum = 0; fnum < NUM_FRAMES && fnum <= opts.last_frame; ++fnum) {
         scene.cam.location[0] = rad*sin(t);
         scene.cam.location[1] = (double)fnum+(NUM_FRAMES/4.0);
         scene.cam.location[2] = rad*cos(t);
         /* scene.cam.look_at[1] = rad; */
         t += dt;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            if (life3d != NULL) {
+                life3d->Step();
+                continue;
+            }
+            life.Step(scratch);
+            if (life_history_push(&history, life.Board())) {
+                std::cout << "Could not allocate the generation history\n";
+                return 1;
+            }
+            curBoard+=1;
+            continue;
+        }
         std::cout << "Rendering frame " << fnum << "\n";
+
+        // Generations never change, so each one's spheres are recorded once,
+        // outside any frame, and every frame after that just instances them
+        size_t oldest = curBoard+1 > depth ? curBoard+1 - depth : 0;
+        size_t firstNew = std::max(oldest, genObjects.size());
+        genObjects.resize(curBoard+1, NULL);
+        if (firstNew <= curBoard && !meshStack && life3d == NULL) {
+            life_history_iter_t gens;
+            if (life_history_iter_init(&gens, &history, firstNew, curBoard+1)) {
+                std::cout << "Could not allocate a board\n";
+                return 1;
+            }
+            for (size_t i=firstNew; i<=curBoard; ++i) {
+                genObjects[i] = RiObjectBegin();
+                GameOfLife::ShowRenderman(life_history_iter_next(&gens), &arena);
+                RiObjectEnd();
+            }
+            life_history_iter_free(&gens);
+        }
+
         RtInt on = 1;
         char buffer[256];
-        RtString on_string = "on";
-        RtInt samples = 2;
         RtPoint light1Pos = {80,80,80};
         RtPoint light2Pos = {0,120,0};
         RtPoint light3Pos = {0,40,0};
@@ -322,9 +497,9 @@ int main(int argc, char *argv[]) {
         RiFrameBegin(fnum);
 
         sprintf(buffer, "images/%s%05zd.jpg", scene.fprefix, fnum);
-        RiDisplay(buffer,(char*)"jpeg",(char*)"rgb",RI_NULL);
+        render_opts_display(&opts, buffer, "jpeg", "rgb");
   
-        RiFormat(1200,1200,1.0);
+        render_opts_format(&opts, 1200, 1200, 1.0);
 
         RiProjection((char*)"perspective",RI_NULL);
 
@@ -338,9 +513,7 @@ int main(int argc, char *argv[]) {
                      "int specular", (RtPointer)&on,
                      "int photon", (RtPointer)&on,
                      RI_NULL );
-        RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL );
-
-        RiAttribute((RtToken)"light", "string shadow", (RtPointer)&on_string, RI_NULL);
+        render_opts_shadows(&opts, 2);
         RiLightSource("distantlight", "point from", (RtPointer)light1Pos, RI_NULL);
         RiLightSource("distantlight", "point from", (RtPointer)light2Pos, RI_NULL);
         RiLightSource("pointlight", "point from", (RtPointer)light3Pos, RI_NULL);
@@ -356,29 +529,50 @@ int main(int argc, char *argv[]) {
         /* RiOpacity(opa); */
 
         RiTransformBegin();
-        for (size_t i=0;i<(curBoard+1); ++i) {
-            boards[i]->ShowRenderman();
-            // gol_show_renderman(boards[i]);
-            RiTranslate(0,1.0,0);
+        RiTranslate(0, (RtFloat)oldest, 0);
+        if (life3d != NULL) {
+            // Centred on the origin the camera looks at
+            RiTranslate(0, -(RtFloat)(life3d->GetSize()/2.0), 0);
+            if (meshStack) {
+                if (life3d->ShowRendermanMesh(&mesh, meshCompare)) {
+                    std::cout << "Could not allocate the mesh\n";
+                    return 1;
+                }
+            } else {
+                life3d->ShowRenderman(&arena);
+            }
+        } else if (meshStack) {
+            if (GameOfLife::ShowRendermanMesh(&mesh, &history, oldest, curBoard+1, meshCompare)) {
+                std::cout << "Could not allocate the mesh\n";
+                return 1;
+            }
+        } else {
+            for (size_t i=oldest;i<(curBoard+1); ++i) {
+                RiObjectInstance(genObjects[i]);
+                // gol_show_renderman(boards[i]);
+                RiTranslate(0,1.0,0);
+            }
         }
-        // GameOfLife::ShowRendermanBlobby(boards, curBoard);
-        // gol_show_renderman_blobby(boards, curBoard);
         RiTransformEnd();
         RiAttributeEnd();
 
-        boards[curBoard+1] = boards[curBoard]->Evolve();
-        curBoard+=1;
+        if (life3d != NULL) {
+            life3d->Step();
+        } else {
+            life.Step(scratch);
+            if (life_history_push(&history, life.Board())) {
+                std::cout << "Could not allocate the generation history\n";
+                return 1;
+            }
+            curBoard+=1;
+        }
         
         RiWorldEnd();
         RiFrameEnd();
+        frame_arena_reset(&arena);
 
     }
     RiEnd();
 
-    for (size_t i=0; i<curBoard; ++i) {
-        delete boards[i];
-        // gol_destroy_board(&boards[i]);
-    }
-
     return 0;
 }
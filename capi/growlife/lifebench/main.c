@@ -0,0 +1,861 @@
+/*
+  main.c
+
+  Cells per nanosecond of each of the packed Life board's kernels (every
+  one the CPU supports) against the cell at a time CountNeighbors()
+  evolution growlife used to do, on boards from growlife's 80x80 up.
+  Every kernel's last generation is also checked against the reference,
+  so this doubles as a test of life_evolve().
+
+  Use:
+      lifebench [-g generations] [-t threads] [-s size] ...
+
+  -t sets the threads for the tiled, pooled run (default one per CPU).
+
+  The tracked column is life_evolve() itself, which only works out tiles
+  near a change; a mostly empty board shows what that saves.
+
+  A life_history_t of a long run is checked generation by generation,
+  with its size against keeping every board.
+
+  The RLE and .cells readers are checked against each other on the
+  Gosper glider gun, placed across the board's corner, and seeding a 100
+  megacell board with random cells is timed.
+
+  A board in a file (life_mapped.h) big enough to take several bands is
+  checked against life_evolve() and timed; LIFE_MAPPED_DIR says where to
+  put the file (default /tmp).
+
+  Each kind of rule (life_rule.h) is checked against the reference with
+  every kernel, and its own kernel timed against the table one.  The
+  byte per cell lookup table kernel (life_lut.h) is checked, ages and
+  all, and timed against the reference.
+
+  3D rules (life3d.h) are checked the same way against a 26 neighbour
+  byte per cell reference, with every kernel and in slabs over the pool,
+  and timed on a 256^3 grid.
+
+  Hashlife is checked too, against life_evolve() on a board big enough
+  that the soup never reaches the edges, and then timed jumping a soup
+  2^20 generations.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <math.h>
+#include <time.h>
+
+#include "hashlife.h"
+#include "life3d.h"
+#include "life_board.h"
+#include "life_history.h"
+#include "life_lut.h"
+#include "life_mapped.h"
+#include "life_pattern.h"
+#include "rng.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* One byte per cell, neighbours counted one by one with wraparound */
+static void reference_evolve(const uint8_t *cur, uint8_t *next, size_t w, size_t h,
+                             const life_rule_t *rule) {
+    size_t i, j;
+    for (i=0; i<h; ++i) {
+        size_t up = (i+h-1)%h, down = (i+1)%h;
+        for (j=0; j<w; ++j) {
+            size_t left = (j+w-1)%w, right = (j+1)%w;
+            int n = cur[up*w+left] + cur[up*w+j] + cur[up*w+right] +
+                cur[i*w+left] + cur[i*w+right] +
+                cur[down*w+left] + cur[down*w+j] + cur[down*w+right];
+            next[i*w+j] = ((cur[i*w+j] ? rule->survive : rule->birth) >> n) & 1;
+        }
+    }
+}
+
+static int same_cells(const life_board_t *board, const uint8_t *cells) {
+    size_t x, y;
+    for (y=0; y<board->height; ++y) {
+        for (x=0; x<board->width; ++x) {
+            if (life_board_get(board, x, y) != cells[y*board->width + x]) {
+                printf("Cell %lu,%lu differs from the reference\n", (unsigned long)x, (unsigned long)y);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Returns nonzero if any packed kernel ever disagrees with the reference */
+static int bench(size_t w, size_t h, size_t gens, work_pool_t *pool) {
+    life_board_t start, a, b;
+    uint8_t *ra = malloc(w*h), *rb = malloc(w*h);
+    float r[256];
+    double t0, ref_time;
+    size_t i, k, g;
+    int isa, failed = 0;
+
+    if (ra == NULL || rb == NULL || life_board_init(&start, w, h) ||
+        life_board_init(&a, w, h) || life_board_init(&b, w, h)) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)h);
+        exit(1);
+    }
+    for (i=0; i<w*h; i+=256) {
+        size_t count = (w*h-i < 256) ? w*h-i : 256;
+        rng_fill_float(1, 0, i, r, count);
+        for (k=0; k<count; ++k) {
+            ra[i+k] = r[k] < 0.25f;
+            life_board_set(&start, (i+k) % w, (i+k) / w, ra[i+k]);
+        }
+    }
+
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        uint8_t *tmp;
+        reference_evolve(ra, rb, w, h, &start.rule);
+        tmp = ra; ra = rb; rb = tmp;
+    }
+    ref_time = now() - t0;
+    printf("%6lux%-6lu %6lu gens  reference %7.3f",
+           (unsigned long)w, (unsigned long)h, (unsigned long)gens,
+           (double)w*h*gens/(ref_time*1e9));
+
+    for (isa=0; isa<LIFE_ISA_COUNT; ++isa) {
+        double packed_time;
+        if (!life_isa_supported((life_isa_t)isa)) {
+            printf("  %s %7s", life_isa_name((life_isa_t)isa), "n/a");
+            continue;
+        }
+        life_board_copy(&a, &start);
+        t0 = now();
+        for (g=0; g<gens; ++g) {
+            life_board_t tmp;
+            life_evolve_isa(&a, &b, (life_isa_t)isa);
+            tmp = a; a = b; b = tmp;
+        }
+        packed_time = now() - t0;
+        printf("  %s %7.3f", life_isa_name((life_isa_t)isa), (double)w*h*gens/(packed_time*1e9));
+        if (!same_cells(&a, ra) || a.num_on != life_board_count(&a)) {
+            printf(" MISMATCH");
+            failed = 1;
+        }
+    }
+
+    /* The best kernel again, in tiles over the pool's threads */
+    life_board_copy(&a, &start);
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve_pool(&a, &b, pool);
+        tmp = a; a = b; b = tmp;
+    }
+    printf("  %dx%s %7.3f", work_pool_threads(pool), life_isa_name(life_isa()),
+           (double)w*h*gens/((now() - t0)*1e9));
+    if (!same_cells(&a, ra) || a.num_on != life_board_count(&a)) {
+        printf(" MISMATCH");
+        failed = 1;
+    }
+
+    /* life_evolve(), skipping tiles nowhere near a change */
+    life_board_copy(&a, &start);
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve(&a, &b);
+        tmp = a; a = b; b = tmp;
+    }
+    printf("  tracked %7.3f", (double)w*h*gens/((now() - t0)*1e9));
+    if (!same_cells(&a, ra) || a.num_on != life_board_count(&a)) {
+        printf(" MISMATCH");
+        failed = 1;
+    }
+    printf("\n");
+
+    life_board_free(&start);
+    life_board_free(&a);
+    life_board_free(&b);
+    free(ra);
+    free(rb);
+    return failed;
+}
+
+/* Returns nonzero if any kernel gets a rule wrong */
+static int bench_rules(size_t w, size_t h, size_t gens) {
+    /* The folded ones, then some that take the table */
+    static const char *rules[] = {"B3/S23", "B36/S23", "B3678/S34678", "B2/S",
+                                  "B34/S34", "B0/S8", "B1357/S1357"};
+    life_board_t start, a, b;
+    life_rule_t rule, table;
+    uint8_t *ra = malloc(w*h), *rb = malloc(w*h), *r0 = malloc(w*h);
+    float r[256];
+    size_t i, k, g, j;
+    int isa, failed = 0;
+
+    if (ra == NULL || rb == NULL || r0 == NULL || life_board_init(&start, w, h) ||
+        life_board_init(&a, w, h) || life_board_init(&b, w, h)) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)h);
+        exit(1);
+    }
+    for (i=0; i<w*h; i+=256) {
+        size_t count = (w*h-i < 256) ? w*h-i : 256;
+        rng_fill_float(3, 0, i, r, count);
+        for (k=0; k<count; ++k) {
+            r0[i+k] = r[k] < 0.3f;
+            life_board_set(&start, (i+k) % w, (i+k) / w, r0[i+k]);
+        }
+    }
+
+    for (j=0; j<sizeof(rules)/sizeof(rules[0]); ++j) {
+        char name[24];
+        double t0;
+        life_rule_parse(&rule, rules[j]);
+        /* The same rule through the table kernels, for comparison */
+        table = rule;
+        table.kind = LIFE_RULE_TABLE;
+        memcpy(ra, r0, w*h);
+        for (g=0; g<gens; ++g) {
+            uint8_t *tmp;
+            reference_evolve(ra, rb, w, h, &rule);
+            tmp = ra; ra = rb; rb = tmp;
+        }
+        printf("%-14s %-9s", life_rule_format(&rule, name), life_rule_kind_name(rule.kind));
+
+        for (isa=0; isa<=LIFE_ISA_COUNT; ++isa) {
+            /* One more pass, of life_evolve() itself */
+            int tracked = (isa == LIFE_ISA_COUNT);
+            if (!tracked && !life_isa_supported((life_isa_t)isa)) {
+                printf("  %s %7s", life_isa_name((life_isa_t)isa), "n/a");
+                continue;
+            }
+            life_board_copy(&a, &start);
+            life_board_set_rule(&a, &rule);
+            t0 = now();
+            for (g=0; g<gens; ++g) {
+                life_board_t tmp;
+                if (tracked) {
+                    life_evolve(&a, &b);
+                } else {
+                    life_evolve_isa(&a, &b, (life_isa_t)isa);
+                }
+                tmp = a; a = b; b = tmp;
+            }
+            printf("  %s %7.3f", tracked ? "tracked" : life_isa_name((life_isa_t)isa),
+                   (double)w*h*gens/((now() - t0)*1e9));
+            if (!same_cells(&a, ra) || a.num_on != life_board_count(&a)) {
+                printf(" MISMATCH");
+                failed = 1;
+            }
+        }
+
+        if (rule.kind != LIFE_RULE_TABLE) {
+            life_board_copy(&a, &start);
+            life_board_set_rule(&a, &table);
+            t0 = now();
+            for (g=0; g<gens; ++g) {
+                life_board_t tmp;
+                life_evolve_isa(&a, &b, life_isa());
+                tmp = a; a = b; b = tmp;
+            }
+            printf("  table %7.3f", (double)w*h*gens/((now() - t0)*1e9));
+            if (!same_cells(&a, ra)) {
+                printf(" MISMATCH");
+                failed = 1;
+            }
+        }
+        printf("\n");
+    }
+
+    life_board_free(&start);
+    life_board_free(&a);
+    life_board_free(&b);
+    free(ra);
+    free(rb);
+    free(r0);
+    return failed;
+}
+
+/* Returns nonzero if the byte per cell lookup table kernel disagrees with the reference */
+static int bench_lut(size_t w, size_t h, size_t gens) {
+    static const char *rules[] = {"B3/S23", "B36/S23", "B0/S8"};
+    life_lut_t lut;
+    life_rule_t rule;
+    uint8_t *ra = malloc(w*h), *rb = malloc(w*h), *la = malloc(w*h), *lb = malloc(w*h);
+    uint8_t *ages = malloc(w*h), *r0 = malloc(w*h);
+    float r[256];
+    double t0, ref_time;
+    size_t i, k, g, j;
+    int failed = 0;
+
+    if (ra == NULL || rb == NULL || la == NULL || lb == NULL || ages == NULL || r0 == NULL) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)h);
+        exit(1);
+    }
+    for (i=0; i<w*h; i+=256) {
+        size_t count = (w*h-i < 256) ? w*h-i : 256;
+        rng_fill_float(4, 0, i, r, count);
+        for (k=0; k<count; ++k) {
+            r0[i+k] = r[k] < 0.3f;
+        }
+    }
+
+    for (j=0; j<sizeof(rules)/sizeof(rules[0]); ++j) {
+        char name[24];
+        size_t n = 0, alive = 0;
+        int same = 1;
+        life_rule_parse(&rule, rules[j]);
+        if (life_lut_init(&lut, &rule, w)) {
+            printf("Couldn't allocate the lookup table kernel's row\n");
+            exit(1);
+        }
+        memcpy(ra, r0, w*h);
+        t0 = now();
+        for (g=0; g<gens; ++g) {
+            uint8_t *tmp;
+            reference_evolve(ra, rb, w, h, &rule);
+            tmp = ra; ra = rb; rb = tmp;
+        }
+        ref_time = now() - t0;
+
+        memcpy(la, r0, w*h);
+        t0 = now();
+        for (g=0; g<gens; ++g) {
+            uint8_t *tmp;
+            n = life_lut_evolve(&lut, la, lb, h);
+            tmp = la; la = lb; lb = tmp;
+        }
+        printf("%-14s %lux%lu byte cells  reference %7.3f  lookup table %7.3f",
+               life_rule_format(&rule, name), (unsigned long)w, (unsigned long)h,
+               (double)w*h*gens/(ref_time*1e9), (double)w*h*gens/((now() - t0)*1e9));
+
+        /* The ages, from the reference's cells generation by generation */
+        memcpy(ra, r0, w*h);
+        memcpy(ages, r0, w*h);
+        for (g=0; g<gens; ++g) {
+            uint8_t *tmp;
+            reference_evolve(ra, rb, w, h, &rule);
+            for (i=0; i<w*h; ++i) {
+                ages[i] = rb[i] ? (uint8_t)(ages[i] + (ages[i] < 255)) : 0;
+            }
+            tmp = ra; ra = rb; rb = tmp;
+        }
+        for (i=0; i<w*h; ++i) {
+            alive += la[i] != 0;
+            same &= la[i] == ages[i];
+        }
+        if (!same || n != alive) {
+            printf(" MISMATCH");
+            failed = 1;
+        }
+        printf("\n");
+        life_lut_free(&lut);
+    }
+    free(ra);
+    free(rb);
+    free(la);
+    free(lb);
+    free(ages);
+    free(r0);
+    return failed;
+}
+
+/* One byte per cell, 26 neighbours counted one by one with wraparound */
+static void reference_evolve_3d(const uint8_t *cur, uint8_t *next, size_t w, size_t h, size_t d,
+                                const life3d_rule_t *rule) {
+    size_t x, y, z;
+    for (z=0; z<d; ++z) {
+        for (y=0; y<h; ++y) {
+            for (x=0; x<w; ++x) {
+                size_t i = (z*h + y)*w + x;
+                int n = -cur[i], dx, dy, dz;
+                for (dz=-1; dz<=1; ++dz) {
+                    for (dy=-1; dy<=1; ++dy) {
+                        for (dx=-1; dx<=1; ++dx) {
+                            n += cur[(((z+d+dz)%d)*h + (y+h+dy)%h)*w + (x+w+dx)%w];
+                        }
+                    }
+                }
+                next[i] = ((cur[i] ? rule->survive : rule->birth) >> n) & 1;
+            }
+        }
+    }
+}
+
+static int same_cells_3d(const life3d_t *grid, const uint8_t *cells) {
+    size_t x, y, z;
+    for (z=0; z<grid->depth; ++z) {
+        for (y=0; y<grid->height; ++y) {
+            for (x=0; x<grid->width; ++x) {
+                if (life3d_get(grid, x, y, z) != cells[(z*grid->height + y)*grid->width + x]) {
+                    printf("Cell %lu,%lu,%lu differs from the reference\n",
+                           (unsigned long)x, (unsigned long)y, (unsigned long)z);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+/* Returns nonzero if any 3D kernel, or the slabs over the pool, disagrees with the reference */
+static int bench_3d(size_t w, size_t h, size_t d, size_t gens, const char *rule_text,
+                    work_pool_t *pool) {
+    life3d_t start, a, b;
+    life3d_rule_t rule;
+    size_t cells = w*h*d, x, y, z, g;
+    uint8_t *ra = malloc(cells), *rb = malloc(cells);
+    char name[LIFE3D_RULE_CHARS];
+    double t0;
+    int isa, failed = 0;
+
+    if (ra == NULL || rb == NULL || life3d_init(&start, w, h, d) ||
+        life3d_init(&a, w, h, d) || life3d_init(&b, w, h, d)) {
+        printf("Couldn't allocate a %lux%lux%lu grid\n", (unsigned long)w, (unsigned long)h,
+               (unsigned long)d);
+        exit(1);
+    }
+    life3d_rule_parse(&rule, rule_text);
+    start.rule = rule;
+    life3d_random(&start, w > h ? (w > d ? w : d) : (h > d ? h : d), 0.3, 5);
+    for (z=0; z<d; ++z) {
+        for (y=0; y<h; ++y) {
+            for (x=0; x<w; ++x) {
+                ra[(z*h + y)*w + x] = (uint8_t)life3d_get(&start, x, y, z);
+            }
+        }
+    }
+
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        uint8_t *tmp;
+        reference_evolve_3d(ra, rb, w, h, d, &rule);
+        tmp = ra; ra = rb; rb = tmp;
+    }
+    printf("%-12s %lux%lux%lu %lu gens  reference %7.3f", life3d_rule_format(&rule, name),
+           (unsigned long)w, (unsigned long)h, (unsigned long)d, (unsigned long)gens,
+           (double)cells*gens/((now() - t0)*1e9));
+
+    for (isa=0; isa<=LIFE_ISA_COUNT; ++isa) {
+        /* One more pass, in slabs over the pool */
+        int pooled = (isa == LIFE_ISA_COUNT);
+        if (!pooled && !life_isa_supported((life_isa_t)isa)) {
+            printf("  %s %7s", life_isa_name((life_isa_t)isa), "n/a");
+            continue;
+        }
+        memcpy(a.cells, start.cells, sizeof(uint64_t)*start.stride*h*d);
+        a.rule = rule;
+        t0 = now();
+        for (g=0; g<gens; ++g) {
+            life3d_t tmp;
+            if (pooled) {
+                life3d_evolve_pool(&a, &b, pool);
+            } else {
+                life3d_evolve_isa(&a, &b, (life_isa_t)isa);
+            }
+            tmp = a; a = b; b = tmp;
+        }
+        if (pooled) {
+            printf("  %dx%s", work_pool_threads(pool), life_isa_name(life_isa()));
+        } else {
+            printf("  %s", life_isa_name((life_isa_t)isa));
+        }
+        printf(" %7.3f", (double)cells*gens/((now() - t0)*1e9));
+        if (!same_cells_3d(&a, ra) || a.num_on != life3d_count(&a)) {
+            printf(" MISMATCH");
+            failed = 1;
+        }
+    }
+    printf("\n");
+
+    life3d_free(&start);
+    life3d_free(&a);
+    life3d_free(&b);
+    free(ra);
+    free(rb);
+    return failed;
+}
+
+/* A size x size soup at generation 0, on a board 4 times as wide */
+static void soup(life_board_t *board, size_t size) {
+    float r[256];
+    size_t i, k, off = (board->width - size)/2;
+    for (i=0; i<size*size; i+=256) {
+        rng_fill_float(2, 0, i, r, 256);
+        for (k=0; k<256 && i+k<size*size; ++k) {
+            life_board_set(board, off + (i+k) % size, off + (i+k) / size, r[k] < 0.3f);
+        }
+    }
+}
+
+/* Returns nonzero if tracking changes gets a sparse board wrong */
+static int bench_sparse(size_t w, size_t gens) {
+    life_board_t full, tracked, b;
+    double t0, full_time, tracked_time;
+    size_t g, changed = 0;
+    int failed = 0;
+
+    if (life_board_init(&full, w, w) || life_board_init(&tracked, w, w) || life_board_init(&b, w, w)) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)w);
+        exit(1);
+    }
+    soup(&full, 64);
+    life_board_copy(&tracked, &full);
+
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve_isa(&full, &b, life_isa());
+        tmp = full; full = b; b = tmp;
+    }
+    full_time = now() - t0;
+
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve(&tracked, &b);
+        changed += life_board_num_changed(&b);
+        tmp = tracked; tracked = b; b = tmp;
+    }
+    tracked_time = now() - t0;
+
+    printf("%6lux%-6lu %6lu gens  64x64 soup  every cell %.3fs  tracked %.3fs  %.1f of %lu tiles changed",
+           (unsigned long)w, (unsigned long)w, (unsigned long)gens, full_time, tracked_time,
+           (double)changed/gens, (unsigned long)(tracked.tiles_across*tracked.tiles_down));
+    if (memcmp(full.cells, tracked.cells, sizeof(uint64_t)*full.stride*full.height) != 0 ||
+        tracked.num_on != life_board_count(&tracked)) {
+        printf(" MISMATCH");
+        failed = 1;
+    }
+    printf("\n");
+
+    life_board_free(&full);
+    life_board_free(&tracked);
+    life_board_free(&b);
+    return failed;
+}
+
+/* Returns nonzero if any generation comes back from the history wrong */
+static int bench_history(size_t w, size_t gens) {
+    life_history_t hist;
+    life_history_iter_t it;
+    life_board_t a, b, check;
+    const life_board_t *board;
+    double t0, push_time, iter_time;
+    size_t g;
+    int failed = 0;
+
+    if (life_history_init(&hist, w, w, 0) || life_board_init(&a, w, w) ||
+        life_board_init(&b, w, w) || life_board_init(&check, w, w)) {
+        printf("Couldn't allocate a %lux%lu history\n", (unsigned long)w, (unsigned long)w);
+        exit(1);
+    }
+    soup(&a, w/2);
+    push_time = 0;
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        t0 = now();
+        if (life_history_push(&hist, &a)) {
+            printf("Couldn't allocate a %lux%lu history\n", (unsigned long)w, (unsigned long)w);
+            exit(1);
+        }
+        push_time += now() - t0;
+        life_evolve(&a, &b);
+        tmp = a; a = b; b = tmp;
+    }
+
+    /* Walk it, and check each board against evolving again from the start */
+    life_board_clear(&a);
+    soup(&a, w/2);
+    life_history_iter_init(&it, &hist, 0, gens);
+    iter_time = 0;
+    for (g=0; ; ++g) {
+        life_board_t tmp;
+        t0 = now();
+        board = life_history_iter_next(&it);
+        iter_time += now() - t0;
+        if (board == NULL) {
+            break;
+        }
+        if (memcmp(board->cells, a.cells, sizeof(uint64_t)*a.stride*a.height) != 0 ||
+            board->num_on != a.num_on) {
+            failed = 1;
+        }
+        life_evolve(&a, &b);
+        tmp = a; a = b; b = tmp;
+    }
+    life_history_iter_free(&it);
+    if (g != gens || life_history_get(&hist, gens/2 + 3, &check) ||
+        check.num_on != life_board_count(&check)) {
+        failed = 1;
+    }
+
+    printf("%6lux%-6lu %6lu gens  history %.1fMB of %.1fMB raw  push %.3fms  next %.3fms%s\n",
+           (unsigned long)w, (unsigned long)w, (unsigned long)gens,
+           life_history_bytes(&hist)/1e6, (double)gens*w*w/8/1e6,
+           push_time*1e3/gens, iter_time*1e3/gens, failed ? " MISMATCH" : "");
+
+    life_history_free(&hist);
+    life_board_free(&a);
+    life_board_free(&b);
+    life_board_free(&check);
+    return failed;
+}
+
+static const char *gun_rle =
+    "#N Gosper glider gun\n"
+    "x = 36, y = 9, rule = B3/S23\n"
+    "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4b\n"
+    "obo$10bo5bo7bo$11bo3bo$12b2o!\n";
+
+static const char *gun_cells =
+    "!Name: Gosper glider gun\n"
+    "........................O\n"
+    "......................O.O\n"
+    "............OO......OO............OO\n"
+    "...........O...O....OO............OO\n"
+    "OO........O.....O...OO\n"
+    "OO........O...O.OO....O.O\n"
+    "..........O.....O.......O\n"
+    "...........O...O\n"
+    "............OO\n";
+
+/* Returns nonzero if the pattern readers disagree or the random density is off */
+static int bench_patterns(size_t w, double prob) {
+    life_pattern_t rle_info, cells_info;
+    life_board_t a, b;
+    double t0, seed_time;
+    size_t x, y;
+    uint64_t check[9];
+    int failed = 0, i;
+
+    if (life_board_init(&a, 100, 100) || life_board_init(&b, 100, 100)) {
+        printf("Couldn't allocate a board\n");
+        exit(1);
+    }
+    /* Across the corner, so the runs wrap both ways */
+    failed |= life_pattern_read_rle(gun_rle, &a, 80, 95, &rle_info);
+    failed |= life_pattern_read_cells(gun_cells, &b, 80, 95, &cells_info);
+    if (memcmp(a.cells, b.cells, sizeof(uint64_t)*a.stride*a.height) != 0 || a.num_on != 36 ||
+        b.num_on != 36 || rle_info.width != 36 || cells_info.width != 36 ||
+        rle_info.height != 9 || cells_info.height != 9 || strcmp(rle_info.rule, "B3/S23") != 0 ||
+        !life_board_get(&a, 4, 95) || !life_board_get(&a, 92, 3) || !life_board_get(&a, 80, 99)) {
+        failed = 1;
+    }
+    life_board_free(&a);
+    life_board_free(&b);
+
+    /* Whole words must be the same numbers a stream at a time gives */
+    rng_fill_u64(5, 1, 100, check, 9);
+    for (i=0; i<9; ++i) {
+        rng_t rng;
+        uint64_t lo;
+        rng_init(&rng, 5, 1, 100 + i);
+        lo = rng_u32(&rng);
+        if (check[i] != (lo | ((uint64_t)rng_u32(&rng) << 32))) {
+            failed = 1;
+        }
+    }
+
+    if (life_board_init(&a, w, w)) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)w);
+        exit(1);
+    }
+    t0 = now();
+    failed |= life_pattern_random(&a, prob, 7);
+    seed_time = now() - t0;
+    /* Well inside 5 standard deviations */
+    x = a.num_on;
+    y = (size_t)(prob*w*w);
+    if ((x > y ? x - y : y - x) > 5*sqrt(prob*(1-prob)*w*w) || a.num_on != life_board_count(&a)) {
+        failed = 1;
+    }
+    printf("%6lux%-6lu patterns read  random %.2f soup %.1fms, %.4f alive%s\n",
+           (unsigned long)w, (unsigned long)w, prob, seed_time*1e3, (double)a.num_on/((double)w*w),
+           failed ? " MISMATCH" : "");
+    life_board_free(&a);
+    return failed;
+}
+
+/* Returns nonzero if the file backed board's generations don't match life_evolve()'s */
+static int bench_mapped(size_t w, size_t h, size_t gens) {
+    const char *dir = getenv("LIFE_MAPPED_DIR");
+    char path[1024];
+    life_mapped_t mapped;
+    life_board_t a, b;
+    float r[256];
+    double t0, mapped_time;
+    size_t g, i, k, y;
+    int failed = 0;
+
+    snprintf(path, sizeof(path), "%s/lifebench.board", dir != NULL ? dir : "/tmp");
+    if (life_mapped_create(&mapped, path, w, h)) {
+        return 1;
+    }
+    if (life_board_init(&a, w, h) || life_board_init(&b, w, h)) {
+        printf("Couldn't allocate a %lux%lu board\n", (unsigned long)w, (unsigned long)h);
+        exit(1);
+    }
+    for (i=0; i<w*h; i+=256) {
+        rng_fill_float(3, 0, i, r, 256);
+        for (k=0; k<256 && i+k<w*h; ++k) {
+            if (r[k] < 0.3f) {
+                life_board_set(&a, (i+k) % w, (i+k) / w, 1);
+                life_mapped_set(&mapped, (i+k) % w, (i+k) / w, 1);
+            }
+        }
+    }
+
+    t0 = now();
+    for (g=0; g<gens; ++g) {
+        if (life_mapped_evolve(&mapped)) {
+            failed = 1;
+        }
+    }
+    mapped_time = now() - t0;
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve(&a, &b);
+        tmp = a; a = b; b = tmp;
+    }
+
+    for (y=0; y<h; ++y) {
+        if (memcmp(life_mapped_row(&mapped, y), life_board_row(&a, y), sizeof(uint64_t)*a.words) != 0) {
+            failed = 1;
+        }
+    }
+    if (mapped.num_on != a.num_on) {
+        failed = 1;
+    }
+    printf("%6lux%-6lu %6lu gens  file backed %.3fs  %.0fMB/s in place%s\n",
+           (unsigned long)w, (unsigned long)h, (unsigned long)gens, mapped_time,
+           (double)gens*mapped.stride*sizeof(uint64_t)*h/1e6/mapped_time, failed ? " MISMATCH" : "");
+
+    life_mapped_close(&mapped);
+    remove(path);
+    life_board_free(&a);
+    life_board_free(&b);
+    return failed;
+}
+
+/* Returns nonzero if Hashlife and life_evolve() disagree */
+static int bench_hashlife(void) {
+    const size_t size = 64, gens = 100;
+    hashlife_t *hl = malloc(sizeof(hashlife_t));
+    life_board_t a, b, window;
+    double t0;
+    size_t g;
+    int failed = 0;
+
+    if (hl == NULL || hashlife_init(hl, 0) || life_board_init(&a, size*4, size*4) ||
+        life_board_init(&b, size*4, size*4) || life_board_init(&window, size*4, size*4)) {
+        printf("Couldn't allocate the Hashlife test\n");
+        exit(1);
+    }
+    soup(&a, size);
+    if (hashlife_load(hl, &a, 0, 0)) {
+        exit(1);
+    }
+    for (g=0; g<gens; ++g) {
+        life_board_t tmp;
+        life_evolve(&a, &b);
+        tmp = a; a = b; b = tmp;
+    }
+    /* 100 generations as 64 + 32 + 4, three different RESULT sizes */
+    if (hashlife_advance_by(hl, gens)) {
+        exit(1);
+    }
+    hashlife_extract(hl, &window, 0, 0);
+    if (memcmp(a.cells, window.cells, sizeof(uint64_t)*a.stride*a.height) != 0 ||
+        hashlife_population(hl) != a.num_on) {
+        printf("Hashlife differs from life_evolve() after %lu generations\n", (unsigned long)gens);
+        failed = 1;
+    }
+
+    hashlife_free(hl);
+    life_board_clear(&a);
+    soup(&a, size);
+    if (hashlife_init(hl, 0) || hashlife_load(hl, &a, 0, 0)) {
+        printf("Couldn't allocate the Hashlife test\n");
+        exit(1);
+    }
+    t0 = now();
+    if (hashlife_advance(hl, 20)) {
+        exit(1);
+    }
+    printf("hashlife %lux%lu soup 2^20 gens in %.3fs, %lu cells alive, %lu nodes%s\n",
+           (unsigned long)size, (unsigned long)size, now() - t0,
+           (unsigned long)hashlife_population(hl), (unsigned long)hl->live,
+           failed ? " MISMATCH" : "");
+
+    hashlife_free(hl);
+    free(hl);
+    life_board_free(&a);
+    life_board_free(&b);
+    life_board_free(&window);
+    return failed;
+}
+
+int main(int argc, char *argv[]) {
+    size_t gens = 0;
+    int threads = 0;
+    work_pool_t *pool;
+    size_t sizes[16];
+    size_t num_sizes = 0;
+    size_t i;
+    int failed = 0;
+
+    for (i=1; i<(size_t)argc; ++i) {
+        if (strcmp(argv[i], "-g") == 0 && i+1 < (size_t)argc) {
+            gens = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-t") == 0 && i+1 < (size_t)argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i+1 < (size_t)argc && num_sizes < 16) {
+            sizes[num_sizes++] = strtoul(argv[++i], NULL, 10);
+        } else {
+            printf("Use:\n\t%s [-g generations] [-t threads] [-s size] ...\n\n", argv[0]);
+            return 1;
+        }
+    }
+    if (num_sizes == 0) {
+        /* growlife's board, one that isn't a multiple of 64, and big ones */
+        sizes[num_sizes++] = 80;
+        sizes[num_sizes++] = 1000;
+        sizes[num_sizes++] = 4096;
+    }
+    pool = work_pool_create(threads);
+    if (pool == NULL) {
+        printf("Couldn't start %d threads\n", threads);
+        return 1;
+    }
+    for (i=0; i<num_sizes; ++i) {
+        /* Roughly the same number of cell updates whatever the size */
+        size_t g = gens ? gens : 1 + 200000000/(sizes[i]*sizes[i]);
+        failed |= bench(sizes[i], sizes[i], g, pool);
+    }
+    /* 3D rules on a grid more than a word wide but not a multiple of it, then at 256^3 */
+    failed |= bench_3d(130, 21, 17, 12, "4555", pool);
+    failed |= bench_3d(130, 21, 17, 12, "5766", pool);
+    failed |= bench_3d(130, 21, 17, 12, "B0,13-26/S0-3,26", pool);
+    failed |= bench_3d(64, 9, 7, 12, "B4/S2-6", pool);
+    failed |= bench_3d(256, 256, 256, 2, "4555", pool);
+    failed |= bench_3d(256, 256, 256, 2, "5766", pool);
+    work_pool_destroy(pool);
+    /* Not a multiple of 64 either way */
+    failed |= bench_rules(1000, 333, 30);
+    /* Long enough for ages to saturate */
+    failed |= bench_lut(333, 200, 300);
+    failed |= bench_sparse(2048, 1000);
+    failed |= bench_history(1024, 1000);
+    failed |= bench_patterns(10000, 0.25);
+    /* Not a multiple of 64 wide, and a few LIFE_MAPPED_BAND_BYTES bands */
+    failed |= bench_mapped(16001, 9000, 5);
+    failed |= bench_hashlife();
+    return failed;
+}
@@ -1,26 +1,24 @@
 #include "ri.h"
 
+#include "render_opts.h"
+#include "big_alloc.h"
+#include "rng.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
 #include <math.h>
-#include <time.h>
 
 #define PI (3.141592654)
 
-size_t randUInt(size_t min, size_t max) {
-    return ((rand()%(max-min)) + min);
-}
-
-RtFloat randFloat(RtFloat min, RtFloat max) {
-    RtFloat zToOne = ((RtFloat)rand()/((RtFloat)RAND_MAX));
-    return zToOne * (max-min) + min;
+RtFloat randFloat(rng_t *rng, RtFloat min, RtFloat max) {
+    return rng_float(rng) * (max-min) + min;
 }
-void randColor(RtColor *rc) {
-    (*rc)[0] = randFloat(0.0,0.5);
-    (*rc)[1] = randFloat(0.0,0.5);
-    (*rc)[2] = randFloat(0.0,0.5);
+void randColor(rng_t *rng, RtColor *rc) {
+    (*rc)[0] = randFloat(rng, 0.0,0.5);
+    (*rc)[1] = randFloat(rng, 0.0,0.5);
+    (*rc)[2] = randFloat(rng, 0.0,0.5);
 }
 
 void transform(RtPoint pt, RtPoint out, RtFloat m[3][3], RtPoint offset) {
@@ -33,8 +31,8 @@ void transform(RtPoint pt, RtPoint out, RtFloat m[3][3], RtPoint offset) {
     out[2] = z + offset[2];
 }
 
-void ifs(RtInt n, RtFloat mats[][3][3], RtPoint offsets[], RtFloat *probs, RtPoint pt, RtPoint out) {
-    RtFloat val = randFloat(0.0, 1.0);
+void ifs(rng_t *rng, RtInt n, RtFloat mats[][3][3], RtPoint offsets[], RtFloat *probs, RtPoint pt, RtPoint out) {
+    RtFloat val = randFloat(rng, 0.0, 1.0);
     RtFloat cf = 0.0;
     for (size_t i=0;i<n;++i) {
         cf += probs[i];
@@ -44,10 +42,10 @@ void ifs(RtInt n, RtFloat mats[][3][3], RtPoint offsets[], RtFloat *probs, RtPoi
         }
     }
 }
-void randomPoint2D(RtPoint pt) {
-    (pt)[0] = randFloat(0.0,1.0);
-    (pt)[1] = randFloat(0.0,1.0);
-    (pt)[2] = randFloat(0.0,1.0);
+void randomPoint2D(rng_t *rng, RtPoint pt) {
+    (pt)[0] = randFloat(rng, 0.0,1.0);
+    (pt)[1] = randFloat(rng, 0.0,1.0);
+    (pt)[2] = randFloat(rng, 0.0,1.0);
 }
 
 /* void randomPointInUnitSphere(double *rx, double *ry, double *rz) { */
@@ -163,17 +161,15 @@ RtFloat zf(RtFloat u, RtFloat v) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Not enough arguments given!\n");
-        return 1;
-    } else if (argc > 2) {
-        printf("Too many arguments given!\n");
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         return 1;
     }
-    char *fprefix = argv[1];
-    srand(time(NULL));
+    char *fprefix = opts.fprefix;
+    unsigned long seed = render_opts_seed(&opts);
+    printf("Using seed %lu\n", seed);
     const size_t NUM_FRAMES = 120;
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     scene_info_t scene;
     double rad = 55.0;
     double t = 0.0;
@@ -200,8 +196,16 @@ int main(int argc, char *argv[]) {
     
     const size_t NUM_POINTS = 100000000;
 
-    RtPoint *pts = malloc(sizeof(RtPoint)* NUM_POINTS);
-    randomPoint2D(pts[0]);
+    /* 1.2 GB written front to back: worth huge pages and prefaulting */
+    RtPoint *pts = big_alloc(sizeof(RtPoint)* NUM_POINTS);
+    if (pts == NULL) {
+        printf("Couldn't allocate %lu points!\n", (unsigned long)NUM_POINTS);
+        return 1;
+    }
+    /* The chaos game is serial, so it's one stream from start to finish */
+    rng_t rng;
+    rng_init(&rng, seed, 0, 0);
+    randomPoint2D(&rng, pts[0]);
     /* pts[0][2] = 0.0; */
 
     /* RtFloat mats[][3][3] = {{{0.0,0.0,0.0}, */
@@ -257,7 +261,7 @@ int main(int argc, char *argv[]) {
                        0.14285714285714285,
     };
     for (size_t i=0; i<NUM_POINTS-1; ++i) {
-        ifs(7, mats, offsets, probs, pts[i], pts[i+1]);
+        ifs(&rng, 7, mats, offsets, probs, pts[i], pts[i+1]);
     }
 
     for (fnum = 0; fnum < NUM_FRAMES; ++fnum) {
@@ -266,10 +270,12 @@ int main(int argc, char *argv[]) {
         scene.cam.location[2] = rad*cos(t);
         /* scene.cam.look_at[1] = rad; */
         t += dt;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            continue;
+        }
         printf("Rendering frame %lu\n", (unsigned long)fnum);
         RtInt on = 1;
         char buffer[256];
-        RtString on_string = "on";
         RtInt samples = 2;
         RtPoint light1Pos = {80,80,80};
         RtPoint light2Pos = {0,120,0};
@@ -281,14 +287,14 @@ int main(int argc, char *argv[]) {
 
         
         sprintf(buffer, "images/%s%05lu.jpg", scene.fprefix, (unsigned long)fnum);
-        RiDisplay(buffer,(char*)"jpeg",(char*)"rgb",RI_NULL);
+        render_opts_display(&opts, buffer, "jpeg", "rgb");
   
-        RiFormat(1280, 720, 1.0);
+        RiShadingRate(1.0);
+        render_opts_format(&opts, 1280, 720, 1.0);
 
         RiProjection((char*)"perspective",RI_NULL);
 
         PlaceCamera(&scene.cam);
-        RiShadingRate(1.0);
         RiShadingInterpolation("smooth");
         /* RtFloat bound = 0.125; */
         /* char *space = "object"; */
@@ -303,7 +309,7 @@ int main(int argc, char *argv[]) {
         /*              RI_NULL ); */
         /* RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL ); */
 
-        RiAttribute((RtToken)"light", "string shadow", (RtPointer)&on_string, RI_NULL);
+        render_opts_shadows(&opts, samples);
         RiLightSource("distantlight", "point from", (RtPointer)light1Pos, RI_NULL);
         RiLightSource("distantlight", "point from", (RtPointer)light2Pos, RI_NULL);
         /* RiLightSource("pointlight", "point from", (RtPointer)light3Pos, RI_NULL); */
@@ -333,6 +339,7 @@ int main(int argc, char *argv[]) {
 
     }
     RiEnd();
+    big_free(pts);
 
     return 0;
 }
@@ -1,26 +1,23 @@
 #include "ri.h"
 
+#include "render_opts.h"
+#include "rng.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
 #include <math.h>
-#include <time.h>
 
 #define PI (3.141592654)
 
-size_t randUInt(size_t min, size_t max) {
-    return ((rand()%(max-min)) + min);
-}
-
-RtFloat randFloat(RtFloat min, RtFloat max) {
-    RtFloat zToOne = ((RtFloat)rand()/((RtFloat)RAND_MAX));
-    return zToOne * (max-min) + min;
+RtFloat randFloat(rng_t *rng, RtFloat min, RtFloat max) {
+    return rng_float(rng) * (max-min) + min;
 }
-void randColor(RtColor *rc) {
-    (*rc)[0] = randFloat(0.0,0.5);
-    (*rc)[1] = randFloat(0.0,0.5);
-    (*rc)[2] = randFloat(0.0,0.5);
+void randColor(rng_t *rng, RtColor *rc) {
+    (*rc)[0] = randFloat(rng, 0.0,0.5);
+    (*rc)[1] = randFloat(rng, 0.0,0.5);
+    (*rc)[2] = randFloat(rng, 0.0,0.5);
 }
 /* void randomPointInUnitSphere(double *rx, double *ry, double *rz) { */
 /*     do { */
@@ -135,17 +132,15 @@ RtFloat zf(RtFloat u, RtFloat v) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Not enough arguments given!\n");
-        return 1;
-    } else if (argc > 2) {
-        printf("Too many arguments given!\n");
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         return 1;
     }
-    char *fprefix = argv[1];
-    srand(time(NULL));
+    char *fprefix = opts.fprefix;
+    unsigned long seed = render_opts_seed(&opts);
+    printf("Using seed %lu\n", seed);
     const size_t NUM_FRAMES = 120;
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     scene_info_t scene;
     double rad = 5.0;
     double t = 0.0;
@@ -234,7 +229,9 @@ int main(int argc, char *argv[]) {
     }
     RtColor css[NUM_SPHERES];
     for (size_t i=0; i< NUM_SPHERES; ++i) {
-        randColor(&css[i]);
+        rng_t rng;
+        rng_init(&rng, seed, 0, i);
+        randColor(&rng, &css[i]);
     }
     size_t numOps = (2*NUM_SPHERES + 2 + NUM_SPHERES);
 
@@ -260,10 +257,12 @@ int main(int argc, char *argv[]) {
         scene.cam.location[2] = rad*cos(t);
         /* scene.cam.look_at[1] = rad; */
         t += dt;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            continue;
+        }
         printf("Rendering frame %lu\n", (unsigned long)fnum);
         RtInt on = 1;
         char buffer[256];
-        RtString on_string = "on";
         RtInt samples = 2;
         RtPoint light1Pos = {80,80,80};
         RtPoint light2Pos = {0,120,0};
@@ -275,14 +274,14 @@ int main(int argc, char *argv[]) {
 
         
         sprintf(buffer, "images/%s%05lu.jpg", scene.fprefix, (unsigned long)fnum);
-        RiDisplay(buffer,(char*)"jpeg",(char*)"rgb",RI_NULL);
+        render_opts_display(&opts, buffer, "jpeg", "rgb");
   
-        RiFormat(1280, 720, 1.0);
+        RiShadingRate(1.0);
+        render_opts_format(&opts, 1280, 720, 1.0);
 
         RiProjection((char*)"perspective",RI_NULL);
 
         PlaceCamera(&scene.cam);
-        RiShadingRate(1.0);
         RiShadingInterpolation("smooth");
         /* RtFloat bound = 0.125; */
         /* char *space = "object"; */
@@ -295,9 +294,7 @@ int main(int argc, char *argv[]) {
                      "int specular", (RtPointer)&on,
                      "int photon", (RtPointer)&on,
                      RI_NULL );
-        RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL );
-
-        RiAttribute((RtToken)"light", "string shadow", (RtPointer)&on_string, RI_NULL);
+        render_opts_shadows(&opts, samples);
         RiLightSource("distantlight", "point from", (RtPointer)light1Pos, RI_NULL);
         RiLightSource("distantlight", "point from", (RtPointer)light2Pos, RI_NULL);
         RiLightSource("pointlight", "point from", (RtPointer)light3Pos, RI_NULL);
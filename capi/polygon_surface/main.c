@@ -23,6 +23,8 @@
 
 #include <ri.h>
 
+#include "frame_arena.h"
+
 typedef struct camera_s {
     RtPoint location;
     RtPoint look_at;
@@ -32,6 +34,7 @@ typedef struct camera_s {
 typedef struct scene_info_s {
     camera_t cam;
     char *fprefix;
+    frame_arena_t arena;
 } scene_info_t;
 
 const double PI = 3.141592654;
@@ -139,8 +142,8 @@ void doFrame(int fNum, scene_info_t *scene) {
     const size_t NUM_I = 256;
     const size_t NUM_J = 256;
 
-    RtPoint *pts = malloc(sizeof(RtPoint)*NUM_I*NUM_J);
-    RtColor *colors = malloc(sizeof(RtPoint)*NUM_I*NUM_J);
+    RtPoint *pts = frame_arena_alloc(&scene->arena, sizeof(RtPoint)*NUM_I*NUM_J);
+    RtColor *colors = frame_arena_alloc(&scene->arena, sizeof(RtColor)*NUM_I*NUM_J);
     
     double umin  = -4*PI;
     double umax = 4*PI;
@@ -172,11 +175,11 @@ void doFrame(int fNum, scene_info_t *scene) {
 
     
     RtInt npolys = 2*(NUM_J+1)*(NUM_I+1);
-    RtInt *nvertices = malloc(sizeof(RtInt) * npolys);
+    RtInt *nvertices = frame_arena_alloc(&scene->arena, sizeof(RtInt) * npolys);
     for (size_t i=0; i<npolys; ++i) {
         nvertices[i] = 3;
     }
-    RtInt *vertices = malloc(sizeof(RtInt)*3*npolys);
+    RtInt *vertices = frame_arena_alloc(&scene->arena, sizeof(RtInt)*3*npolys);
 
     size_t curIdx = 0;
     for (size_t i = 0; i<(NUM_I-1); ++i) {
@@ -193,14 +196,10 @@ void doFrame(int fNum, scene_info_t *scene) {
     
     RiPointsPolygons(curIdx/3, nvertices, vertices, "P", pts, "Cs", colors, RI_NULL);
     /* RiSphere(10.0, -10.0, 10.0, 360.0); */
-
-    free(vertices);
-    free(nvertices);
-    free(colors);
-    free(pts);
                     
     RiWorldEnd();
     RiFrameEnd();
+    frame_arena_reset(&scene->arena);
 }
 
 int main(int argc, char *argv[]) {
@@ -226,6 +225,10 @@ int main(int argc, char *argv[]) {
     scene.cam.roll = 0.0;
     
     scene.fprefix = argv[1];
+    if (frame_arena_init(&scene.arena, 4*1024*1024)) {
+        printf("Could not allocate the frame arena\n");
+        exit(1);
+    }
 
     size_t cur_frame = 0;
     
@@ -251,6 +254,7 @@ int main(int argc, char *argv[]) {
     }
 
     RiEnd();
+    frame_arena_free(&scene.arena);
 
     return 0;
 }
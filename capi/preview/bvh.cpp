@@ -0,0 +1,293 @@
+/*
+  bvh.cpp
+
+  Binned SAH bounding volume hierarchy over spheres and triangles.
+*/
+
+#include "preview.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace preview {
+
+namespace {
+
+const int NUM_BINS = 12;
+const uint32_t MAX_LEAF = 4;
+/* Deeper nodes become leaves however big, so traverse()'s stack can't overflow */
+const int MAX_DEPTH = 63;
+const float RAY_EPSILON = 1.0e-5f;
+
+struct Bounds {
+    V3 lo, hi;
+    Bounds() : lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+    void grow(V3 p) { lo = vmin(lo, p); hi = vmax(hi, p); }
+    void grow(const Bounds &b) { lo = vmin(lo, b.lo); hi = vmax(hi, b.hi); }
+    float area() const {
+        if (lo.x > hi.x) return 0;
+        V3 d = hi - lo;
+        return 2.0f*(d.x*d.y + d.y*d.z + d.z*d.x);
+    }
+};
+
+struct Builder {
+    const Scene &scene;
+    Bvh &bvh;
+    std::vector<Bounds> bounds;
+    std::vector<V3> centers;
+
+    Builder(const Scene &s, Bvh &b) : scene(s), bvh(b) {}
+
+    void set_node_bounds(BvhNode &node, uint32_t first, uint32_t count) {
+        Bounds b;
+        for (uint32_t i=first; i<first+count; ++i) {
+            b.grow(bounds[bvh.prims[i]]);
+        }
+        node.bmin[0] = b.lo.x; node.bmin[1] = b.lo.y; node.bmin[2] = b.lo.z;
+        node.bmax[0] = b.hi.x; node.bmax[1] = b.hi.y; node.bmax[2] = b.hi.z;
+    }
+
+    /* Splits node n, depth deep, holding prims[first, first+count) and recurses */
+    void subdivide(uint32_t n, uint32_t first, uint32_t count, int depth) {
+        bvh.nodes[n].first = first;
+        bvh.nodes[n].count = count;
+        set_node_bounds(bvh.nodes[n], first, count);
+        if (count <= MAX_LEAF || depth >= MAX_DEPTH) {
+            return;
+        }
+
+        Bounds cb;
+        for (uint32_t i=first; i<first+count; ++i) {
+            cb.grow(centers[bvh.prims[i]]);
+        }
+
+        int best_axis = -1;
+        int best_split = 0;
+        float best_cost = FLT_MAX;
+        for (int axis=0; axis<3; ++axis) {
+            float lo = cb.lo[axis];
+            float extent = cb.hi[axis] - lo;
+            if (extent <= 0) continue;
+
+            Bounds bin_bounds[NUM_BINS];
+            uint32_t bin_count[NUM_BINS] = {0};
+            float scale = NUM_BINS / extent;
+            for (uint32_t i=first; i<first+count; ++i) {
+                uint32_t p = bvh.prims[i];
+                int b = std::min(NUM_BINS-1, (int)((centers[p][axis] - lo)*scale));
+                bin_bounds[b].grow(bounds[p]);
+                bin_count[b]++;
+            }
+
+            /* Sweep from the right, then from the left */
+            float right_area[NUM_BINS];
+            uint32_t right_count[NUM_BINS];
+            Bounds acc;
+            uint32_t num = 0;
+            for (int b=NUM_BINS-1; b>0; --b) {
+                acc.grow(bin_bounds[b]);
+                num += bin_count[b];
+                right_area[b] = acc.area();
+                right_count[b] = num;
+            }
+            acc = Bounds();
+            num = 0;
+            for (int b=0; b<NUM_BINS-1; ++b) {
+                acc.grow(bin_bounds[b]);
+                num += bin_count[b];
+                float cost = num*acc.area() + right_count[b+1]*right_area[b+1];
+                if (num > 0 && right_count[b+1] > 0 && cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = b+1;
+                }
+            }
+        }
+
+        Bounds nb;
+        nb.lo = V3(bvh.nodes[n].bmin);
+        nb.hi = V3(bvh.nodes[n].bmax);
+        if (best_axis >= 0 && best_cost >= count*nb.area() && count <= 4*MAX_LEAF) {
+            /* No split beats a small leaf */
+            return;
+        }
+
+        uint32_t mid;
+        if (best_axis < 0) {
+            /* Coincident centers, split the list in half */
+            mid = first + count/2;
+        } else {
+            float lo = cb.lo[best_axis];
+            float scale = NUM_BINS / (cb.hi[best_axis] - lo);
+            uint32_t *begin = &bvh.prims[first];
+            uint32_t *split = std::partition(begin, begin + count, [&](uint32_t p) {
+                    int b = std::min(NUM_BINS-1, (int)((centers[p][best_axis] - lo)*scale));
+                    return b < best_split;
+                });
+            mid = first + (uint32_t)(split - begin);
+        }
+
+        uint32_t left = (uint32_t)bvh.nodes.size();
+        bvh.nodes.resize(bvh.nodes.size() + 2);
+        bvh.nodes[n].first = left;
+        bvh.nodes[n].count = 0;
+        subdivide(left, first, mid - first, depth+1);
+        subdivide(left+1, mid, first + count - mid, depth+1);
+    }
+
+    void build() {
+        size_t ns = scene.spheres.size();
+        size_t nt = scene.triangles.size();
+        size_t total = ns + nt;
+
+        bvh.nodes.clear();
+        bvh.prims.clear();
+        if (total == 0) {
+            return;
+        }
+        bounds.resize(total);
+        centers.resize(total);
+        bvh.prims.resize(total);
+
+        /* Prims are numbered spheres first; the reference carries the type bit */
+        std::vector<uint32_t> ids(total);
+        for (size_t i=0; i<ns; ++i) {
+            const Sphere &s = scene.spheres[i];
+            V3 r(s.radius, s.radius, s.radius);
+            bounds[i].lo = s.center - r;
+            bounds[i].hi = s.center + r;
+            centers[i] = s.center;
+        }
+        for (size_t i=0; i<nt; ++i) {
+            const Triangle &t = scene.triangles[i];
+            Bounds &b = bounds[ns+i];
+            b.grow(t.p0);
+            b.grow(t.p0 + t.e1);
+            b.grow(t.p0 + t.e2);
+            centers[ns+i] = (b.lo + b.hi)*0.5f;
+        }
+        for (size_t i=0; i<total; ++i) {
+            bvh.prims[i] = (uint32_t)i;
+        }
+
+        bvh.nodes.reserve(2*total/MAX_LEAF + 1);
+        bvh.nodes.resize(1);
+        subdivide(0, 0, (uint32_t)total, 0);
+
+        for (size_t i=0; i<total; ++i) {
+            uint32_t p = bvh.prims[i];
+            bvh.prims[i] = p < ns ? p : (uint32_t)((p - ns) | BVH_TRIANGLE);
+        }
+    }
+};
+
+/* Slab test; returns the entry distance or FLT_MAX on a miss */
+inline float hit_box(const BvhNode &node, const V3 &org, const V3 &inv, float tmax) {
+    float tx0 = (node.bmin[0] - org.x)*inv.x, tx1 = (node.bmax[0] - org.x)*inv.x;
+    float ty0 = (node.bmin[1] - org.y)*inv.y, ty1 = (node.bmax[1] - org.y)*inv.y;
+    float tz0 = (node.bmin[2] - org.z)*inv.z, tz1 = (node.bmax[2] - org.z)*inv.z;
+    float tnear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+                           std::max(std::min(tz0, tz1), 0.0f));
+    float tfar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+                          std::min(std::max(tz0, tz1), tmax));
+    return tnear <= tfar ? tnear : FLT_MAX;
+}
+
+inline bool hit_sphere(const Sphere &s, const Ray &ray, float tmax, float &t) {
+    V3 oc = ray.org - s.center;
+    float b = dot(oc, ray.dir);
+    float c = dot(oc, oc) - s.radius*s.radius;
+    float disc = b*b - c;
+    if (disc < 0) return false;
+    float root = std::sqrt(disc);
+    t = -b - root;
+    if (t < RAY_EPSILON) {
+        t = -b + root;
+    }
+    return t >= RAY_EPSILON && t < tmax;
+}
+
+inline bool hit_triangle(const Triangle &tri, const Ray &ray, float tmax,
+                         float &t, float &u, float &v) {
+    V3 pvec = cross(ray.dir, tri.e2);
+    float det = dot(tri.e1, pvec);
+    if (std::fabs(det) < 1.0e-12f) return false;
+    float inv = 1.0f/det;
+    V3 tvec = ray.org - tri.p0;
+    u = dot(tvec, pvec)*inv;
+    if (u < 0 || u > 1) return false;
+    V3 qvec = cross(tvec, tri.e1);
+    v = dot(ray.dir, qvec)*inv;
+    if (v < 0 || u + v > 1) return false;
+    t = dot(tri.e2, qvec)*inv;
+    return t >= RAY_EPSILON && t < tmax;
+}
+
+template <bool ANY_HIT>
+bool traverse(const Scene &scene, const Bvh &bvh, const Ray &ray, float tmax, Hit &hit) {
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    V3 inv(1.0f/ray.dir.x, 1.0f/ray.dir.y, 1.0f/ray.dir.z);
+    /* A node's unvisited sibling per level on the way down, and the node */
+    uint32_t stack[MAX_DEPTH+1];
+    int sp = 0;
+    bool found = false;
+    hit.t = tmax;
+
+    if (hit_box(bvh.nodes[0], ray.org, inv, tmax) == FLT_MAX) {
+        return false;
+    }
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const BvhNode &node = bvh.nodes[stack[--sp]];
+        if (node.count > 0) {
+            for (uint32_t i=node.first; i<node.first+node.count; ++i) {
+                uint32_t p = bvh.prims[i];
+                float t, u = 0, v = 0;
+                bool h = (p & BVH_TRIANGLE)
+                    ? hit_triangle(scene.triangles[p & ~BVH_TRIANGLE], ray, hit.t, t, u, v)
+                    : hit_sphere(scene.spheres[p], ray, hit.t, t);
+                if (h) {
+                    if (ANY_HIT) return true;
+                    found = true;
+                    hit.t = t;
+                    hit.prim = p;
+                    hit.u = u;
+                    hit.v = v;
+                }
+            }
+            continue;
+        }
+        /* Visit the nearer child first */
+        float tl = hit_box(bvh.nodes[node.first], ray.org, inv, hit.t);
+        float tr = hit_box(bvh.nodes[node.first+1], ray.org, inv, hit.t);
+        if (tl <= tr) {
+            if (tr != FLT_MAX) stack[sp++] = node.first+1;
+            if (tl != FLT_MAX) stack[sp++] = node.first;
+        } else {
+            if (tl != FLT_MAX) stack[sp++] = node.first;
+            stack[sp++] = node.first+1;
+        }
+    }
+    return found;
+}
+
+} // namespace
+
+void bvh_build(const Scene &scene, Bvh &bvh) {
+    Builder builder(scene, bvh);
+    builder.build();
+}
+
+bool bvh_intersect(const Scene &scene, const Bvh &bvh, const Ray &ray, float tmax, Hit &hit) {
+    return traverse<false>(scene, bvh, ray, tmax, hit);
+}
+
+bool bvh_occluded(const Scene &scene, const Bvh &bvh, const Ray &ray, float tmax) {
+    Hit hit;
+    return traverse<true>(scene, bvh, ray, tmax, hit);
+}
+
+} // namespace preview
@@ -0,0 +1,176 @@
+/*
+  geometry.cpp
+
+  Transforms and turning object space primitives into the camera space
+  spheres and triangles the renderer intersects.
+*/
+
+#include "preview.h"
+
+namespace preview {
+
+Mat4 Mat4::identity() {
+    Mat4 r;
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+            r.m[i][j] = (i == j) ? 1.0f : 0.0f;
+        }
+    }
+    return r;
+}
+
+Mat4 Mat4::from_ri(const float ri[4][4]) {
+    Mat4 r;
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+            r.m[i][j] = ri[j][i];
+        }
+    }
+    return r;
+}
+
+Mat4 Mat4::translate(float dx, float dy, float dz) {
+    Mat4 r = identity();
+    r.m[0][3] = dx;
+    r.m[1][3] = dy;
+    r.m[2][3] = dz;
+    return r;
+}
+
+Mat4 Mat4::scale(float sx, float sy, float sz) {
+    Mat4 r = identity();
+    r.m[0][0] = sx;
+    r.m[1][1] = sy;
+    r.m[2][2] = sz;
+    return r;
+}
+
+Mat4 Mat4::rotate(float degrees, float ax, float ay, float az) {
+    Mat4 r = identity();
+    V3 a = normalize(V3(ax, ay, az));
+    float rad = degrees*3.14159265358979f/180.0f;
+    float c = std::cos(rad), s = std::sin(rad), t = 1.0f - c;
+    r.m[0][0] = c + a.x*a.x*t;
+    r.m[0][1] = a.x*a.y*t - a.z*s;
+    r.m[0][2] = a.x*a.z*t + a.y*s;
+    r.m[1][0] = a.y*a.x*t + a.z*s;
+    r.m[1][1] = c + a.y*a.y*t;
+    r.m[1][2] = a.y*a.z*t - a.x*s;
+    r.m[2][0] = a.z*a.x*t - a.y*s;
+    r.m[2][1] = a.z*a.y*t + a.x*s;
+    r.m[2][2] = c + a.z*a.z*t;
+    return r;
+}
+
+Mat4 Mat4::operator*(const Mat4 &b) const {
+    Mat4 r;
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+            r.m[i][j] = m[i][0]*b.m[0][j] + m[i][1]*b.m[1][j] + m[i][2]*b.m[2][j] + m[i][3]*b.m[3][j];
+        }
+    }
+    return r;
+}
+
+V3 Mat4::point(V3 p) const {
+    V3 r(m[0][0]*p.x + m[0][1]*p.y + m[0][2]*p.z + m[0][3],
+         m[1][0]*p.x + m[1][1]*p.y + m[1][2]*p.z + m[1][3],
+         m[2][0]*p.x + m[2][1]*p.y + m[2][2]*p.z + m[2][3]);
+    float w = m[3][0]*p.x + m[3][1]*p.y + m[3][2]*p.z + m[3][3];
+    return (w != 1.0f && w != 0.0f) ? r*(1.0f/w) : r;
+}
+
+V3 Mat4::vector(V3 v) const {
+    return V3(m[0][0]*v.x + m[0][1]*v.y + m[0][2]*v.z,
+              m[1][0]*v.x + m[1][1]*v.y + m[1][2]*v.z,
+              m[2][0]*v.x + m[2][1]*v.y + m[2][2]*v.z);
+}
+
+float Mat4::uniform_scale() const {
+    V3 c0(m[0][0], m[1][0], m[2][0]);
+    V3 c1(m[0][1], m[1][1], m[2][1]);
+    V3 c2(m[0][2], m[1][2], m[2][2]);
+    float l0 = length(c0), l1 = length(c1), l2 = length(c2);
+    float tol = 1.0e-3f*l0;
+    if (std::fabs(l0 - l1) > tol || std::fabs(l0 - l2) > tol) {
+        return -1.0f;
+    }
+    if (std::fabs(dot(c0, c1)) > tol*l0 || std::fabs(dot(c1, c2)) > tol*l0 ||
+        std::fabs(dot(c0, c2)) > tol*l0) {
+        return -1.0f;
+    }
+    return l0;
+}
+
+void add_sphere(Scene &scene, const Mat4 &xform, float radius, uint32_t material, V3 color) {
+    float s = xform.uniform_scale();
+    if (s > 0) {
+        Sphere sph;
+        sph.center = xform.point(V3(0, 0, 0));
+        sph.radius = radius*s;
+        sph.color = color;
+        sph.material = material;
+        scene.spheres.push_back(sph);
+        return;
+    }
+
+    /* Squashed or sheared: fall back to a tessellated ellipsoid */
+    const int nu = 24, nv = 12;
+    std::vector<V3> grid;
+    grid.reserve((nu+1)*(nv+1));
+    for (int j=0; j<=nv; ++j) {
+        float phi = -1.5707963f + 3.14159265f*j/nv;
+        for (int i=0; i<=nu; ++i) {
+            float theta = 6.2831853f*i/nu;
+            grid.push_back(V3(radius*std::cos(theta)*std::cos(phi),
+                              radius*std::sin(theta)*std::cos(phi),
+                              radius*std::sin(phi)));
+        }
+    }
+    size_t first = scene.materials.size();
+    /* Tessellated spheres take their color from the material */
+    Material mat = scene.materials[material];
+    mat.color = color;
+    scene.materials.push_back(mat);
+    add_grid(scene, xform, grid, nu, nv, (uint32_t)first);
+}
+
+void add_grid(Scene &scene, const Mat4 &xform, const std::vector<V3> &grid, int nu, int nv,
+              uint32_t material) {
+    std::vector<V3> pts(grid.size());
+    for (size_t i=0; i<grid.size(); ++i) {
+        pts[i] = xform.point(grid[i]);
+    }
+    for (int j=0; j<nv; ++j) {
+        for (int i=0; i<nu; ++i) {
+            const V3 &a = pts[j*(nu+1) + i];
+            const V3 &b = pts[j*(nu+1) + i + 1];
+            const V3 &c = pts[(j+1)*(nu+1) + i + 1];
+            const V3 &d = pts[(j+1)*(nu+1) + i];
+            add_triangle(scene, a, b, c, material, NULL);
+            add_triangle(scene, a, c, d, material, NULL);
+        }
+    }
+}
+
+void add_triangle(Scene &scene, V3 a, V3 b, V3 c, uint32_t material, const V3 *colors) {
+    Triangle tri;
+    tri.p0 = a;
+    tri.e1 = b - a;
+    tri.e2 = c - a;
+    /* Poles and seams produce zero area triangles */
+    if (dot(cross(tri.e1, tri.e2), cross(tri.e1, tri.e2)) == 0.0f) {
+        return;
+    }
+    tri.material = material;
+    tri.colors = -1;
+    if (colors != NULL) {
+        tri.colors = (int32_t)scene.vertex_colors.size();
+        scene.vertex_colors.push_back(colors[0]);
+        scene.vertex_colors.push_back(colors[1]);
+        scene.vertex_colors.push_back(colors[2]);
+    }
+    scene.triangles.push_back(tri);
+}
+
+} // namespace preview
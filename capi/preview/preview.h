@@ -0,0 +1,205 @@
+/*
+  preview.h
+
+  Internal data structures shared by the preview ray caster.  Everything
+  the Ri calls produce is stored in camera space (RenderMan's left handed
+  space: +x right, +y up, +z into the screen), so the renderer only sees
+  flat arrays of spheres and triangles plus a list of lights.
+*/
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace preview {
+
+struct V3 {
+    float x, y, z;
+    V3() : x(0), y(0), z(0) {}
+    V3(float a, float b, float c) : x(a), y(b), z(c) {}
+    explicit V3(const float *p) : x(p[0]), y(p[1]), z(p[2]) {}
+    float operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+inline V3 operator+(V3 a, V3 b) { return V3(a.x+b.x, a.y+b.y, a.z+b.z); }
+inline V3 operator-(V3 a, V3 b) { return V3(a.x-b.x, a.y-b.y, a.z-b.z); }
+inline V3 operator-(V3 a) { return V3(-a.x, -a.y, -a.z); }
+inline V3 operator*(V3 a, float s) { return V3(a.x*s, a.y*s, a.z*s); }
+inline V3 operator*(V3 a, V3 b) { return V3(a.x*b.x, a.y*b.y, a.z*b.z); }
+inline float dot(V3 a, V3 b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+inline V3 cross(V3 a, V3 b) {
+    return V3(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x);
+}
+inline float length(V3 a) { return std::sqrt(dot(a, a)); }
+inline V3 normalize(V3 a) {
+    float len = length(a);
+    return len > 0 ? a * (1.0f/len) : a;
+}
+inline V3 vmin(V3 a, V3 b) {
+    return V3(std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z));
+}
+inline V3 vmax(V3 a, V3 b) {
+    return V3(std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z));
+}
+
+/*
+ * A 4x4 transform acting on column vectors, so m.point(p) = M*p.  Ri
+ * matrices are row vector matrices and are transposed on the way in.
+ */
+struct Mat4 {
+    float m[4][4];
+
+    static Mat4 identity();
+    static Mat4 from_ri(const float ri[4][4]);
+    static Mat4 translate(float dx, float dy, float dz);
+    static Mat4 scale(float sx, float sy, float sz);
+    static Mat4 rotate(float degrees, float ax, float ay, float az);
+
+    Mat4 operator*(const Mat4 &b) const;
+    V3 point(V3 p) const;
+    V3 vector(V3 v) const;
+
+    /* Uniform scale factor if the upper 3x3 is a similarity, else -1 */
+    float uniform_scale() const;
+};
+
+enum SurfaceType { SURFACE_CONSTANT, SURFACE_MATTE, SURFACE_PLASTIC };
+
+struct Material {
+    SurfaceType type;
+    V3 color;
+    float Ka, Kd, Ks, roughness;
+    V3 specularcolor;
+};
+
+/* An analytic sphere; 32 bytes so leaves stay cache line friendly */
+struct Sphere {
+    V3 center;
+    float radius;
+    V3 color;
+    uint32_t material;
+};
+
+/* A triangle stored as a vertex and two edges for Moller-Trumbore */
+struct Triangle {
+    V3 p0, e1, e2;
+    uint32_t material;
+    /* Index of three vertex colors in Scene::vertex_colors, or -1 to use the material's */
+    int32_t colors;
+};
+
+enum LightType { LIGHT_AMBIENT, LIGHT_DISTANT, LIGHT_POINT };
+
+struct Light {
+    LightType type;
+    /* Position for point lights, direction towards the light for distant ones */
+    V3 from;
+    V3 color;
+    bool shadows;
+};
+
+struct Scene {
+    std::vector<Sphere> spheres;
+    std::vector<Triangle> triangles;
+    std::vector<V3> vertex_colors;
+    std::vector<Material> materials;
+    std::vector<Light> lights;
+
+    void clear_geometry() {
+        spheres.clear();
+        triangles.clear();
+        vertex_colors.clear();
+        materials.clear();
+    }
+};
+
+/*
+ * Adding geometry to a scene.  Points are in object space and xform takes
+ * them to camera space.
+ */
+/* A full sphere, tessellated if xform is not a similarity */
+void add_sphere(Scene &scene, const Mat4 &xform, float radius, uint32_t material, V3 color);
+/* A (nu+1) x (nv+1) grid of points, as two triangles per quad */
+void add_grid(Scene &scene, const Mat4 &xform, const std::vector<V3> &grid, int nu, int nv,
+              uint32_t material);
+/* A triangle already in camera space, with optional vertex colors */
+void add_triangle(Scene &scene, V3 a, V3 b, V3 c, uint32_t material, const V3 *colors);
+
+/*
+ * A binary BVH over both primitive types.  Primitive references have the
+ * top bit set for triangles.  Nodes are 32 bytes: a leaf has count > 0 and
+ * first indexing into prims, an interior node has its left child at
+ * first and its right child at first+1.
+ */
+struct BvhNode {
+    float bmin[3];
+    float bmax[3];
+    uint32_t first;
+    uint32_t count;
+};
+
+const uint32_t BVH_TRIANGLE = 0x80000000u;
+
+struct Bvh {
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> prims;
+};
+
+void bvh_build(const Scene &scene, Bvh &bvh);
+
+struct Ray {
+    V3 org, dir;
+};
+
+struct Hit {
+    float t;
+    uint32_t prim;
+    float u, v;
+};
+
+/* Nearest hit closer than tmax; returns false on a miss */
+bool bvh_intersect(const Scene &scene, const Bvh &bvh, const Ray &ray, float tmax, Hit &hit);
+/* True if anything blocks the ray before tmax */
+bool bvh_occluded(const Scene &scene, const Bvh &bvh, const Ray &ray, float tmax);
+
+struct Display {
+    std::string name;
+    std::string type;
+    std::string mode;
+};
+
+/* Frame options, saved and restored around RiFrameBegin/RiFrameEnd */
+struct Options {
+    int xres, yres;
+    float pixel_aspect;
+    float frame_aspect;
+    bool have_screen;
+    float screen[4];
+    float crop[4];
+    int xsamples, ysamples;
+    bool perspective;
+    float fov;
+    V3 background;
+    bool have_background;
+    std::vector<Display> displays;
+
+    Options();
+};
+
+struct RenderStats {
+    size_t primary_rays;
+    size_t shadow_rays;
+    double build_ms;
+    double render_ms;
+};
+
+/* Builds the BVH, renders the crop window and writes every display */
+void render_frame(const Options &opts, const Scene &scene, RenderStats &stats);
+
+} // namespace preview
+
+#endif
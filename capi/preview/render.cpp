@@ -0,0 +1,289 @@
+/*
+  render.cpp
+
+  Casts the camera rays for one frame over a pool of threads, shades the
+  hits with matte/plastic and writes the frame's displays.
+*/
+
+#include "preview.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "image_io.h"
+
+namespace preview {
+
+namespace {
+
+const int TILE_SIZE = 16;
+
+namespace sc = std::chrono;
+
+double ms_since(sc::steady_clock::time_point start) {
+    return sc::duration<double, std::milli>(sc::steady_clock::now() - start).count();
+}
+
+struct Camera {
+    bool perspective;
+    float screen[4];
+    float tan_half_fov;
+    int xres, yres;
+
+    Ray ray(float px, float py) const {
+        float sx = screen[0] + px/xres*(screen[1] - screen[0]);
+        float sy = screen[3] - py/yres*(screen[3] - screen[2]);
+        Ray r;
+        if (perspective) {
+            r.org = V3(0, 0, 0);
+            r.dir = normalize(V3(sx*tan_half_fov, sy*tan_half_fov, 1.0f));
+        } else {
+            r.org = V3(sx, sy, 0);
+            r.dir = V3(0, 0, 1);
+        }
+        return r;
+    }
+};
+
+struct Tracer {
+    const Options &opts;
+    const Scene &scene;
+    const Bvh &bvh;
+    Camera cam;
+    int x0, x1, y0, y1;
+    std::vector<float> rgba;
+    std::atomic<int> next_tile;
+    std::atomic<size_t> primary_rays, shadow_rays;
+
+    Tracer(const Options &o, const Scene &s, const Bvh &b)
+        : opts(o), scene(s), bvh(b), next_tile(0), primary_rays(0), shadow_rays(0) {}
+
+    V3 shade(const Ray &ray, const Hit &hit, size_t &nshadow) const {
+        V3 P = ray.org + ray.dir*hit.t;
+        V3 N, Cs;
+        const Material *mat;
+        if (hit.prim & BVH_TRIANGLE) {
+            const Triangle &tri = scene.triangles[hit.prim & ~BVH_TRIANGLE];
+            mat = &scene.materials[tri.material];
+            N = normalize(cross(tri.e1, tri.e2));
+            if (tri.colors >= 0) {
+                const V3 *c = &scene.vertex_colors[tri.colors];
+                Cs = c[0]*(1.0f - hit.u - hit.v) + c[1]*hit.u + c[2]*hit.v;
+            } else {
+                Cs = mat->color;
+            }
+        } else {
+            const Sphere &s = scene.spheres[hit.prim];
+            mat = &scene.materials[s.material];
+            N = (P - s.center)*(1.0f/s.radius);
+            Cs = s.color;
+        }
+        if (mat->type == SURFACE_CONSTANT) {
+            return Cs;
+        }
+        if (dot(N, ray.dir) > 0) {
+            N = -N;
+        }
+        V3 V = -ray.dir;
+        float eps = 1.0e-4f*std::max(1.0f, std::max(std::fabs(P.x), std::max(std::fabs(P.y), std::fabs(P.z))));
+        V3 ambient, diffuse, specular;
+        for (const Light &light : scene.lights) {
+            if (light.type == LIGHT_AMBIENT) {
+                ambient = ambient + light.color;
+                continue;
+            }
+            V3 L, Cl = light.color;
+            float dist = 1.0e30f;
+            if (light.type == LIGHT_DISTANT) {
+                L = light.from;
+            } else {
+                L = light.from - P;
+                dist = length(L);
+                L = L*(1.0f/dist);
+                Cl = Cl*(1.0f/(dist*dist));
+            }
+            float ndl = dot(N, L);
+            if (ndl <= 0) {
+                continue;
+            }
+            if (light.shadows) {
+                Ray shadow;
+                shadow.org = P + N*eps;
+                shadow.dir = L;
+                ++nshadow;
+                if (bvh_occluded(scene, bvh, shadow, dist - eps)) {
+                    continue;
+                }
+            }
+            diffuse = diffuse + Cl*ndl;
+            if (mat->type == SURFACE_PLASTIC) {
+                float ndh = dot(N, normalize(L + V));
+                if (ndh > 0) {
+                    specular = specular + Cl*std::pow(ndh, 1.0f/mat->roughness);
+                }
+            }
+        }
+        V3 Ci = Cs*(ambient*mat->Ka + diffuse*mat->Kd);
+        if (mat->type == SURFACE_PLASTIC) {
+            Ci = Ci + mat->specularcolor*specular*mat->Ks;
+        }
+        return Ci;
+    }
+
+    void render_tile(int tx, int ty, size_t &nprimary, size_t &nshadow) {
+        int w = x1 - x0;
+        int xs = opts.xsamples, ys = opts.ysamples;
+        float weight = 1.0f/(xs*ys);
+        for (int y=ty; y<std::min(ty+TILE_SIZE, y1); ++y) {
+            for (int x=tx; x<std::min(tx+TILE_SIZE, x1); ++x) {
+                V3 color;
+                float alpha = 0;
+                /* Stratified, unjittered samples so frames are repeatable */
+                for (int j=0; j<ys; ++j) {
+                    for (int i=0; i<xs; ++i) {
+                        Ray ray = cam.ray(x + (i + 0.5f)/xs, y + (j + 0.5f)/ys);
+                        Hit hit;
+                        ++nprimary;
+                        if (bvh_intersect(scene, bvh, ray, 1.0e30f, hit)) {
+                            color = color + shade(ray, hit, nshadow);
+                            alpha += 1.0f;
+                        }
+                    }
+                }
+                color = color*weight;
+                alpha *= weight;
+                if (opts.have_background) {
+                    color = color + opts.background*(1.0f - alpha);
+                    alpha = 1.0f;
+                }
+                float *dst = &rgba[4*((size_t)(y - y0)*w + (x - x0))];
+                dst[0] = color.x;
+                dst[1] = color.y;
+                dst[2] = color.z;
+                dst[3] = alpha;
+            }
+        }
+    }
+
+    void worker() {
+        int tiles_x = (x1 - x0 + TILE_SIZE - 1)/TILE_SIZE;
+        int tiles_y = (y1 - y0 + TILE_SIZE - 1)/TILE_SIZE;
+        size_t nprimary = 0, nshadow = 0;
+        for (;;) {
+            int tile = next_tile++;
+            if (tile >= tiles_x*tiles_y) {
+                break;
+            }
+            render_tile(x0 + (tile % tiles_x)*TILE_SIZE, y0 + (tile / tiles_x)*TILE_SIZE,
+                        nprimary, nshadow);
+        }
+        primary_rays += nprimary;
+        shadow_rays += nshadow;
+    }
+};
+
+int num_threads() {
+    const char *env = getenv("RI_PREVIEW_THREADS");
+    int n = env ? atoi(env) : (int)std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+uint8_t quantize(float v) {
+    v = v*255.0f + 0.5f;
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+void write_display(const Display &disp, const Tracer &tr) {
+    const char *name = disp.name.c_str();
+    if (name[0] == '+') {
+        ++name;
+    }
+    if (disp.type == "framebuffer") {
+        printf("Preview renderer has no framebuffer, skipping display \"%s\"\n", name);
+        return;
+    }
+    size_t channels = disp.mode.find('a') != std::string::npos ? 4 : 3;
+    image_t img;
+    if (image_alloc(&img, tr.x1 - tr.x0, tr.y1 - tr.y0, channels)) {
+        printf("Could not allocate the image for display \"%s\"\n", name);
+        return;
+    }
+    for (size_t i=0; i<img.width*img.height; ++i) {
+        for (size_t c=0; c<channels; ++c) {
+            img.pixels[i*channels + c] = quantize(tr.rgba[4*i + c]);
+        }
+    }
+    if (disp.type == "jpeg") {
+        image_write_jpeg(name, &img, 95);
+    } else {
+        image_write_tiff(name, &img);
+    }
+    image_free(&img);
+}
+
+} // namespace
+
+void render_frame(const Options &opts, const Scene &scene, RenderStats &stats) {
+    auto start = sc::steady_clock::now();
+    Bvh bvh;
+    bvh_build(scene, bvh);
+    stats.build_ms = ms_since(start);
+
+    Tracer tr(opts, scene, bvh);
+    Camera &cam = tr.cam;
+    cam.perspective = opts.perspective;
+    cam.tan_half_fov = std::tan(opts.fov*0.5f*3.14159265f/180.0f);
+    cam.xres = opts.xres;
+    cam.yres = opts.yres;
+    if (opts.have_screen) {
+        std::copy(opts.screen, opts.screen+4, cam.screen);
+    } else {
+        float aspect = opts.frame_aspect > 0 ? opts.frame_aspect
+            : opts.xres*opts.pixel_aspect/opts.yres;
+        if (aspect >= 1) {
+            cam.screen[0] = -aspect; cam.screen[1] = aspect;
+            cam.screen[2] = -1; cam.screen[3] = 1;
+        } else {
+            cam.screen[0] = -1; cam.screen[1] = 1;
+            cam.screen[2] = -1/aspect; cam.screen[3] = 1/aspect;
+        }
+    }
+
+    /* Pixel rectangle covered by the crop window, as RenderMan rounds it */
+    tr.x0 = std::min(opts.xres-1, std::max(0, (int)std::ceil(opts.xres*opts.crop[0])));
+    tr.x1 = std::min(opts.xres, std::max(tr.x0+1, (int)std::ceil(opts.xres*opts.crop[1])));
+    tr.y0 = std::min(opts.yres-1, std::max(0, (int)std::ceil(opts.yres*opts.crop[2])));
+    tr.y1 = std::min(opts.yres, std::max(tr.y0+1, (int)std::ceil(opts.yres*opts.crop[3])));
+    tr.rgba.assign(4*(size_t)(tr.x1 - tr.x0)*(tr.y1 - tr.y0), 0.0f);
+
+    start = sc::steady_clock::now();
+    std::vector<std::thread> threads;
+    int nthreads = num_threads();
+    for (int i=1; i<nthreads; ++i) {
+        threads.push_back(std::thread(&Tracer::worker, &tr));
+    }
+    tr.worker();
+    for (std::thread &t : threads) {
+        t.join();
+    }
+    stats.render_ms = ms_since(start);
+    stats.primary_rays = tr.primary_rays;
+    stats.shadow_rays = tr.shadow_rays;
+
+    if (opts.displays.empty()) {
+        Display disp;
+        disp.name = "ri.tif";
+        disp.type = "file";
+        disp.mode = "rgba";
+        write_display(disp, tr);
+    }
+    for (const Display &disp : opts.displays) {
+        write_display(disp, tr);
+    }
+}
+
+} // namespace preview
@@ -0,0 +1,148 @@
+/*
+  ri.h
+
+  The subset of the RenderMan C API implemented by the preview ray caster
+  in this directory.  It is source compatible with the ri.h shipped with
+  3Delight for the calls the capi programs make, so a program builds
+  against either one unchanged (see config/cmake/RiBackend.cmake).
+*/
+
+#ifndef RI_H
+#define RI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef short RtBoolean;
+typedef int RtInt;
+typedef float RtFloat;
+typedef char *RtToken;
+typedef const char *RtConstToken;
+typedef char *RtString;
+typedef void *RtPointer;
+typedef void RtVoid;
+
+typedef RtFloat RtColor[3];
+typedef RtFloat RtPoint[3];
+typedef RtFloat RtVector[3];
+typedef RtFloat RtNormal[3];
+typedef RtFloat RtMatrix[4][4];
+typedef RtFloat RtBasis[4][4];
+typedef RtFloat RtBound[6];
+
+typedef RtPointer RtObjectHandle;
+typedef RtPointer RtLightHandle;
+typedef RtPointer RtContextHandle;
+
+typedef RtFloat (*RtFilterFunc)(RtFloat, RtFloat, RtFloat, RtFloat);
+typedef RtVoid (*RtProcSubdivFunc)(RtPointer, RtFloat);
+typedef RtVoid (*RtProcFreeFunc)(RtPointer);
+
+#define RI_FALSE 0
+#define RI_TRUE 1
+#define RI_INFINITY 1.0e38f
+#define RI_EPSILON 1.0e-10f
+#define RI_NULL ((RtToken)0)
+
+extern RtToken RI_P, RI_N, RI_CS, RI_OS, RI_WIDTH, RI_CONSTANTWIDTH;
+extern RtToken RI_FROM, RI_TO, RI_INTENSITY, RI_LIGHTCOLOR, RI_FOV;
+extern RtToken RI_PERSPECTIVE, RI_ORTHOGRAPHIC, RI_RGB, RI_RGBA;
+extern RtToken RI_KA, RI_KD, RI_KS, RI_ROUGHNESS, RI_SPECULARCOLOR;
+
+extern RtBasis RiBezierBasis, RiBSplineBasis, RiCatmullRomBasis, RiHermiteBasis, RiPowerBasis;
+
+/* Structure */
+RtVoid RiBegin(RtConstToken name);
+RtVoid RiEnd(void);
+RtVoid RiFrameBegin(RtInt frame);
+RtVoid RiFrameEnd(void);
+RtVoid RiWorldBegin(void);
+RtVoid RiWorldEnd(void);
+RtVoid RiSolidBegin(RtConstToken operation);
+RtVoid RiSolidEnd(void);
+RtObjectHandle RiObjectBegin(void);
+RtVoid RiObjectEnd(void);
+RtVoid RiObjectInstance(RtObjectHandle handle);
+
+/* Options */
+RtVoid RiFormat(RtInt xres, RtInt yres, RtFloat aspect);
+RtVoid RiFrameAspectRatio(RtFloat aspect);
+RtVoid RiScreenWindow(RtFloat left, RtFloat right, RtFloat bottom, RtFloat top);
+RtVoid RiCropWindow(RtFloat xmin, RtFloat xmax, RtFloat ymin, RtFloat ymax);
+RtVoid RiPixelSamples(RtFloat xsamples, RtFloat ysamples);
+RtVoid RiDisplay(RtConstToken name, RtConstToken type, RtConstToken mode, ...);
+RtVoid RiDisplayV(RtConstToken name, RtConstToken type, RtConstToken mode,
+                  RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiProjection(RtConstToken name, ...);
+RtVoid RiProjectionV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiOption(RtConstToken name, ...);
+RtVoid RiOptionV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiImager(RtConstToken name, ...);
+RtVoid RiImagerV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiClipping(RtFloat hither, RtFloat yon);
+RtVoid RiExposure(RtFloat gain, RtFloat gamma);
+RtVoid RiQuantize(RtConstToken type, RtInt one, RtInt min, RtInt max, RtFloat dither);
+RtVoid RiDeclare(RtConstToken name, RtConstToken declaration);
+
+/* Attributes */
+RtVoid RiAttributeBegin(void);
+RtVoid RiAttributeEnd(void);
+RtVoid RiAttribute(RtConstToken name, ...);
+RtVoid RiAttributeV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiColor(RtColor color);
+RtVoid RiOpacity(RtColor color);
+RtVoid RiSides(RtInt sides);
+RtVoid RiShadingRate(RtFloat size);
+RtVoid RiShadingInterpolation(RtConstToken type);
+RtVoid RiBasis(RtBasis ubasis, RtInt ustep, RtBasis vbasis, RtInt vstep);
+RtLightHandle RiLightSource(RtConstToken name, ...);
+RtLightHandle RiLightSourceV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiSurface(RtConstToken name, ...);
+RtVoid RiSurfaceV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiDisplacement(RtConstToken name, ...);
+RtVoid RiDisplacementV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]);
+
+/* Transformations */
+RtVoid RiTransformBegin(void);
+RtVoid RiTransformEnd(void);
+RtVoid RiIdentity(void);
+RtVoid RiTransform(RtMatrix transform);
+RtVoid RiConcatTransform(RtMatrix transform);
+RtVoid RiTranslate(RtFloat dx, RtFloat dy, RtFloat dz);
+RtVoid RiRotate(RtFloat angle, RtFloat dx, RtFloat dy, RtFloat dz);
+RtVoid RiScale(RtFloat sx, RtFloat sy, RtFloat sz);
+
+/* Geometry */
+RtVoid RiSphere(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...);
+RtVoid RiSphereV(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax,
+                 RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiCylinder(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...);
+RtVoid RiCone(RtFloat height, RtFloat radius, RtFloat thetamax, ...);
+RtVoid RiDisk(RtFloat height, RtFloat radius, RtFloat thetamax, ...);
+RtVoid RiParaboloid(RtFloat rmax, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...);
+RtVoid RiHyperboloid(RtPoint point1, RtPoint point2, RtFloat thetamax, ...);
+RtVoid RiTorus(RtFloat majorrad, RtFloat minorrad, RtFloat phimin, RtFloat phimax,
+               RtFloat thetamax, ...);
+RtVoid RiPolygon(RtInt nvertices, ...);
+RtVoid RiPolygonV(RtInt nvertices, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiPointsPolygons(RtInt npolys, RtInt nvertices[], RtInt vertices[], ...);
+RtVoid RiPointsPolygonsV(RtInt npolys, RtInt nvertices[], RtInt vertices[],
+                         RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiPoints(RtInt npoints, ...);
+RtVoid RiPointsV(RtInt npoints, RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiCurves(RtConstToken type, RtInt ncurves, RtInt nvertices[], RtConstToken wrap, ...);
+RtVoid RiBlobby(RtInt nleaf, RtInt ncode, RtInt code[], RtInt nflt, RtFloat flt[],
+                RtInt nstr, RtString str[], ...);
+RtVoid RiBlobbyV(RtInt nleaf, RtInt ncode, RtInt code[], RtInt nflt, RtFloat flt[],
+                 RtInt nstr, RtString str[], RtInt n, RtToken tokens[], RtPointer params[]);
+RtVoid RiReadArchive(RtConstToken name, RtVoid (*callback)(RtToken, char *, ...), ...);
+RtVoid RiProcedural(RtPointer data, RtBound bound, RtProcSubdivFunc subdivfunc, RtProcFreeFunc freefunc);
+RtVoid RiProcDelayedReadArchive(RtPointer data, RtFloat detail);
+RtVoid RiProcFree(RtPointer data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,875 @@
+/*
+  ri_api.cpp
+
+  The Ri entry points.  They track the graphics state (transform and
+  attribute stacks, frame options) and hand camera space geometry to the
+  scene, which is rendered at RiWorldEnd.
+*/
+
+#include "ri.h"
+#include "preview.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+using namespace preview;
+
+RtToken RI_P = (RtToken)"P";
+RtToken RI_N = (RtToken)"N";
+RtToken RI_CS = (RtToken)"Cs";
+RtToken RI_OS = (RtToken)"Os";
+RtToken RI_WIDTH = (RtToken)"width";
+RtToken RI_CONSTANTWIDTH = (RtToken)"constantwidth";
+RtToken RI_FROM = (RtToken)"from";
+RtToken RI_TO = (RtToken)"to";
+RtToken RI_INTENSITY = (RtToken)"intensity";
+RtToken RI_LIGHTCOLOR = (RtToken)"lightcolor";
+RtToken RI_FOV = (RtToken)"fov";
+RtToken RI_PERSPECTIVE = (RtToken)"perspective";
+RtToken RI_ORTHOGRAPHIC = (RtToken)"orthographic";
+RtToken RI_RGB = (RtToken)"rgb";
+RtToken RI_RGBA = (RtToken)"rgba";
+RtToken RI_KA = (RtToken)"Ka";
+RtToken RI_KD = (RtToken)"Kd";
+RtToken RI_KS = (RtToken)"Ks";
+RtToken RI_ROUGHNESS = (RtToken)"roughness";
+RtToken RI_SPECULARCOLOR = (RtToken)"specularcolor";
+
+RtBasis RiBezierBasis = {{-1, 3, -3, 1}, {3, -6, 3, 0}, {-3, 3, 0, 0}, {1, 0, 0, 0}};
+RtBasis RiBSplineBasis = {{-1.0f/6, 3.0f/6, -3.0f/6, 1.0f/6}, {3.0f/6, -6.0f/6, 3.0f/6, 0},
+                          {-3.0f/6, 0, 3.0f/6, 0}, {1.0f/6, 4.0f/6, 1.0f/6, 0}};
+RtBasis RiCatmullRomBasis = {{-0.5f, 1.5f, -1.5f, 0.5f}, {1, -2.5f, 2, -0.5f},
+                             {-0.5f, 0, 0.5f, 0}, {0, 1, 0, 0}};
+RtBasis RiHermiteBasis = {{2, 1, -2, 1}, {-3, -2, 3, -1}, {0, 1, 0, 0}, {1, 0, 0, 0}};
+RtBasis RiPowerBasis = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+
+namespace preview {
+
+Options::Options()
+    : xres(640), yres(480), pixel_aspect(1.0f), frame_aspect(0.0f), have_screen(false),
+      xsamples(2), ysamples(2), perspective(false), fov(90.0f), have_background(false) {
+    crop[0] = 0; crop[1] = 1; crop[2] = 0; crop[3] = 1;
+    screen[0] = -1; screen[1] = 1; screen[2] = -1; screen[3] = 1;
+}
+
+} // namespace preview
+
+namespace {
+
+struct Attributes {
+    Mat4 ctm;
+    Material material;
+    bool shadows;
+};
+
+/* A retained object: geometry in object space plus whether it set its own attributes */
+struct ObjectDef {
+    Scene geom;
+    bool own_attributes;
+};
+
+struct State {
+    Options opts;
+    std::vector<Options> saved_opts;
+    Attributes attr;
+    std::vector<Attributes> attr_stack;
+    std::vector<Mat4> xform_stack;
+    Mat4 world_to_camera;
+    bool in_world;
+    int frame;
+    size_t frame_lights, world_lights;
+
+    Scene scene;
+    std::vector<ObjectDef *> objects;
+    ObjectDef *recording;
+
+    /* Index of attr.material in target()'s materials, or -1 if it changed */
+    long material_index;
+    std::set<std::string> warned;
+
+    Scene &target() { return recording ? recording->geom : scene; }
+};
+
+State state;
+
+void reset_state() {
+    state.opts = Options();
+    state.saved_opts.clear();
+    state.attr.ctm = Mat4::identity();
+    state.attr.material.type = SURFACE_MATTE;
+    state.attr.material.color = V3(1, 1, 1);
+    state.attr.material.Ka = 1;
+    state.attr.material.Kd = 1;
+    state.attr.material.Ks = 0;
+    state.attr.material.roughness = 0.1f;
+    state.attr.material.specularcolor = V3(1, 1, 1);
+    state.attr.shadows = false;
+    state.attr_stack.clear();
+    state.xform_stack.clear();
+    state.world_to_camera = Mat4::identity();
+    state.in_world = false;
+    state.frame = 0;
+    state.frame_lights = 0;
+    state.world_lights = 0;
+    state.scene = Scene();
+    state.recording = NULL;
+    state.material_index = -1;
+}
+
+void warn_once(const std::string &what) {
+    if (state.warned.insert(what).second) {
+        printf("Preview renderer: %s\n", what.c_str());
+    }
+}
+
+/* The material current attributes map to, added to the target scene on first use */
+uint32_t current_material() {
+    if (state.material_index < 0) {
+        Scene &scene = state.target();
+        state.material_index = (long)scene.materials.size();
+        scene.materials.push_back(state.attr.material);
+    }
+    return (uint32_t)state.material_index;
+}
+
+void attributes_changed() {
+    state.material_index = -1;
+    if (state.recording) {
+        state.recording->own_attributes = true;
+    }
+}
+
+struct ParamList {
+    RtInt n;
+    RtToken *tokens;
+    RtPointer *values;
+
+    ParamList(RtInt count, RtToken t[], RtPointer v[]) : n(count), tokens(t), values(v) {}
+
+    /* Matches the last word so inline declarations like "point from" work */
+    RtPointer find(const char *name, const char **decl = NULL) const {
+        for (RtInt i=0; i<n; ++i) {
+            const char *tok = tokens[i];
+            const char *word = strrchr(tok, ' ');
+            word = word ? word+1 : tok;
+            if (strcmp(word, name) == 0) {
+                if (decl) *decl = tok;
+                return values[i];
+            }
+        }
+        return NULL;
+    }
+    float get_float(const char *name, float def) const {
+        RtFloat *v = (RtFloat *)find(name);
+        return v ? v[0] : def;
+    }
+    V3 get_v3(const char *name, V3 def) const {
+        RtFloat *v = (RtFloat *)find(name);
+        return v ? V3(v) : def;
+    }
+    const char *get_string(const char *name) const {
+        RtString *v = (RtString *)find(name);
+        return v ? v[0] : NULL;
+    }
+};
+
+/* Gathers the NULL terminated token/value pairs of a varargs Ri call */
+struct VarArgs {
+    std::vector<RtToken> tokens;
+    std::vector<RtPointer> values;
+
+    void collect(va_list ap) {
+        for (RtToken tok = va_arg(ap, RtToken); tok != RI_NULL; tok = va_arg(ap, RtToken)) {
+            tokens.push_back(tok);
+            values.push_back(va_arg(ap, RtPointer));
+        }
+    }
+    RtInt n() const { return (RtInt)tokens.size(); }
+    RtToken *t() { return tokens.empty() ? NULL : &tokens[0]; }
+    RtPointer *v() { return values.empty() ? NULL : &values[0]; }
+};
+
+#define COLLECT(args, last)                     \
+    VarArgs args;                               \
+    do {                                        \
+        va_list ap;                             \
+        va_start(ap, last);                     \
+        args.collect(ap);                       \
+        va_end(ap);                             \
+    } while (0)
+
+void concat(const Mat4 &m) {
+    state.attr.ctm = state.attr.ctm * m;
+}
+
+/* A quadric as a grid over (u, v) in [0,1]x[0,1] */
+template <typename F>
+void add_quadric(F surface) {
+    const int nu = 24, nv = 12;
+    std::vector<V3> grid;
+    grid.reserve((nu+1)*(nv+1));
+    for (int j=0; j<=nv; ++j) {
+        for (int i=0; i<=nu; ++i) {
+            grid.push_back(surface((float)i/nu, (float)j/nv));
+        }
+    }
+    add_grid(state.target(), state.attr.ctm, grid, nu, nv, current_material());
+}
+
+float radians(float degrees) {
+    return degrees*3.14159265f/180.0f;
+}
+
+/* Per vertex colors from a "Cs" parameter, or NULL */
+const RtFloat *vertex_colors(const ParamList &params, bool &uniform) {
+    const char *decl = NULL;
+    const RtFloat *cs = (const RtFloat *)params.find("Cs", &decl);
+    uniform = decl && (strstr(decl, "uniform") || strstr(decl, "constant"));
+    if (cs && state.recording) {
+        state.recording->own_attributes = true;
+    }
+    return cs;
+}
+
+void add_polygons(RtInt npolys, const RtInt nverts[], const RtInt verts[], const ParamList &params) {
+    const RtFloat *P = (const RtFloat *)params.find("P");
+    if (P == NULL) {
+        warn_once("polygons without \"P\" are ignored");
+        return;
+    }
+    bool uniform;
+    const RtFloat *cs = vertex_colors(params, uniform);
+
+    RtInt npoints = 0, total = 0;
+    for (RtInt i=0; i<npolys; ++i) {
+        total += nverts[i];
+    }
+    for (RtInt i=0; i<total; ++i) {
+        npoints = std::max(npoints, verts[i]+1);
+    }
+    std::vector<V3> pts(npoints);
+    for (RtInt i=0; i<npoints; ++i) {
+        pts[i] = state.attr.ctm.point(V3(P + 3*i));
+    }
+
+    Scene &scene = state.target();
+    uint32_t mat = current_material();
+    const RtInt *poly = verts;
+    for (RtInt i=0; i<npolys; ++i) {
+        /* Triangle fan around the first vertex */
+        for (RtInt k=1; k+1<nverts[i]; ++k) {
+            RtInt a = poly[0], b = poly[k], c = poly[k+1];
+            if (cs) {
+                V3 colors[3];
+                if (uniform) {
+                    colors[0] = colors[1] = colors[2] = V3(cs + 3*i);
+                } else {
+                    colors[0] = V3(cs + 3*a);
+                    colors[1] = V3(cs + 3*b);
+                    colors[2] = V3(cs + 3*c);
+                }
+                add_triangle(scene, pts[a], pts[b], pts[c], mat, colors);
+            } else {
+                add_triangle(scene, pts[a], pts[b], pts[c], mat, NULL);
+            }
+        }
+        poly += nverts[i];
+    }
+}
+
+/* Draws the geometry of a retained object with the current transform */
+void instance_object(const ObjectDef &obj) {
+    Scene &scene = state.target();
+    const Mat4 &ctm = state.attr.ctm;
+    uint32_t base = (uint32_t)scene.materials.size();
+    uint32_t mat = 0;
+    if (obj.own_attributes) {
+        scene.materials.insert(scene.materials.end(),
+                               obj.geom.materials.begin(), obj.geom.materials.end());
+    } else {
+        mat = current_material();
+    }
+    for (const Sphere &s : obj.geom.spheres) {
+        if (obj.own_attributes) {
+            add_sphere(scene, ctm*Mat4::translate(s.center.x, s.center.y, s.center.z),
+                       s.radius, base + s.material, s.color);
+        } else {
+            add_sphere(scene, ctm*Mat4::translate(s.center.x, s.center.y, s.center.z),
+                       s.radius, mat, state.attr.material.color);
+        }
+    }
+    for (const Triangle &t : obj.geom.triangles) {
+        const V3 *colors = t.colors >= 0 ? &obj.geom.vertex_colors[t.colors] : NULL;
+        add_triangle(scene, ctm.point(t.p0), ctm.point(t.p0 + t.e1), ctm.point(t.p0 + t.e2),
+                     obj.own_attributes ? base + t.material : mat, colors);
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+RtVoid RiBegin(RtConstToken name) {
+    reset_state();
+    if (name != NULL) {
+        printf("Preview renderer can't write RIB, rendering \"%s\" directly\n", name);
+    }
+}
+
+RtVoid RiEnd(void) {
+    for (ObjectDef *obj : state.objects) {
+        delete obj;
+    }
+    state.objects.clear();
+    state.scene = Scene();
+}
+
+RtVoid RiFrameBegin(RtInt frame) {
+    state.frame = frame;
+    state.saved_opts.push_back(state.opts);
+    state.attr_stack.push_back(state.attr);
+    state.frame_lights = state.scene.lights.size();
+}
+
+RtVoid RiFrameEnd(void) {
+    if (state.saved_opts.empty()) {
+        return;
+    }
+    state.opts = state.saved_opts.back();
+    state.saved_opts.pop_back();
+    state.attr = state.attr_stack.back();
+    state.attr_stack.pop_back();
+    state.scene.lights.resize(state.frame_lights);
+    state.material_index = -1;
+}
+
+RtVoid RiWorldBegin(void) {
+    state.world_to_camera = state.attr.ctm;
+    state.in_world = true;
+    state.attr_stack.push_back(state.attr);
+    state.world_lights = state.scene.lights.size();
+    state.scene.clear_geometry();
+    state.material_index = -1;
+}
+
+RtVoid RiWorldEnd(void) {
+    RenderStats stats;
+    render_frame(state.opts, state.scene, stats);
+    if (getenv("RI_PREVIEW_STATS")) {
+        double rays = (double)(stats.primary_rays + stats.shadow_rays);
+        printf("Frame %d: %zu spheres, %zu triangles, BVH %.1f ms, render %.1f ms, "
+               "%.2f Mrays/s\n", state.frame, state.scene.spheres.size(),
+               state.scene.triangles.size(), stats.build_ms, stats.render_ms,
+               rays/(stats.render_ms*1000.0));
+    }
+    state.scene.clear_geometry();
+    state.scene.lights.resize(state.world_lights);
+    state.attr = state.attr_stack.back();
+    state.attr_stack.pop_back();
+    state.in_world = false;
+    state.material_index = -1;
+}
+
+RtVoid RiSolidBegin(RtConstToken operation) {
+    if (strcmp(operation, "primitive") != 0) {
+        warn_once("CSG is drawn as the union of its parts");
+    }
+    RiAttributeBegin();
+}
+
+RtVoid RiSolidEnd(void) {
+    RiAttributeEnd();
+}
+
+RtObjectHandle RiObjectBegin(void) {
+    RiAttributeBegin();
+    state.attr.ctm = Mat4::identity();
+    state.recording = new ObjectDef();
+    state.recording->own_attributes = false;
+    state.objects.push_back(state.recording);
+    state.material_index = -1;
+    return (RtObjectHandle)state.objects.size();
+}
+
+RtVoid RiObjectEnd(void) {
+    state.recording = NULL;
+    RiAttributeEnd();
+}
+
+RtVoid RiObjectInstance(RtObjectHandle handle) {
+    size_t i = (size_t)handle;
+    if (i == 0 || i > state.objects.size()) {
+        printf("Preview renderer: bad object handle %p\n", handle);
+        return;
+    }
+    instance_object(*state.objects[i-1]);
+}
+
+RtVoid RiFormat(RtInt xres, RtInt yres, RtFloat aspect) {
+    state.opts.xres = xres;
+    state.opts.yres = yres;
+    state.opts.pixel_aspect = aspect > 0 ? aspect : 1.0f;
+}
+
+RtVoid RiFrameAspectRatio(RtFloat aspect) {
+    state.opts.frame_aspect = aspect;
+}
+
+RtVoid RiScreenWindow(RtFloat left, RtFloat right, RtFloat bottom, RtFloat top) {
+    state.opts.have_screen = true;
+    state.opts.screen[0] = left;
+    state.opts.screen[1] = right;
+    state.opts.screen[2] = bottom;
+    state.opts.screen[3] = top;
+}
+
+RtVoid RiCropWindow(RtFloat xmin, RtFloat xmax, RtFloat ymin, RtFloat ymax) {
+    state.opts.crop[0] = xmin;
+    state.opts.crop[1] = xmax;
+    state.opts.crop[2] = ymin;
+    state.opts.crop[3] = ymax;
+}
+
+RtVoid RiPixelSamples(RtFloat xsamples, RtFloat ysamples) {
+    state.opts.xsamples = std::max(1, (int)(xsamples + 0.5f));
+    state.opts.ysamples = std::max(1, (int)(ysamples + 0.5f));
+}
+
+RtVoid RiDisplayV(RtConstToken name, RtConstToken type, RtConstToken mode,
+                  RtInt n, RtToken tokens[], RtPointer params[]) {
+    Display disp;
+    disp.name = name;
+    disp.type = type;
+    disp.mode = mode;
+    if (name[0] != '+') {
+        state.opts.displays.clear();
+    }
+    state.opts.displays.push_back(disp);
+    (void)n; (void)tokens; (void)params;
+}
+
+RtVoid RiDisplay(RtConstToken name, RtConstToken type, RtConstToken mode, ...) {
+    COLLECT(args, mode);
+    RiDisplayV(name, type, mode, args.n(), args.t(), args.v());
+}
+
+RtVoid RiProjectionV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    if (strcmp(name, "perspective") == 0) {
+        state.opts.perspective = true;
+        state.opts.fov = p.get_float("fov", 90.0f);
+    } else {
+        if (strcmp(name, "orthographic") != 0) {
+            warn_once(std::string("unknown projection \"") + name + "\", using orthographic");
+        }
+        state.opts.perspective = false;
+    }
+    /* The projection ends the camera description; start from camera space */
+    state.attr.ctm = Mat4::identity();
+}
+
+RtVoid RiProjection(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiProjectionV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiOptionV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    /* Nothing we render (no reflections, no searchpaths) depends on options */
+    (void)name; (void)n; (void)tokens; (void)params;
+}
+
+RtVoid RiOption(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiOptionV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiImagerV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    if (strcmp(name, "background") != 0) {
+        warn_once(std::string("imager \"") + name + "\" is ignored");
+        return;
+    }
+    state.opts.have_background = true;
+    state.opts.background = p.get_v3("bgcolor", p.get_v3("background", V3(0, 0, 0)));
+}
+
+RtVoid RiImager(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiImagerV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiClipping(RtFloat hither, RtFloat yon) {
+    (void)hither; (void)yon;
+}
+
+RtVoid RiExposure(RtFloat gain, RtFloat gamma) {
+    (void)gain; (void)gamma;
+}
+
+RtVoid RiQuantize(RtConstToken type, RtInt one, RtInt min, RtInt max, RtFloat dither) {
+    (void)type; (void)one; (void)min; (void)max; (void)dither;
+}
+
+RtVoid RiDeclare(RtConstToken name, RtConstToken declaration) {
+    (void)name; (void)declaration;
+}
+
+RtVoid RiAttributeBegin(void) {
+    state.attr_stack.push_back(state.attr);
+}
+
+RtVoid RiAttributeEnd(void) {
+    if (state.attr_stack.empty()) {
+        return;
+    }
+    state.attr = state.attr_stack.back();
+    state.attr_stack.pop_back();
+    state.material_index = -1;
+}
+
+RtVoid RiAttributeV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    if (strcmp(name, "light") == 0) {
+        const char *shadows = p.get_string("shadows");
+        if (shadows) {
+            state.attr.shadows = strcmp(shadows, "on") == 0;
+        }
+    }
+}
+
+RtVoid RiAttribute(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiAttributeV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiColor(RtColor color) {
+    state.attr.material.color = V3(color);
+    attributes_changed();
+}
+
+RtVoid RiOpacity(RtColor color) {
+    if (color[0] < 1 || color[1] < 1 || color[2] < 1) {
+        warn_once("opacity is ignored, everything is opaque");
+    }
+}
+
+RtVoid RiSides(RtInt sides) {
+    /* Both sides are always shaded */
+    (void)sides;
+}
+
+RtVoid RiShadingRate(RtFloat size) {
+    (void)size;
+}
+
+RtVoid RiShadingInterpolation(RtConstToken type) {
+    (void)type;
+}
+
+RtVoid RiBasis(RtBasis ubasis, RtInt ustep, RtBasis vbasis, RtInt vstep) {
+    (void)ubasis; (void)ustep; (void)vbasis; (void)vstep;
+}
+
+RtLightHandle RiLightSourceV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    const Mat4 &ctm = state.attr.ctm;
+    Light light;
+    light.shadows = state.attr.shadows;
+    light.color = p.get_v3("lightcolor", V3(1, 1, 1))*p.get_float("intensity", 1.0f);
+    V3 from = ctm.point(p.get_v3("from", V3(0, 0, 0)));
+    if (strcmp(name, "ambientlight") == 0) {
+        light.type = LIGHT_AMBIENT;
+    } else if (strcmp(name, "distantlight") == 0) {
+        light.type = LIGHT_DISTANT;
+        light.from = normalize(from - ctm.point(p.get_v3("to", V3(0, 0, 1))));
+    } else {
+        if (strcmp(name, "pointlight") != 0) {
+            warn_once(std::string("light \"") + name + "\" is treated as a pointlight");
+        }
+        light.type = LIGHT_POINT;
+        light.from = from;
+    }
+    state.scene.lights.push_back(light);
+    return (RtLightHandle)state.scene.lights.size();
+}
+
+RtLightHandle RiLightSource(RtConstToken name, ...) {
+    COLLECT(args, name);
+    return RiLightSourceV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiSurfaceV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    Material &mat = state.attr.material;
+    if (strcmp(name, "constant") == 0) {
+        mat.type = SURFACE_CONSTANT;
+    } else if (strcmp(name, "plastic") == 0 || strcmp(name, "paintedplastic") == 0 ||
+               strcmp(name, "metal") == 0 || strcmp(name, "shinymetal") == 0) {
+        bool metal = strstr(name, "metal") != NULL;
+        mat.type = SURFACE_PLASTIC;
+        mat.Ka = p.get_float("Ka", 1.0f);
+        mat.Kd = p.get_float("Kd", metal ? 0.0f : 0.5f);
+        mat.Ks = p.get_float("Ks", metal ? 1.0f : 0.5f);
+        mat.roughness = p.get_float("roughness", 0.1f);
+        mat.specularcolor = p.get_v3("specularcolor", V3(1, 1, 1));
+    } else {
+        if (strcmp(name, "matte") != 0) {
+            warn_once(std::string("surface \"") + name + "\" is shaded as matte");
+        }
+        mat.type = SURFACE_MATTE;
+        mat.Ka = p.get_float("Ka", 1.0f);
+        mat.Kd = p.get_float("Kd", 1.0f);
+    }
+    attributes_changed();
+}
+
+RtVoid RiSurface(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiSurfaceV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiDisplacementV(RtConstToken name, RtInt n, RtToken tokens[], RtPointer params[]) {
+    warn_once(std::string("displacement \"") + name + "\" is ignored");
+    (void)n; (void)tokens; (void)params;
+}
+
+RtVoid RiDisplacement(RtConstToken name, ...) {
+    COLLECT(args, name);
+    RiDisplacementV(name, args.n(), args.t(), args.v());
+}
+
+RtVoid RiTransformBegin(void) {
+    state.xform_stack.push_back(state.attr.ctm);
+}
+
+RtVoid RiTransformEnd(void) {
+    if (state.xform_stack.empty()) {
+        return;
+    }
+    state.attr.ctm = state.xform_stack.back();
+    state.xform_stack.pop_back();
+}
+
+RtVoid RiIdentity(void) {
+    state.attr.ctm = state.in_world ? state.world_to_camera : Mat4::identity();
+}
+
+RtVoid RiTransform(RtMatrix transform) {
+    RiIdentity();
+    concat(Mat4::from_ri(transform));
+}
+
+RtVoid RiConcatTransform(RtMatrix transform) {
+    concat(Mat4::from_ri(transform));
+}
+
+RtVoid RiTranslate(RtFloat dx, RtFloat dy, RtFloat dz) {
+    concat(Mat4::translate(dx, dy, dz));
+}
+
+RtVoid RiRotate(RtFloat angle, RtFloat dx, RtFloat dy, RtFloat dz) {
+    concat(Mat4::rotate(angle, dx, dy, dz));
+}
+
+RtVoid RiScale(RtFloat sx, RtFloat sy, RtFloat sz) {
+    concat(Mat4::scale(sx, sy, sz));
+}
+
+RtVoid RiSphereV(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax,
+                 RtInt n, RtToken tokens[], RtPointer params[]) {
+    (void)n; (void)tokens; (void)params;
+    if (zmin <= -radius && zmax >= radius && thetamax >= 360.0f) {
+        add_sphere(state.target(), state.attr.ctm, radius, current_material(),
+                   state.attr.material.color);
+        return;
+    }
+    float phimin = std::asin(std::max(-1.0f, zmin/radius));
+    float phimax = std::asin(std::min(1.0f, zmax/radius));
+    float tmax = radians(thetamax);
+    add_quadric([=](float u, float v) {
+            float theta = u*tmax, phi = phimin + v*(phimax - phimin);
+            return V3(radius*std::cos(theta)*std::cos(phi), radius*std::sin(theta)*std::cos(phi),
+                      radius*std::sin(phi));
+        });
+}
+
+RtVoid RiSphere(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...) {
+    COLLECT(args, thetamax);
+    RiSphereV(radius, zmin, zmax, thetamax, args.n(), args.t(), args.v());
+}
+
+RtVoid RiCylinder(RtFloat radius, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...) {
+    float tmax = radians(thetamax);
+    add_quadric([=](float u, float v) {
+            return V3(radius*std::cos(u*tmax), radius*std::sin(u*tmax), zmin + v*(zmax - zmin));
+        });
+}
+
+RtVoid RiCone(RtFloat height, RtFloat radius, RtFloat thetamax, ...) {
+    float tmax = radians(thetamax);
+    add_quadric([=](float u, float v) {
+            float r = radius*(1.0f - v);
+            return V3(r*std::cos(u*tmax), r*std::sin(u*tmax), v*height);
+        });
+}
+
+RtVoid RiDisk(RtFloat height, RtFloat radius, RtFloat thetamax, ...) {
+    float tmax = radians(thetamax);
+    add_quadric([=](float u, float v) {
+            float r = radius*(1.0f - v);
+            return V3(r*std::cos(u*tmax), r*std::sin(u*tmax), height);
+        });
+}
+
+RtVoid RiParaboloid(RtFloat rmax, RtFloat zmin, RtFloat zmax, RtFloat thetamax, ...) {
+    float tmax = radians(thetamax);
+    add_quadric([=](float u, float v) {
+            float z = zmin + v*(zmax - zmin);
+            float r = zmax > 0 ? rmax*std::sqrt(std::max(0.0f, z/zmax)) : 0.0f;
+            return V3(r*std::cos(u*tmax), r*std::sin(u*tmax), z);
+        });
+}
+
+RtVoid RiHyperboloid(RtPoint point1, RtPoint point2, RtFloat thetamax, ...) {
+    float tmax = radians(thetamax);
+    V3 p1(point1), p2(point2);
+    add_quadric([=](float u, float v) {
+            V3 p = p1 + (p2 - p1)*v;
+            float c = std::cos(u*tmax), s = std::sin(u*tmax);
+            return V3(p.x*c - p.y*s, p.x*s + p.y*c, p.z);
+        });
+}
+
+RtVoid RiTorus(RtFloat majorrad, RtFloat minorrad, RtFloat phimin, RtFloat phimax,
+               RtFloat thetamax, ...) {
+    float tmax = radians(thetamax), pmin = radians(phimin), pmax = radians(phimax);
+    add_quadric([=](float u, float v) {
+            float phi = pmin + v*(pmax - pmin);
+            float r = majorrad + minorrad*std::cos(phi);
+            return V3(r*std::cos(u*tmax), r*std::sin(u*tmax), minorrad*std::sin(phi));
+        });
+}
+
+RtVoid RiPolygonV(RtInt nvertices, RtInt n, RtToken tokens[], RtPointer params[]) {
+    std::vector<RtInt> verts(nvertices);
+    for (RtInt i=0; i<nvertices; ++i) {
+        verts[i] = i;
+    }
+    add_polygons(1, &nvertices, &verts[0], ParamList(n, tokens, params));
+}
+
+RtVoid RiPolygon(RtInt nvertices, ...) {
+    COLLECT(args, nvertices);
+    RiPolygonV(nvertices, args.n(), args.t(), args.v());
+}
+
+RtVoid RiPointsPolygonsV(RtInt npolys, RtInt nvertices[], RtInt vertices[],
+                         RtInt n, RtToken tokens[], RtPointer params[]) {
+    add_polygons(npolys, nvertices, vertices, ParamList(n, tokens, params));
+}
+
+RtVoid RiPointsPolygons(RtInt npolys, RtInt nvertices[], RtInt vertices[], ...) {
+    COLLECT(args, vertices);
+    RiPointsPolygonsV(npolys, nvertices, vertices, args.n(), args.t(), args.v());
+}
+
+RtVoid RiPointsV(RtInt npoints, RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    const RtFloat *P = (const RtFloat *)p.find("P");
+    if (P == NULL) {
+        warn_once("points without \"P\" are ignored");
+        return;
+    }
+    const RtFloat *width = (const RtFloat *)p.find("width");
+    float constantwidth = p.get_float("constantwidth", 1.0f);
+    bool uniform;
+    const RtFloat *cs = vertex_colors(p, uniform);
+
+    Scene &scene = state.target();
+    uint32_t mat = current_material();
+    const Mat4 &ctm = state.attr.ctm;
+    for (RtInt i=0; i<npoints; ++i) {
+        float w = width ? width[i] : constantwidth;
+        V3 color = cs ? V3(cs + (uniform ? 0 : 3*i)) : state.attr.material.color;
+        add_sphere(scene, ctm*Mat4::translate(P[3*i], P[3*i+1], P[3*i+2]), 0.5f*w, mat, color);
+    }
+}
+
+RtVoid RiPoints(RtInt npoints, ...) {
+    COLLECT(args, npoints);
+    RiPointsV(npoints, args.n(), args.t(), args.v());
+}
+
+RtVoid RiCurves(RtConstToken type, RtInt ncurves, RtInt nvertices[], RtConstToken wrap, ...) {
+    warn_once("curves are not drawn");
+    (void)type; (void)ncurves; (void)nvertices; (void)wrap;
+}
+
+RtVoid RiBlobbyV(RtInt nleaf, RtInt ncode, RtInt code[], RtInt nflt, RtFloat flt[],
+                 RtInt nstr, RtString str[], RtInt n, RtToken tokens[], RtPointer params[]) {
+    ParamList p(n, tokens, params);
+    bool uniform;
+    const RtFloat *cs = vertex_colors(p, uniform);
+    Scene &scene = state.target();
+    uint32_t mat = current_material();
+
+    /*
+     * Each ellipsoid leaf is drawn on its own where its field, (1-r^2)^3,
+     * reaches the 0.5 threshold: a unit sphere scaled by 0.4545.  Blending
+     * between leaves is not attempted.
+     */
+    RtInt pc = 0;
+    for (RtInt leaf=0; leaf<nleaf && pc<ncode; ++leaf) {
+        RtInt op = code[pc];
+        if (op == 1001 && pc+1 < ncode && code[pc+1]+16 <= nflt) {
+            Mat4 m = Mat4::from_ri((const float (*)[4])(flt + code[pc+1]));
+            V3 color = cs ? V3(cs + (uniform ? 0 : 3*leaf)) : state.attr.material.color;
+            add_sphere(scene, state.attr.ctm*m, 0.4545f, mat, color);
+        } else if (op != 1000 && op != 1001) {
+            warn_once("only ellipsoid blobby leaves are drawn");
+        }
+        pc += (op == 1003) ? 3 : 2;
+    }
+    (void)nstr; (void)str;
+}
+
+RtVoid RiBlobby(RtInt nleaf, RtInt ncode, RtInt code[], RtInt nflt, RtFloat flt[],
+                RtInt nstr, RtString str[], ...) {
+    COLLECT(args, str);
+    RiBlobbyV(nleaf, ncode, code, nflt, flt, nstr, str, args.n(), args.t(), args.v());
+}
+
+RtVoid RiReadArchive(RtConstToken name, RtVoid (*callback)(RtToken, char *, ...), ...) {
+    warn_once(std::string("can't read RIB archive \"") + name + "\"");
+    (void)callback;
+}
+
+RtVoid RiProcedural(RtPointer data, RtBound bound, RtProcSubdivFunc subdivfunc,
+                    RtProcFreeFunc freefunc) {
+    /* Expanded right away; the only procedurals we can run are C callbacks */
+    if (subdivfunc == RiProcDelayedReadArchive) {
+        RiReadArchive(((RtString *)data)[0], NULL, RI_NULL);
+    } else {
+        subdivfunc(data, RI_INFINITY);
+    }
+    if (freefunc) {
+        freefunc(data);
+    }
+    (void)bound;
+}
+
+RtVoid RiProcDelayedReadArchive(RtPointer data, RtFloat detail) {
+    RiReadArchive(((RtString *)data)[0], NULL, RI_NULL);
+    (void)detail;
+}
+
+RtVoid RiProcFree(RtPointer data) {
+    free(data);
+}
+
+}
@@ -6,6 +6,9 @@
 
 #include "ri.h"
 
+#include "big_alloc.h"
+#include "scene_graph.h"
+
 enum obj_entry_type {vertex, normal, text_coord, face, object, comment, bad};
 
 typedef struct text_coord_s {
@@ -43,6 +46,7 @@ typedef struct camera_s {
 typedef struct scene_info_s {
     camera_t cam;
     char *fprefix;
+    sg_node_t *world;
 } scene_info_t;
 
 
@@ -103,7 +107,7 @@ void PlaceCamera(camera_t *cam)
     RiTranslate(-cam->location[0], -cam->location[1], -cam->location[2]);
 }
 
-void doFrame(size_t fNum, scene_info_t *scene, wave_object_t *obj);
+void doFrame(size_t fNum, scene_info_t *scene);
 
 void init_object(wave_object_t *obj) {
     obj->num_verts = 0;
@@ -121,17 +125,17 @@ void init_object(wave_object_t *obj) {
 
 void free_object(wave_object_t *obj) {
     if (obj->num_verts>0  &&  obj->verts!=NULL) {
-        free(obj->verts);
+        big_free(obj->verts);
         obj->verts = NULL;
         obj->num_verts = 0;
     }
     if (obj->num_norms>0  &&  obj->norms!=NULL) {
-        free(obj->norms);
+        big_free(obj->norms);
         obj->norms = NULL;
         obj->num_norms = 0;
     }
     if (obj->num_texts>0  &&  obj->text_coords!=NULL) {
-        free(obj->text_coords);
+        big_free(obj->text_coords);
         obj->text_coords = NULL;
         obj->num_texts = 0;
     }
@@ -153,7 +157,7 @@ void free_object(wave_object_t *obj) {
 
             }
         }
-        free(obj->faces);
+        big_free(obj->faces);
         obj->faces = NULL;
         obj->num_texts = 0;
     }
@@ -301,16 +305,16 @@ void preprocess(FILE* inf, wave_object_t *obj) {
         }
     }
     obj->num_verts = nv;
-    obj->verts = malloc(sizeof(RtPoint) * nv);
+    obj->verts = big_alloc(sizeof(RtPoint) * nv);
     
     obj->num_norms = nn;
-    obj->norms = malloc(sizeof(RtPoint) * nn);
+    obj->norms = big_alloc(sizeof(RtPoint) * nn);
     
     obj->num_texts = nt;
-    obj->text_coords = malloc(sizeof(text_coord_t) * nt);
+    obj->text_coords = big_alloc(sizeof(text_coord_t) * nt);
     
     obj->num_faces = nf;
-    obj->faces = malloc(sizeof(face_t) * nf);
+    obj->faces = big_alloc(sizeof(face_t) * nf);
 
     // Return to original position
     fsetpos(inf, &original_pos);
@@ -518,12 +522,16 @@ void show_object(wave_object_t *obj) {
     free(verts);
 }
 
+static void show_object_node(void *obj) {
+    show_object(obj);
+}
+
 void read_object(FILE *inf, wave_object_t *obj) {
     preprocess(inf, obj);
     read_data(inf, obj);
 }
 
-void doFrame(size_t fNum, scene_info_t *scene, wave_object_t *obj) {
+void doFrame(size_t fNum, scene_info_t *scene) {
     RtInt on = 1;
     char buffer[256];
     RtString on_string = "on";
@@ -558,7 +566,7 @@ void doFrame(size_t fNum, scene_info_t *scene, wave_object_t *obj) {
     RiWorldBegin();
   
     RiSurface((char*)"matte", RI_NULL);
-    show_object(obj);
+    sg_render(scene->world);
 
     RiWorldEnd();
     RiFrameEnd();
@@ -608,15 +616,18 @@ int main(int argc, char *argv[]) {
     scene.cam.roll = 0.0;
     
     scene.fprefix = argv[2];
+    scene.world = sg_geometry(show_object_node, &obj);
 
     for (fnum = 0; fnum < NUM_FRAMES; ++fnum) {
         scene.cam.location[0] = rad * sin(t);
         scene.cam.location[2] = rad * cos(t);
         t += dt;
         printf("Rendering frame %lu\n", fnum);
-        doFrame(fnum, &scene, &obj);
+        sg_prepare(scene.world);
+        doFrame(fnum, &scene);
     }
     RiEnd();
+    sg_free(scene.world);
 
     free_object(&obj);
 
@@ -23,6 +23,9 @@
 
 #include <ri.h>
 
+#include "render_opts.h"
+#include "scene_graph.h"
+
 typedef struct camera_s {
     RtPoint location;
     RtPoint look_at;
@@ -32,6 +35,8 @@ typedef struct camera_s {
 typedef struct scene_info_s {
     camera_t cam;
     char *fprefix;
+    render_opts_t *opts;
+    sg_node_t *world;
 } scene_info_t;
 
 const double PI = 3.141592654;
@@ -94,6 +99,41 @@ void PlaceCamera(camera_t *cam)
 
 void doFrame(int fNum, scene_info_t *scene);
 
+static void sphere(void *data) {
+    RiSphere(5, -5, 5, 360.0, RI_NULL);
+}
+
+static void ground(void *data) {
+    RtPoint pts[4] = {
+        {-40.0, 0.0, -40.0},
+        {-40.0, 0.0, 40.0},
+        {40.0, 0.0, 40.0},
+        {40.0, 0.0, -40.0},
+    };
+    RiPolygon(4, "P", pts, RI_NULL);
+}
+
+/* Four colored spheres over a matte ground; only the camera moves */
+sg_node_t *build_world(void) {
+    RtColor colors[] = {{1.0, 0.0, 0.0},
+                        {0.0, 1.0, 0.0},
+                        {0.0, 0.0, 1.0},
+                        {1.0, 0.0, 1.0},
+    };
+    RtFloat offsets[4][2] = {{-10, -10}, {10, -10}, {10, 10}, {-10, 10}};
+    sg_node_t *world = sg_attributes("plastic", NULL);
+    size_t i;
+
+    for (i=0; i<4; ++i) {
+        sg_node_t *xform = sg_add(sg_add(world, sg_attributes(NULL, colors[i])),
+                                  sg_transform());
+        sg_translate(xform, offsets[i][0], 10, offsets[i][1]);
+        sg_add(xform, sg_geometry(sphere, NULL));
+    }
+    sg_add(sg_add(world, sg_attributes("matte", NULL)), sg_geometry(ground, NULL));
+    return world;
+}
+
 double x(double u, double v) {
     return u;
 }
@@ -120,9 +160,9 @@ void doFrame(int fNum, scene_info_t *scene) {
 
     char buffer[256];
     sprintf(buffer, "images/%s%05d.tif", scene->fprefix, fNum);
-    RiDisplay(buffer,(char*)"file",(char*)"rgba",RI_NULL);
+    render_opts_display(scene->opts, buffer, "file", "rgba");
   
-    RiFormat(800, 600,  1.25);
+    render_opts_format(scene->opts, 800, 600, 1.25);
 
 
     RiProjection((char*)"perspective",RI_NULL);
@@ -137,73 +177,28 @@ void doFrame(int fNum, scene_info_t *scene) {
                  "int specular", (RtPointer)&on,
                  "int photon", (RtPointer)&on,
                  RI_NULL );
-    RtString on_string = "on";
-    RtInt samples = 2;
-    RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL );
+    render_opts_shadows(scene->opts, 2);
     RtPoint lightPos = {40,80,40};
-    RiAttribute((RtToken)"light", "string shadow", (RtPointer)"on", RI_NULL);
     RiLightSource("distantlight", (RtToken)"from", (RtPointer)lightPos, RI_NULL);
     
     RiWorldBegin();
   
-    RiSurface((char*)"plastic", RI_NULL);
-
-    RiAttributeBegin();
-
-    /* RiAttribute("shade", "string transmissionhitmode", "shader", RI_NULL); */
-
+    sg_render(scene->world);
 
-    RtColor colors[] = {{1.0, 0.0, 0.0},
-                        {0.0, 1.0, 0.0},
-                        {0.0, 0.0, 1.0},
-                        {1.0, 0.0, 1.0},
-    };
-    
-    RiTranslate(-10, 10, -10);                        
-    RiColor(colors[0]);
-    RiSphere(5, -5, 5, 360.0, RI_NULL);
-
-    RiTranslate(20, 0, 0);
-    RiColor(colors[1]);
-    RiSphere(5, -5, 5, 360.0, RI_NULL);
-
-    RiTranslate(0, 0, 20);
-    RiColor(colors[2]);
-    RiSphere(5, -5, 5, 360.0, RI_NULL);
-
-    RiTranslate(-20, 0, 0);
-    RiColor(colors[3]);
-    RiSphere(5, -5, 5, 360.0, RI_NULL);
-
-    RiAttributeEnd();
-    
-    RtPoint pts[4] = {
-        {-40.0, 0.0, -40.0},
-        {-40.0, 0.0, 40.0},
-        {40.0, 0.0, 40.0},
-        {40.0, 0.0, -40.0},
-    };
-
-    RiAttributeBegin();
-    /* RiAttribute("shade", "string transmissionhitmode", "shader", RI_NULL); */
-    RiSurface("matte", RI_NULL);
-    RiPolygon(4, "P", pts, RI_NULL);
-    RiAttributeEnd();
     RiWorldEnd();
     RiFrameEnd();
 }
 
 int main(int argc, char *argv[]) {
-    if (argc<2) {
-        printf("No output file name prefixgiven.\n");
-        printf("Use:\n\t%s output_prefix\n\n", argv[0]);
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         exit(1);
     }
 
     const size_t NUM_FRAMES = 360;
 
     RiBegin(RI_NULL);
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     RiOption("trace", "maxdepth", &md, RI_NULL);
     RiSides(2);
 
@@ -218,7 +213,9 @@ int main(int argc, char *argv[]) {
     scene.cam.look_at[2]= 0.0;
     scene.cam.roll = 0.0;
     
-    scene.fprefix = argv[1];
+    scene.fprefix = opts.fprefix;
+    scene.opts = &opts;
+    scene.world = build_world();
 
     /* size_t cur_frame = 0; */
 
@@ -230,11 +227,16 @@ int main(int argc, char *argv[]) {
         scene.cam.location[0] = rad * sin(t);
         scene.cam.location[2] = rad * cos(t);
         t += dt;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            continue;
+        }
         printf("Rendering frame %lu\n", fnum);
+        sg_prepare(scene.world);
         doFrame(fnum, &scene);
     }
 
     RiEnd();
+    sg_free(scene.world);
 
     return 0;
 }
@@ -0,0 +1,110 @@
+/*
+  gen_blobs.c
+
+  A blobby of ellipsoids drifting along Lissajous paths, merging and
+  splitting as they pass each other.
+
+  params: count (20) blobs, radius (1.5) of each, spread (6) of their
+          paths, speed (0.05) in radians per frame
+*/
+
+#include <ri.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "generator.h"
+#include "rng.h"
+
+typedef struct blobs_s {
+    RtInt count;
+    RtFloat radius;
+    RtFloat spread;
+    RtFloat speed;
+    RtFloat t;
+    /* Per blob frequencies and phases for x, y and z */
+    RtFloat (*freq)[3];
+    RtFloat (*phase)[3];
+    RtInt *code;
+    RtFloat *flt;
+} blobs_t;
+
+static void *blobs_create(const scene_desc_t *desc, unsigned long seed) {
+    blobs_t *blobs = malloc(sizeof(blobs_t));
+    RtInt i;
+    int k;
+
+    blobs->count = (RtInt)scene_param_long(desc, "count", 20);
+    blobs->radius = (RtFloat)scene_param_double(desc, "radius", 1.5);
+    blobs->spread = (RtFloat)scene_param_double(desc, "spread", 6.0);
+    blobs->speed = (RtFloat)scene_param_double(desc, "speed", 0.05);
+    blobs->t = 0.0f;
+    if (blobs->count < 1) {
+        printf("Need at least one blob\n");
+        free(blobs);
+        return NULL;
+    }
+    blobs->freq = malloc(sizeof(RtFloat)*3*blobs->count);
+    blobs->phase = malloc(sizeof(RtFloat)*3*blobs->count);
+    /* One ellipsoid op per blob, then an add of all of them */
+    blobs->code = malloc(sizeof(RtInt)*(2*blobs->count + 2 + blobs->count));
+    blobs->flt = malloc(sizeof(RtFloat)*16*blobs->count);
+
+    for (i=0; i<blobs->count; ++i) {
+        rng_t rng;
+        rng_init(&rng, seed, 0, i);
+        for (k=0; k<3; ++k) {
+            blobs->freq[i][k] = 0.5f + rng_float(&rng);
+            blobs->phase[i][k] = 6.2831853f*rng_float(&rng);
+        }
+        blobs->code[2*i] = 1001;
+        blobs->code[2*i+1] = 16*i;
+    }
+    blobs->code[2*blobs->count] = 0;
+    blobs->code[2*blobs->count+1] = blobs->count;
+    for (i=0; i<blobs->count; ++i) {
+        blobs->code[2*blobs->count+2+i] = i;
+    }
+    return blobs;
+}
+
+static int blobs_update(void *state, size_t fnum) {
+    blobs_t *blobs = state;
+    blobs->t = blobs->speed*fnum;
+    return blobs->speed != 0.0f;
+}
+
+static void blobs_render(void *state) {
+    blobs_t *blobs = state;
+    RtFloat t = blobs->t;
+    RtInt i;
+    int k;
+
+    for (i=0; i<blobs->count; ++i) {
+        RtFloat *m = blobs->flt + 16*i;
+        for (k=0; k<16; ++k) {
+            m[k] = 0.0f;
+        }
+        m[0] = m[5] = m[10] = blobs->radius;
+        m[15] = 1.0f;
+        for (k=0; k<3; ++k) {
+            m[12+k] = blobs->spread*sinf(blobs->freq[i][k]*t + blobs->phase[i][k]);
+        }
+    }
+    RiBlobby(blobs->count, 3*blobs->count + 2, blobs->code,
+             16*blobs->count, blobs->flt, 0, NULL, RI_NULL);
+}
+
+static void blobs_destroy(void *state) {
+    blobs_t *blobs = state;
+    free(blobs->freq);
+    free(blobs->phase);
+    free(blobs->code);
+    free(blobs->flt);
+    free(blobs);
+}
+
+const generator_t blobs_generator = {
+    "blobs", "blobby ellipsoids drifting along Lissajous curves",
+    blobs_create, blobs_update, blobs_render, blobs_destroy
+};
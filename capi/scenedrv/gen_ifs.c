@@ -0,0 +1,87 @@
+/*
+  gen_ifs.c
+
+  Points from the chaos game on an iterated function system.  The maps
+  are the seven scaled copies ifsfract uses, which fill out a fractal
+  cross.
+
+  params: points (1000000), scale (50) of the unit cube they fill,
+          width (0.0005) of each point before scaling
+*/
+
+#include <ri.h>
+
+#include <stdio.h>
+
+#include "generator.h"
+#include "rng.h"
+
+#define NUM_MAPS 7
+
+typedef struct ifs_s {
+    RtInt num_points;
+    RtFloat scale;
+    RtFloat width;
+    RtPoint *pts;
+} ifs_t;
+
+static const float map_scale = 0.34f;
+static const float map_offsets[NUM_MAPS][3] = {
+    {0.0f, 0.0f, 0.66f}, {0.0f, 0.0f, -0.66f}, {0.0f, 0.0f, 0.0f},
+    {0.66f, 0.0f, 0.0f}, {-0.66f, 0.0f, 0.0f},
+    {0.0f, 0.66f, 0.0f}, {0.0f, -0.66f, 0.0f}
+};
+
+static void *ifs_create(const scene_desc_t *desc, unsigned long seed) {
+    ifs_t *ifs = malloc(sizeof(ifs_t));
+    rng_t rng;
+    RtInt i;
+    int k;
+
+    ifs->num_points = (RtInt)scene_param_long(desc, "points", 1000000);
+    ifs->scale = (RtFloat)scene_param_double(desc, "scale", 50.0);
+    ifs->width = (RtFloat)scene_param_double(desc, "width", 0.0005);
+    ifs->pts = malloc(sizeof(RtPoint)*ifs->num_points);
+    if (ifs->pts == NULL || ifs->num_points < 1) {
+        printf("Could not allocate %d points\n", ifs->num_points);
+        free(ifs->pts);
+        free(ifs);
+        return NULL;
+    }
+
+    rng_init(&rng, seed, 0, 0);
+    for (k=0; k<3; ++k) {
+        ifs->pts[0][k] = rng_float(&rng);
+    }
+    /* Point i's map comes from element i's number, a batch at a time */
+    for (i=1; i<ifs->num_points; i+=256) {
+        uint32_t r[256];
+        RtInt j, count = ifs->num_points - i;
+        if (count > 256) count = 256;
+        rng_fill_u32(seed, 0, i, r, count);
+        for (j=0; j<count; ++j) {
+            int m = (int)(((uint64_t)r[j]*NUM_MAPS) >> 32);
+            for (k=0; k<3; ++k) {
+                ifs->pts[i+j][k] = map_scale*ifs->pts[i+j-1][k] + map_offsets[m][k];
+            }
+        }
+    }
+    return ifs;
+}
+
+static void ifs_render(void *state) {
+    ifs_t *ifs = state;
+    RiScale(ifs->scale, ifs->scale, ifs->scale);
+    RiPoints(ifs->num_points, "constantwidth", &ifs->width, RI_P, ifs->pts, RI_NULL);
+}
+
+static void ifs_destroy(void *state) {
+    ifs_t *ifs = state;
+    free(ifs->pts);
+    free(ifs);
+}
+
+const generator_t ifs_generator = {
+    "ifs", "iterated function system point cloud",
+    ifs_create, NULL, ifs_render, ifs_destroy
+};
@@ -0,0 +1,139 @@
+/*
+  gen_life.c
+
+  Life (Conway's unless the rule param says otherwise) on a torus, each
+  generation stacked on top of the last as a layer of spheres, like
+  growlife.  Cells are a byte each, holding their age, and are evolved
+  with the lookup table kernel in life_lut.h.
+
+  params: width (80), height (80), prob (0.25) of a cell starting alive,
+          radius (0.5) of the spheres, rule (B3/S23) as a rulestring,
+          age_colour (0): 1 shades new cells red through to green for
+          cells 32 or more generations old
+*/
+
+#include <ri.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "generator.h"
+#include "life_lut.h"
+#include "life_rule.h"
+#include "rng.h"
+
+typedef struct life_s {
+    size_t width;
+    size_t height;
+    size_t num_gens;
+    size_t max_gens;
+    /* Generations shown in the current frame */
+    size_t shown;
+    RtFloat radius;
+    int age_colour;
+    life_lut_t lut;
+    /* max_gens boards of width*height cells, each a byte holding its age */
+    uint8_t *boards;
+} life_t;
+
+static uint8_t *board(life_t *life, size_t gen) {
+    return life->boards + gen*life->width*life->height;
+}
+
+static void *life_create(const scene_desc_t *desc, unsigned long seed) {
+    life_t *life = malloc(sizeof(life_t));
+    double prob = scene_param_double(desc, "prob", 0.25);
+    life_rule_t rule;
+    size_t i;
+
+    if (life_rule_parse(&rule, scene_param(desc, "rule", "B3/S23"))) {
+        free(life);
+        return NULL;
+    }
+    life->width = (size_t)scene_param_long(desc, "width", 80);
+    life->height = (size_t)scene_param_long(desc, "height", 80);
+    life->radius = (RtFloat)scene_param_double(desc, "radius", 0.5);
+    life->age_colour = (int)scene_param_long(desc, "age_colour", 0);
+    life->max_gens = desc->num_frames;
+    life->num_gens = 0;
+    life->boards = malloc(life->max_gens*life->width*life->height);
+    if (life->boards == NULL || life_lut_init(&life->lut, &rule, life->width)) {
+        printf("Could not allocate %lu generations of %lux%lu\n",
+               (unsigned long)life->max_gens, (unsigned long)life->width,
+               (unsigned long)life->height);
+        free(life->boards);
+        free(life);
+        return NULL;
+    }
+
+    /* One number per cell, a batch at a time */
+    for (i=0; i<life->width*life->height; i+=256) {
+        float r[256];
+        size_t k, count = life->width*life->height - i;
+        if (count > 256) count = 256;
+        rng_fill_float(seed, 0, i, r, count);
+        for (k=0; k<count; ++k) {
+            life->boards[i+k] = r[k] < prob;
+        }
+    }
+    life->num_gens = 1;
+    life->shown = 0;
+    return life;
+}
+
+static int life_update(void *state, size_t fnum) {
+    life_t *life = state;
+
+    /* Frame n shows generations 0..n */
+    while (life->num_gens <= fnum && life->num_gens < life->max_gens) {
+        life_lut_evolve(&life->lut, board(life, life->num_gens-1), board(life, life->num_gens),
+                        life->height);
+        life->num_gens++;
+    }
+    if (life->shown == life->num_gens) {
+        return 0;
+    }
+    life->shown = life->num_gens;
+    return 1;
+}
+
+static void life_render(void *state) {
+    life_t *life = state;
+    size_t w = life->width, h = life->height;
+    size_t g, i, j;
+
+    RiTranslate(-(RtFloat)w/2, 0.0, -(RtFloat)h/2);
+    for (g=0; g<life->shown; ++g) {
+        const uint8_t *cells = board(life, g);
+        for (i=0; i<h; ++i) {
+            for (j=0; j<w; ++j) {
+                if (!cells[i*w+j]) continue;
+                if (life->age_colour) {
+                    RtFloat t = cells[i*w+j] >= 32 ? 1.0f : (cells[i*w+j] - 1)/31.0f;
+                    RtColor col;
+                    col[0] = 1.0f - t;
+                    col[1] = 0.2f + 0.6f*t;
+                    col[2] = 0.2f;
+                    RiColor(col);
+                }
+                RiTransformBegin();
+                RiTranslate(j, g, i);
+                RiSphere(life->radius, -life->radius, life->radius, 360.0, RI_NULL);
+                RiTransformEnd();
+            }
+        }
+    }
+}
+
+static void life_destroy(void *state) {
+    life_t *life = state;
+    life_lut_free(&life->lut);
+    free(life->boards);
+    free(life);
+}
+
+const generator_t life_generator = {
+    "life", "Game of Life generations stacked as layers of spheres",
+    life_create, life_update, life_render, life_destroy
+};
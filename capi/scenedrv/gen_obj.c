@@ -0,0 +1,132 @@
+/*
+  gen_obj.c
+
+  A Wavefront OBJ model as a single RiPointsPolygons.  Only vertices and
+  faces are read; texture coordinates and normals are skipped.
+
+  params: file (required), scale (1.0), spin (0) degrees per frame
+          about the y axis
+*/
+
+#include <ri.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "generator.h"
+
+typedef struct obj_s {
+    RtFloat scale;
+    RtFloat spin;
+    RtFloat angle;
+    RtInt num_pts;
+    RtInt npolys;
+    RtPoint *pts;
+    RtInt *nvertices;
+    RtInt *vertices;
+    size_t num_vertices;
+} obj_t;
+
+/* Appends v to a growable array of RtInt */
+static void push_int(RtInt **arr, size_t *len, size_t *cap, RtInt v) {
+    if (*len == *cap) {
+        *cap = *cap ? 2*(*cap) : 1024;
+        *arr = realloc(*arr, sizeof(RtInt)*(*cap));
+    }
+    (*arr)[(*len)++] = v;
+}
+
+static int read_obj(obj_t *obj, const char *fname) {
+    FILE *inf = fopen(fname, "r");
+    char line[1024];
+    size_t pts_cap = 0, nv_cap = 0, v_cap = 0, npolys = 0;
+
+    if (inf == NULL) {
+        printf("Could not open \"%s\"\n", fname);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), inf) != NULL) {
+        if (line[0] == 'v' && line[1] == ' ') {
+            if ((size_t)obj->num_pts == pts_cap) {
+                pts_cap = pts_cap ? 2*pts_cap : 1024;
+                obj->pts = realloc(obj->pts, sizeof(RtPoint)*pts_cap);
+            }
+            RtPoint *p = &obj->pts[obj->num_pts++];
+            if (sscanf(line+2, "%f %f %f", &(*p)[0], &(*p)[1], &(*p)[2]) != 3) {
+                printf("Bad vertex in \"%s\": %s", fname, line);
+                fclose(inf);
+                return 1;
+            }
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            char *tok = strtok(line+2, " \t\r\n");
+            RtInt count = 0;
+            while (tok != NULL) {
+                /* "v", "v/vt", "v//vn" or "v/vt/vn"; negative is relative */
+                long idx = strtol(tok, NULL, 10);
+                idx = (idx < 0) ? obj->num_pts + idx : idx - 1;
+                if (idx < 0 || idx >= obj->num_pts) {
+                    printf("Bad face index in \"%s\": %s\n", fname, tok);
+                    fclose(inf);
+                    return 1;
+                }
+                push_int(&obj->vertices, &obj->num_vertices, &v_cap, (RtInt)idx);
+                ++count;
+                tok = strtok(NULL, " \t\r\n");
+            }
+            push_int(&obj->nvertices, &npolys, &nv_cap, count);
+        }
+    }
+    fclose(inf);
+    obj->npolys = (RtInt)npolys;
+    if (npolys == 0) {
+        printf("No faces in \"%s\"\n", fname);
+        return 1;
+    }
+    return 0;
+}
+
+static void obj_destroy(void *state) {
+    obj_t *obj = state;
+    free(obj->pts);
+    free(obj->nvertices);
+    free(obj->vertices);
+    free(obj);
+}
+
+static void *obj_create(const scene_desc_t *desc, unsigned long seed) {
+    obj_t *obj = calloc(1, sizeof(obj_t));
+    const char *fname = scene_param(desc, "file", NULL);
+
+    obj->scale = (RtFloat)scene_param_double(desc, "scale", 1.0);
+    obj->spin = (RtFloat)scene_param_double(desc, "spin", 0.0);
+    obj->angle = 0.0f;
+    if (fname == NULL) {
+        printf("The obj generator needs a \"file\" param\n");
+        free(obj);
+        return NULL;
+    }
+    if (read_obj(obj, fname) != 0) {
+        obj_destroy(obj);
+        return NULL;
+    }
+    printf("Read %d points and %d faces from \"%s\"\n", obj->num_pts, obj->npolys, fname);
+    return obj;
+}
+
+static int obj_update(void *state, size_t fnum) {
+    obj_t *obj = state;
+    obj->angle = obj->spin*fnum;
+    return obj->spin != 0.0f;
+}
+
+static void obj_render(void *state) {
+    obj_t *obj = state;
+    RiRotate(obj->angle, 0.0, 1.0, 0.0);
+    RiScale(obj->scale, obj->scale, obj->scale);
+    RiPointsPolygons(obj->npolys, obj->nvertices, obj->vertices, "P", obj->pts, RI_NULL);
+}
+
+const generator_t obj_generator = {
+    "obj", "Wavefront OBJ model",
+    obj_create, obj_update, obj_render, obj_destroy
+};
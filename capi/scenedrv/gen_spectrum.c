@@ -0,0 +1,232 @@
+/*
+  gen_spectrum.c
+
+  A bar graph of an audio file's spectrum, one window of samples per
+  frame.  sound_anim does this with ffmpeg and FFTW; to keep the driver
+  free of both this reads 16 bit PCM WAV files only and uses a small
+  radix-2 FFT, which is plenty for one window a frame.
+
+  params: file (required, 16 bit PCM .wav), bars (32), fps (30),
+          window (2048, rounded up to a power of 2), height (10) of a full scale bar
+*/
+
+#include <ri.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "generator.h"
+
+typedef struct spectrum_s {
+    float *samples;
+    size_t num_samples;
+    unsigned sample_rate;
+    int bars;
+    double fps;
+    size_t window;
+    RtFloat height;
+    size_t start;
+    double *re;
+    double *im;
+} spectrum_t;
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24;
+}
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1]<<8);
+}
+
+/* Reads a 16 bit PCM WAV, mixed down to mono floats in [-1,1] */
+static int read_wav(spectrum_t *sp, const char *fname) {
+    FILE *inf = fopen(fname, "rb");
+    uint8_t hdr[12], chunk[8];
+    unsigned channels = 0, bits = 0, format = 0;
+
+    if (inf == NULL) {
+        printf("Could not open \"%s\"\n", fname);
+        return 1;
+    }
+    if (fread(hdr, 1, 12, inf) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr+8, "WAVE", 4) != 0) {
+        printf("\"%s\" is not a WAV file\n", fname);
+        fclose(inf);
+        return 1;
+    }
+    while (fread(chunk, 1, 8, inf) == 8) {
+        uint32_t size = le32(chunk+4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, 16, inf) != 16) break;
+            format = le16(fmt);
+            channels = le16(fmt+2);
+            sp->sample_rate = le32(fmt+4);
+            bits = le16(fmt+14);
+            fseek(inf, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0 && channels > 0) {
+            size_t frames, i;
+            unsigned c;
+            int16_t *pcm;
+            if (format != 1 || bits != 16) {
+                printf("\"%s\" must be 16 bit PCM (format %u, %u bits)\n", fname, format, bits);
+                fclose(inf);
+                return 1;
+            }
+            frames = size / (2*channels);
+            pcm = malloc(size);
+            frames = fread(pcm, 2*channels, frames, inf);
+            sp->samples = malloc(sizeof(float)*frames);
+            for (i=0; i<frames; ++i) {
+                float sum = 0.0f;
+                for (c=0; c<channels; ++c) {
+                    sum += (int16_t)le16((const uint8_t *)&pcm[i*channels + c]);
+                }
+                sp->samples[i] = sum/(32768.0f*channels);
+            }
+            sp->num_samples = frames;
+            free(pcm);
+            fclose(inf);
+            return 0;
+        } else {
+            fseek(inf, size + (size & 1), SEEK_CUR);
+        }
+    }
+    printf("No audio data in \"%s\"\n", fname);
+    fclose(inf);
+    return 1;
+}
+
+static void *spectrum_create(const scene_desc_t *desc, unsigned long seed) {
+    spectrum_t *sp = calloc(1, sizeof(spectrum_t));
+    const char *fname = scene_param(desc, "file", NULL);
+
+    sp->bars = (int)scene_param_long(desc, "bars", 32);
+    sp->fps = scene_param_double(desc, "fps", 30.0);
+    sp->window = 2;
+    while (sp->window < (size_t)scene_param_long(desc, "window", 2048)) {
+        sp->window *= 2;
+    }
+    sp->height = (RtFloat)scene_param_double(desc, "height", 10.0);
+    if (fname == NULL) {
+        printf("The spectrum generator needs a \"file\" param\n");
+        free(sp);
+        return NULL;
+    }
+    if (read_wav(sp, fname) != 0) {
+        free(sp);
+        return NULL;
+    }
+    sp->re = malloc(sizeof(double)*sp->window);
+    sp->im = malloc(sizeof(double)*sp->window);
+    printf("Read %.1f seconds of audio from \"%s\"\n",
+           (double)sp->num_samples/sp->sample_rate, fname);
+    return sp;
+}
+
+/* In place iterative radix-2 FFT; n must be a power of 2 */
+static void fft(double *re, double *im, size_t n) {
+    const double PI = 3.141592654;
+    size_t i, j, len;
+
+    for (i=1, j=0; i<n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (len=2; len<=n; len <<= 1) {
+        double ang = -2.0*PI/len;
+        double wr = cos(ang), wi = sin(ang);
+        for (i=0; i<n; i+=len) {
+            double cr = 1.0, ci = 0.0;
+            for (j=0; j<len/2; ++j) {
+                size_t a = i+j, b = i+j+len/2;
+                double tr = re[b]*cr - im[b]*ci;
+                double ti = re[b]*ci + im[b]*cr;
+                double t;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+                t = cr*wr - ci*wi;
+                ci = cr*wi + ci*wr;
+                cr = t;
+            }
+        }
+    }
+}
+
+/* A unit cube from (0,0,0) to (1,1,1) */
+static void unit_cube(void) {
+    static RtPoint pts[8] = {
+        {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}
+    };
+    static RtInt nverts[6] = {4, 4, 4, 4, 4, 4};
+    static RtInt verts[24] = {
+        0,3,2,1, 4,5,6,7, 0,1,5,4, 2,3,7,6, 1,2,6,5, 0,4,7,3
+    };
+    RiPointsPolygons(6, nverts, verts, "P", pts, RI_NULL);
+}
+
+static int spectrum_update(void *state, size_t fnum) {
+    spectrum_t *sp = state;
+    sp->start = (size_t)(fnum/sp->fps*sp->sample_rate);
+    return 1;
+}
+
+static void spectrum_render(void *state) {
+    const double PI = 3.141592654;
+    spectrum_t *sp = state;
+    size_t start = sp->start;
+    size_t n = sp->window, i;
+    double top = sp->sample_rate/2.0 < 16000.0 ? sp->sample_rate/2.0 : 16000.0;
+    int b;
+
+    /* Hann windowed, zero padded past the end of the track */
+    for (i=0; i<n; ++i) {
+        double w = 0.5 - 0.5*cos(2.0*PI*i/(n-1));
+        sp->re[i] = (start+i < sp->num_samples) ? w*sp->samples[start+i] : 0.0;
+        sp->im[i] = 0.0;
+    }
+    fft(sp->re, sp->im, n);
+
+    RiTranslate(-sp->bars/2.0f, 0.0, 0.0);
+    for (b=0; b<sp->bars; ++b) {
+        /* Log spaced bands from 40Hz up to 16kHz (or Nyquist), each bar
+           the loudest bin in its band, about 1 for a full scale sine */
+        size_t lo = (size_t)(40.0*pow(top/40.0, (double)b/sp->bars)*n/sp->sample_rate);
+        size_t hi = (size_t)(40.0*pow(top/40.0, (b + 1.0)/sp->bars)*n/sp->sample_rate);
+        double mag = 0.0;
+        RtFloat h;
+        for (i=lo; i<=hi && i<n/2; ++i) {
+            double m = sqrt(sp->re[i]*sp->re[i] + sp->im[i]*sp->im[i])/(0.25*n);
+            if (m > mag) mag = m;
+        }
+        h = sp->height*(RtFloat)(mag > 1.0 ? 1.0 : mag) + 0.05f;
+        RiTransformBegin();
+        RiTranslate(b, 0.0, 0.0);
+        RiScale(0.8f, h, 0.8f);
+        unit_cube();
+        RiTransformEnd();
+    }
+}
+
+static void spectrum_destroy(void *state) {
+    spectrum_t *sp = state;
+    free(sp->samples);
+    free(sp->re);
+    free(sp->im);
+    free(sp);
+}
+
+const generator_t spectrum_generator = {
+    "spectrum", "audio spectrum bars from a 16 bit PCM WAV file",
+    spectrum_create, spectrum_update, spectrum_render, spectrum_destroy
+};
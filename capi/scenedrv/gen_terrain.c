@@ -0,0 +1,141 @@
+/*
+  gen_terrain.c
+
+  Diamond-square fractal terrain as a colored triangle mesh.
+
+  params: size (129, rounded up to 2^n+1 points a side), roughness (2.0)
+          of the initial displacement, spacing (0.5) between points
+*/
+
+#include <ri.h>
+
+#include <stdio.h>
+
+#include "generator.h"
+#include "rng.h"
+
+typedef struct terrain_s {
+    unsigned long seed;
+    size_t n;
+    RtInt npolys;
+    RtInt *nvertices;
+    RtInt *vertices;
+    RtPoint *pts;
+    RtColor *colors;
+} terrain_t;
+
+/* Each grid point is set once, so its index picks its random number */
+static double rand_range(terrain_t *t, size_t point, double min, double max) {
+    rng_t rng;
+    rng_init(&rng, t->seed, 0, point);
+    return rng_range(&rng, min, max);
+}
+
+/* Height of grid point (i,j); points outside the grid are skipped */
+static void average(terrain_t *t, long i, long j, long step, double disp, int diamond) {
+    static const long square[4][2] = {{-1,-1}, {1,-1}, {1,1}, {-1,1}};
+    static const long diamond_offs[4][2] = {{0,-1}, {1,0}, {0,1}, {-1,0}};
+    const long (*offs)[2] = diamond ? diamond_offs : square;
+    long n = (long)t->n;
+    double sum = 0.0;
+    int k, count = 0;
+
+    for (k=0; k<4; ++k) {
+        long ii = i + offs[k][0]*step, jj = j + offs[k][1]*step;
+        if (ii < 0 || jj < 0 || ii >= n || jj >= n) continue;
+        sum += t->pts[ii*n+jj][1];
+        ++count;
+    }
+    t->pts[i*n+j][1] = (RtFloat)(sum/count + rand_range(t, i*n+j, -disp, disp));
+}
+
+static void *terrain_create(const scene_desc_t *desc, unsigned long seed) {
+    terrain_t *t = malloc(sizeof(terrain_t));
+    size_t size = (size_t)scene_param_long(desc, "size", 129);
+    double disp = scene_param_double(desc, "roughness", 2.0);
+    double spacing = scene_param_double(desc, "spacing", 0.5);
+    double lo = 0.0, hi = 0.0;
+    size_t i, j, n, step;
+    RtInt *v;
+
+    n = 2;
+    while (n+1 < size) {
+        n *= 2;
+    }
+    t->n = n = n+1;
+    t->pts = malloc(sizeof(RtPoint)*n*n);
+    t->colors = malloc(sizeof(RtColor)*n*n);
+    t->npolys = (RtInt)(2*(n-1)*(n-1));
+    t->nvertices = malloc(sizeof(RtInt)*t->npolys);
+    t->vertices = malloc(sizeof(RtInt)*3*t->npolys);
+
+    t->seed = seed;
+    for (i=0; i<n; ++i) {
+        for (j=0; j<n; ++j) {
+            t->pts[i*n+j][0] = (RtFloat)((i - (double)n/2)*spacing);
+            t->pts[i*n+j][1] = 0.0f;
+            t->pts[i*n+j][2] = (RtFloat)((j - (double)n/2)*spacing);
+        }
+    }
+    for (step=(n-1)/2; step>0; step/=2) {
+        for (i=step; i<n; i+=2*step) {
+            for (j=step; j<n; j+=2*step) {
+                average(t, i, j, step, disp, 0);
+            }
+        }
+        for (i=0; i<n; i+=step) {
+            for (j=((i/step)%2 == 0) ? step : 0; j<n; j+=2*step) {
+                average(t, i, j, step, disp, 1);
+            }
+        }
+        disp /= 2.0;
+    }
+
+    for (i=0; i<n*n; ++i) {
+        lo = (t->pts[i][1] < lo) ? t->pts[i][1] : lo;
+        hi = (t->pts[i][1] > hi) ? t->pts[i][1] : hi;
+    }
+    for (i=0; i<n*n; ++i) {
+        /* Green valleys to white peaks */
+        double f = (hi > lo) ? (t->pts[i][1] - lo)/(hi - lo) : 0.0;
+        t->colors[i][0] = (RtFloat)(f*f);
+        t->colors[i][1] = (RtFloat)(0.6 + 0.4*f);
+        t->colors[i][2] = (RtFloat)(f*f);
+    }
+
+    v = t->vertices;
+    for (i=0; i<n-1; ++i) {
+        for (j=0; j<n-1; ++j) {
+            *v++ = (RtInt)(i*n+j);
+            *v++ = (RtInt)(i*n+j+1);
+            *v++ = (RtInt)((i+1)*n+j);
+            *v++ = (RtInt)(i*n+j+1);
+            *v++ = (RtInt)((i+1)*n+j+1);
+            *v++ = (RtInt)((i+1)*n+j);
+        }
+    }
+    for (i=0; i<(size_t)t->npolys; ++i) {
+        t->nvertices[i] = 3;
+    }
+    return t;
+}
+
+static void terrain_render(void *state) {
+    terrain_t *t = state;
+    RiPointsPolygons(t->npolys, t->nvertices, t->vertices,
+                     "P", t->pts, "Cs", t->colors, RI_NULL);
+}
+
+static void terrain_destroy(void *state) {
+    terrain_t *t = state;
+    free(t->pts);
+    free(t->colors);
+    free(t->nvertices);
+    free(t->vertices);
+    free(t);
+}
+
+const generator_t terrain_generator = {
+    "terrain", "diamond-square terrain mesh",
+    terrain_create, NULL, terrain_render, terrain_destroy
+};
@@ -0,0 +1,47 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdlib.h>
+
+#include "scene_desc.h"
+
+/*
+ * A generator makes the geometry for a scene.  The driver handles the
+ * camera, lights, displays and frame loop from the scene description and
+ * only calls the generator for what goes between RiWorldBegin() and
+ * RiWorldEnd().
+ */
+typedef struct generator_s {
+    const char *name;
+    const char *description;
+
+    /* Builds the generator's state from the scene's params; NULL on error */
+    void *(*create)(const scene_desc_t *desc, unsigned long seed);
+
+    /*
+     * Advances to frame fnum.  Called for every frame in order, rendered
+     * or not, so simulations stay deterministic under -f.  Returns nonzero
+     * if render() would now emit something different; the driver replays
+     * the previous frame's geometry otherwise.  NULL for static geometry.
+     */
+    int (*update)(void *state, size_t fnum);
+
+    /* Emits the current frame's geometry, inside the world block */
+    void (*render)(void *state);
+
+    void (*destroy)(void *state);
+} generator_t;
+
+extern const generator_t life_generator;
+extern const generator_t terrain_generator;
+extern const generator_t ifs_generator;
+extern const generator_t blobs_generator;
+extern const generator_t obj_generator;
+extern const generator_t spectrum_generator;
+
+/* NULL if there's no generator called name */
+const generator_t *find_generator(const char *name);
+
+void list_generators(void);
+
+#endif
@@ -0,0 +1,208 @@
+/*
+  main.c
+
+  A generic frame driver: the camera, lights, displays and frame count
+  come from a scene description (see capi/common/scene_desc.h) and the
+  geometry from one of the generators in this directory, so changing a
+  scene doesn't need a recompile.  The geometry sits in a scene graph
+  node, so frames where the generator reports no change just replay it.
+*/
+
+#include <ri.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "camera.h"
+#include "generator.h"
+#include "render_opts.h"
+#include "scene_desc.h"
+#include "scene_graph.h"
+
+static const generator_t *generators[] = {
+    &life_generator,
+    &terrain_generator,
+    &ifs_generator,
+    &blobs_generator,
+    &obj_generator,
+    &spectrum_generator,
+    NULL
+};
+
+const generator_t *find_generator(const char *name) {
+    size_t i;
+    for (i=0; generators[i] != NULL; ++i) {
+        if (strcmp(generators[i]->name, name) == 0) {
+            return generators[i];
+        }
+    }
+    return NULL;
+}
+
+void list_generators(void) {
+    size_t i;
+    printf("Generators:\n");
+    for (i=0; generators[i] != NULL; ++i) {
+        printf("\t%-10s %s\n", generators[i]->name, generators[i]->description);
+    }
+}
+
+static void usage(const char *prog) {
+    printf("Use:\n\t%s scene_file [-f first:last] [-s seed] [-p fraction] "
+           "[-c xmin,xmax,ymin,ymax [-t tag]] output_prefix\n"
+           "\t%s -l\n\n", prog, prog);
+}
+
+/* The camera for a frame, orbiting the look at point if the scene asks */
+static void frame_camera(const scene_desc_t *desc, size_t fnum, camera_t *cam) {
+    const double PI = 3.141592654;
+    double angle = 2.0*PI*desc->orbit_turns*fnum/desc->num_frames;
+    double dx = desc->cam_location[0] - desc->cam_look_at[0];
+    double dz = desc->cam_location[2] - desc->cam_look_at[2];
+    int i;
+
+    for (i=0; i<3; ++i) {
+        cam->location[i] = desc->cam_location[i];
+        cam->look_at[i] = desc->cam_look_at[i];
+    }
+    cam->location[0] = desc->cam_look_at[0] + dx*cos(angle) + dz*sin(angle);
+    cam->location[2] = desc->cam_look_at[2] - dx*sin(angle) + dz*cos(angle);
+    cam->roll = desc->cam_roll;
+}
+
+static void do_frame(const scene_desc_t *desc, const render_opts_t *opts,
+                     sg_node_t *geometry, size_t fnum) {
+    char buffer[256];
+    camera_t cam;
+    RtInt md = render_opts_maxdepth(opts, desc->maxdepth);
+    RtFloat fov = desc->fov;
+    RtColor color;
+    uint32_t i;
+
+    RiFrameBegin(fnum);
+
+    scene_display_name(desc, opts->fprefix, fnum, buffer, sizeof(buffer));
+    render_opts_display(opts, buffer, desc->display_type, desc->display_mode);
+    RiPixelSamples(desc->xsamples, desc->ysamples);
+    render_opts_format(opts, desc->xres, desc->yres, desc->pixel_aspect);
+    RiOption("trace", "maxdepth", &md, RI_NULL);
+    if (desc->have_background) {
+        RtColor bg;
+        bg[0] = desc->background[0];
+        bg[1] = desc->background[1];
+        bg[2] = desc->background[2];
+        RiImager("background", "color background", (RtPointer)bg, RI_NULL);
+    }
+
+    RiProjection((char*)"perspective", "fov", &fov, RI_NULL);
+    frame_camera(desc, fnum, &cam);
+    PlaceCamera(&cam);
+
+    if (desc->shadows) {
+        render_opts_shadows(opts, desc->shadow_samples);
+    }
+    for (i=0; i<desc->num_lights; ++i) {
+        const scene_light_t *light = &desc->lights[i];
+        RtPoint from;
+        RtFloat intensity = light->intensity;
+        from[0] = light->from[0];
+        from[1] = light->from[1];
+        from[2] = light->from[2];
+        switch (light->type) {
+        case SCENE_LIGHT_AMBIENT:
+            RiLightSource("ambientlight", "intensity", &intensity, RI_NULL);
+            break;
+        case SCENE_LIGHT_DISTANT:
+            RiLightSource("distantlight", "point from", (RtPointer)from,
+                          "intensity", &intensity, RI_NULL);
+            break;
+        default:
+            RiLightSource("pointlight", "point from", (RtPointer)from,
+                          "intensity", &intensity, RI_NULL);
+            break;
+        }
+    }
+
+    RiWorldBegin();
+    RiSides(desc->sides);
+    RiSurface((char*)desc->surface, RI_NULL);
+    color[0] = desc->color[0];
+    color[1] = desc->color[1];
+    color[2] = desc->color[2];
+    RiColor(color);
+
+    sg_render(geometry);
+
+    RiWorldEnd();
+    RiFrameEnd();
+}
+
+int main(int argc, char *argv[]) {
+    scene_file_t file;
+    const scene_desc_t *desc;
+    const generator_t *gen;
+    sg_node_t *geometry;
+    render_opts_t opts;
+    unsigned long seed;
+    void *state;
+    size_t fnum;
+    char *prog = argv[0];
+
+    if (argc == 2 && strcmp(argv[1], "-l") == 0) {
+        list_generators();
+        return 0;
+    }
+    if (argc < 2 || argv[1][0] == '-') {
+        usage(prog);
+        return 1;
+    }
+    if (scene_file_open(argv[1], &file) != 0) {
+        return 1;
+    }
+    desc = file.desc;
+
+    /* The rest of the command line is the usual options and prefix */
+    argv[1] = prog;
+    if (render_opts_parse(&opts, argc-1, argv+1) != 0) {
+        scene_file_close(&file);
+        return 1;
+    }
+
+    gen = find_generator(desc->generator);
+    if (gen == NULL) {
+        printf("Unknown generator \"%s\"\n", desc->generator);
+        list_generators();
+        scene_file_close(&file);
+        return 1;
+    }
+
+    seed = render_opts_seed(&opts);
+    printf("Using seed %lu\n", seed);
+    state = gen->create(desc, seed);
+    if (state == NULL) {
+        scene_file_close(&file);
+        return 1;
+    }
+
+    geometry = sg_geometry(gen->render, state);
+
+    RiBegin(RI_NULL);
+    for (fnum = 0; fnum < desc->num_frames && fnum <= opts.last_frame; ++fnum) {
+        if (gen->update != NULL && gen->update(state, fnum)) {
+            sg_touch(geometry);
+        }
+        if (!render_opts_want_frame(&opts, fnum)) {
+            continue;
+        }
+        printf("Rendering frame %lu\n", (unsigned long)fnum);
+        sg_prepare(geometry);
+        do_frame(desc, &opts, geometry, fnum);
+    }
+    RiEnd();
+
+    sg_free(geometry);
+    gen->destroy(state);
+    scene_file_close(&file);
+    return 0;
+}
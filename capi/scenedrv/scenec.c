@@ -0,0 +1,39 @@
+/*
+  scenec.c
+
+  Converts scene descriptions between the text and binary forms.
+
+    scenec scene.scn scene.scb     text (or binary) to binary
+    scenec -t scene.scb scene.scn  binary (or text) back to text
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "scene_desc.h"
+
+int main(int argc, char *argv[]) {
+    scene_file_t file;
+    int to_text = 0;
+    int rv;
+
+    if (argc == 4 && strcmp(argv[1], "-t") == 0) {
+        to_text = 1;
+        ++argv;
+        --argc;
+    }
+    if (argc != 3) {
+        printf("Use:\n\t%s [-t] input output\n\n", argv[0]);
+        return 1;
+    }
+    if (scene_file_open(argv[1], &file) != 0) {
+        return 1;
+    }
+    if (to_text) {
+        rv = scene_desc_write_text(argv[2], file.desc);
+    } else {
+        rv = scene_desc_write_binary(argv[2], file.desc);
+    }
+    scene_file_close(&file);
+    return rv;
+}
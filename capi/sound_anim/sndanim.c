@@ -26,6 +26,8 @@
 
 #include <ri.h>
 
+#include "frame_arena.h"
+
 typedef struct audio_data_s {
     uint8_t *samples;
     size_t buffer_size;
@@ -95,7 +97,7 @@ int32_t get_sample(audio_data_t *ad, size_t idx, int8_t channel) {
 void doFrame(int fNum,
              /* double rval, */
              size_t cur, int fft_size, fftw_complex *fft_data[],
-             char *fName);
+             char *fName, frame_arena_t *arena);
 
 int read_audio(char *fname, audio_data_t *ad);
 
@@ -204,7 +206,7 @@ int read_audio(char *fname, audio_data_t *ad) {
 
 void doFrame(int fNum,
              size_t cur, int fft_size, fftw_complex *fft_data[],
-             char *fName) {
+             char *fName, frame_arena_t *arena) {
 
     RiFrameBegin(fNum);
 
@@ -227,9 +229,9 @@ void doFrame(int fNum,
     RiTranslate(-fft_size/2.0, -fft_size/2.0+fft_size/4.0, 0);
     
     size_t real_i = cur;
-    RtPoint *pts = malloc(sizeof(RtPoint)*(fft_size*fft_size/2));
-    RtColor *colors = malloc(sizeof(RtColor)*(fft_size*fft_size/2));
-    RtInt *numCurves = malloc(sizeof(RtInt)*fft_size);
+    RtPoint *pts = frame_arena_alloc(arena, sizeof(RtPoint)*(fft_size*fft_size/2));
+    RtColor *colors = frame_arena_alloc(arena, sizeof(RtColor)*(fft_size*fft_size/2));
+    RtInt *numCurves = frame_arena_alloc(arena, sizeof(RtInt)*fft_size);
     size_t cp = 0;
     for (int i=fft_size-1; i>=0; --i) {
         real_i += 1;
@@ -254,12 +256,9 @@ void doFrame(int fNum,
     
     RiCurves( "linear", fft_size, numCurves, "nonperiodic", "P", (RtPointer)pts, "Cs", (RtPointer)colors, RI_NULL );
 
-    free(numCurves);
-    free(colors);
-    free(pts);
-
     RiWorldEnd();
     RiFrameEnd();
+    frame_arena_reset(arena);
 }
 
 int main(int argc, char *argv[]) {
@@ -312,6 +311,13 @@ int main(int argc, char *argv[]) {
     }
     show_audio_info(&snd_data);
     
+    /* Each frame's curves: N*N/2 points and colors */
+    frame_arena_t arena;
+    if (frame_arena_init(&arena, N*N*sizeof(RtPoint) + N*sizeof(RtInt) + 64)) {
+        printf("Could not allocate the frame arena\n");
+        exit(1);
+    }
+
     RiBegin(RI_NULL);
     
     size_t num_frames = (snd_data.num_samples-per_frame)/per_frame;
@@ -332,7 +338,7 @@ int main(int argc, char *argv[]) {
 
         doFrame(fnum,
                 cur_out, N, fft_out,
-                argv[2]);
+                argv[2], &arena);
 
         cur_out += 1;
         if (cur_out == N) {
@@ -341,6 +347,7 @@ int main(int argc, char *argv[]) {
     }
 
     RiEnd();
+    frame_arena_free(&arena);
     for (size_t i=0; i<N; ++i) {
         fftw_free(fft_out[i]);
     }
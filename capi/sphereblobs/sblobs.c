@@ -1,5 +1,8 @@
 #include "ri.h"
 
+#include "render_opts.h"
+#include "rng.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -9,20 +12,11 @@
 
 #define PI (3.141592654)
 
-size_t randUInt(size_t min, size_t max) {
-    return ((rand()%(max-min)) + min);
-}
-
-double randFloat(double min, double max) {
-    double zToOne = ((double)rand()/((double)RAND_MAX));
-    return zToOne * (max-min) + min;
-}
-
-void randomPointInUnitSphere(double *rx, double *ry, double *rz) {
+void randomPointInUnitSphere(rng_t *rng, double *rx, double *ry, double *rz) {
     do {
-        *rx = randFloat(-1.0,1.0);
-        *ry = randFloat(-1.0,1.0);
-        *rz = randFloat(-1.0,1.0);
+        *rx = rng_range(rng, -1.0,1.0);
+        *ry = rng_range(rng, -1.0,1.0);
+        *rz = rng_range(rng, -1.0,1.0);
     } while (*rx**rx+*ry**ry+*rz**rz > 1.0);
 }
 void showDoubleArray(size_t len, RtFloat *mat) {
@@ -109,17 +103,14 @@ void PlaceCamera(camera_t *cam)
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Not enough arguments given!\n");
-        return 1;
-    } else if (argc > 2) {
-        printf("Too many arguments given!\n");
+    render_opts_t opts;
+    if (render_opts_parse(&opts, argc, argv)) {
         return 1;
     }
-    char *fprefix = argv[1];
-    srand(time(NULL));
+    char *fprefix = opts.fprefix;
+    unsigned long seed = render_opts_seed(&opts);
     const size_t NUM_FRAMES = 100;
-    RtInt md = 4;
+    RtInt md = render_opts_maxdepth(&opts, 4);
     scene_info_t scene;
     double rad = 150.0;
     double t = 0.0;
@@ -164,7 +155,9 @@ int main(int argc, char *argv[]) {
         mats[curOff+11] = 0.0;
 
         double rx, ry, rz;
-        randomPointInUnitSphere(&rx, &ry, &rz);
+        rng_t rng;
+        rng_init(&rng, seed, 0, i);
+        randomPointInUnitSphere(&rng, &rx, &ry, &rz);
         mats[curOff+12] = 50.0*rx;
         mats[curOff+13] = 50.0*ry;
         mats[curOff+14] = 50.0*rz;
@@ -195,11 +188,12 @@ int main(int argc, char *argv[]) {
         /* scene.cam.location[2] = rad*cos(t); */
         /* scene.cam.look_at[1] = rad; */
         t += dt;
+        if (!render_opts_want_frame(&opts, fnum)) {
+            continue;
+        }
         printf("Rendering frame %lu\n", (unsigned long)fnum);
         RtInt on = 1;
         char buffer[256];
-        RtString on_string = "on";
-        RtInt samples = 2;
         RtPoint light1Pos = {80,80,80};
         RtPoint light2Pos = {0,120,0};
         RtPoint light3Pos = {0,40,0};
@@ -210,9 +204,9 @@ int main(int argc, char *argv[]) {
 
         
         sprintf(buffer, "images/%s%05lu.jpg", scene.fprefix, (unsigned long)fnum);
-        RiDisplay(buffer,(char*)"jpeg",(char*)"rgb",RI_NULL);
+        render_opts_display(&opts, buffer, "jpeg", "rgb");
   
-        RiFormat(1200,1200,1.0);
+        render_opts_format(&opts, 1200, 1200, 1.0);
 
         RiProjection((char*)"perspective",RI_NULL);
 
@@ -229,9 +223,7 @@ int main(int argc, char *argv[]) {
                      "int specular", (RtPointer)&on,
                      "int photon", (RtPointer)&on,
                      RI_NULL );
-        RiAttribute( "light", (RtToken)"shadows", (RtPointer)&on_string, (RtToken)"samples", (RtPointer)&samples, RI_NULL );
-
-        RiAttribute((RtToken)"light", "string shadow", (RtPointer)&on_string, RI_NULL);
+        render_opts_shadows(&opts, 2);
         RiLightSource("distantlight", "point from", (RtPointer)light1Pos, RI_NULL);
         RiLightSource("distantlight", "point from", (RtPointer)light2Pos, RI_NULL);
         RiLightSource("pointlight", "point from", (RtPointer)light3Pos, RI_NULL);
@@ -0,0 +1,98 @@
+/*
+  stitch.c
+
+  Assembles crop window tiles rendered by separate processes back into
+  one image.  Used by "renderq --tiles", but can be run by hand:
+
+      stitch out.jpg 1200 1200 t0.tif 0 0 600 600  t1.tif 600 0 1200 600 ...
+
+  Each tile is followed by the pixel rectangle it covers (x0 y0 x1 y1,
+  end exclusive).  A tile may either be exactly that size or a full
+  resolution image with only the crop window filled in.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image_io.h"
+
+int place_tile(image_t *out, const image_t *tile, size_t x0, size_t y0, size_t x1, size_t y1) {
+    size_t w = x1-x0;
+    size_t h = y1-y0;
+    size_t sx = 0, sy = 0;
+    size_t ch = (tile->channels < out->channels) ? tile->channels : out->channels;
+    size_t i, j, k;
+
+    if (x1 > out->width || y1 > out->height || x1 <= x0 || y1 <= y0) {
+        printf("Tile rectangle %lu %lu %lu %lu is outside the %lux%lu image\n",
+               (unsigned long)x0, (unsigned long)y0, (unsigned long)x1, (unsigned long)y1,
+               (unsigned long)out->width, (unsigned long)out->height);
+        return 1;
+    }
+    if (tile->width == out->width && tile->height == out->height) {
+        sx = x0;
+        sy = y0;
+    } else if (tile->width != w || tile->height != h) {
+        printf("Tile is %lux%lu, expected %lux%lu\n",
+               (unsigned long)tile->width, (unsigned long)tile->height,
+               (unsigned long)w, (unsigned long)h);
+        return 1;
+    }
+    for (j=0; j<h; ++j) {
+        const uint8_t *src = tile->pixels + ((sy+j)*tile->width + sx)*tile->channels;
+        uint8_t *dst = out->pixels + ((y0+j)*out->width + x0)*out->channels;
+        if (ch == tile->channels && ch == out->channels) {
+            memcpy(dst, src, w*ch);
+            continue;
+        }
+        for (i=0; i<w; ++i) {
+            for (k=0; k<ch; ++k) {
+                dst[i*out->channels + k] = src[i*tile->channels + k];
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    image_t out;
+    image_t tile;
+    size_t width, height;
+    int i;
+    int rv = 0;
+
+    if (argc < 9 || (argc-4)%5 != 0) {
+        printf("Use:\n\t%s output width height tile x0 y0 x1 y1 [tile x0 y0 x1 y1 ...]\n\n", argv[0]);
+        return 1;
+    }
+    width = strtoul(argv[2], NULL, 10);
+    height = strtoul(argv[3], NULL, 10);
+    out.pixels = NULL;
+
+    for (i=4; i<argc && rv == 0; i+=5) {
+        if (image_read_tiff(argv[i], &tile)) {
+            rv = 1;
+            break;
+        }
+        if (out.pixels == NULL && image_alloc(&out, width, height, tile.channels)) {
+            printf("Could not allocate a %lux%lu output image\n",
+                   (unsigned long)width, (unsigned long)height);
+            image_free(&tile);
+            rv = 1;
+            break;
+        }
+        rv = place_tile(&out, &tile,
+                        strtoul(argv[i+1], NULL, 10), strtoul(argv[i+2], NULL, 10),
+                        strtoul(argv[i+3], NULL, 10), strtoul(argv[i+4], NULL, 10));
+        if (rv) {
+            printf("Bad tile \"%s\"\n", argv[i]);
+        }
+        image_free(&tile);
+    }
+    if (rv == 0) {
+        rv = image_write(argv[1], &out);
+    }
+    image_free(&out);
+    return rv;
+}
@@ -28,6 +28,8 @@
 
 #include <ri.h>
 
+#include "rng.h"
+#include "scene_graph.h"
 #include "trimesh.h"
 
 
@@ -40,15 +42,22 @@ typedef struct camera_s {
 typedef struct scene_info_s {
     camera_t cam;
     char *fprefix;
+    sg_node_t *world;
 } scene_info_t;
 
 
-double randF(double min, double max);
+/* Same terrain every run, as when this used rand() without srand() */
+#define TERRAIN_SEED 1
+
+double randF(uint64_t element, double min, double max);
 
 const double PI = 3.141592654;
 
-double randF(double min, double max) {
-    return (max-min) + ((double)rand())/((double)RAND_MAX) + min;
+/* Displacement for one grid point of one pass, whatever order they're done in */
+double randF(uint64_t element, double min, double max) {
+    rng_t rng;
+    rng_init(&rng, TERRAIN_SEED, 0, element);
+    return rng_range(&rng, min, max);
 }
 
 /*
@@ -107,7 +116,7 @@ void PlaceCamera(camera_t *cam)
     RiTranslate(-cam->location[0], -cam->location[1], -cam->location[2]);
 }
 
-void doFrame(size_t fNum, scene_info_t *scene, tri_mesh_t *tmesh);
+void doFrame(size_t fNum, scene_info_t *scene);
 
 double x(double u, double v) {
     return u;
@@ -129,10 +138,16 @@ double b(double u, double v) {
     return 0.2f;
 }
 
+static void render_terrain(void *tmesh) {
+    tmesh_render(tmesh);
+}
+
 void gen_terrain(tri_mesh_t *tmesh) {
     size_t NUM_I = tmesh->NUM_I;
     size_t NUM_J = tmesh->NUM_J;
     size_t step, i, j;
+    /* Each sweep over the grid gets its own block of elements */
+    uint64_t pass = 0;
 
     double x0,y0,z0;
     double x1,y1,z1;
@@ -152,7 +167,7 @@ void gen_terrain(tri_mesh_t *tmesh) {
                 
                 
                 tmesh_get_pt(tmesh, i,j, &nx,&ny,&nz);
-                ny = (y0+y1+y2+y3)/4.0 + randF(-2.0, 2.0);
+                ny = (y0+y1+y2+y3)/4.0 + randF(pass*NUM_I*NUM_J + i*NUM_J + j, -2.0, 2.0);
                 nx = (i-(double)NUM_I/2.0)/2.0;
                 nz = (j-(double)NUM_J/2.0)/2.0;
                 // printf("Assigning pt %lu %lu to %f %f %f\n", i,j, nx, ny, nz);
@@ -161,6 +176,7 @@ void gen_terrain(tri_mesh_t *tmesh) {
                 tmesh_set_color(tmesh, i,j, 0.0,1.0,0.0);
             }
         }
+        ++pass;
         hs = step/2;
         for (i=hs; i< NUM_I; i += step) {
             for (j=hs; j < NUM_J; j += step) {
@@ -171,7 +187,7 @@ void gen_terrain(tri_mesh_t *tmesh) {
                 tmesh_get_pt(tmesh, i-hs,j+hs, &x3,&y3,&z3);
                 
                 tmesh_get_pt(tmesh, i,j, &nx,&ny,&nz);
-                ny = (y0+y1+y2+y3)/4.0 + randF(-2.0,2.0);
+                ny = (y0+y1+y2+y3)/4.0 + randF(pass*NUM_I*NUM_J + i*NUM_J + j, -2.0, 2.0);
                 nx = (i-(double)NUM_I/2.0)/2.0;
                 nz = (j-(double)NUM_J/2.0)/2.0;
                 // printf("Assigning pt %lu %lu to %f %f %f\n", i,j, nx, ny, nz);
@@ -181,10 +197,11 @@ void gen_terrain(tri_mesh_t *tmesh) {
             }
         }
 
+        ++pass;
     }
 }
 
-void doFrame(size_t fNum, scene_info_t *scene, tri_mesh_t *tmesh) {
+void doFrame(size_t fNum, scene_info_t *scene) {
     RtInt on = 1;
     char buffer[256];
     RtString on_string = "on";
@@ -219,7 +236,7 @@ void doFrame(size_t fNum, scene_info_t *scene, tri_mesh_t *tmesh) {
   
     RiSurface((char*)"matte", RI_NULL);
 
-    tmesh_render(tmesh);
+    sg_render(scene->world);
 
     RiWorldEnd();
     RiFrameEnd();
@@ -266,16 +283,19 @@ int main(int argc, char *argv[]) {
 
     tmesh_alloc(&tmesh, 256,256);
     gen_terrain(&tmesh);
-    
+    scene.world = sg_geometry(render_terrain, &tmesh);
+
     for (fnum = 0; fnum < NUM_FRAMES; ++fnum) {
         scene.cam.location[0] = rad * sin(t);
         scene.cam.location[2] = rad * cos(t);
         t += dt;
         printf("Rendering frame %lu\n", fnum);
-        doFrame(fnum, &scene, &tmesh);
+        sg_prepare(scene.world);
+        doFrame(fnum, &scene);
     }
-    tmesh_free(&tmesh);
     RiEnd();
+    sg_free(scene.world);
+    tmesh_free(&tmesh);
 
     return 0;
 }
@@ -25,6 +25,8 @@
 
 #include <ri.h>
 
+#include "big_alloc.h"
+
 RtInt idx(size_t i, size_t j, size_t NUM_I, size_t NUM_J) {
     return (RtInt)(i*NUM_J + j);
 }
@@ -35,8 +37,8 @@ void tmesh_alloc(tri_mesh_t *tmesh, size_t ni, size_t nj) {
     tmesh->NUM_I = ni;
     tmesh->NUM_J = nj;
 
-    tmesh->pts = (RtPoint*)malloc(sizeof(RtPoint)*ni*nj);
-    tmesh->colors = (RtColor*)malloc(sizeof(RtColor)*ni*nj);
+    tmesh->pts = (RtPoint*)big_alloc(sizeof(RtPoint)*ni*nj);
+    tmesh->colors = (RtColor*)big_alloc(sizeof(RtColor)*ni*nj);
 
     for (i=0; i< ni; ++i) {
         for (j=0; j < nj; ++j) {
@@ -47,12 +49,12 @@ void tmesh_alloc(tri_mesh_t *tmesh, size_t ni, size_t nj) {
     
     tmesh->npolys = (RtInt)(2*(nj+1)*(ni+1));
 
-    tmesh->nvertices = (RtInt*)malloc(sizeof(RtInt) * tmesh->npolys);
+    tmesh->nvertices = (RtInt*)big_alloc(sizeof(RtInt) * tmesh->npolys);
     for (i=0; i<tmesh->npolys; ++i) {
         tmesh->nvertices[i] = 3;
     }
     
-    tmesh->vertices = (RtInt*)malloc(sizeof(RtInt)*3*tmesh->npolys);
+    tmesh->vertices = (RtInt*)big_alloc(sizeof(RtInt)*3*tmesh->npolys);
     curIdx = 0;
     for (i = 0; i<(ni-1); ++i) {
         for (j=0; j<(nj-1); ++j) {
@@ -71,10 +73,10 @@ void tmesh_alloc(tri_mesh_t *tmesh, size_t ni, size_t nj) {
 }
 
 void tmesh_free(tri_mesh_t *tmesh) {
-    free(tmesh->vertices);
-    free(tmesh->nvertices);
-    free(tmesh->colors);
-    free(tmesh->pts);
+    big_free(tmesh->vertices);
+    big_free(tmesh->nvertices);
+    big_free(tmesh->colors);
+    big_free(tmesh->pts);
 
     tmesh->vertices = NULL;
     tmesh->nvertices = NULL;
@@ -0,0 +1,38 @@
+#==========
+#
+# Picks the RenderMan implementation a program links against.
+#
+# Variables defined by this module:
+#   RI_INCLUDE_DIR
+#   RI_COMPILE_FLAGS
+#   RI_LIBRARIES
+#
+# Usage:
+#   include( ${CMAKE_SOURCE_DIR}/../../config/cmake/RiBackend.cmake )
+#
+# By default this is 3Delight (see Find3Delight.cmake).  Configuring with
+# -DUSE_RI_PREVIEW=ON builds the preview ray caster in capi/preview
+# instead, which needs no license and writes the same output files.
+#
+#==========
+
+option( USE_RI_PREVIEW "Render with the built-in preview ray caster instead of 3Delight" OFF )
+
+get_filename_component( RI_BACKEND_ROOT ${CMAKE_CURRENT_LIST_DIR}/../.. ABSOLUTE )
+
+if( USE_RI_PREVIEW )
+  # The ray caster is C++, so C programs need the C++ linker
+  enable_language( CXX )
+  if( NOT TARGET ripreview )
+    add_subdirectory( ${RI_BACKEND_ROOT}/capi/preview ${CMAKE_BINARY_DIR}/ripreview )
+  endif()
+  set( RI_INCLUDE_DIR ${RI_BACKEND_ROOT}/capi/preview )
+  set( RI_COMPILE_FLAGS "" )
+  set( RI_LIBRARIES ripreview )
+else()
+  set( CMAKE_MODULE_PATH ${CMAKE_MODULE_PATH} ${CMAKE_CURRENT_LIST_DIR} )
+  find_package( 3Delight )
+  set( RI_INCLUDE_DIR ${3Delight_INCLUDE_DIR} )
+  set( RI_COMPILE_FLAGS ${3Delight_COMPILE_FLAGS} )
+  set( RI_LIBRARIES ${3Delight_LIBRARIES} )
+endif()